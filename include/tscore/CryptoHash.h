@@ -158,11 +158,17 @@ public:
     MMH,
 #endif
     SHA256,
+#if TS_ENABLE_FIPS == 0
+    XXH3, ///< Non-cryptographic, for cache keys only.
+#endif
   }; ///< What type of hash we really are.
   static HashType Setting;
 
+  /// Use the hash @a type instead of the global @c Setting.
+  explicit CryptoContext(HashType type);
+
   /// Size of storage for placement @c new of hashing context.
-  static size_t const OBJ_SIZE = 256;
+  static size_t const OBJ_SIZE = 384;
 
 protected:
   char _obj[OBJ_SIZE]; ///< Raw storage for instantiated context.
@@ -0,0 +1,154 @@
+/** @file
+
+  Slab allocator with geometric size classes.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  The power of two fast allocators waste up to half of a block for sizes just above a power of
+  two. This allocator serves a range of sizes from size classes spaced by a constant factor
+  (@c CLASS_SPACING) so the waste per object is bounded by that factor instead.
+
+  Objects are carved from slabs. A slab is a power of two sized, naturally aligned memory region
+  so the slab of an object is found by masking its address. Slabs are backed by huge pages if
+  they are enabled, otherwise transparent huge pages are requested where supported. Slabs are
+  returned to the operating system when they become empty, except for a small number kept per
+  size class to absorb allocation churn.
+
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "tscore/ink_mutex.h"
+
+class SlabAllocator
+{
+public:
+  /// Ratio between consecutive size classes.
+  static constexpr double CLASS_SPACING = 1.25;
+  /// Minimum number of objects in a slab.
+  static constexpr size_t MIN_SLAB_OBJECTS = 8;
+  /// Number of empty slabs kept per size class before slabs are returned to the OS.
+  static constexpr size_t DEFAULT_IDLE_SLABS = 1;
+
+  /** Create an allocator for sizes in [@a min_size, @a max_size].
+
+      @param name Name used in the memory dump.
+      @param min_size Smallest size served.
+      @param max_size Largest size served.
+      @param alignment Alignment of objects, a power of two. Class sizes are multiples of this.
+      @param min_slab_size Minimum slab size, a power of two.
+      @param advice @c madvise advice for new slabs, 0 for none.
+  */
+  SlabAllocator(const char *name, size_t min_size, size_t max_size, size_t alignment, size_t min_slab_size, int advice = 0);
+  ~SlabAllocator();
+
+  SlabAllocator(const SlabAllocator &) = delete;
+  SlabAllocator &operator=(const SlabAllocator &) = delete;
+
+  /// Check if @a size is served by this allocator.
+  bool
+  covers(size_t size) const
+  {
+    return size >= _min_size && size <= _max_size;
+  }
+
+  /// Size of the class used for @a size, 0 if @a size is not covered.
+  size_t class_size(size_t size) const;
+
+  /** Allocate memory for @a size bytes.
+
+      The usable size of the returned block is @c class_size(size).
+      @return The block or @c nullptr if @a size is not covered or no memory is available.
+  */
+  void *alloc(size_t size);
+
+  /** Free @a ptr which was allocated with a @a size of its class.
+
+      @a size can be any size of the class, usually it is the class size.
+  */
+  void free(void *ptr, size_t size);
+
+  /// Number of empty slabs kept per class.
+  void
+  set_idle_slabs(size_t n)
+  {
+    _idle_slabs = n;
+  }
+
+  /// Statistics for a size class.
+  struct ClassStats {
+    size_t size        = 0; ///< Object size of the class.
+    size_t slab_size   = 0; ///< Size of the slabs of the class.
+    size_t slabs       = 0; ///< Slabs currently mapped.
+    size_t in_use      = 0; ///< Objects currently allocated.
+    size_t capacity    = 0; ///< Objects the mapped slabs can hold.
+    uint64_t allocs    = 0; ///< Total allocations.
+    uint64_t requested = 0; ///< Total bytes requested by allocations.
+    uint64_t released  = 0; ///< Total slabs returned to the OS.
+  };
+
+  /// Number of size classes.
+  size_t
+  n_classes() const
+  {
+    return _classes.size();
+  }
+
+  /// Snapshot of the statistics of class @a idx.
+  ClassStats stats(size_t idx) const;
+
+  /// Total bytes mapped for slabs.
+  size_t mapped_bytes() const;
+
+  /** Write the per class usage and fragmentation to @a f.
+
+      Internal fragmentation is the average difference between the requested size and the class
+      size. External fragmentation is the free space in mapped slabs.
+  */
+  void dump(FILE *f) const;
+
+private:
+  struct Slab;
+  struct SizeClass {
+    size_t size      = 0;
+    size_t slab_size = 0;
+    size_t n_objects = 0; ///< Objects per slab.
+    mutable ink_mutex mutex;
+    Slab *partial = nullptr; ///< Slabs with free objects.
+    size_t empty  = 0;       ///< Slabs in @a partial without any allocated object.
+    ClassStats stats;
+  };
+
+  size_t class_index(size_t size) const;
+  Slab *map_slab(size_t idx);
+
+  const char *_name;
+  size_t _min_size;
+  size_t _max_size;
+  size_t _alignment;
+  int _advice;
+  size_t _header_size = 0;
+  size_t _idle_slabs  = DEFAULT_IDLE_SLABS;
+  std::vector<SizeClass> _classes;
+};
@@ -25,21 +25,28 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <new>
 
 #include "tscore/List.h"
 #include "tscore/Diags.h"
 
+// The trie is path compressed (a radix tree): a node holds the run of key bytes leading to it
+// from its parent, so a key costs about one node per branch point instead of one 256 pointer
+// node per byte. Children are found by the first byte of their run, kept in a small byte array
+// that is scanned with memchr.
+//
 // Note that you should provide the class to use here, but we'll store
 // pointers to such objects internally.
 template <typename T> class Trie
 {
 public:
-  Trie() { m_root.Clear(); }
+  Trie() {}
   // will return false for duplicates; key should be nullptr-terminated
   // if key_len is defaulted to -1
   bool Insert(const char *key, T *value, int rank, int key_len = -1);
 
-  // will return false if not found; else value_ptr will point to found value
+  // Return the value of the prefix of key with the best (lowest) rank, the longest one on ties.
+  // will return nullptr if not found
   T *Search(const char *key, int key_len = -1) const;
   void Clear();
   void Print();
@@ -53,42 +60,59 @@ public:
   virtual ~Trie() { Clear(); }
 
 private:
-  static const int N_NODE_CHILDREN = 256;
-
   class Node
   {
   public:
-    T *value;
-    bool occupied;
-    int rank;
+    T *value            = nullptr;
+    int rank            = 0;
+    bool occupied       = false;
+    uint16_t n_children = 0;
+    uint16_t capacity   = 0;
+    int label_len       = 0;
+    Node **children     = nullptr; ///< @a capacity child pointers followed by their first bytes.
+
+    // The label is stored right after the node.
+    char *
+    label()
+    {
+      return reinterpret_cast<char *>(this + 1);
+    }
+    const char *
+    label() const
+    {
+      return reinterpret_cast<const char *>(this + 1);
+    }
+
+    unsigned char *
+    child_keys() const
+    {
+      return reinterpret_cast<unsigned char *>(children + capacity);
+    }
 
-    void
-    Clear()
+    static Node *
+    Allocate(const char *label, int label_len)
     {
-      value    = nullptr;
-      occupied = false;
-      rank     = 0;
-      ink_zero(children);
+      Node *node = new (ats_malloc(sizeof(Node) + label_len)) Node;
+      memcpy(node->label(), label, label_len);
+      node->label_len = label_len;
+      return node;
     }
 
     void Print(const char *debug_tag) const;
-    inline Node *
-    GetChild(char index) const
+
+    inline int
+    FindChild(char c) const
     {
-      return children[static_cast<unsigned char>(index)];
+      const void *spot = n_children ? memchr(child_keys(), static_cast<unsigned char>(c), n_children) : nullptr;
+      return spot ? static_cast<const unsigned char *>(spot) - child_keys() : -1;
     }
     inline Node *
-    AllocateChild(char index)
+    GetChild(char c) const
     {
-      Node *&child = children[static_cast<unsigned char>(index)];
-      ink_assert(child == nullptr);
-      child = static_cast<Node *>(ats_malloc(sizeof(Node)));
-      child->Clear();
-      return child;
+      int idx = FindChild(c);
+      return idx < 0 ? nullptr : children[idx];
     }
-
-  private:
-    Node *children[N_NODE_CHILDREN];
+    void AddChild(Node *child);
   };
 
   Node m_root;
@@ -107,6 +131,27 @@ private:
   }
 };
 
+template <typename T>
+void
+Trie<T>::Node::AddChild(Node *child)
+{
+  ink_assert(child->label_len > 0 && FindChild(child->label()[0]) < 0);
+  if (n_children == capacity) {
+    uint16_t n_capacity = capacity ? capacity * 2 : 2;
+    Node **n_children_v = static_cast<Node **>(ats_malloc(n_capacity * (sizeof(Node *) + 1)));
+    if (n_children) {
+      memcpy(n_children_v, children, n_children * sizeof(Node *));
+      memcpy(n_children_v + n_capacity, child_keys(), n_children);
+    }
+    ats_free(children);
+    children = n_children_v;
+    capacity = n_capacity;
+  }
+  children[n_children]     = child;
+  child_keys()[n_children] = child->label()[0];
+  ++n_children;
+}
+
 template <typename T>
 void
 Trie<T>::_CheckArgs(const char *key, int &key_len) const
@@ -124,31 +169,43 @@ Trie<T>::Insert(const char *key, T *value, int rank, int key_len /* = -1 */)
 {
   _CheckArgs(key, key_len);
 
-  Node *next_node;
   Node *curr_node = &m_root;
   int i           = 0;
 
-  while (true) {
+  while (i < key_len) {
     if (is_debug_tag_set("Trie::Insert")) {
       Debug("Trie::Insert", "Visiting Node...");
       curr_node->Print("Trie::Insert");
     }
 
-    if (i == key_len) {
+    int idx = curr_node->FindChild(key[i]);
+    if (idx < 0) {
+      Debug("Trie::Insert", "Creating child node for [%.*s]", key_len - i, key + i);
+      Node *child = Node::Allocate(key + i, key_len - i);
+      curr_node->AddChild(child);
+      curr_node = child;
       break;
     }
 
-    next_node = curr_node->GetChild(key[i]);
-    if (!next_node) {
-      while (i < key_len) {
-        Debug("Trie::Insert", "Creating child node for char %c (%d)", key[i], key[i]);
-        curr_node = curr_node->AllocateChild(key[i]);
-        ++i;
-      }
-      break;
+    Node *child = curr_node->children[idx];
+    int n       = 1; // the first byte matched the child
+    while (n < child->label_len && i + n < key_len && child->label()[n] == key[i + n]) {
+      ++n;
+    }
+
+    if (n < child->label_len) {
+      // Split the child where the key diverges, the new node takes over its slot.
+      Debug("Trie::Insert", "Splitting node [%.*s] at %d", child->label_len, child->label(), n);
+      Node *split = Node::Allocate(child->label(), n);
+      memmove(child->label(), child->label() + n, child->label_len - n);
+      child->label_len -= n;
+      split->AddChild(child);
+      curr_node->children[idx] = split;
+      child                    = split;
     }
-    curr_node = next_node;
-    ++i;
+
+    curr_node = child;
+    i += n;
   }
 
   if (curr_node->occupied) {
@@ -174,7 +231,7 @@ Trie<T>::Search(const char *key, int key_len /* = -1 */) const
   const Node *curr_node  = &m_root;
   int i                  = 0;
 
-  while (curr_node) {
+  while (true) {
     if (is_debug_tag_set("Trie::Search")) {
       Debug("Trie::Search", "Visiting node...");
       curr_node->Print("Trie::Search");
@@ -187,8 +244,13 @@ Trie<T>::Search(const char *key, int key_len /* = -1 */) const
     if (i == key_len) {
       break;
     }
-    curr_node = curr_node->GetChild(key[i]);
-    ++i;
+    // The child lookup matches the first byte of the label, compare the rest.
+    const Node *child = curr_node->GetChild(key[i]);
+    if (!child || child->label_len > key_len - i || memcmp(child->label() + 1, key + i + 1, child->label_len - 1) != 0) {
+      break;
+    }
+    curr_node = child;
+    i += child->label_len;
   }
 
   if (found_node) {
@@ -203,15 +265,15 @@ template <typename T>
 void
 Trie<T>::_Clear(Node *node)
 {
-  Node *child;
-
-  for (int i = 0; i < N_NODE_CHILDREN; ++i) {
-    child = node->GetChild(i);
-    if (child) {
-      _Clear(child);
-      ats_free(child);
-    }
+  for (int i = 0; i < node->n_children; ++i) {
+    Node *child = node->children[i];
+    _Clear(child);
+    child->~Node();
+    ats_free(child);
   }
+  ats_free(node->children);
+  node->children   = nullptr;
+  node->n_children = node->capacity = 0;
 }
 
 template <typename T>
@@ -224,7 +286,9 @@ Trie<T>::Clear()
   }
 
   _Clear(&m_root);
-  m_root.Clear();
+  m_root.value    = nullptr;
+  m_root.occupied = false;
+  m_root.rank     = 0;
 }
 
 template <typename T>
@@ -239,6 +303,7 @@ template <typename T>
 void
 Trie<T>::Node::Print(const char *debug_tag) const
 {
+  Debug(debug_tag, "Node has label [%.*s]", label_len, label());
   if (occupied) {
     Debug(debug_tag, "Node is occupied");
     Debug(debug_tag, "Node has rank %d", rank);
@@ -246,9 +311,7 @@ Trie<T>::Node::Print(const char *debug_tag) const
     Debug(debug_tag, "Node is not occupied");
   }
 
-  for (int i = 0; i < N_NODE_CHILDREN; ++i) {
-    if (GetChild(i)) {
-      Debug(debug_tag, "Node has child for char %c", static_cast<char>(i));
-    }
+  for (int i = 0; i < n_children; ++i) {
+    Debug(debug_tag, "Node has child for char %c", static_cast<char>(child_keys()[i]));
   }
 }
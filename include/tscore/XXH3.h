@@ -0,0 +1,53 @@
+/** @file
+
+  XXH3 128 bit hash context.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include "tscore/ink_defs.h"
+#include "tscore/CryptoHash.h"
+
+/**
+  XXH3 128 bit hash with the default secret and no seed, the same value as @c XXH3_128bits() of
+  xxHash 0.8. @c u64[0] of the result is the low 64 bits of the hash, @c u64[1] the high 64 bits.
+
+  This is not a cryptographic hash, it is several times faster than MD5 on short inputs like URLs.
+*/
+class XXH3Context : public ats::CryptoContextBase
+{
+public:
+  XXH3Context();
+  /// Update the hash with @a data of @a length bytes.
+  bool update(void const *data, int length) override;
+  /// Finalize and extract the @a hash.
+  bool finalize(CryptoHash &hash) override;
+
+  static constexpr int STRIPE_LEN  = 64;
+  static constexpr int BUFFER_SIZE = 256;
+
+protected:
+  uint64_t _acc[STRIPE_LEN / sizeof(uint64_t)];
+  uint8_t _buffer[BUFFER_SIZE];
+  uint64_t _total_len;
+  uint32_t _buffered;
+  uint32_t _stripes; ///< Stripes accumulated in the current block.
+};
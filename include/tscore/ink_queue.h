@@ -164,12 +164,19 @@ union head_p {
 #error "unsupported processor"
 #endif
 
+/// Maximum number of NUMA nodes with a private free list head.
+#define INK_FREELIST_MAX_NUMA_NODES 8
+
 struct _InkFreeList {
   head_p head;
   const char *name;
   uint32_t type_size, chunk_size, used, allocated, alignment;
   uint32_t allocated_base, used_base;
   int advice;
+  /* Per NUMA node free list heads and chunk accounting, used only if NUMA aware
+     free lists are enabled (see ink_freelist_numa_init()). */
+  head_p node_head[INK_FREELIST_MAX_NUMA_NODES];
+  uint32_t node_allocated[INK_FREELIST_MAX_NUMA_NODES];
 };
 
 typedef struct ink_freelist_ops InkFreeListOps;
@@ -194,6 +201,18 @@ void ink_freelists_dump(FILE *f);
 void ink_freelists_dump_baselinerel(FILE *f);
 void ink_freelists_snap_baseline();
 
+/*
+ * NUMA aware free lists. If enabled, each free list keeps a separate head per
+ * NUMA node. A thread that has set its node allocates from, and frees to, the
+ * list for that node and new chunks for a node are bound to the node memory.
+ * Threads without a node use the shared head.
+ */
+void ink_freelist_numa_init(int n_nodes);
+int ink_freelist_numa_nodes();
+void ink_freelist_set_thread_numa_node(int node);
+int ink_freelist_thread_numa_node();
+uint64_t ink_freelists_numa_allocated(int node);
+
 struct InkAtomicList {
   InkAtomicList() {}
   head_p head{};
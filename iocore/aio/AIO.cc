@@ -192,8 +192,13 @@ struct AIOThreadInfo : public Continuation {
     (void)event;
     (void)e;
 #if TS_USE_HWLOC
-    hwloc_set_membind_nodeset(ink_get_topology(), hwloc_topology_get_topology_nodeset(ink_get_topology()), HWLOC_MEMBIND_INTERLEAVE,
-                              HWLOC_MEMBIND_THREAD);
+    if (eventProcessor.net_numa_node() >= 0) {
+      // Keep the disk threads on the node of the net threads they serve.
+      eventProcessor.bind_to_net_numa_node();
+    } else {
+      hwloc_set_membind_nodeset(ink_get_topology(), hwloc_topology_get_topology_nodeset(ink_get_topology()),
+                                HWLOC_MEMBIND_INTERLEAVE, HWLOC_MEMBIND_THREAD);
+    }
 #endif
     aio_thread_main(this);
     delete this;
@@ -41,6 +41,8 @@ int net_config_poll_timeout = 10;
 #include "diags.i"
 
 #define MAX_DISK_THREADS 200
+#define DIRECT_IO_ALIGN 4096 // sizes and offsets of O_DIRECT operations, the largest common sector size
+#define LATENCY_BUCKETS 32   // log2 of the microseconds an operation took
 #ifdef DISK_ALIGN
 #define MIN_OFFSET (32 * 1024)
 #else
@@ -73,6 +75,7 @@ int threads_per_disk = 1;
 int delete_disks     = 0;
 int max_size         = 0;
 int use_lseek        = 0;
+int direct_io        = 0;
 
 int chains                    = 1;
 double seq_read_percent       = 0.0;
@@ -97,13 +100,31 @@ struct AIO_Device : public Continuation {
   int hotset_idx;
   int mode;
   AIOCallback *io;
+  ink_hrtime io_start;
+  int64_t latency[LATENCY_BUCKETS];
   AIO_Device(ProxyMutex *m) : Continuation(m)
   {
     hotset_idx = 0;
     io         = new_AIOCallback();
     time_start = 0;
+    io_start   = 0;
+    memset(latency, 0, sizeof(latency));
     SET_HANDLER(&AIO_Device::do_hotset);
   }
+  void
+  record_latency()
+  {
+    if (io_start) {
+      int64_t usecs = (Thread::get_hrtime() - io_start) / HRTIME_USECOND;
+      int b         = 0;
+      while (usecs > 1 && b < LATENCY_BUCKETS - 1) {
+        usecs >>= 1;
+        b++;
+      }
+      latency[b]++;
+    }
+    io_start = Thread::get_hrtime();
+  }
   int
   select_mode(double p)
   {
@@ -210,6 +231,24 @@ dump_summary()
   printf("%f ops %0.2f mbytes/sec %0.1f ops/sec %0.1f ops/sec/disk rand_read\n", total_rand_reads, rr,
          total_rand_reads / total_secs, total_rand_reads / total_secs / n_disk_path);
   printf("%0.2f total mbytes/sec\n", sr + sw + rr);
+  printf("-------------------------------\n");
+  printf("latency%s\n", direct_io ? " (direct I/O)" : "");
+  printf("-------------------------------\n");
+  int64_t latency[LATENCY_BUCKETS] = {0}, ops = 0;
+  for (int i = 0; i < orig_n_accessors; i++) {
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+      latency[b] += dev[i]->latency[b];
+      ops += dev[i]->latency[b];
+    }
+  }
+  for (double p : {0.5, 0.9, 0.99, 0.999}) {
+    int64_t n = 0;
+    int b     = 0;
+    while (b < LATENCY_BUCKETS - 1 && (n += latency[b]) < p * ops) {
+      b++;
+    }
+    printf("p%g < %" PRId64 " usecs\n", p * 100.0, static_cast<int64_t>(2) << b);
+  }
   printf("----------------------------------------------------------\n");
 
   if (delete_disks) {
@@ -276,6 +315,7 @@ AIO_Device::do_fd(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   if (io->aiocb.aio_lio_opcode == LIO_READ) {
     ink_assert(!do_check_data(io->aiocb.aio_nbytes, io->aiocb.aio_offset));
   }
+  record_latency();
   memset((void *)buf, 0, max_size);
   io->aiocb.aio_fildes = fd;
   io->aiocb.aio_buf    = buf;
@@ -377,6 +417,7 @@ read_config(const char *config_filename)
     PARAM(chains)
     PARAM(threads_per_disk)
     PARAM(delete_disks)
+    PARAM(direct_io)
     else if (strcmp(field_name, "disk_path") == 0)
     {
       assert(n_disk_path < MAX_DISK_THREADS);
@@ -439,6 +480,14 @@ main(int /* argc ATS_UNUSED */, char *argv[])
     exit(1);
   }
 
+  if (direct_io) {
+    // O_DIRECT requires whole sectors
+    seq_read_size  = INK_ALIGN(seq_read_size, DIRECT_IO_ALIGN);
+    seq_write_size = INK_ALIGN(seq_write_size, DIRECT_IO_ALIGN);
+    rand_read_size = INK_ALIGN(rand_read_size, DIRECT_IO_ALIGN);
+    write_skip     = INK_ALIGN(write_skip, DIRECT_IO_ALIGN);
+  }
+
   max_size = seq_read_size;
   if (seq_write_size > max_size) {
     max_size = seq_write_size;
@@ -458,7 +507,13 @@ main(int /* argc ATS_UNUSED */, char *argv[])
       dev[n_accessors]->seq_reads  = 0;
       dev[n_accessors]->seq_writes = 0;
       dev[n_accessors]->rand_reads = 0;
-      dev[n_accessors]->fd         = open(dev[n_accessors]->path, O_RDWR | O_CREAT, 0600);
+      int opts                     = O_RDWR | O_CREAT;
+#ifdef O_DIRECT
+      if (direct_io) {
+        opts |= O_DIRECT;
+      }
+#endif
+      dev[n_accessors]->fd = open(dev[n_accessors]->path, opts, 0600);
       fchmod(dev[n_accessors]->fd, S_IRWXU | S_IRWXG);
       if (dev[n_accessors]->fd < 0) {
         perror(disk_path[i]);
@@ -22,6 +22,7 @@
  */
 
 #include "P_Cache.h"
+#include "I_Tasks.h"
 
 // Cache Inspector and State Pages
 #include "P_CacheTest.h"
@@ -36,8 +37,12 @@
 #include "P_CacheBC.h"
 
 #include "tscore/hugepages.h"
+#include "tscpp/util/TextView.h"
 
+#include <algorithm>
 #include <atomic>
+#include <mutex>
+#include <vector>
 
 constexpr ts::VersionNumber CACHE_DB_VERSION(CACHE_DB_MAJOR_VERSION, CACHE_DB_MINOR_VERSION);
 
@@ -63,6 +68,11 @@ int cache_config_ram_cache_algorithm           = 1;
 int cache_config_ram_cache_compress            = 0;
 int cache_config_ram_cache_compress_percent    = 90;
 int cache_config_ram_cache_use_seen_filter     = 1;
+int cache_config_ram_cache_shared              = 0;
+int cache_config_ram_cache_shards              = 64;
+int cache_config_init_stripes_per_disk         = 2;
+int cache_config_init_serve_while_recovering   = 0;
+int cache_config_ram_cache_compress_threads    = 0;
 int cache_config_http_max_alts                 = 3;
 int cache_config_dir_sync_frequency            = 60;
 int cache_config_permit_pinning                = 0;
@@ -73,7 +83,21 @@ int64_t cache_config_ram_cache_cutoff          = AGG_SIZE;
 int cache_config_max_disk_errors               = 5;
 int cache_config_hit_evacuate_percent          = 10;
 int cache_config_hit_evacuate_size_limit       = 0;
+int cache_config_compact_min_hits              = 0;
+int cache_config_compact_max_percent           = 10;
+int cache_config_compress                      = CACHE_COMPRESSION_NONE;
+int cache_config_tier_promote_hits             = 2;
+int cache_config_tier_promote_max_size         = 262144;
+int cache_config_tier_demote_percent           = 10;
+int cache_config_read_ahead_max_fragments      = 4;
+int64_t cache_config_read_ahead_stripe_memory  = 32 * 1024 * 1024;
+int64_t cache_config_sparse_chunk_size         = 0;
+int cache_config_disk_latency_slow_factor      = 0;
+int cache_config_disk_latency_min              = 2000;
+int cache_config_disk_latency_min_share        = 10;
+int cache_config_disk_latency_move_lookups     = 0;
 int cache_config_force_sector_size             = 0;
+int cache_config_key_hash                      = CACHE_KEY_HASH_DEFAULT;
 int cache_config_target_fragment_size          = DEFAULT_TARGET_FRAGMENT_SIZE;
 int cache_config_agg_write_backlog             = AGG_SIZE * 2;
 int cache_config_enable_checksum               = 0;
@@ -114,6 +138,12 @@ ClassAllocator<CacheRemoveCont> cacheRemoveContAllocator("cacheRemoveCont");
 ClassAllocator<EvacuationKey> evacuationKeyAllocator("evacuationKey");
 int CacheVC::size_to_init = -1;
 CacheKey zero_key;
+EventType ET_RAM_CACHE_COMPRESS = ET_CALL; // set by CacheProcessor::start()
+
+// Content type prefixes which are not compressed in the RAM cache
+static std::vector<std::string> ram_cache_compress_skip_types;
+// Content type prefixes which are compressed on disk
+static std::vector<std::string> cache_compress_types;
 
 struct VolInitInfo {
   off_t recover_pos;
@@ -137,29 +167,22 @@ struct VolInitInfo {
   }
 };
 
-#if AIO_MODE == AIO_MODE_NATIVE
 struct VolInit : public Continuation {
   Vol *vol;
-  char *path;
-  off_t blocks;
-  int64_t offset;
-  bool vol_clear;
 
   int
   mainEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   {
-    vol->init(path, blocks, offset, vol_clear);
+    vol->load();
     mutex.clear();
     delete this;
     return EVENT_DONE;
   }
 
-  VolInit(Vol *v, char *p, off_t b, int64_t o, bool c) : Continuation(v->mutex), vol(v), path(p), blocks(b), offset(o), vol_clear(c)
-  {
-    SET_HANDLER(&VolInit::mainEvent);
-  }
+  explicit VolInit(Vol *v) : Continuation(v->mutex), vol(v) { SET_HANDLER(&VolInit::mainEvent); }
 };
 
+#if AIO_MODE == AIO_MODE_NATIVE
 struct DiskInit : public Continuation {
   CacheDisk *disk;
   char *s;
@@ -191,6 +214,7 @@ static void cplist_update();
 int cplist_reconfigure();
 static int create_volume(int volume_number, off_t size_in_blocks, int scheme, CacheVol *cp);
 static void rebuild_host_table(Cache *cache);
+static void disk_health_init();
 void register_cache_stats(RecRawStatBlock *rsb, const char *prefix);
 
 // Global list of the volumes created
@@ -438,6 +462,27 @@ CacheVC::get_http_info(CacheHTTPInfo **ainfo)
   *ainfo = &((CacheVC *)this)->alternate;
 }
 
+// Check the response of the alternate, only the content types listed are compressed on disk and
+// never the content which is already encoded.
+static bool
+disk_compressible(CacheHTTPInfo *alternate)
+{
+  HTTPHdr *response = alternate->response_get();
+  int len           = 0;
+  const char *value = response->value_get(MIME_FIELD_CONTENT_ENCODING, MIME_LEN_CONTENT_ENCODING, &len);
+  if (value && !(len == 8 && strncasecmp(value, "identity", 8) == 0)) {
+    return false;
+  }
+  if ((value = response->value_get(MIME_FIELD_CONTENT_TYPE, MIME_LEN_CONTENT_TYPE, &len)) != nullptr) {
+    for (auto const &type : cache_compress_types) {
+      if (static_cast<size_t>(len) >= type.size() && strncasecmp(value, type.data(), type.size()) == 0) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 // set_http_info must be called before do_io_write
 // cluster vc does an optimization where it calls do_io_write() before
 // calling set_http_info(), but it guarantees that the info will
@@ -463,10 +508,42 @@ CacheVC::set_http_info(CacheHTTPInfo *ainfo)
   } else {
     f.allow_empty_doc = 0;
   }
+  compression = CACHE_COMPRESSION_NONE;
+  if (vol->cache_vol->compression != CACHE_COMPRESSION_NONE && disk_compressible(ainfo)) {
+    compression = vol->cache_vol->compression;
+  }
   alternate.copy_shallow(ainfo);
   ainfo->clear();
 }
 
+bool
+CacheVC::set_sparse_write(int64_t data_offset)
+{
+  ink_assert(vio.op == VIO::WRITE && !total_len && alternate.valid());
+  int64_t object_size = alternate.response_get()->get_content_length();
+  HTTPChunkMap *map   = new HTTPChunkMap;
+  if (frag_type != CACHE_FRAG_TYPE_HTTP || !map->load(alternate.response_get(), object_size) || data_offset < 0 ||
+      data_offset >= object_size) {
+    delete map;
+    return false;
+  }
+  // The chunks of a map which starts afresh go under a new key, the stale chunks of an older
+  // version of the object are still found under the old one.
+  if (f.update && map->first() >= 0) {
+    earliest_key = update_key;
+  }
+  chunk_map   = map;
+  f.sparse    = 1;
+  total_len   = object_size;
+  fragment    = (data_offset + map->chunk_size - 1) / map->chunk_size;
+  sparse_skip = fragment * map->chunk_size - data_offset;
+  key         = earliest_key;
+  for (int i = 0; i < fragment; ++i) {
+    next_CacheKey(&key, &key);
+  }
+  return true;
+}
+
 bool
 CacheVC::set_pin_in_cache(time_t time_pin)
 {
@@ -557,8 +634,14 @@ Vol::close_read(CacheVC *cont)
 // Cache Processor
 
 int
-CacheProcessor::start(int, size_t)
+CacheProcessor::start(int, size_t stacksize)
 {
+  if (cache_config_ram_cache_compress && cache_config_ram_cache_compress_threads > 0) {
+    ET_RAM_CACHE_COMPRESS =
+      eventProcessor.spawn_event_threads("ET_RAM_COMPRESS", cache_config_ram_cache_compress_threads, stacksize);
+  } else {
+    ET_RAM_CACHE_COMPRESS = ET_TASK;
+  }
   return start_internal(0);
 }
 
@@ -622,7 +705,9 @@ CacheProcessor::start_internal(int flags)
     }
 
 #ifdef O_DIRECT
-    opts |= O_DIRECT;
+    if (sd->direct_io != SPAN_DIRECT_IO_OFF) {
+      opts |= O_DIRECT;
+    }
 #endif
 #ifdef O_DSYNC
     opts |= O_DSYNC;
@@ -634,10 +719,18 @@ CacheProcessor::start_internal(int flags)
 
     int fd         = open(path, opts, 0644);
     int64_t blocks = sd->blocks;
+    bool direct_io = false;
 
-    if (fd < 0 && (opts & O_CREAT)) { // Try without O_DIRECT if this is a file on filesystem, e.g. tmpfs.
+    // Try without O_DIRECT if this is a file on filesystem, e.g. tmpfs.
+    if (fd < 0 && (opts & O_CREAT) && sd->direct_io == SPAN_DIRECT_IO_AUTO) {
       fd = open(path, DEFAULT_CACHE_OPTIONS | O_CREAT, 0644);
+      if (fd >= 0) {
+        Warning("cache file '%s' does not support direct I/O, it is read and written through the page cache", path);
+      }
     }
+#ifdef O_DIRECT
+    direct_io = fd >= 0 && (fcntl(fd, F_GETFL) & O_DIRECT);
+#endif
 
     if (fd >= 0) {
       bool diskok = true;
@@ -667,6 +760,8 @@ CacheProcessor::start_internal(int flags)
           gdisks[gndisks]->read_only_p = true;
         }
         gdisks[gndisks]->forced_volume_num = sd->forced_volume_num;
+        gdisks[gndisks]->fast_tier         = sd->fast_tier;
+        gdisks[gndisks]->direct_io         = direct_io;
         if (sd->hash_base_string) {
           gdisks[gndisks]->hash_base_string = ats_strdup(sd->hash_base_string);
         }
@@ -691,7 +786,7 @@ CacheProcessor::start_internal(int flags)
         gdisks[gndisks]->open(path, blocks, skip, sector_size, fd, clear);
 #endif
 
-        Debug("cache_hosting", "Disk: %d:%s, blocks: %" PRId64 "", gndisks, path, blocks);
+        Debug("cache_hosting", "Disk: %d:%s, blocks: %" PRId64 ", direct I/O: %s", gndisks, path, blocks, direct_io ? "yes" : "no");
         fd = -1;
         gndisks++;
       }
@@ -802,6 +897,18 @@ CacheProcessor::diskInitialized()
       char vol_stat_str_prefix[256];
       snprintf(vol_stat_str_prefix, sizeof(vol_stat_str_prefix), "proxy.process.cache.volume_%d", cp->vol_number);
       register_cache_stats(cp->vol_rsb, vol_stat_str_prefix);
+
+      cp->compression = cache_config_compress;
+      for (ConfigVol *config_vol = config_volumes.cp_queue.head; config_vol; config_vol = config_vol->link.next) {
+        if (config_vol->number == cp->vol_number && config_vol->compression >= 0) {
+          cp->compression = config_vol->compression;
+        }
+      }
+      if (!cache_compression_available(cp->compression)) {
+        Warning("compression %d is not available for volume %d, the fragments are stored uncompressed", cp->compression,
+                cp->vol_number);
+        cp->compression = CACHE_COMPRESSION_NONE;
+      }
     }
   }
 
@@ -855,10 +962,8 @@ CacheProcessor::cacheInitialized()
   int64_t total_size             = 0; // count in HTTP & MIXT
   uint64_t total_cache_bytes     = 0; // bytes that can used in total_size
   uint64_t total_direntries      = 0; // all the direntries in the cache
-  uint64_t used_direntries       = 0; //   and used
   uint64_t vol_total_cache_bytes = 0;
   uint64_t vol_total_direntries  = 0;
-  uint64_t vol_used_direntries   = 0;
   Vol *vol;
 
   ProxyMutex *mutex = this_ethread()->mutex.get();
@@ -878,65 +983,61 @@ CacheProcessor::cacheInitialized()
     }
   }
 
-  // Update stripe version data.
-  if (gnvol) { // start with whatever the first stripe is.
-    cacheProcessor.min_stripe_version = cacheProcessor.max_stripe_version = gvol[0]->header->version;
-  }
-  // scan the rest of the stripes.
-  for (i = 1; i < gnvol; i++) {
-    Vol *v = gvol[i];
-    if (v->header->version < cacheProcessor.min_stripe_version) {
-      cacheProcessor.min_stripe_version = v->header->version;
-    }
-    if (cacheProcessor.max_stripe_version < v->header->version) {
-      cacheProcessor.max_stripe_version = v->header->version;
-    }
-  }
-
   if (caches_ready) {
-    Debug("cache_init", "CacheProcessor::cacheInitialized - caches_ready=0x%0X, gnvol=%d", (unsigned int)caches_ready,
-          gnvol.load());
-
-    int64_t ram_cache_bytes = 0;
-
-    if (gnvol) {
+    // All the stripes get their RAM cache now, including the ones still loading when serving while recovering.
+    int nvol   = theCache ? theCache->total_nvol : 0;
+    Vol **vols = theCache ? theCache->vols : nullptr;
+    Debug("cache_init", "CacheProcessor::cacheInitialized - caches_ready=0x%0X, nvol=%d", (unsigned int)caches_ready, nvol);
+
+    int64_t ram_cache_bytes        = 0;
+    int64_t shared_ram_cache_bytes = 0;
+    RamCache *shared_ram_cache     = nullptr;
+
+    if (nvol) {
+      if (cache_config_ram_cache_shared) {
+        shared_ram_cache = new_RamCacheShared(cache_config_ram_cache_algorithm, cache_config_ram_cache_shards);
+      }
       // new ram_caches, with algorithm from the config
-      for (i = 0; i < gnvol; i++) {
+      for (i = 0; i < nvol; i++) {
+        if (shared_ram_cache) {
+          vols[i]->ram_cache = shared_ram_cache;
+          continue;
+        }
         switch (cache_config_ram_cache_algorithm) {
         default:
         case RAM_CACHE_ALGORITHM_CLFUS:
-          gvol[i]->ram_cache = new_RamCacheCLFUS();
+          vols[i]->ram_cache = new_RamCacheCLFUS();
           break;
         case RAM_CACHE_ALGORITHM_LRU:
-          gvol[i]->ram_cache = new_RamCacheLRU();
+          vols[i]->ram_cache = new_RamCacheLRU();
           break;
         }
       }
       // let us calculate the Size
       if (cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE) {
         Debug("cache_init", "CacheProcessor::cacheInitialized - cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE");
-        for (i = 0; i < gnvol; i++) {
-          vol = gvol[i];
-          gvol[i]->ram_cache->init(vol->dirlen() * DEFAULT_RAM_CACHE_MULTIPLIER, vol);
-          ram_cache_bytes += gvol[i]->dirlen();
+        for (i = 0; i < nvol; i++) {
+          vol = vols[i];
+          if (shared_ram_cache) {
+            shared_ram_cache_bytes += vol->dirlen() * DEFAULT_RAM_CACHE_MULTIPLIER;
+          } else {
+            vols[i]->ram_cache->init(vol->dirlen() * DEFAULT_RAM_CACHE_MULTIPLIER, vol);
+            CACHE_VOL_SUM_DYN_STAT(cache_ram_cache_bytes_total_stat, (int64_t)vols[i]->dirlen());
+          }
+          ram_cache_bytes += vols[i]->dirlen();
           Debug("cache_init", "CacheProcessor::cacheInitialized - ram_cache_bytes = %" PRId64 " = %" PRId64 "Mb", ram_cache_bytes,
                 ram_cache_bytes / (1024 * 1024));
-          CACHE_VOL_SUM_DYN_STAT(cache_ram_cache_bytes_total_stat, (int64_t)gvol[i]->dirlen());
 
-          vol_total_cache_bytes = gvol[i]->len - gvol[i]->dirlen();
+          vol_total_cache_bytes = vols[i]->len - vols[i]->dirlen();
           total_cache_bytes += vol_total_cache_bytes;
           Debug("cache_init", "CacheProcessor::cacheInitialized - total_cache_bytes = %" PRId64 " = %" PRId64 "Mb",
                 total_cache_bytes, total_cache_bytes / (1024 * 1024));
 
           CACHE_VOL_SUM_DYN_STAT(cache_bytes_total_stat, vol_total_cache_bytes);
 
-          vol_total_direntries = gvol[i]->buckets * gvol[i]->segments * DIR_DEPTH;
+          vol_total_direntries = vols[i]->buckets * vols[i]->segments * DIR_DEPTH;
           total_direntries += vol_total_direntries;
           CACHE_VOL_SUM_DYN_STAT(cache_direntries_total_stat, vol_total_direntries);
-
-          vol_used_direntries = dir_entries_used(gvol[i]);
-          CACHE_VOL_SUM_DYN_STAT(cache_direntries_used_stat, vol_used_direntries);
-          used_direntries += vol_used_direntries;
         }
 
       } else {
@@ -956,36 +1057,42 @@ CacheProcessor::cacheInitialized()
         Debug("ram_cache", "config: size = %" PRId64 ", cutoff = %" PRId64 "", cache_config_ram_cache_size,
               cache_config_ram_cache_cutoff);
 
-        for (i = 0; i < gnvol; i++) {
-          vol = gvol[i];
+        for (i = 0; i < nvol; i++) {
+          vol = vols[i];
           double factor;
-          if (gvol[i]->cache == theCache) {
-            ink_assert(gvol[i]->cache != nullptr);
-            factor = (double)(int64_t)(gvol[i]->len >> STORE_BLOCK_SHIFT) / (int64_t)theCache->cache_size;
+          if (vols[i]->cache == theCache) {
+            ink_assert(vols[i]->cache != nullptr);
+            factor = (double)(int64_t)(vols[i]->len >> STORE_BLOCK_SHIFT) / (int64_t)theCache->cache_size;
             Debug("cache_init", "CacheProcessor::cacheInitialized - factor = %f", factor);
-            gvol[i]->ram_cache->init((int64_t)(http_ram_cache_size * factor), vol);
+            if (shared_ram_cache) {
+              shared_ram_cache_bytes += (int64_t)(http_ram_cache_size * factor);
+            } else {
+              vols[i]->ram_cache->init((int64_t)(http_ram_cache_size * factor), vol);
+              CACHE_VOL_SUM_DYN_STAT(cache_ram_cache_bytes_total_stat, (int64_t)(http_ram_cache_size * factor));
+            }
             ram_cache_bytes += (int64_t)(http_ram_cache_size * factor);
-            CACHE_VOL_SUM_DYN_STAT(cache_ram_cache_bytes_total_stat, (int64_t)(http_ram_cache_size * factor));
           } else {
             ink_release_assert(!"Unexpected non-HTTP cache volume");
           }
           Debug("cache_init", "CacheProcessor::cacheInitialized[%d] - ram_cache_bytes = %" PRId64 " = %" PRId64 "Mb", i,
                 ram_cache_bytes, ram_cache_bytes / (1024 * 1024));
-          vol_total_cache_bytes = gvol[i]->len - gvol[i]->dirlen();
+          vol_total_cache_bytes = vols[i]->len - vols[i]->dirlen();
           total_cache_bytes += vol_total_cache_bytes;
           CACHE_VOL_SUM_DYN_STAT(cache_bytes_total_stat, vol_total_cache_bytes);
           Debug("cache_init", "CacheProcessor::cacheInitialized - total_cache_bytes = %" PRId64 " = %" PRId64 "Mb",
                 total_cache_bytes, total_cache_bytes / (1024 * 1024));
 
-          vol_total_direntries = gvol[i]->buckets * gvol[i]->segments * DIR_DEPTH;
+          vol_total_direntries = vols[i]->buckets * vols[i]->segments * DIR_DEPTH;
           total_direntries += vol_total_direntries;
           CACHE_VOL_SUM_DYN_STAT(cache_direntries_total_stat, vol_total_direntries);
-
-          vol_used_direntries = dir_entries_used(gvol[i]);
-          CACHE_VOL_SUM_DYN_STAT(cache_direntries_used_stat, vol_used_direntries);
-          used_direntries += vol_used_direntries;
         }
       }
+      if (shared_ram_cache) {
+        // one budget for all the stripes, the per stripe RAM cache stats are not maintained
+        Debug("cache_init", "CacheProcessor::cacheInitialized - shared_ram_cache_bytes = %" PRId64 " = %" PRId64 "Mb",
+              shared_ram_cache_bytes, shared_ram_cache_bytes / (1024 * 1024));
+        shared_ram_cache->init(shared_ram_cache_bytes, nullptr);
+      }
       switch (cache_config_ram_cache_compress) {
       default:
         Fatal("unknown RAM cache compression type: %d", cache_config_ram_cache_compress);
@@ -1000,6 +1107,16 @@ CacheProcessor::cacheInitialized()
       case CACHE_COMPRESSION_LIBLZMA:
 #ifndef HAVE_LZMA_H
         Fatal("lzma not available for RAM cache compression");
+#endif
+        break;
+      case CACHE_COMPRESSION_ZSTD:
+#ifndef HAVE_ZSTD_H
+        Fatal("zstd not available for RAM cache compression");
+#endif
+        break;
+      case CACHE_COMPRESSION_LZ4:
+#ifndef HAVE_LZ4_H
+        Fatal("lz4 not available for RAM cache compression");
 #endif
         break;
       }
@@ -1007,9 +1124,9 @@ CacheProcessor::cacheInitialized()
       GLOBAL_CACHE_SET_DYN_STAT(cache_ram_cache_bytes_total_stat, ram_cache_bytes);
       GLOBAL_CACHE_SET_DYN_STAT(cache_bytes_total_stat, total_cache_bytes);
       GLOBAL_CACHE_SET_DYN_STAT(cache_direntries_total_stat, total_direntries);
-      GLOBAL_CACHE_SET_DYN_STAT(cache_direntries_used_stat, used_direntries);
       if (!check) {
         dir_sync_init();
+        disk_health_init();
       }
       cache_init_ok = 1;
     } else {
@@ -1187,6 +1304,7 @@ vol_clear_init(Vol *d)
   d->header->cycle                                        = 0;
   d->header->create_time                                  = time(nullptr);
   d->header->dirty                                        = 0;
+  d->header->key_hash                                     = cache_config_key_hash;
   d->sector_size = d->header->sector_size = d->disk->hw_sector_size;
   *d->footer                              = *d->header;
 }
@@ -1223,6 +1341,13 @@ Vol::clear_dir()
   return 0;
 }
 
+// Hits in the window of a fast tier stripe demote the object to the capacity tier.
+int
+Vol::hit_evacuate_percent() const
+{
+  return disk->fast_tier ? cache_config_tier_demote_percent : cache_config_hit_evacuate_percent;
+}
+
 int
 Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
 {
@@ -1247,7 +1372,7 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
   start = dir_skip;
   vol_init_data(this);
   data_blocks         = (len - (start - skip)) / STORE_BLOCK_SIZE;
-  hit_evacuate_window = (data_blocks * cache_config_hit_evacuate_percent) / 100;
+  hit_evacuate_window = (data_blocks * hit_evacuate_percent()) / 100;
 
   evacuate_size = (int)(len / EVACUATION_BUCKET_SIZE) + 2;
   int evac_len  = (int)evacuate_size * sizeof(DLL<EvacuationBlock>);
@@ -1269,7 +1394,16 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
   header = (VolHeaderFooter *)raw_dir;
   footer = (VolHeaderFooter *)(raw_dir + this->dirlen() - ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter)));
 
-  if (clear) {
+  load_clear = clear;
+  return 0;
+}
+
+// Read (or clear) the directory set up by init(), the stripe goes online in dir_init_done().
+int
+Vol::load()
+{
+  load_start = Thread::get_hrtime_updated();
+  if (load_clear) {
     Note("clearing cache directory '%s'", hash_text.get());
     return clear_dir();
   }
@@ -1360,9 +1494,17 @@ Vol::handle_dir_read(int event, void *data)
     clear_dir();
     return EVENT_DONE;
   }
+  // the keys would not be found with another hash, and could collide with the new keys
+  if (header->key_hash != static_cast<uint32_t>(cache_config_key_hash)) {
+    Note("cache directory '%s' was written with key hash %u, clearing for key hash %d", hash_text.get(), header->key_hash,
+         cache_config_key_hash);
+    clear_dir();
+    return EVENT_DONE;
+  }
   CHECK_DIR(this);
 
-  sector_size = header->sector_size;
+  sector_size   = header->sector_size;
+  recover_start = Thread::get_hrtime_updated();
 
   return this->recover_data();
 
@@ -1756,14 +1898,13 @@ Vol::dir_init_done(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
     eventProcessor.schedule_in(this, HRTIME_MSECONDS(5), ET_CALL);
     return EVENT_CONT;
   } else {
-    int vol_no = gnvol++;
-    ink_assert(!gvol[vol_no]);
-    gvol[vol_no] = this;
     SET_HANDLER(&Vol::aggWrite);
-    if (fd == -1) {
-      cache->vol_initialized(false);
-    } else {
-      cache->vol_initialized(true);
+    Vol *next = load_next;
+    load_next = nullptr;
+    cache->vol_initialized(this, fd != -1);
+    // the next stripe of the lane starts once this one is online
+    if (next) {
+      eventProcessor.schedule_imm(new VolInit(next));
     }
     return EVENT_DONE;
   }
@@ -1791,8 +1932,26 @@ cmprtable(const void *aa, const void *bb)
   return 0;
 }
 
-void
-build_vol_hash_table(CacheHostRecord *cp)
+// Stripe selection of make_vol_hash_table, a record which is not tiered uses all its stripes.
+enum { VOL_TIER_ANY, VOL_TIER_CAPACITY, VOL_TIER_FAST };
+
+// Percent of its share of the hash table a stripe keeps. A slow disk gives up a part of it only if the lookups of
+// the objects it holds may move with their writes.
+static int
+vol_hash_share(const Vol *vol)
+{
+  return cache_config_disk_latency_move_lookups ? vol->disk->hash_share : 100;
+}
+
+// Size of the stripe in the hash table, less the part its disk gave up for being slow.
+static uint64_t
+vol_hash_blocks(const Vol *vol)
+{
+  return (vol->len >> STORE_BLOCK_SHIFT) * vol_hash_share(vol) / 100;
+}
+
+static unsigned short *
+make_vol_hash_table(CacheHostRecord *cp, int tier)
 {
   int num_vols          = cp->num_vols;
   unsigned int *mapping = (unsigned int *)ats_malloc(sizeof(unsigned int) * num_vols);
@@ -1806,41 +1965,37 @@ build_vol_hash_table(CacheHostRecord *cp)
   uint64_t used  = 0;
   // initialize number of elements per vol
   for (int i = 0; i < num_vols; i++) {
-    if (DISK_BAD(cp->vols[i]->disk)) {
+    if (DISK_BAD(cp->vols[i]->disk) || (tier != VOL_TIER_ANY && cp->vols[i]->disk->fast_tier != (tier == VOL_TIER_FAST))) {
       bad_vols++;
       continue;
     }
     mapping[map] = i;
     p[map++]     = cp->vols[i];
-    total += (cp->vols[i]->len >> STORE_BLOCK_SHIFT);
+    total += vol_hash_blocks(cp->vols[i]);
   }
 
   num_vols -= bad_vols;
 
   if (!num_vols || !total) {
     // all the disks are corrupt,
-    if (cp->vol_hash_table) {
-      new_Freer(cp->vol_hash_table, CACHE_MEM_FREE_TIMEOUT);
-    }
-    cp->vol_hash_table = nullptr;
     ats_free(mapping);
     ats_free(p);
-    return;
+    return nullptr;
   }
 
-  unsigned int *forvol   = (unsigned int *)ats_malloc(sizeof(unsigned int) * num_vols);
-  unsigned int *gotvol   = (unsigned int *)ats_malloc(sizeof(unsigned int) * num_vols);
-  unsigned int *rnd      = (unsigned int *)ats_malloc(sizeof(unsigned int) * num_vols);
-  unsigned short *ttable = (unsigned short *)ats_malloc(sizeof(unsigned short) * VOL_HASH_TABLE_SIZE);
-  unsigned short *old_table;
+  unsigned int *forvol         = (unsigned int *)ats_malloc(sizeof(unsigned int) * num_vols);
+  unsigned int *gotvol         = (unsigned int *)ats_malloc(sizeof(unsigned int) * num_vols);
+  unsigned int *rnd            = (unsigned int *)ats_malloc(sizeof(unsigned int) * num_vols);
+  unsigned short *ttable       = (unsigned short *)ats_malloc(sizeof(unsigned short) * VOL_HASH_TABLE_SIZE);
   unsigned int *rtable_entries = (unsigned int *)ats_malloc(sizeof(unsigned int) * num_vols);
   unsigned int rtable_size     = 0;
-
   // estimate allocation
   for (int i = 0; i < num_vols; i++) {
-    forvol[i] = (VOL_HASH_TABLE_SIZE * (p[i]->len >> STORE_BLOCK_SHIFT)) / total;
+    forvol[i] = (VOL_HASH_TABLE_SIZE * vol_hash_blocks(p[i])) / total;
     used += forvol[i];
-    rtable_entries[i] = p[i]->len / VOL_HASH_ALLOC_SIZE;
+    // the points of a stripe are always drawn in the same order, so a smaller share drops only its last points
+    // and the buckets given up by a slow disk are the only ones which move
+    rtable_entries[i] = std::max<int64_t>(1, p[i]->len / VOL_HASH_ALLOC_SIZE * vol_hash_share(p[i]) / 100);
     rtable_size += rtable_entries[i];
     gotvol[i] = 0;
   }
@@ -1884,11 +2039,8 @@ build_vol_hash_table(CacheHostRecord *cp)
     gotvol[rtable[i].idx]++;
   }
   for (int i = 0; i < num_vols; i++) {
-    Debug("cache_init", "build_vol_hash_table index %d mapped to %d requested %d got %d", i, mapping[i], forvol[i], gotvol[i]);
-  }
-  // install new table
-  if (nullptr != (old_table = ink_atomic_swap(&(cp->vol_hash_table), ttable))) {
-    new_Freer(old_table, CACHE_MEM_FREE_TIMEOUT);
+    Debug("cache_init", "build_vol_hash_table %s index %d mapped to %d requested %d got %d",
+          tier == VOL_TIER_FAST ? "fast" : "capacity", i, mapping[i], forvol[i], gotvol[i]);
   }
   ats_free(mapping);
   ats_free(p);
@@ -1897,16 +2049,78 @@ build_vol_hash_table(CacheHostRecord *cp)
   ats_free(rnd);
   ats_free(rtable_entries);
   ats_free(rtable);
+  return ttable;
 }
 
+static void
+install_vol_hash_table(unsigned short **slot, unsigned short *table)
+{
+  unsigned short *old_table;
+  if (nullptr != (old_table = ink_atomic_swap(slot, table))) {
+    new_Freer(old_table, CACHE_MEM_FREE_TIMEOUT);
+  }
+}
+
+void
+build_vol_hash_table(CacheHostRecord *cp)
+{
+  // With stripes in both tiers keys map to a capacity stripe, where they are written, and a fast stripe.
+  int fast = 0, capacity = 0;
+  for (int i = 0; i < cp->num_vols; i++) {
+    if (!DISK_BAD(cp->vols[i]->disk)) {
+      ++(cp->vols[i]->disk->fast_tier ? fast : capacity);
+    }
+  }
+  bool tiered = fast && capacity;
+  install_vol_hash_table(&cp->vol_hash_table, make_vol_hash_table(cp, tiered ? VOL_TIER_CAPACITY : VOL_TIER_ANY));
+  install_vol_hash_table(&cp->fast_vol_hash_table, tiered ? make_vol_hash_table(cp, VOL_TIER_FAST) : nullptr);
+}
+
+// Serializes stripes going online, gvol is read without a lock.
+static std::mutex vol_online_mutex;
+
 void
-Cache::vol_initialized(bool result)
+Cache::vol_initialized(Vol *vol, bool result)
 {
+  ink_hrtime now = Thread::get_hrtime_updated();
+  int64_t used   = dir_entries_used(vol);
+
+  {
+    std::lock_guard<std::mutex> lock(vol_online_mutex);
+    if (gnvol == 0 || vol->header->version < cacheProcessor.min_stripe_version) {
+      cacheProcessor.min_stripe_version = vol->header->version;
+    }
+    if (gnvol == 0 || cacheProcessor.max_stripe_version < vol->header->version) {
+      cacheProcessor.max_stripe_version = vol->header->version;
+    }
+    ink_assert(!gvol[gnvol]);
+    gvol[gnvol] = vol;
+    ++gnvol;
+  }
+
+  RecIncrGlobalRawStatSum(cache_rsb, cache_direntries_used_stat, used);
+  RecIncrGlobalRawStatSum(vol->cache_vol->vol_rsb, cache_direntries_used_stat, used);
+  RecIncrGlobalRawStat(cache_rsb, cache_stripe_loading_stat, -1);
+  RecIncrGlobalRawStat(cache_rsb, cache_stripe_online_stat, 1);
+  // A record per stripe could fill the records table, the stripes are counted by the stats and logged here.
+  Note("cache stripe %d '%s' %s in %" PRId64 " ms, %" PRId64 " ms of recovery", vol->stripe_index, vol->hash_text.get(),
+       result ? "online" : "failed", ink_hrtime_to_msec(now - vol->load_start),
+       vol->recover_start ? ink_hrtime_to_msec(now - vol->recover_start) : 0);
+  vol->load_done = now;
+  vol->online    = true;
+
   if (result) {
-    ink_atomic_increment(&total_good_nvol, 1);
+    // The first good stripe enables the cache when serving while the other stripes recover.
+    if (ink_atomic_increment(&total_good_nvol, 1) == 0 && cache_config_init_serve_while_recovering) {
+      ink_atomic_increment(&total_initialized_vol, 1);
+      open_done();
+      return;
+    }
   }
   if (total_nvol == ink_atomic_increment(&total_initialized_vol, 1) + 1) {
-    open_done();
+    if (!cache_config_init_serve_while_recovering || total_good_nvol == 0) {
+      open_done();
+    }
   }
 }
 
@@ -1933,11 +2147,14 @@ CacheProcessor::mark_storage_offline(CacheDisk *d, ///< Target disk
     SET_DISK_BAD(d);
   }
 
-  for (p = 0; p < gnvol; p++) {
-    if (d->fd == gvol[p]->fd) {
-      total_dir_delete += gvol[p]->buckets * gvol[p]->segments * DIR_DEPTH;
-      used_dir_delete += dir_entries_used(gvol[p]);
-      total_bytes_delete += gvol[p]->len - gvol[p]->dirlen();
+  for (p = 0; theCache && p < theCache->total_nvol; p++) {
+    Vol *vol = theCache->vols[p];
+    if (d->fd == vol->fd) {
+      total_dir_delete += vol->buckets * vol->segments * DIR_DEPTH;
+      if (vol->online) {
+        used_dir_delete += dir_entries_used(vol);
+      }
+      total_bytes_delete += vol->len - vol->dirlen();
     }
   }
 
@@ -2068,6 +2285,22 @@ Cache::open(bool clear, bool /* fix ATS_UNUSED */)
 
   CacheVol *cp = cp_list.head;
   for (; cp; cp = cp->link.next) {
+    if (cp->scheme == scheme) {
+      total_nvol += cp->num_vols;
+    }
+  }
+  vols       = (Vol **)ats_malloc(std::max(total_nvol, 1) * sizeof(Vol *));
+  total_nvol = 0;
+
+  // Set up all the stripes first so the host table can be built before they are loaded. Only the first
+  // proxy.config.cache.init.stripes_per_disk stripes of a disk start loading, each of the others waits
+  // for a stripe of the same disk to finish.
+  int per_disk = cache_config_init_stripes_per_disk;
+  Vol **disk_lanes =
+    per_disk > 0 ? static_cast<Vol **>(ats_calloc(static_cast<size_t>(gndisks) * per_disk, sizeof(Vol *))) : nullptr;
+  int *disk_loading = static_cast<int *>(ats_calloc(std::max(gndisks, 1), sizeof(int)));
+
+  for (cp = cp_list.head; cp; cp = cp->link.next) {
     if (cp->scheme == scheme) {
       cp->vols   = (Vol **)ats_malloc(cp->num_vols * sizeof(Vol *));
       int vol_no = 0;
@@ -2075,28 +2308,40 @@ Cache::open(bool clear, bool /* fix ATS_UNUSED */)
         if (cp->disk_vols[i] && !DISK_BAD(cp->disk_vols[i]->disk)) {
           DiskVolBlockQueue *q = cp->disk_vols[i]->dpb_queue.head;
           for (; q; q = q->link.next) {
-            cp->vols[vol_no]            = new Vol();
-            CacheDisk *d                = cp->disk_vols[i]->disk;
-            cp->vols[vol_no]->disk      = d;
-            cp->vols[vol_no]->fd        = d->fd;
-            cp->vols[vol_no]->cache     = this;
-            cp->vols[vol_no]->cache_vol = cp;
-            blocks                      = q->b->len;
-
-            bool vol_clear = clear || d->cleared || q->new_block;
-#if AIO_MODE == AIO_MODE_NATIVE
-            eventProcessor.schedule_imm(new VolInit(cp->vols[vol_no], d->path, blocks, q->b->offset, vol_clear));
-#else
-            cp->vols[vol_no]->init(d->path, blocks, q->b->offset, vol_clear);
-#endif
+            Vol *vol          = new Vol();
+            CacheDisk *d      = cp->disk_vols[i]->disk;
+            vol->disk         = d;
+            vol->fd           = d->fd;
+            vol->cache        = this;
+            vol->cache_vol    = cp;
+            vol->stripe_index = total_nvol;
+            blocks            = q->b->len;
+
+            vol->init(d->path, blocks, q->b->offset, clear || d->cleared || q->new_block);
+            RecIncrGlobalRawStat(cache_rsb, cache_stripe_loading_stat, 1);
+
+            if (!disk_lanes || disk_loading[i] < per_disk) {
+              eventProcessor.schedule_imm(new VolInit(vol));
+            } else {
+              disk_lanes[i * per_disk + disk_loading[i] % per_disk]->load_next = vol;
+            }
+            if (disk_lanes) {
+              disk_lanes[i * per_disk + disk_loading[i] % per_disk] = vol;
+            }
+            disk_loading[i]++;
+
+            cp->vols[vol_no]   = vol;
+            vols[total_nvol++] = vol;
             vol_no++;
             cache_size += blocks;
           }
         }
       }
-      total_nvol += vol_no;
     }
   }
+  ats_free(disk_lanes);
+  ats_free(disk_loading);
+
   if (total_nvol == 0) {
     return open_done();
   }
@@ -2230,15 +2475,68 @@ upgrade_doc_version(Ptr<IOBufferData> &buf)
       n_doc->doc_type = CACHE_FRAG_TYPE_HTTP; // We converted so adjust doc_type.
       // Set these to zero for debugging - they'll be updated to the current values if/when this is
       // put in the aggregation buffer.
-      n_doc->v_major = 0;
-      n_doc->v_minor = 0;
-      n_doc->unused  = 0; // force to zero to make future use easier.
+      n_doc->v_major     = 0;
+      n_doc->v_minor     = 0;
+      n_doc->compression = CACHE_COMPRESSION_NONE;
     }
   }
   return zret;
 }
 
 // [amc] I think this is where all disk reads from cache funnel through here.
+// Check the response of the alternate, compressed content is not worth compressing again in the RAM cache.
+static bool
+ram_cache_compressible(CacheHTTPInfo *alternate)
+{
+  if (!cache_config_ram_cache_compress || !alternate->valid()) {
+    return true;
+  }
+  HTTPHdr *response = alternate->response_get();
+  int len           = 0;
+  const char *value = response->value_get(MIME_FIELD_CONTENT_ENCODING, MIME_LEN_CONTENT_ENCODING, &len);
+  if (value && !(len == 8 && strncasecmp(value, "identity", 8) == 0)) {
+    return false;
+  }
+  if ((value = response->value_get(MIME_FIELD_CONTENT_TYPE, MIME_LEN_CONTENT_TYPE, &len)) != nullptr) {
+    for (auto const &type : ram_cache_compress_skip_types) {
+      if (static_cast<size_t>(len) >= type.size() && strncasecmp(value, type.data(), type.size()) == 0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// The head fragment holds the headers of all the alternates and the body of a single fragment
+// object, it is worth compressing unless none of the alternates is.
+static bool
+ram_cache_head_compressible(Doc *doc)
+{
+  if (!cache_config_ram_cache_compress || ts::VersionNumber(doc->v_major, doc->v_minor) < CACHE_DB_VERSION) {
+    return true;
+  }
+  // the headers are put in the RAM cache marshaled, look at a copy of them
+  char *b = static_cast<char *>(ats_malloc(doc->hlen));
+  memcpy(b, doc->hdr(), doc->hlen);
+  Ptr<IOBufferData> hdrs(new_xmalloc_IOBufferData(b, doc->hlen));
+  hdrs->_mem_type = DEFAULT_ALLOC;
+
+  CacheHTTPInfo info;
+  bool compressible = false;
+  for (int len = doc->hlen; len > static_cast<int>(sizeof(HTTPCacheAlt)) && !compressible;) {
+    int r = HTTPInfo::unmarshal(b, len, hdrs.get());
+    if (r < 0) {
+      return true;
+    }
+    info.m_alt   = reinterpret_cast<HTTPCacheAlt *>(b);
+    compressible = ram_cache_compressible(&info);
+    len -= r;
+    b += r;
+  }
+  info.clear();
+  return compressible;
+}
+
 int
 CacheVC::handleReadDone(int event, Event *e)
 {
@@ -2248,6 +2546,10 @@ CacheVC::handleReadDone(int event, Event *e)
   Doc *doc = nullptr;
   if (event == AIO_EVENT_DONE) {
     set_io_not_in_progress();
+    if (io_start) {
+      vol->disk->io_done(io_start);
+      io_start = 0;
+    }
   } else if (is_io_in_progress()) {
     return EVENT_CONT;
   }
@@ -2342,6 +2644,17 @@ CacheVC::handleReadDone(int event, Event *e)
           okay       = 0;
         }
       }
+      if (okay && doc->compression != CACHE_COMPRESSION_NONE) {
+        if (cache_decompress_doc(buf)) {
+          doc = reinterpret_cast<Doc *>(buf->data());
+        } else {
+          Note("cache: decompression error for [%" PRIu64 " %" PRIu64 "] len %d, hlen %d, disk %s, offset %" PRIu64,
+               doc->first_key.b[0], doc->first_key.b[1], doc->len, doc->hlen, vol->path, (uint64_t)io.aiocb.aio_offset);
+          CACHE_INCREMENT_DYN_STAT(cache_compress_errors_stat);
+          doc->magic = DOC_CORRUPT;
+          okay       = 0;
+        }
+      }
       (void)e; // Avoid compiler warnings
       bool http_copy_hdr = false;
       http_copy_hdr =
@@ -2364,7 +2677,10 @@ CacheVC::handleReadDone(int event, Event *e)
                         (doc_len && (int64_t)doc_len < cache_config_ram_cache_cutoff) || !cache_config_ram_cache_cutoff);
         if (cutoff_check && !f.doc_from_ram_cache) {
           uint64_t o = dir_offset(&dir);
-          vol->ram_cache->put(read_key, buf.get(), doc->len, http_copy_hdr, (uint32_t)(o >> 32), (uint32_t)o);
+          // the alternate is known when reading the fragments after the first one
+          bool compressible = doc->doc_type != CACHE_FRAG_TYPE_HTTP ||
+                              (doc->hlen ? ram_cache_head_compressible(doc) : ram_cache_compressible(&alternate));
+          vol->ram_cache->put(read_key, buf.get(), doc->len, http_copy_hdr, (uint32_t)(o >> 32), (uint32_t)o, compressible);
         }
         if (!doc_len) {
           // keep a pointer to it. In case the state machine decides to
@@ -2410,7 +2726,7 @@ CacheVC::handleRead(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   // see if its in the aggregation buffer
   if (dir_agg_buf_valid(vol, &dir)) {
     int agg_offset = vol->vol_offset(&dir) - vol->header->write_pos;
-    buf            = new_IOBufferData(iobuffer_size_to_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+    buf            = new_sized_IOBufferData(io.aiocb.aio_nbytes, MEMALIGNED);
     ink_assert((agg_offset + io.aiocb.aio_nbytes) <= (unsigned)vol->agg_buf_pos);
     char *doc = buf->data();
     char *agg = vol->agg_buffer + agg_offset;
@@ -2419,19 +2735,29 @@ CacheVC::handleRead(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
     SET_HANDLER(&CacheVC::handleReadDone);
     return EVENT_RETURN;
   }
+  // see if it was read ahead
+  if (read_ahead.head) {
+    if (CacheReadAheadIO *ra = read_ahead_find()) {
+      return read_ahead_take(ra);
+    }
+  }
 
   io.aiocb.aio_fildes = vol->fd;
   io.aiocb.aio_offset = vol->vol_offset(&dir);
   if ((off_t)(io.aiocb.aio_offset + io.aiocb.aio_nbytes) > (off_t)(vol->skip + vol->len)) {
     io.aiocb.aio_nbytes = vol->skip + vol->len - io.aiocb.aio_offset;
   }
-  buf              = new_IOBufferData(iobuffer_size_to_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+  // fragments are written in whole sectors, which O_DIRECT reads require
+  ink_assert(!vol->disk->direct_io || !((io.aiocb.aio_offset | io.aiocb.aio_nbytes) & (vol->sector_size - 1)));
+  buf              = new_sized_IOBufferData(io.aiocb.aio_nbytes, MEMALIGNED);
   io.aiocb.aio_buf = buf->data();
   io.action        = this;
   io.thread        = mutex->thread_holding->tt == DEDICATED ? AIO_CALLBACK_THREAD_ANY : mutex->thread_holding;
+  io_start         = cache_config_disk_latency_slow_factor ? Thread::get_hrtime_updated() : 0;
   SET_HANDLER(&CacheVC::handleReadDone);
   ink_assert(ink_aio_read(&io) >= 0);
   CACHE_DEBUG_INCREMENT_DYN_STAT(cache_pread_count_stat);
+  read_ahead_fill(nullptr);
   return EVENT_CONT;
 
 LramHit : {
@@ -2458,7 +2784,17 @@ Cache::lookup(Continuation *cont, const CacheKey *key, CacheFragType type, const
     return ACTION_RESULT_DONE;
   }
 
-  Vol *vol          = key_to_vol(key, hostname, host_len);
+  Vol *vol = key_to_vol(key, hostname, host_len);
+  if (!vol->online) { // still loading, serving while recovering
+    cont->handleEvent(CACHE_EVENT_LOOKUP_FAILED, nullptr);
+    return ACTION_RESULT_DONE;
+  }
+  // the capacity tier may have overwritten an object which is still in the fast tier
+  Vol *tier_vol = key_to_fast_vol(key, hostname, host_len);
+  if (tier_vol) {
+    Dir result, *last_collision = nullptr;
+    cache_tier_probe(*key, vol, tier_vol, &result, &last_collision);
+  }
   ProxyMutex *mutex = cont->mutex.get();
   CacheVC *c        = new_CacheVC(cont);
   SET_CONTINUATION_HANDLER(c, &CacheVC::openReadStartHead);
@@ -2469,6 +2805,7 @@ Cache::lookup(Continuation *cont, const CacheKey *key, CacheFragType type, const
   c->frag_type          = type;
   c->f.lookup           = 1;
   c->vol                = vol;
+  c->tier_vol           = tier_vol;
   c->last_collision     = nullptr;
 
   if (c->handleEvent(EVENT_INTERVAL, nullptr) == EVENT_CONT) {
@@ -2570,6 +2907,18 @@ Cache::remove(Continuation *cont, const CacheKey *key, CacheFragType type, const
     return ACTION_RESULT_DONE;
   }
 
+  Vol *vol = key_to_vol(key, hostname, host_len);
+  if (!vol->online) {
+    if (cont) {
+      cont->handleEvent(CACHE_EVENT_REMOVE_FAILED, nullptr);
+    }
+    return ACTION_RESULT_DONE;
+  }
+
+  if (Vol *fast_vol = key_to_fast_vol(key, hostname, host_len)) {
+    cache_tier_invalidate(fast_vol, *key);
+  }
+
   Ptr<ProxyMutex> mutex;
   if (!cont) {
     cont = new_CacheRemoveCont();
@@ -2577,7 +2926,6 @@ Cache::remove(Continuation *cont, const CacheKey *key, CacheFragType type, const
 
   CACHE_TRY_LOCK(lock, cont->mutex, this_ethread());
   ink_assert(lock.is_locked());
-  Vol *vol = key_to_vol(key, hostname, host_len);
   // coverity[var_decl]
   Dir result;
   dir_clear(&result); // initialized here, set result empty so we can recognize missed lock
@@ -3047,6 +3395,107 @@ rebuild_host_table(Cache *cache)
   }
 }
 
+// Disk health
+//
+// The latency of each disk is compared with the median latency of the disks every few seconds. A disk
+// slower than proxy.config.cache.disk_latency.slow_factor times the median gives up half the aggregation
+// write backlog of its stripes until it catches up. With proxy.config.cache.disk_latency.move_lookups it
+// also gives up half its share of the volume hash tables, which moves the lookups of the keys it loses.
+
+#define DISK_HEALTH_PERIOD HRTIME_SECONDS(5)
+// The records table is small and shared with the plugins, only this many spans have their own metrics.
+#define DISK_HEALTH_MAX_SPAN_STATS 32
+
+static void
+disk_stat_name(char *buf, size_t size, int i, const char *name)
+{
+  snprintf(buf, size, "proxy.process.cache.span_%d.%s", i, name);
+}
+
+static void
+disk_stat_set(int i, const char *name, RecInt value)
+{
+  char stat_name[256];
+
+  if (i < DISK_HEALTH_MAX_SPAN_STATS) {
+    disk_stat_name(stat_name, sizeof(stat_name), i, name);
+    RecSetRecordInt(stat_name, value, REC_SOURCE_EXPLICIT);
+  }
+}
+
+struct CacheDiskHealth : public Continuation {
+  int
+  mainEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+  {
+    std::vector<int64_t> latencies;
+    for (int i = 0; i < gndisks; i++) {
+      if (!DISK_BAD(gdisks[i]) && gdisks[i]->online && gdisks[i]->io_count > 0) {
+        latencies.push_back(gdisks[i]->io_latency);
+      }
+    }
+    std::sort(latencies.begin(), latencies.end());
+    int64_t median = latencies.empty() ? 0 : latencies[(latencies.size() - 1) / 2];
+    bool changed   = false;
+
+    for (int i = 0; i < gndisks; i++) {
+      CacheDisk *d    = gdisks[i];
+      bool active     = d->io_count.exchange(0) > 0 && !DISK_BAD(d) && d->online;
+      int64_t latency = d->io_latency;
+      int share       = d->hash_share;
+
+      d->health     = !active || !median || latency <= median ? 100 : 100 * median / latency;
+      int64_t limit = std::max<int64_t>(median, cache_config_disk_latency_min) * cache_config_disk_latency_slow_factor;
+      if (active && median && latency > limit) {
+        share = std::max(share / 2, cache_config_disk_latency_min_share);
+      } else if (!active || !median || latency < limit / 2) {
+        share = std::min(share * 2, 100);
+      }
+      if (share != d->hash_share) {
+        Note("cache disk %s latency %" PRId64 " usecs, median %" PRId64 " usecs, hash share %d%% -> %d%%", d->path, latency, median,
+             d->hash_share, share);
+        d->hash_share = share;
+        changed       = true;
+      }
+
+      disk_stat_set(i, "health", d->health);
+      disk_stat_set(i, "latency", latency);
+      disk_stat_set(i, "hash_share", d->hash_share);
+    }
+
+    if (changed && cache_config_disk_latency_move_lookups && theCache && theCache->hosttable) {
+      rebuild_host_table(theCache);
+    }
+    return EVENT_CONT;
+  }
+
+  CacheDiskHealth() : Continuation(new_ProxyMutex()) { SET_HANDLER(&CacheDiskHealth::mainEvent); }
+};
+
+static void
+disk_health_init()
+{
+  char name[256];
+
+  if (!cache_config_disk_latency_slow_factor) {
+    return;
+  }
+  if (gndisks > DISK_HEALTH_MAX_SPAN_STATS) {
+    Warning("only the first %d of the %d cache spans have proxy.process.cache.span_N metrics", DISK_HEALTH_MAX_SPAN_STATS,
+            gndisks);
+  }
+  for (int i = 0; i < std::min(gndisks, DISK_HEALTH_MAX_SPAN_STATS); i++) {
+    disk_stat_name(name, sizeof(name), i, "path");
+    RecRegisterStatString(RECT_PROCESS, name, gdisks[i]->path, RECP_NON_PERSISTENT);
+    disk_stat_name(name, sizeof(name), i, "health");
+    RecRegisterStatInt(RECT_PROCESS, name, 100, RECP_NON_PERSISTENT);
+    disk_stat_name(name, sizeof(name), i, "latency");
+    RecRegisterStatInt(RECT_PROCESS, name, 0, RECP_NON_PERSISTENT);
+    disk_stat_name(name, sizeof(name), i, "hash_share");
+    RecRegisterStatInt(RECT_PROCESS, name, 100, RECP_NON_PERSISTENT);
+  }
+  eventProcessor.schedule_every(new CacheDiskHealth, DISK_HEALTH_PERIOD, ET_CALL);
+}
+
 // if generic_host_rec.vols == nullptr, what do we do???
 Vol *
 Cache::key_to_vol(const CacheKey *key, const char *hostname, int host_len)
@@ -3082,6 +3531,25 @@ Cache::key_to_vol(const CacheKey *key, const char *hostname, int host_len)
   }
 }
 
+// The fast tier stripe of @a key, nullptr unless its hosting record is tiered.
+Vol *
+Cache::key_to_fast_vol(const CacheKey *key, const char *hostname, int host_len)
+{
+  uint32_t h                = (key->slice32(2) >> DIR_TAG_WIDTH) % VOL_HASH_TABLE_SIZE;
+  CacheHostRecord *host_rec = &hosttable->gen_host_rec;
+
+  if (hosttable->m_numEntries > 0 && host_len) {
+    CacheHostResult res;
+    hosttable->Match(hostname, host_len, &res);
+    // same record as key_to_vol
+    if (res.record && res.record->vol_hash_table) {
+      host_rec = res.record;
+    }
+  }
+  unsigned short *hash_table = host_rec->fast_vol_hash_table;
+  return hash_table ? host_rec->vols[hash_table[h]] : nullptr;
+}
+
 static void
 reg_int(const char *str, int stat, RecRawStatBlock *rsb, const char *prefix, RecRawStatSyncCb sync_cb = RecRawStatSyncSum)
 {
@@ -3104,6 +3572,10 @@ register_cache_stats(RecRawStatBlock *rsb, const char *prefix)
   REG_INT("ram_cache.bytes_used", cache_ram_cache_bytes_stat);
   REG_INT("ram_cache.hits", cache_ram_cache_hits_stat);
   REG_INT("ram_cache.misses", cache_ram_cache_misses_stat);
+  REG_INT("ram_cache.compress.bytes_in", cache_ram_cache_compress_bytes_in_stat);
+  REG_INT("ram_cache.compress.bytes_out", cache_ram_cache_compress_bytes_out_stat);
+  REG_INT("ram_cache.compress.cpu_time", cache_ram_cache_compress_time_stat);
+  REG_INT("ram_cache.compress.skipped", cache_ram_cache_compress_skipped_stat);
   REG_INT("pread_count", cache_pread_count_stat);
   REG_INT("percent_full", cache_percent_full_stat);
   REG_INT("lookup.active", cache_lookup_active_stat);
@@ -3136,6 +3608,7 @@ register_cache_stats(RecRawStatBlock *rsb, const char *prefix)
   REG_INT("frags_per_doc.3+", cache_three_plus_plus_fragment_document_count_stat);
   REG_INT("read_busy.success", cache_read_busy_success_stat);
   REG_INT("read_busy.failure", cache_read_busy_failure_stat);
+  REG_INT("read_busy.coalesced", cache_read_busy_coalesced_stat);
   REG_INT("write_bytes_stat", cache_write_bytes_stat);
   REG_INT("vector_marshals", cache_hdr_vector_marshal_stat);
   REG_INT("hdr_marshals", cache_hdr_marshal_stat);
@@ -3151,6 +3624,34 @@ register_cache_stats(RecRawStatBlock *rsb, const char *prefix)
   REG_INT("span.failing", cache_span_failing_stat);
   REG_INT("span.offline", cache_span_offline_stat);
   REG_INT("span.online", cache_span_online_stat);
+  REG_INT("stripe.loading", cache_stripe_loading_stat);
+  REG_INT("stripe.online", cache_stripe_online_stat);
+  REG_INT("tier.fast.hits", cache_tier_fast_hits_stat);
+  REG_INT("tier.fast.hit_bytes", cache_tier_fast_hit_bytes_stat);
+  REG_INT("tier.capacity.hits", cache_tier_capacity_hits_stat);
+  REG_INT("tier.capacity.hit_bytes", cache_tier_capacity_hit_bytes_stat);
+  REG_INT("tier.misses", cache_tier_misses_stat);
+  REG_INT("tier.promotions", cache_tier_promotions_stat);
+  REG_INT("tier.promoted_bytes", cache_tier_promoted_bytes_stat);
+  REG_INT("tier.demotions", cache_tier_demotions_stat);
+  REG_INT("tier.demoted_bytes", cache_tier_demoted_bytes_stat);
+  REG_INT("read_ahead.reads", cache_read_ahead_reads_stat);
+  REG_INT("read_ahead.bytes", cache_read_ahead_bytes_stat);
+  REG_INT("read_ahead.hits", cache_read_ahead_hits_stat);
+  REG_INT("read_ahead.waits", cache_read_ahead_waits_stat);
+  REG_INT("read_ahead.dropped", cache_read_ahead_dropped_stat);
+  REG_INT("read_ahead.over_budget", cache_read_ahead_over_budget_stat);
+  REG_INT("sparse.chunks_written", cache_sparse_chunks_written_stat);
+  REG_INT("sparse.chunks_skipped", cache_sparse_chunks_skipped_stat);
+  REG_INT("sparse.bytes_dropped", cache_sparse_bytes_dropped_stat);
+  REG_INT("compact.objects", cache_compact_objects_stat);
+  REG_INT("compact.bytes", cache_compact_bytes_stat);
+  REG_INT("compact.over_budget", cache_compact_over_budget_stat);
+  REG_INT("compress.fragments", cache_compress_fragments_stat);
+  REG_INT("compress.skipped", cache_compress_skipped_stat);
+  REG_INT("compress.bytes_in", cache_compress_bytes_in_stat);
+  REG_INT("compress.bytes_out", cache_compress_bytes_out_stat);
+  REG_INT("compress.errors", cache_compress_errors_stat);
 }
 
 int
@@ -3165,6 +3666,22 @@ FragmentSizeUpdateCb(const char * /* name ATS_UNUSED */, RecDataT /* data_type A
   return 0;
 }
 
+// Read the comma separated list of content type prefixes in the @a name configuration.
+static void
+read_content_types(const char *name, std::vector<std::string> &types)
+{
+  char *value = nullptr;
+  REC_ReadConfigStringAlloc(value, name);
+  ts::TextView text{value, value ? strlen(value) : 0};
+  while (text) {
+    ts::TextView type = text.take_prefix_at(',').trim_if(&isspace);
+    if (type) {
+      types.emplace_back(type.data(), type.size());
+    }
+  }
+  ats_free(value);
+}
+
 void
 ink_cache_init(ts::ModuleVersion v)
 {
@@ -3179,7 +3696,13 @@ ink_cache_init(ts::ModuleVersion v)
   REC_EstablishStaticConfigInt32(cache_config_ram_cache_algorithm, "proxy.config.cache.ram_cache.algorithm");
   REC_EstablishStaticConfigInt32(cache_config_ram_cache_compress, "proxy.config.cache.ram_cache.compress");
   REC_EstablishStaticConfigInt32(cache_config_ram_cache_compress_percent, "proxy.config.cache.ram_cache.compress_percent");
+  REC_EstablishStaticConfigInt32(cache_config_ram_cache_compress_threads, "proxy.config.cache.ram_cache.compress_threads");
+  read_content_types("proxy.config.cache.ram_cache.compress_skip_types", ram_cache_compress_skip_types);
   REC_ReadConfigInt32(cache_config_ram_cache_use_seen_filter, "proxy.config.cache.ram_cache.use_seen_filter");
+  REC_EstablishStaticConfigInt32(cache_config_ram_cache_shared, "proxy.config.cache.ram_cache.shared");
+  REC_EstablishStaticConfigInt32(cache_config_ram_cache_shards, "proxy.config.cache.ram_cache.shards");
+  REC_EstablishStaticConfigInt32(cache_config_init_stripes_per_disk, "proxy.config.cache.init.stripes_per_disk");
+  REC_EstablishStaticConfigInt32(cache_config_init_serve_while_recovering, "proxy.config.cache.init.serve_while_recovering");
 
   REC_EstablishStaticConfigInt32(cache_config_http_max_alts, "proxy.config.cache.limits.http.max_alts");
   Debug("cache_init", "proxy.config.cache.limits.http.max_alts = %d", cache_config_http_max_alts);
@@ -3216,8 +3739,60 @@ ink_cache_init(ts::ModuleVersion v)
   REC_EstablishStaticConfigInt32(cache_config_hit_evacuate_size_limit, "proxy.config.cache.hit_evacuate_size_limit");
   Debug("cache_init", "proxy.config.cache.hit_evacuate_size_limit = %d", cache_config_hit_evacuate_size_limit);
 
+  REC_EstablishStaticConfigInt32(cache_config_compact_min_hits, "proxy.config.cache.compact.min_hits");
+  REC_EstablishStaticConfigInt32(cache_config_compact_max_percent, "proxy.config.cache.compact.max_percent");
+  Debug("cache_init", "proxy.config.cache.compact.min_hits = %d, max_percent = %d", cache_config_compact_min_hits,
+        cache_config_compact_max_percent);
+
+  REC_EstablishStaticConfigInt32(cache_config_compress, "proxy.config.cache.compress");
+  read_content_types("proxy.config.cache.compress.types", cache_compress_types);
+  Debug("cache_init", "proxy.config.cache.compress = %d", cache_config_compress);
+
+  REC_EstablishStaticConfigInt32(cache_config_tier_promote_hits, "proxy.config.cache.tier.promote_hits");
+  REC_EstablishStaticConfigInt32(cache_config_tier_promote_max_size, "proxy.config.cache.tier.promote_max_size");
+  REC_EstablishStaticConfigInt32(cache_config_tier_demote_percent, "proxy.config.cache.tier.demote_percent");
+  Debug("cache_init", "proxy.config.cache.tier.promote_hits = %d, promote_max_size = %d, demote_percent = %d",
+        cache_config_tier_promote_hits, cache_config_tier_promote_max_size, cache_config_tier_demote_percent);
+
+  REC_EstablishStaticConfigInt32(cache_config_read_ahead_max_fragments, "proxy.config.cache.read_ahead.max_fragments");
+  REC_EstablishStaticConfigInteger(cache_config_read_ahead_stripe_memory, "proxy.config.cache.read_ahead.stripe_memory");
+  Debug("cache_init", "proxy.config.cache.read_ahead.max_fragments = %d, stripe_memory = %" PRId64,
+        cache_config_read_ahead_max_fragments, cache_config_read_ahead_stripe_memory);
+
+  REC_EstablishStaticConfigInteger(cache_config_sparse_chunk_size, "proxy.config.cache.sparse.chunk_size");
+  if (cache_config_sparse_chunk_size < 0 || cache_config_sparse_chunk_size > static_cast<int64_t>(MAX_FRAG_SIZE)) {
+    Warning("proxy.config.cache.sparse.chunk_size %" PRId64 " is not between 0 and %d, sparse objects are disabled",
+            cache_config_sparse_chunk_size, static_cast<int>(MAX_FRAG_SIZE));
+    cache_config_sparse_chunk_size = 0;
+  }
+  Debug("cache_init", "proxy.config.cache.sparse.chunk_size = %" PRId64, cache_config_sparse_chunk_size);
+
+  REC_EstablishStaticConfigInt32(cache_config_disk_latency_slow_factor, "proxy.config.cache.disk_latency.slow_factor");
+  Debug("cache_init", "proxy.config.cache.disk_latency.slow_factor = %d", cache_config_disk_latency_slow_factor);
+  REC_EstablishStaticConfigInt32(cache_config_disk_latency_min, "proxy.config.cache.disk_latency.min");
+  Debug("cache_init", "proxy.config.cache.disk_latency.min = %d", cache_config_disk_latency_min);
+  REC_EstablishStaticConfigInt32(cache_config_disk_latency_min_share, "proxy.config.cache.disk_latency.min_share");
+  cache_config_disk_latency_min_share = std::clamp(cache_config_disk_latency_min_share, 1, 100);
+  Debug("cache_init", "proxy.config.cache.disk_latency.min_share = %d", cache_config_disk_latency_min_share);
+  REC_EstablishStaticConfigInt32(cache_config_disk_latency_move_lookups, "proxy.config.cache.disk_latency.move_lookups");
+  Debug("cache_init", "proxy.config.cache.disk_latency.move_lookups = %d", cache_config_disk_latency_move_lookups);
+
   REC_EstablishStaticConfigInt32(cache_config_force_sector_size, "proxy.config.cache.force_sector_size");
 
+  // Must be set before anything is hashed, the stripe assignment depends on it too.
+  REC_EstablishStaticConfigInt32(cache_config_key_hash, "proxy.config.cache.key_hash");
+#if TS_ENABLE_FIPS == 0
+  if (cache_config_key_hash == CACHE_KEY_HASH_XXH3) {
+    CryptoContext::Setting = CryptoContext::XXH3;
+  }
+#else
+  if (cache_config_key_hash != CACHE_KEY_HASH_DEFAULT) {
+    Warning("proxy.config.cache.key_hash %d is not available in FIPS mode, using SHA256", cache_config_key_hash);
+    cache_config_key_hash = CACHE_KEY_HASH_DEFAULT;
+  }
+#endif
+  Debug("cache_init", "proxy.config.cache.key_hash = %d", cache_config_key_hash);
+
   ink_assert(REC_RegisterConfigUpdateFunc("proxy.config.cache.target_fragment_size", FragmentSizeUpdateCb, nullptr) !=
              REC_ERR_FAIL);
   REC_ReadConfigInt32(cache_config_target_fragment_size, "proxy.config.cache.target_fragment_size");
@@ -0,0 +1,192 @@
+/** @file
+
+  Compression of the data of the fragments written to disk.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  The data of a compressed fragment is the length of the data once decompressed, in host byte
+  order, followed by the data compressed with the codec in Doc::compression. The headers of the
+  fragment are never compressed, so the alternates are read without decompressing anything.
+
+ */
+
+#include "P_Cache.h"
+#include "tscore/fastlz.h"
+#ifdef HAVE_ZLIB_H
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD_H
+#include <zstd.h>
+#endif
+#ifdef HAVE_LZ4_H
+#include <lz4.h>
+#endif
+
+#define ZSTD_LEVEL 3 // fragments are compressed once and read many times
+
+bool
+cache_compression_available(int codec)
+{
+  switch (codec) {
+  case CACHE_COMPRESSION_NONE:
+  case CACHE_COMPRESSION_FASTLZ:
+    return true;
+#ifdef HAVE_ZLIB_H
+  case CACHE_COMPRESSION_LIBZ:
+    return true;
+#endif
+#ifdef HAVE_ZSTD_H
+  case CACHE_COMPRESSION_ZSTD:
+    return true;
+#endif
+#ifdef HAVE_LZ4_H
+  case CACHE_COMPRESSION_LZ4:
+    return true;
+#endif
+  default:
+    return false;
+  }
+}
+
+uint32_t
+cache_compress(int codec, const char *in, uint32_t in_len, Ptr<IOBufferData> &out)
+{
+  size_t bound = 0;
+  switch (codec) {
+  case CACHE_COMPRESSION_FASTLZ:
+    if (in_len < 16) { // fastlz does not take less
+      return 0;
+    }
+    bound = in_len + in_len / 16 + 66;
+    break;
+#ifdef HAVE_ZLIB_H
+  case CACHE_COMPRESSION_LIBZ:
+    bound = compressBound(in_len);
+    break;
+#endif
+#ifdef HAVE_ZSTD_H
+  case CACHE_COMPRESSION_ZSTD:
+    bound = ZSTD_compressBound(in_len);
+    break;
+#endif
+#ifdef HAVE_LZ4_H
+  case CACHE_COMPRESSION_LZ4:
+    bound = LZ4_compressBound(in_len);
+    break;
+#endif
+  default:
+    return 0;
+  }
+
+  char *b    = static_cast<char *>(ats_malloc(sizeof(uint32_t) + bound));
+  char *dst  = b + sizeof(uint32_t);
+  size_t len = 0;
+  memcpy(b, &in_len, sizeof(uint32_t));
+  switch (codec) {
+  case CACHE_COMPRESSION_FASTLZ: {
+    int l = fastlz_compress(in, in_len, dst);
+    len   = l > 0 ? l : 0;
+    break;
+  }
+#ifdef HAVE_ZLIB_H
+  case CACHE_COMPRESSION_LIBZ: {
+    uLongf l = bound;
+    len      = Z_OK == compress(reinterpret_cast<Bytef *>(dst), &l, reinterpret_cast<const Bytef *>(in), in_len) ? l : 0;
+    break;
+  }
+#endif
+#ifdef HAVE_ZSTD_H
+  case CACHE_COMPRESSION_ZSTD: {
+    size_t l = ZSTD_compress(dst, bound, in, in_len, ZSTD_LEVEL);
+    len      = ZSTD_isError(l) ? 0 : l;
+    break;
+  }
+#endif
+#ifdef HAVE_LZ4_H
+  case CACHE_COMPRESSION_LZ4: {
+    int l = LZ4_compress_default(in, dst, in_len, bound);
+    len   = l > 0 ? l : 0;
+    break;
+  }
+#endif
+  }
+  if (!len) {
+    ats_free(b);
+    return 0;
+  }
+  out            = new_xmalloc_IOBufferData(b, sizeof(uint32_t) + len);
+  out->_mem_type = DEFAULT_ALLOC;
+  return sizeof(uint32_t) + len;
+}
+
+bool
+cache_decompress_doc(Ptr<IOBufferData> &buf)
+{
+  Doc *doc = reinterpret_cast<Doc *>(buf->data());
+  if (doc->data_len() < sizeof(uint32_t) || doc->raw_data_len() > MAX_FRAG_SIZE) {
+    return false;
+  }
+  uint32_t raw_len = doc->raw_data_len();
+  uint32_t len     = doc->prefix_len() + raw_len;
+  const char *src  = doc->data() + sizeof(uint32_t);
+  uint32_t src_len = doc->data_len() - sizeof(uint32_t);
+  char *b          = static_cast<char *>(ats_malloc(len));
+  char *dst        = b + doc->prefix_len();
+  bool ok          = false;
+  memcpy(b, doc, doc->prefix_len());
+
+  switch (doc->compression) {
+  case CACHE_COMPRESSION_FASTLZ:
+    ok = fastlz_decompress(src, src_len, dst, raw_len) == static_cast<int>(raw_len);
+    break;
+#ifdef HAVE_ZLIB_H
+  case CACHE_COMPRESSION_LIBZ: {
+    uLongf l = raw_len;
+    int r    = uncompress(reinterpret_cast<Bytef *>(dst), &l, reinterpret_cast<const Bytef *>(src), src_len);
+    ok       = r == Z_OK && l == raw_len;
+    break;
+  }
+#endif
+#ifdef HAVE_ZSTD_H
+  case CACHE_COMPRESSION_ZSTD: {
+    size_t l = ZSTD_decompress(dst, raw_len, src, src_len);
+    ok       = !ZSTD_isError(l) && l == raw_len;
+    break;
+  }
+#endif
+#ifdef HAVE_LZ4_H
+  case CACHE_COMPRESSION_LZ4:
+    ok = LZ4_decompress_safe(src, dst, src_len, raw_len) == static_cast<int>(raw_len);
+    break;
+#endif
+  default:
+    break;
+  }
+  if (!ok) {
+    ats_free(b);
+    return false;
+  }
+
+  Doc *n_doc         = reinterpret_cast<Doc *>(b);
+  n_doc->len         = len;
+  n_doc->compression = CACHE_COMPRESSION_NONE;
+  buf                = new_xmalloc_IOBufferData(b, len);
+  buf->_mem_type     = DEFAULT_ALLOC;
+  return true;
+}
@@ -141,15 +141,46 @@ OpenDir::close_write(CacheVC *cont)
     unsigned int h = cont->first_key.slice32(0);
     int b          = h % OPEN_DIR_BUCKETS;
     bucket[b].remove(cont->od);
-    delayed_readers.append(cont->od->readers);
+    this->move_readers(cont->od);
     signal_readers(0, nullptr);
     cont->od->vector.clear();
     THREAD_FREE(cont->od, openDirEntryAllocator, cont->mutex->thread_holding);
+  } else {
+    // The readers waiting for this writer have to pick another one.
+    this->wake_readers(cont->od);
   }
   cont->od = nullptr;
   return 0;
 }
 
+/*
+   Readers parked on @a od with OpenDirEntry::wait are moved to the
+   delayed readers. From then on they are not attached to @a od.
+   */
+void
+OpenDir::move_readers(OpenDirEntry *od)
+{
+  CacheVC *c = nullptr;
+  while ((c = od->readers.pop())) {
+    c->od = nullptr;
+    delayed_readers.push(c);
+  }
+}
+
+/*
+   Signal the readers parked on @a od that a writer made progress. They
+   are called back from the event loop rather than from the writer.
+   */
+void
+OpenDir::wake_readers(OpenDirEntry *od)
+{
+  ink_assert(mutex->thread_holding == this_ethread());
+  if (od->readers.head) {
+    this->move_readers(od);
+    mutex->thread_holding->schedule_imm_local(this);
+  }
+}
+
 OpenDirEntry *
 OpenDir::open_read(const CryptoHash *key)
 {
@@ -169,6 +200,7 @@ OpenDirEntry::wait(CacheVC *cont, int msec)
   ink_assert(cont->vol->mutex->thread_holding == this_ethread());
   cont->f.open_read_timeout = 1;
   ink_assert(!cont->trigger);
+  cont->od      = this;
   cont->trigger = cont->vol->mutex->thread_holding->schedule_in_local(cont, HRTIME_MSECONDS(msec));
   readers.push(cont);
   return EVENT_CONT;
@@ -960,7 +992,7 @@ sync_cache_dir_on_shutdown()
       continue;
     }
     // recompute hit_evacuate_window
-    d->hit_evacuate_window = (d->data_blocks * cache_config_hit_evacuate_percent) / 100;
+    d->hit_evacuate_window = (d->data_blocks * d->hit_evacuate_percent()) / 100;
 
     // check if we have data in the agg buffer
     // dont worry about the cachevc s in the agg queue
@@ -1085,7 +1117,7 @@ Lrestart:
     }
 
     // recompute hit_evacuate_window
-    vol->hit_evacuate_window = (vol->data_blocks * cache_config_hit_evacuate_percent) / 100;
+    vol->hit_evacuate_window = (vol->data_blocks * vol->hit_evacuate_percent()) / 100;
 
     if (DISK_BAD(vol->disk)) {
       goto Ldone;
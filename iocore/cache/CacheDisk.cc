@@ -52,6 +52,17 @@ CacheDisk::incrErrors(const AIOCallback *io)
   Warning("failed operation: %s (opcode=%d), span: %s (fd=%d)", opname, opcode, path, fd);
 }
 
+void
+CacheDisk::io_done(ink_hrtime start)
+{
+  int64_t usecs = ink_hrtime_to_usec(Thread::get_hrtime_updated() - start);
+  int64_t avg   = io_latency.load(std::memory_order_relaxed);
+
+  // average of about the last 16 I/Os, concurrent updates may lose a sample
+  io_latency.store(avg ? avg + (usecs - avg) / 16 : usecs, std::memory_order_relaxed);
+  io_count.fetch_add(1, std::memory_order_relaxed);
+}
+
 int
 CacheDisk::open(char *s, off_t blocks, off_t askip, int ahw_sector_size, int fildes, bool clear)
 {
@@ -0,0 +1,88 @@
+/** @file
+
+  Hit counting, to find the popular objects of the cache.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "P_CacheHitFilter.h"
+
+#include "tscore/ink_memory.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+constexpr int64_t FILTER_MIN_SIZE = 1 << 12;
+} // namespace
+
+CacheHitFilter::~CacheHitFilter()
+{
+  ats_free(_counts);
+}
+
+void
+CacheHitFilter::init(int64_t size)
+{
+  ats_free(_counts);
+  _size   = std::max(size, FILTER_MIN_SIZE);
+  _counts = static_cast<uint8_t *>(ats_malloc(_size));
+  memset(_counts, 0, _size);
+  _hits = 0;
+}
+
+bool
+CacheHitFilter::hit(uint64_t item, int threshold)
+{
+  uint8_t &a = _counts[static_cast<uint32_t>(item) % _size];
+  uint8_t &b = _counts[(item >> 32) % _size];
+  int count  = std::min(a, b);
+
+  // Only raise the counters up to the new estimate, the larger one is shared with hotter items.
+  if (count < UINT8_MAX) {
+    ++count;
+    if (a < count) {
+      ++a;
+    }
+    if (b < count) {
+      ++b;
+    }
+  }
+  if (++_hits >= _size) {
+    for (int64_t i = 0; i < _size; ++i) {
+      _counts[i] >>= 1;
+    }
+    _hits = 0;
+  }
+  return count >= threshold;
+}
+
+int
+CacheHitFilter::count(uint64_t item) const
+{
+  return std::min(_counts[static_cast<uint32_t>(item) % _size], _counts[(item >> 32) % _size]);
+}
+
+void
+CacheHitFilter::clear(uint64_t item)
+{
+  _counts[static_cast<uint32_t>(item) % _size] = 0;
+  _counts[(item >> 32) % _size]                = 0;
+}
@@ -648,6 +648,7 @@ ConfigVolumes::BuildListFromString(char *config_file_path, char *file_buf)
     CacheType scheme  = CACHE_NONE_TYPE;
     int size          = 0;
     int in_percent    = 0;
+    int compression   = -1;
 
     while (true) {
       // skip all blank spaces at beginning of line
@@ -735,6 +736,21 @@ ConfigVolumes::BuildListFromString(char *config_file_path, char *file_buf)
         } else {
           in_percent = 0;
         }
+      } else if (strcasecmp(tmp, "compress") == 0) { // match compress
+        tmp += 9;
+
+        static const char *codecs[] = {"none", "fastlz", "libz", "liblzma", "zstd", "lz4"};
+        for (unsigned c = 0; c < countof(codecs); ++c) {
+          if (!strcasecmp(tmp, codecs[c])) {
+            compression = c;
+            tmp += strlen(codecs[c]);
+            break;
+          }
+        }
+        if (compression < 0) {
+          err = "Unknown compression";
+          break;
+        }
       }
 
       // ends here
@@ -757,9 +773,10 @@ ConfigVolumes::BuildListFromString(char *config_file_path, char *file_buf)
       } else {
         configp->in_percent = false;
       }
-      configp->scheme = scheme;
-      configp->size   = size;
-      configp->cachep = nullptr;
+      configp->scheme      = scheme;
+      configp->size        = size;
+      configp->compression = compression;
+      configp->cachep      = nullptr;
       cp_queue.enqueue(configp);
       num_volumes++;
       if (scheme == CACHE_HTTP_TYPE) {
@@ -767,7 +784,8 @@ ConfigVolumes::BuildListFromString(char *config_file_path, char *file_buf)
       } else {
         ink_release_assert(!"Unexpected non-HTTP cache volume");
       }
-      Debug("cache_hosting", "added volume=%d, scheme=%d, size=%d percent=%d", volume_number, scheme, size, in_percent);
+      Debug("cache_hosting", "added volume=%d, scheme=%d, size=%d percent=%d compress=%d", volume_number, scheme, size, in_percent,
+            compression);
     }
 
     tmp = bufTok.iterNext(&i_state);
@@ -37,6 +37,10 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheFragType type, co
   ink_assert(caches[type] == this);
 
   Vol *vol = key_to_vol(key, hostname, host_len);
+  if (!vol->online) {
+    cont->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *)-ECACHE_NOT_READY);
+    return ACTION_RESULT_DONE;
+  }
   Dir result, *last_collision = nullptr;
   ProxyMutex *mutex = cont->mutex.get();
   OpenDirEntry *od  = nullptr;
@@ -102,18 +106,26 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheHTTPHdr *request,
   }
   ink_assert(caches[type] == this);
 
-  Vol *vol = key_to_vol(key, hostname, host_len);
+  Vol *vol      = key_to_vol(key, hostname, host_len);
+  Vol *tier_vol = key_to_fast_vol(key, hostname, host_len);
+  if (!vol->online) {
+    cont->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *)-ECACHE_NOT_READY);
+    return ACTION_RESULT_DONE;
+  }
   Dir result, *last_collision = nullptr;
   ProxyMutex *mutex = cont->mutex.get();
   OpenDirEntry *od  = nullptr;
   CacheVC *c        = nullptr;
+  // the tiers are probed in order, one directory probe each
+  bool fast_hit = tier_vol && cache_tier_probe(*key, vol, tier_vol, &result, &last_collision);
 
   {
     CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
-    if (!lock.is_locked() || (od = vol->open_read(key)) || dir_probe(key, vol, &result, &last_collision)) {
+    if (!lock.is_locked() || (od = vol->open_read(key)) || fast_hit || dir_probe(key, vol, &result, &last_collision)) {
       c            = new_CacheVC(cont);
       c->first_key = c->key = c->earliest_key = *key;
       c->vol                                  = vol;
+      c->tier_vol                             = tier_vol;
       c->vio.op                               = VIO::READ;
       c->base_stat                            = cache_read_active_stat;
       CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
@@ -148,6 +160,9 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheHTTPHdr *request,
   }
 Lmiss:
   CACHE_INCREMENT_DYN_STAT(cache_read_failure_stat);
+  if (tier_vol) {
+    CACHE_INCREMENT_DYN_STAT(cache_tier_misses_stat);
+  }
   cont->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *)-ECACHE_NO_DOC);
   return ACTION_RESULT_DONE;
 Lwriter:
@@ -285,9 +300,11 @@ CacheVC::openReadChooseWriter(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSE
       }
     }
     vector.clear(false);
-    if (!write_vc) {
+    // the chunks of a sparse writer are read from the disk once it closes
+    if (!write_vc || write_vc->f.sparse) {
       DDebug("cache_read_agg", "%p: key: %X writer alternate different: %d", this, first_key.slice32(1), alternate_index);
-      od = nullptr;
+      write_vc = nullptr;
+      od       = nullptr;
       return EVENT_RETURN;
     }
 
@@ -315,6 +332,21 @@ CacheVC::openReadFromWriter(int event, Event *e)
   cancel_trigger();
   intptr_t err = ECACHE_DOC_BUSY;
   DDebug("cache_read_agg", "%p: key: %X In openReadFromWriter", this, first_key.slice32(1));
+  if (f.open_read_timeout) {
+    // Still parked on the writer, the wait timed out or the signal is not delivered yet.
+    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    if (!lock.is_locked()) {
+      VC_SCHED_LOCK_RETRY();
+    }
+    if (od) {
+      od->readers.remove(this);
+      writer_lock_retry = cache_config_read_while_writer_max_retries;
+    } else {
+      vol->open_dir.delayed_readers.remove(this);
+    }
+    od                  = nullptr;
+    f.open_read_timeout = 0;
+  }
   if (_action.cancelled) {
     od = nullptr; // only open for read so no need to close
     return free_CacheVC(this);
@@ -345,7 +377,7 @@ CacheVC::openReadFromWriter(int event, Event *e)
     } else if (ret == EVENT_CONT) {
       ink_assert(!write_vc);
       if (writer_lock_retry < cache_config_read_while_writer_max_retries) {
-        VC_SCHED_WRITER_RETRY();
+        VC_WAIT_WRITER(vol->open_read(&first_key));
       } else {
         return openReadFromWriterFailure(CACHE_EVENT_OPEN_READ_FAILED, (Event *)-err);
       }
@@ -382,7 +414,7 @@ CacheVC::openReadFromWriter(int event, Event *e)
     }
     DDebug("cache_read_agg", "%p: key: %X writer: closed:%d, fragment:%d, retry: %d", this, first_key.slice32(1), write_vc->closed,
            write_vc->fragment, writer_lock_retry);
-    VC_SCHED_WRITER_RETRY();
+    VC_WAIT_WRITER(cod);
   }
 
   CACHE_TRY_LOCK(writer_lock, write_vc->mutex, mutex->thread_holding);
@@ -539,7 +571,11 @@ CacheVC::openReadClose(int event, Event * /* e ATS_UNUSED */)
   }
   if (f.hit_evacuate && dir_valid(vol, &first_dir) && closed > 0) {
     if (f.single_fragment) {
-      vol->force_evacuate_head(&first_dir, dir_pinned(&first_dir));
+      EvacuationBlock *b = vol->force_evacuate_head(&first_dir, dir_pinned(&first_dir));
+      // demote the object when the write cursor reaches it
+      if (b && tier_vol && vol->disk->fast_tier) {
+        b->tier_vol = tier_vol;
+      }
     } else if (dir_valid(vol, &earliest_dir)) {
       vol->force_evacuate_head(&first_dir, dir_pinned(&first_dir));
       vol->force_evacuate_head(&earliest_dir, dir_pinned(&earliest_dir));
@@ -645,6 +681,7 @@ int
 CacheVC::openReadMain(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
 {
   cancel_trigger();
+Lstart:
   Doc *doc         = (Doc *)buf->data();
   int64_t ntodo    = vio.ntodo();
   int64_t bytes    = doc->len - doc_pos;
@@ -765,6 +802,23 @@ Lread : {
   // EVENT_IMMEDIATE events. So, we have to cancel that trigger and set
   // a new EVENT_INTERVAL event.
   cancel_trigger();
+  // The shared RAM cache has its own locks and fragment keys are never reused,
+  // so a fragment found there needs neither the directory nor the stripe lock.
+  if (cache_config_ram_cache_shared && !write_vc) {
+    Ptr<IOBufferData> data;
+    if (vol->ram_cache->get_fragment(&key, &data) > 0) {
+      doc = (Doc *)data->data();
+      if (doc->magic == DOC_MAGIC && doc->key == key) {
+        buf                  = data;
+        f.doc_from_ram_cache = true;
+        fragment++;
+        doc_pos = doc->prefix_len();
+        next_CacheKey(&key, &key);
+        // loop rather than recurse, all the fragments of a large object may be in the RAM cache
+        goto Lstart;
+      }
+    }
+  }
   CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
   if (!lock.is_locked()) {
     SET_HANDLER(&CacheVC::openReadMain);
@@ -871,6 +925,9 @@ CacheVC::openReadStartEarliest(int /* event ATS_UNUSED */, Event * /* e ATS_UNUS
     earliest_key = key;
     doc_pos      = doc->prefix_len();
     next_CacheKey(&key, &doc->key);
+    if (tier_vol) {
+      tier_hit(doc);
+    }
     vol->begin_read(this);
     if (vol->within_hit_evacuate_window(&earliest_dir) &&
         (!cache_config_hit_evacuate_size_limit || doc_len <= (uint64_t)cache_config_hit_evacuate_size_limit)) {
@@ -1136,6 +1193,13 @@ CacheVC::openReadStartHead(int event, Event *e)
         next_CacheKey(&key, &doc->key);
       } else {
         f.single_fragment = false;
+        // start a sparse alternate at its first chunk
+        HTTPChunkMap chunks;
+        if (chunks.load(alternate.response_get(), doc_len) && chunks.first() > 0) {
+          for (fragment = 0; fragment < chunks.first(); ++fragment) {
+            next_CacheKey(&key, &key);
+          }
+        }
       }
     } else {
       next_CacheKey(&key, &doc->key);
@@ -1156,6 +1220,9 @@ CacheVC::openReadStartHead(int event, Event *e)
       goto Learliest;
     }
 
+    if (cache_config_compact_min_hits > 0) {
+      vol->compact_hit(&dir);
+    }
     if (vol->within_hit_evacuate_window(&dir) &&
         (!cache_config_hit_evacuate_size_limit || doc_len <= (uint64_t)cache_config_hit_evacuate_size_limit)) {
       DDebug("cache_hit_evac", "dir: %" PRId64 ", write: %" PRId64 ", phase: %d", dir_offset(&dir),
@@ -1163,6 +1230,10 @@ CacheVC::openReadStartHead(int event, Event *e)
       f.hit_evacuate = 1;
     }
 
+    if (tier_vol) {
+      tier_hit(doc);
+    }
+
     first_buf = buf;
     vol->begin_read(this);
 
@@ -1193,6 +1264,14 @@ CacheVC::openReadStartHead(int event, Event *e)
       }
       return ret;
     }
+    // the fast tier copy went away, try the capacity tier
+    if (tier_vol && vol->disk->fast_tier) {
+      std::swap(vol, tier_vol);
+      buf            = nullptr;
+      last_collision = nullptr;
+      MUTEX_RELEASE(lock);
+      return openReadStartHead(EVENT_IMMEDIATE, nullptr);
+    }
   }
 Ldone:
   if (!f.lookup) {
@@ -0,0 +1,189 @@
+/** @file
+
+  Sequential read-ahead of the fragments of large objects.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "P_Cache.h"
+
+#include <algorithm>
+
+CacheReadAheadIO::CacheReadAheadIO(CacheVC *c, const CacheKey &k, Dir *d) : Continuation(c->mutex), vc(c), vol(c->vol), key(k)
+{
+  dir = *d;
+  SET_HANDLER(&CacheReadAheadIO::io_done);
+}
+
+void
+CacheReadAheadIO::free()
+{
+  vol->read_ahead_bytes -= io.aiocb.aio_nbytes;
+  delete this;
+}
+
+int
+CacheReadAheadIO::io_done(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
+{
+  done = true;
+  if (!vc) {
+    free();
+    return EVENT_DONE;
+  }
+  if (waiting) {
+    CacheVC *c = vc;
+    c->read_ahead.remove(this);
+    c->buf           = buf;
+    c->io.aio_result = io.aio_result;
+    free();
+    return c->handleEvent(AIO_EVENT_DONE, &c->io);
+  }
+  return EVENT_CONT;
+}
+
+/// Find the read ahead of *read_key at @c dir, and drop the reads ahead before it. All the reads
+/// ahead are dropped if there is none, the reader went elsewhere.
+CacheReadAheadIO *
+CacheVC::read_ahead_find()
+{
+  CacheReadAheadIO *ra = read_ahead.head;
+  while (ra && !(ra->key == *read_key && dir_offset(&ra->dir) == dir_offset(&dir))) {
+    ra = ra->link.next;
+  }
+  while (read_ahead.head != ra) {
+    read_ahead_drop(read_ahead.head);
+  }
+  return ra;
+}
+
+void
+CacheVC::read_ahead_drop(CacheReadAheadIO *ra)
+{
+  read_ahead.remove(ra);
+  CACHE_INCREMENT_DYN_STAT(cache_read_ahead_dropped_stat);
+  if (ra->done) {
+    ra->free();
+  } else {
+    ra->vc = nullptr; // freed when the read completes
+  }
+}
+
+void
+CacheVC::read_ahead_cancel()
+{
+  while (read_ahead.head) {
+    read_ahead_drop(read_ahead.head);
+  }
+}
+
+/// Read *read_key from the read ahead @a ra, or wait for it. The handler is set to handleReadDone.
+int
+CacheVC::read_ahead_take(CacheReadAheadIO *ra)
+{
+  io.aiocb.aio_offset = ra->io.aiocb.aio_offset;
+  io.aiocb.aio_nbytes = ra->io.aiocb.aio_nbytes;
+  SET_HANDLER(&CacheVC::handleReadDone);
+
+  if (!ra->done) {
+    // the consumer caught up with the disk, read further ahead
+    CACHE_INCREMENT_DYN_STAT(cache_read_ahead_waits_stat);
+    read_ahead_window = std::min(read_ahead_window * 2, cache_config_read_ahead_max_fragments);
+
+    ra->waiting         = true;
+    io.aiocb.aio_fildes = vol->fd; // in progress until ra completes
+    read_ahead_fill(ra);
+    return EVENT_CONT;
+  }
+
+  CACHE_INCREMENT_DYN_STAT(cache_read_ahead_hits_stat);
+  read_ahead.remove(ra);
+  bool idle = read_ahead.head != nullptr;
+  for (CacheReadAheadIO *r = read_ahead.head; r; r = r->link.next) {
+    idle = idle && r->done;
+  }
+  // the disk is ahead of the consumer, read less ahead
+  if (idle && read_ahead_window > 1) {
+    --read_ahead_window;
+  }
+  buf           = ra->buf;
+  io.aio_result = ra->io.aio_result;
+  ra->free();
+  read_ahead_fill(nullptr);
+  return EVENT_RETURN;
+}
+
+/// Start reads ahead of *read_key, the fragment at @c dir, up to the window. @a waiting is the read of
+/// *read_key when the reader waits for it. Must hold the vol lock.
+void
+CacheVC::read_ahead_fill(CacheReadAheadIO *waiting)
+{
+  if (cache_config_read_ahead_max_fragments <= 0 || vio.op != VIO::READ || write_vc || !doc_len || vio.ntodo() <= 0) {
+    return;
+  }
+  if (!read_ahead_window) {
+    read_ahead_window = 1;
+  }
+
+  // fragments already covered, the reads ahead are in fragment order after *read_key
+  int n           = 0;
+  int64_t covered = dir_approx_size(&dir);
+  CacheKey next   = *read_key;
+  for (CacheReadAheadIO *r = read_ahead.head; r; r = r->link.next) {
+    if (r != waiting) {
+      ++n;
+      covered += r->io.aiocb.aio_nbytes;
+      next = r->key;
+    }
+  }
+
+  while (n < read_ahead_window && covered < vio.ntodo()) {
+    Dir d, *collision = nullptr;
+    next_CacheKey(&next, &next);
+    // the end of the object, or a fragment which is not on the disk yet
+    if (!dir_probe(&next, vol, &d, &collision) || dir_agg_buf_valid(vol, &d)) {
+      return;
+    }
+    int64_t size = dir_approx_size(&d);
+    off_t offset = vol->vol_offset(&d);
+    if (static_cast<off_t>(offset + size) > static_cast<off_t>(vol->skip + vol->len)) {
+      size = vol->skip + vol->len - offset;
+    }
+    if (vol->read_ahead_bytes + size > cache_config_read_ahead_stripe_memory) {
+      CACHE_INCREMENT_DYN_STAT(cache_read_ahead_over_budget_stat);
+      return;
+    }
+    vol->read_ahead_bytes += size;
+
+    CacheReadAheadIO *ra    = new CacheReadAheadIO(this, next, &d);
+    ra->buf                 = new_sized_IOBufferData(size, MEMALIGNED);
+    ra->io.aiocb.aio_fildes = vol->fd;
+    ra->io.aiocb.aio_offset = offset;
+    ra->io.aiocb.aio_nbytes = size;
+    ra->io.aiocb.aio_buf    = ra->buf->data();
+    ra->io.action           = ra;
+    ra->io.thread           = mutex->thread_holding->tt == DEDICATED ? AIO_CALLBACK_THREAD_ANY : mutex->thread_holding;
+    read_ahead.enqueue(ra);
+    ink_assert(ink_aio_read(&ra->io) >= 0);
+    CACHE_INCREMENT_DYN_STAT(cache_read_ahead_reads_stat);
+    CACHE_SUM_DYN_STAT(cache_read_ahead_bytes_stat, size);
+
+    ++n;
+    covered += size;
+  }
+}
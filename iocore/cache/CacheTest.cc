@@ -237,7 +237,6 @@ CacheTestSM::fill_buffer()
     k.b[0]  = pos / sk;
     char *x = ((char *)&k) + o;
     buffer->write(x, l);
-    buffer->fill(l);
     avail -= l;
   }
 }
@@ -266,7 +265,6 @@ CacheTestSM::check_buffer()
     if (::memcmp(b, x, l)) {
       return 0;
     }
-    buffer_reader->consume(l);
     pos += l;
     avail -= l;
   }
@@ -387,6 +385,13 @@ EXCLUSIVE_REGRESSION_TEST(cache)(RegressionTest *t, int /* atype ATS_UNUSED */,
   large_write_test.nbytes               = 10000000;
   rand_CacheKey(&large_write_test.key, thread->mutex);
 
+  // reads the fragments ahead of the consumer
+  CACHE_SM(t, large_read_test, { cacheProcessor.open_read(this, &key); });
+  large_read_test.expect_initial_event = CACHE_EVENT_OPEN_READ;
+  large_read_test.expect_event         = VC_EVENT_READ_COMPLETE;
+  large_read_test.nbytes               = large_write_test.nbytes;
+  large_read_test.key                  = large_write_test.key;
+
   CACHE_SM(t, pread_test, { cacheProcessor.open_read(this, &key); } int open_read_callout() {
     cvio = cache_vc->do_io_pread(this, nbytes, buffer, 7000000);
     return 1;
@@ -409,6 +414,7 @@ EXCLUSIVE_REGRESSION_TEST(cache)(RegressionTest *t, int /* atype ATS_UNUSED */,
       replace_test.clone(),
       replace_read_test.clone(),
       large_write_test.clone(),
+      large_read_test.clone(),
       pread_test.clone(),
       nullptr)
   ->run(pstatus);
@@ -498,6 +504,75 @@ REGRESSION_TEST(cache_disk_replacement_stability)(RegressionTest *t, int level,
   hr2.vols = nullptr;
 }
 
+// run -R 3 -r cache_disk_latency_share
+
+REGRESSION_TEST(cache_disk_latency_share)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  static int const MAX_VOLS           = 16;
+  static uint64_t DEFAULT_SKIP        = 8192;
+  static uint64_t DEFAULT_STRIPE_SIZE = 1024ULL * 1024 * 1024 * 64; // 64G
+  CacheDisk fast, slow;                                              // the even stripes are on the slow disk
+  CacheHostRecord hr1, hr2, hr3;
+  Vol vols[MAX_VOLS];
+  Vol *vol_ptrs[MAX_VOLS];
+  char buff[2048];
+  int move_lookups = cache_config_disk_latency_move_lookups;
+
+  *pstatus = REGRESSION_TEST_INPROGRESS;
+
+  fast.num_errors = slow.num_errors = 0;
+
+  for (int i = 0; i < MAX_VOLS; ++i) {
+    vol_ptrs[i]  = vols + i;
+    vols[i].disk = i % 2 ? &fast : &slow;
+    vols[i].len  = DEFAULT_STRIPE_SIZE;
+    snprintf(buff, sizeof(buff), "/dev/sd%c %" PRIu64 ":%" PRIu64, 'a' + i % 2, DEFAULT_SKIP + i / 2 * vols[i].len, vols[i].len);
+    CryptoContext().hash_immediate(vols[i].hash_id, buff, strlen(buff));
+  }
+
+  hr1.vol_hash_table = nullptr;
+  hr1.vols           = vol_ptrs;
+  hr1.num_vols       = MAX_VOLS;
+  build_vol_hash_table(&hr1);
+
+  // By default a slow disk keeps its share of the lookups.
+  slow.hash_share                        = 25;
+  cache_config_disk_latency_move_lookups = 0;
+  hr2.vol_hash_table                     = nullptr;
+  hr2.vols                               = vol_ptrs;
+  hr2.num_vols                           = MAX_VOLS;
+  build_vol_hash_table(&hr2);
+
+  cache_config_disk_latency_move_lookups = 1;
+  hr3.vol_hash_table                     = nullptr;
+  hr3.vols                               = vol_ptrs;
+  hr3.num_vols                           = MAX_VOLS;
+  build_vol_hash_table(&hr3);
+  cache_config_disk_latency_move_lookups = move_lookups;
+
+  // Only the buckets of the slow disk move. The points of the other stripes win more of the buckets it gives up,
+  // yet with a quarter of its points it keeps about 40% of them.
+  int then = 0, now = 0, moved = 0, wrong = 0, kept = 0;
+  for (int i = 0; i < VOL_HASH_TABLE_SIZE; ++i) {
+    bool was_slow = vols[hr1.vol_hash_table[i]].disk == &slow;
+    then += was_slow;
+    now += vols[hr3.vol_hash_table[i]].disk == &slow;
+    kept += hr1.vol_hash_table[i] == hr2.vol_hash_table[i];
+    if (hr1.vol_hash_table[i] != hr3.vol_hash_table[i]) {
+      ++(was_slow ? moved : wrong);
+    }
+  }
+  rprintf(t, "Slow disk share - originally %d slots, now %d slots, %d moved from its stripes, %d moved from others\n", then,
+          now, moved, wrong);
+  rprintf(t, "Slow disk share without moving the lookups - %d of %d slots kept\n", kept, VOL_HASH_TABLE_SIZE);
+  *pstatus = kept == VOL_HASH_TABLE_SIZE && wrong == 0 && now < then / 2 && now > then / 4 ? REGRESSION_TEST_PASSED :
+                                                                                              REGRESSION_TEST_FAILED;
+
+  hr1.vols = nullptr;
+  hr2.vols = nullptr;
+  hr3.vols = nullptr;
+}
+
 static double zipf_alpha        = 1.2;
 static int64_t zipf_bucket_size = 1;
 
@@ -667,8 +742,68 @@ REGRESSION_TEST(ram_cache)(RegressionTest *t, int level, int *pstatus)
   for (int s = 20; s <= 28; s += 4) {
     int64_t cache_size = 1LL << s;
     *pstatus           = REGRESSION_TEST_PASSED;
-    if (!test_RamCache(t, new_RamCacheLRU(), "LRU", cache_size) || !test_RamCache(t, new_RamCacheCLFUS(), "CLFUS", cache_size)) {
+    if (!test_RamCache(t, new_RamCacheLRU(), "LRU", cache_size) || !test_RamCache(t, new_RamCacheCLFUS(), "CLFUS", cache_size) ||
+        !test_RamCache(t, new_RamCacheShared(RAM_CACHE_ALGORITHM_CLFUS, 16), "Shared CLFUS", cache_size)) {
       *pstatus = REGRESSION_TEST_FAILED;
     }
   }
 }
+
+// Simulate a fast tier of TIER_SLOTS objects, filled in order like a stripe, in front of a capacity
+// tier holding every object, promoting objects on repeated capacity hits.
+static void
+test_CacheTier(RegressionTest *t, const int *r, int sample_size, int threshold, int *promotions, double *fast_hit_rate)
+{
+  const int TIER_SLOTS = 1 << 12;
+  CacheHitFilter filter;
+  vector<int> ring(TIER_SLOTS, -1);
+  vector<char> in_fast(ZIPF_SIZE, 0);
+  int next = 0, fast_hits = 0;
+
+  filter.init(1 << 14);
+  *promotions = 0;
+  for (int i = 0; i < sample_size; i++) {
+    CryptoHash hash;
+    if (in_fast[r[i]]) {
+      fast_hits++;
+      continue;
+    }
+    CryptoContext().hash_immediate(hash, &r[i], sizeof(r[i]));
+    if (filter.hit(hash.fold(), threshold)) {
+      filter.clear(hash.fold());
+      if (ring[next] >= 0) {
+        in_fast[ring[next]] = 0;
+      }
+      ring[next]    = r[i];
+      in_fast[r[i]] = 1;
+      next          = (next + 1) % TIER_SLOTS;
+      (*promotions)++;
+    }
+  }
+  *fast_hit_rate = static_cast<double>(fast_hits) / sample_size;
+  rprintf(t, "CacheTier threshold %d Promotions %d Fast Hit Rate %f\n", threshold, *promotions, *fast_hit_rate);
+}
+
+REGRESSION_TEST(cache_tier)(RegressionTest *t, int /* level ATS_UNUSED */, int *pstatus)
+{
+  const int sample_size = 1 << 19;
+  int *r                = (int *)ats_malloc(sample_size * sizeof(int));
+  int once_promotions, twice_promotions;
+  double once_rate, twice_rate;
+
+  build_zipf();
+  srand48(13);
+  for (int i = 0; i < sample_size; i++) {
+    // coverity[dont_call]
+    r[i] = get_zipf(drand48());
+  }
+  test_CacheTier(t, r, sample_size, 1, &once_promotions, &once_rate);
+  test_CacheTier(t, r, sample_size, 2, &twice_promotions, &twice_rate);
+  ats_free(r);
+
+  // Requiring a second hit keeps the one hit wonders out, far fewer copies for at least the same hit rate.
+  *pstatus = REGRESSION_TEST_PASSED;
+  if (twice_promotions * 2 > once_promotions || twice_rate < once_rate || twice_rate < 0.5) {
+    *pstatus = REGRESSION_TEST_FAILED;
+  }
+}
@@ -0,0 +1,256 @@
+/** @file
+
+  Tiered cache, a fast tier of stripes in front of the capacity tier.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "P_Cache.h"
+
+#include <algorithm>
+
+namespace
+{
+constexpr int GENERATION_SLOTS         = 1 << 12;
+constexpr int REMOVE_RETRY_DELAY_MSECS = 1000;
+
+std::atomic<uint32_t> generations[GENERATION_SLOTS];
+
+void
+tier_dir_remove(Vol *vol, const CryptoHash &key)
+{
+  Dir dir, *last_collision = nullptr;
+  while (dir_probe(&key, vol, &dir, &last_collision)) {
+    dir_delete(&key, vol, &dir);
+    last_collision = nullptr;
+  }
+}
+
+// Deletes the fast tier copy of a key when the stripe was busy or still loading.
+struct CacheTierRemove : public Continuation {
+  Vol *vol;
+  CryptoHash key;
+
+  CacheTierRemove(Vol *v, const CryptoHash &k) : Continuation(v->mutex), vol(v), key(k)
+  {
+    SET_HANDLER(&CacheTierRemove::remove_event);
+  }
+
+  int
+  remove_event(int /* event ATS_UNUSED */, Event *e)
+  {
+    if (!vol->online && !DISK_BAD(vol->disk)) {
+      e->schedule_in(HRTIME_MSECONDS(REMOVE_RETRY_DELAY_MSECS));
+      return EVENT_CONT;
+    }
+    if (vol->online) {
+      tier_dir_remove(vol, key);
+    }
+    delete this;
+    return EVENT_DONE;
+  }
+};
+
+// A copier is allocated on the thread holding the source stripe lock and runs under the lock of the
+// destination stripe, agg_copy writes it like an evacuated document.
+CacheVC *
+new_TierCopier(Vol *from, Vol *to, const CryptoHash &key)
+{
+  CacheVC *c        = new_CacheVC(from);
+  ProxyMutex *mutex = from->mutex.get();
+  Vol *vol          = to;
+  c->mutex          = to->mutex;
+  c->_action        = to;
+  c->vol            = to;
+  c->base_stat      = cache_evacuate_active_stat;
+  CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
+  c->tier_vol        = from;
+  c->first_key       = key;
+  c->tier_generation = cache_tier_generation(key);
+  return c;
+}
+} // namespace
+
+uint32_t
+cache_tier_generation(const CryptoHash &key)
+{
+  return generations[key.slice32(1) % GENERATION_SLOTS].load(std::memory_order_acquire);
+}
+
+void
+cache_tier_invalidate(Vol *fast_vol, const CryptoHash &key)
+{
+  generations[key.slice32(1) % GENERATION_SLOTS].fetch_add(1, std::memory_order_acq_rel);
+
+  CACHE_TRY_LOCK(lock, fast_vol->mutex, this_ethread());
+  if (lock.is_locked() && fast_vol->online) {
+    tier_dir_remove(fast_vol, key);
+  } else {
+    eventProcessor.schedule_imm(new CacheTierRemove(fast_vol, key), ET_CALL);
+  }
+}
+
+bool
+cache_tier_probe(const CryptoHash &key, Vol *&vol, Vol *&tier_vol, Dir *result, Dir **last_collision)
+{
+  if (!tier_vol->online) {
+    return false;
+  }
+  CACHE_TRY_LOCK(lock, tier_vol->mutex, this_ethread());
+  if (!lock.is_locked() || !dir_probe(&key, tier_vol, result, last_collision)) {
+    *last_collision = nullptr;
+    return false;
+  }
+  std::swap(vol, tier_vol);
+  return true;
+}
+
+void
+cache_tier_promote(Vol *from, Vol *to, Dir *dir, const CryptoHash &key)
+{
+  if (!to->online) {
+    return;
+  }
+  CacheVC *c             = new_TierCopier(from, to, key);
+  c->overwrite_dir       = *dir;
+  c->io.aiocb.aio_fildes = from->fd;
+  c->io.aiocb.aio_nbytes = dir_approx_size(dir);
+  c->io.aiocb.aio_offset = from->vol_offset(dir);
+  if ((off_t)(c->io.aiocb.aio_offset + c->io.aiocb.aio_nbytes) > (off_t)(from->skip + from->len)) {
+    c->io.aiocb.aio_nbytes = from->skip + from->len - c->io.aiocb.aio_offset;
+  }
+  c->buf              = new_sized_IOBufferData(c->io.aiocb.aio_nbytes, MEMALIGNED);
+  c->io.aiocb.aio_buf = c->buf->data();
+  c->io.action        = c;
+  c->io.thread        = AIO_CALLBACK_THREAD_ANY;
+  SET_CONTINUATION_HANDLER(c, &CacheVC::tierCopyRead);
+  ink_assert(ink_aio_read(&c->io) >= 0);
+}
+
+void
+cache_tier_demote(Vol *from, Vol *to, Dir *dir, CacheVC *evacuator)
+{
+  Doc *doc = (Doc *)evacuator->buf->data();
+  Dir cur, *last_collision = nullptr;
+  bool current = false;
+
+  // a write or removal of the key since the hit deleted the entry, there is nothing to keep
+  while (!current && dir_probe(&doc->first_key, from, &cur, &last_collision)) {
+    current = dir_offset(&cur) == dir_offset(dir);
+  }
+  if (current && doc->single_fragment() && to->online) {
+    CacheVC *c       = new_TierCopier(from, to, doc->first_key);
+    c->buf           = evacuator->buf;
+    c->overwrite_dir = *dir;
+    SET_CONTINUATION_HANDLER(c, &CacheVC::tierCopyWrite);
+    eventProcessor.schedule_imm(c, ET_CALL);
+  }
+  free_CacheVC(evacuator);
+}
+
+int
+CacheVC::tierCopyRead(int event, Event * /* e ATS_UNUSED */)
+{
+  ink_assert(vol->mutex->thread_holding == this_ethread());
+  cancel_trigger();
+  set_io_not_in_progress();
+  bool valid;
+  {
+    // the source stripe may have written over the object during the read
+    CACHE_TRY_LOCK(lock, tier_vol->mutex, mutex->thread_holding);
+    if (!lock.is_locked()) {
+      VC_SCHED_LOCK_RETRY();
+    }
+    valid = dir_valid(tier_vol, &overwrite_dir) && dir_agg_valid(tier_vol, &overwrite_dir);
+  }
+  Doc *doc = (Doc *)buf->data();
+  if (!valid || !io.ok() || doc->magic != DOC_MAGIC || !(doc->first_key == first_key) || !doc->hlen || !doc->single_fragment() ||
+      doc->len > io.aiocb.aio_nbytes) {
+    return free_CacheVC(this);
+  }
+  return tierCopyWrite(event, nullptr);
+}
+
+int
+CacheVC::tierCopyWrite(int event, Event *e)
+{
+  ink_assert(vol->mutex->thread_holding == this_ethread());
+  Doc *doc = (Doc *)buf->data();
+  Dir existing, *collision = nullptr;
+
+  agg_len = vol->round_to_approx_size(doc->len);
+  if (tier_generation != cache_tier_generation(first_key) || agg_len > AGG_SIZE ||
+      dir_probe(&first_key, vol, &existing, &collision)) {
+    return free_CacheVC(this);
+  }
+  dir_set_approx_size(&overwrite_dir, agg_len);
+  f.evacuator = 1;
+  SET_HANDLER(&CacheVC::tierCopyDone);
+  vol->agg_todo_size += agg_len;
+  vol->agg.enqueue(this);
+  if (!vol->is_io_in_progress()) {
+    return vol->aggWrite(event, e);
+  }
+  return EVENT_CONT;
+}
+
+// Called by aggWrite once the document is copied to the aggregation buffer.
+int
+CacheVC::tierCopyDone(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  ink_assert(vol->mutex->thread_holding == this_ethread());
+  Dir existing, *collision = nullptr;
+
+  if (tier_generation == cache_tier_generation(first_key) && !dir_probe(&first_key, vol, &existing, &collision)) {
+    dir_insert(&first_key, vol, &dir);
+    if (vol->disk->fast_tier) {
+      CACHE_INCREMENT_DYN_STAT(cache_tier_promotions_stat);
+      CACHE_SUM_DYN_STAT(cache_tier_promoted_bytes_stat, agg_len);
+    } else {
+      CACHE_INCREMENT_DYN_STAT(cache_tier_demotions_stat);
+      CACHE_SUM_DYN_STAT(cache_tier_demoted_bytes_stat, agg_len);
+    }
+  }
+  return free_CacheVC(this);
+}
+
+// A tiered read opened an object, count it and promote it if it is hot enough. Must hold the vol lock.
+void
+CacheVC::tier_hit(Doc *doc)
+{
+  if (vol->disk->fast_tier) {
+    CACHE_INCREMENT_DYN_STAT(cache_tier_fast_hits_stat);
+    CACHE_SUM_DYN_STAT(cache_tier_fast_hit_bytes_stat, doc_len);
+    return;
+  }
+  CACHE_INCREMENT_DYN_STAT(cache_tier_capacity_hits_stat);
+  CACHE_SUM_DYN_STAT(cache_tier_capacity_hit_bytes_stat, doc_len);
+
+  // The other alternates of an object would not be found in the fast tier.
+  if (!f.single_fragment || vector.count() != 1 || doc->len > static_cast<uint32_t>(cache_config_tier_promote_max_size)) {
+    return;
+  }
+  if (!vol->tier_filter.is_initialized()) {
+    vol->tier_filter.init(vol->direntries() / 4);
+  }
+  if (vol->tier_filter.hit(first_key.fold(), cache_config_tier_promote_hits)) {
+    vol->tier_filter.clear(first_key.fold());
+    cache_tier_promote(vol, tier_vol, &dir, first_key);
+  }
+}
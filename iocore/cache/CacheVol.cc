@@ -65,21 +65,21 @@ CacheVC::scanVol(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
       rec = res.record;
     }
   }
-  if (!vol) {
-    if (!rec->num_vols) {
-      goto Ldone;
-    }
-    vol = rec->vols[0];
-  } else {
-    for (int i = 0; i < rec->num_vols - 1; i++) {
-      if (vol == rec->vols[i]) {
-        vol = rec->vols[i + 1];
-        goto Lcont;
-      }
+  int i = 0;
+  if (vol) {
+    while (i < rec->num_vols && vol != rec->vols[i]) {
+      i++;
     }
+    i++;
+  }
+  // stripes still loading are skipped
+  while (i < rec->num_vols && !rec->vols[i]->online) {
+    i++;
+  }
+  if (i >= rec->num_vols) {
     goto Ldone;
   }
-Lcont:
+  vol = rec->vols[i];
   fragment = 0;
   SET_HANDLER(&CacheVC::scanObject);
   eventProcessor.schedule_in(this, HRTIME_MSECONDS(scan_msec_delay));
@@ -194,6 +194,7 @@ CacheVC::scanObject(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
     io.aiocb.aio_buf    = buf->data();
     io.action           = this;
     io.thread           = AIO_CALLBACK_THREAD_ANY;
+    offset              = 0;
     Debug("cache_scan_truss", "read %p:scanObject", this);
     goto Lread;
   }
@@ -341,13 +342,17 @@ CacheVC::scanObject(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   // fix it.
   if (might_need_overlap_read && ((off_t)((char *)doc - buf->data()) + next_object_len > (off_t)io.aiocb.aio_nbytes) &&
       next_object_len > 0) {
-    off_t partial_object_len = io.aiocb.aio_nbytes - ((char *)doc - buf->data());
+    // Keep the whole sector the object starts in, O_DIRECT reads whole sectors into aligned memory.
+    off_t doc_offset         = (char *)doc - buf->data();
+    off_t sector_offset      = doc_offset & ~(off_t)(vol->sector_size - 1);
+    off_t partial_object_len = io.aiocb.aio_nbytes - sector_offset;
     // Copy partial object to beginning of the buffer.
-    memmove(buf->data(), (char *)doc, partial_object_len);
+    memmove(buf->data(), buf->data() + sector_offset, partial_object_len);
     io.aiocb.aio_offset += io.aiocb.aio_nbytes;
     io.aiocb.aio_nbytes    = SCAN_BUF_SIZE - partial_object_len;
     io.aiocb.aio_buf       = buf->data() + partial_object_len;
     scan_fix_buffer_offset = partial_object_len;
+    offset                 = doc_offset - sector_offset;
   } else { // Normal case, where we ended on a object boundary.
     io.aiocb.aio_offset += ((char *)doc - buf->data()) + next_object_len;
     Debug("cache_scan_truss", "next %p:scanObject %" PRId64, this, (int64_t)io.aiocb.aio_offset);
@@ -356,6 +361,7 @@ CacheVC::scanObject(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
     io.aiocb.aio_nbytes    = SCAN_BUF_SIZE;
     io.aiocb.aio_buf       = buf->data();
     scan_fix_buffer_offset = 0;
+    offset                 = 0;
   }
 
   if (io.aiocb.aio_offset >= vol->skip + vol->len) {
@@ -370,7 +376,6 @@ Lread:
   if ((off_t)(io.aiocb.aio_offset + io.aiocb.aio_nbytes) > (off_t)(vol->skip + vol->len)) {
     io.aiocb.aio_nbytes = vol->skip + vol->len - io.aiocb.aio_offset;
   }
-  offset = 0;
   ink_assert(ink_aio_read(&io) >= 0);
   Debug("cache_scan_truss", "read %p:scanObject %" PRId64 " %zu", this, (int64_t)io.aiocb.aio_offset, (size_t)io.aiocb.aio_nbytes);
   return EVENT_CONT;
@@ -101,11 +101,10 @@ CacheVC::updateVector(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
       write_vector->remove(0, true);
     }
     if (vec) {
-      /* preserve fragment offset data from old info. This method is
-         called iff the update is a header only update so the fragment
-         data should remain valid.
+      /* preserve fragment offset data from old info. The fragment data
+         remains valid only if the update is a header only update.
       */
-      if (alternate_index >= 0) {
+      if (alternate_index >= 0 && !total_len) {
         alternate.copy_frag_offsets_from(write_vector->get(alternate_index));
       }
       alternate_index = write_vector->insert(&alternate, alternate_index);
@@ -189,10 +188,10 @@ CacheVC::handleWrite(int event, Event * /* e ATS_UNUSED */)
 
   set_agg_write_in_progress();
   POP_HANDLER;
-  agg_len = vol->round_to_approx_size(write_len + header_len + frag_len + sizeof(Doc));
+  agg_len = vol->round_to_approx_size((compressed_buf ? compressed_len : write_len) + header_len + frag_len + sizeof(Doc));
   vol->agg_todo_size += agg_len;
   bool agg_error = (agg_len > AGG_SIZE || header_len + sizeof(Doc) > MAX_FRAG_SIZE ||
-                    (!f.readers && (vol->agg_todo_size > cache_config_agg_write_backlog + AGG_SIZE) && write_len));
+                    (!f.readers && (vol->agg_todo_size > vol->agg_write_backlog() + AGG_SIZE) && write_len));
 #ifdef CACHE_AGG_FAIL_RATE
   agg_error = agg_error || ((uint32_t)mutex->thread_holding->generator.random() < (uint32_t)(UINT_MAX * CACHE_AGG_FAIL_RATE));
 #endif
@@ -203,7 +202,8 @@ CacheVC::handleWrite(int event, Event * /* e ATS_UNUSED */)
     CACHE_INCREMENT_DYN_STAT(cache_write_backlog_failure_stat);
     CACHE_INCREMENT_DYN_STAT(base_stat + CACHE_STAT_FAILURE);
     vol->agg_todo_size -= agg_len;
-    io.aio_result = AIO_SOFT_FAILURE;
+    compressed_buf = nullptr;
+    io.aio_result  = AIO_SOFT_FAILURE;
     if (event == EVENT_CALL) {
       return EVENT_RETURN;
     }
@@ -248,6 +248,30 @@ iobufferblock_memcpy(char *p, int len, IOBufferBlock *ab, int offset)
   return p;
 }
 
+/// Compress the write_len bytes of the fragment into compressed_buf, kept only if it takes less
+/// space on the disk.
+void
+CacheVC::compress_fragment()
+{
+  compressed_buf = nullptr;
+  if (f.rewrite_resident_alt) {
+    return;
+  }
+  ats_scoped_str raw(write_len);
+  iobufferblock_memcpy(raw.get(), write_len, blocks.get(), offset);
+  uint32_t len = cache_compress(compression, raw.get(), write_len, compressed_buf);
+  uint32_t hdr = header_len + sizeof(Doc);
+  if (!len || vol->round_to_approx_size(hdr + len) >= vol->round_to_approx_size(hdr + write_len)) {
+    compressed_buf = nullptr;
+    CACHE_INCREMENT_DYN_STAT(cache_compress_skipped_stat);
+    return;
+  }
+  compressed_len = len;
+  CACHE_INCREMENT_DYN_STAT(cache_compress_fragments_stat);
+  CACHE_SUM_DYN_STAT(cache_compress_bytes_in_stat, write_len);
+  CACHE_SUM_DYN_STAT(cache_compress_bytes_out_stat, len);
+}
+
 EvacuationBlock *
 Vol::force_evacuate_head(Dir *evac_dir, int pinned)
 {
@@ -306,6 +330,76 @@ Vol::scan_for_pinned_documents()
   }
 }
 
+/// The item of the object at @a d in the compaction filter. The phase tells an object from the one
+/// which overwrites it at the same offset in the next pass of the write cursor.
+static uint64_t
+compact_item(Dir *d)
+{
+  uint64_t x = (static_cast<uint64_t>(dir_offset(d)) << 1) | dir_phase(d);
+  // both halves of the item pick a counter, spread the offset over them
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+void
+Vol::compact_hit(Dir *d)
+{
+  if (!compact_filter.is_initialized()) {
+    compact_filter.init(direntries() / 4);
+  }
+  compact_filter.hit(compact_item(d), cache_config_compact_min_hits);
+}
+
+/// Rewrite the objects hit recently in the region the write cursor reaches next, as the pinned
+/// objects are, so the popular objects survive the pass of the write cursor. Only the heads of
+/// single fragment objects are counted as hits. At most compact.max_percent of the bytes the
+/// write cursor moves over before the next scan are rewritten.
+void
+Vol::scan_for_hot_documents()
+{
+  if (cache_config_compact_min_hits <= 0 || !compact_filter.is_initialized()) {
+    return;
+  }
+  int ps                = this->offset_to_vol_offset(header->write_pos + AGG_SIZE);
+  int pe                = this->offset_to_vol_offset(header->write_pos + 2 * EVACUATION_SIZE + (len / PIN_SCAN_EVERY));
+  int vol_end_offset    = this->offset_to_vol_offset(len + skip);
+  int before_end_of_vol = pe < vol_end_offset;
+  int64_t budget        = (len / PIN_SCAN_EVERY) * cache_config_compact_max_percent / 100;
+  Vol *vol              = this; // for the stats
+  for (int i = 0; i < this->direntries(); i++) {
+    if (dir_is_empty(&dir[i]) || !dir_head(&dir[i]) || dir_pinned(&dir[i])) {
+      continue;
+    }
+    int o = dir_offset(&dir[i]);
+    if (dir_phase(&dir[i]) == header->phase) {
+      if (before_end_of_vol || o >= (pe - vol_end_offset)) {
+        continue;
+      }
+    } else {
+      if (o < ps || o >= pe) {
+        continue;
+      }
+    }
+    if (compact_filter.count(compact_item(&dir[i])) < cache_config_compact_min_hits || evacuation_block_exists(&dir[i], this)) {
+      continue;
+    }
+    int64_t size = dir_approx_size(&dir[i]);
+    if (size > budget) {
+      CACHE_INCREMENT_DYN_STAT(cache_compact_over_budget_stat);
+      continue;
+    }
+    budget -= size;
+    DDebug("cache_evac", "compact offset %d size %" PRId64, o, size);
+    force_evacuate_head(&dir[i], 0);
+    CACHE_INCREMENT_DYN_STAT(cache_compact_objects_stat);
+    CACHE_SUM_DYN_STAT(cache_compact_bytes_stat, size);
+  }
+}
+
 /* NOTE:: This state can be called by an AIO thread, so DON'T DON'T
    DON'T schedule any events on this thread using VC_SCHED_XXX or
    mutex->thread_holding->schedule_xxx_local(). ALWAYS use
@@ -315,6 +409,10 @@ int
 Vol::aggWriteDone(int event, Event *e)
 {
   cancel_trigger();
+  if (agg_write_start) {
+    disk->io_done(agg_write_start);
+    agg_write_start = 0;
+  }
 
   // ensure we have the cacheDirSync lock if we intend to call it later
   // retaking the current mutex recursively is a NOOP
@@ -381,7 +479,7 @@ new_DocEvacuator(int nbytes, Vol *vol)
   ProxyMutex *mutex = vol->mutex.get();
   c->base_stat      = cache_evacuate_active_stat;
   CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
-  c->buf          = new_IOBufferData(iobuffer_size_to_index(nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+  c->buf          = new_sized_IOBufferData(nbytes, MEMALIGNED);
   c->vol          = vol;
   c->f.evacuator  = 1;
   c->earliest_key = zero_key;
@@ -490,7 +588,7 @@ CacheVC::evacuateDocDone(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
           dir_lookaside_probe(&evac->earliest_key, vol, &dir_tmp, &eblock);
           if (eblock) {
             CacheVC *earliest_evac = eblock->earliest_evacuator;
-            earliest_evac->total_len += doc->data_len();
+            earliest_evac->total_len += doc->raw_data_len();
             if (earliest_evac->total_len == earliest_evac->doc_len) {
               dir_lookaside_fixup(&evac->earliest_key, vol);
               free_CacheVC(earliest_evac);
@@ -525,7 +623,7 @@ CacheVC::evacuateDocDone(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
           DDebug("cache_evac", "evacuating earliest: %X %d", (int)doc->key.slice32(0), (int)dir_offset(&overwrite_dir));
           ink_assert(dir_compare_tag(&overwrite_dir, &doc->key));
           ink_assert(b->earliest_evacuator == this);
-          total_len += doc->data_len();
+          total_len += doc->raw_data_len();
           first_key    = doc->first_key;
           earliest_dir = dir;
           if (dir_probe(&first_key, vol, &dir, &last_collision) > 0) {
@@ -636,6 +734,12 @@ Vol::evacuateDocReadDone(int event, Event *e)
   if ((b->f.pinned && !b->readers) && doc->pinned < (uint32_t)(Thread::get_hrtime() / HRTIME_SECOND)) {
     goto Ldone;
   }
+  // a recently hit object of a fast tier stripe moves to the capacity tier instead
+  if (b->tier_vol && dir_head(&b->dir) && b->f.evacuate_head && dir_compare_tag(&b->dir, &doc->first_key)) {
+    cache_tier_demote(this, b->tier_vol, &b->dir, doc_evacuator);
+    doc_evacuator = nullptr;
+    return aggWrite(event, e);
+  }
 
   if (dir_head(&b->dir) && b->f.evacuate_head) {
     ink_assert(!b->evac_frags.key.fold());
@@ -746,7 +850,8 @@ agg_copy(char *p, CacheVC *vc)
     Doc *doc                   = (Doc *)p;
     IOBufferBlock *res_alt_blk = nullptr;
 
-    uint32_t len = vc->write_len + vc->header_len + vc->frag_len + sizeof(Doc);
+    uint32_t data_len = vc->compressed_buf ? vc->compressed_len : vc->write_len;
+    uint32_t len      = data_len + vc->header_len + vc->frag_len + sizeof(Doc);
     ink_assert(vc->frag_type != CACHE_FRAG_TYPE_HTTP || len != sizeof(Doc));
     ink_assert(vol->round_to_approx_size(len) == vc->agg_len);
     // update copy of directory entry for this document
@@ -762,7 +867,7 @@ agg_copy(char *p, CacheVC *vc)
     doc->doc_type    = vc->frag_type;
     doc->v_major     = CACHE_DB_MAJOR_VERSION;
     doc->v_minor     = CACHE_DB_MINOR_VERSION;
-    doc->unused      = 0; // force this for forward compatibility.
+    doc->compression = vc->compressed_buf ? vc->compression : CACHE_COMPRESSION_NONE;
     doc->total_len   = vc->total_len;
     doc->first_key   = vc->first_key;
     doc->sync_serial = vol->header->sync_serial;
@@ -822,9 +927,6 @@ agg_copy(char *p, CacheVC *vc)
       } else {
         memcpy(doc->hdr(), vc->header_to_write, vc->header_len);
       }
-      // the single fragment flag is not used in the write call.
-      // putting it in for completeness.
-      vc->f.single_fragment = doc->single_fragment();
     }
     // move data
     if (vc->write_len) {
@@ -835,6 +937,9 @@ agg_copy(char *p, CacheVC *vc)
       }
       if (vc->f.rewrite_resident_alt) {
         iobufferblock_memcpy(doc->data(), vc->write_len, res_alt_blk, 0);
+      } else if (vc->compressed_buf) {
+        memcpy(doc->data(), vc->compressed_buf->data(), data_len);
+        vc->compressed_buf = nullptr;
       } else {
         iobufferblock_memcpy(doc->data(), vc->write_len, vc->blocks.get(), vc->offset);
       }
@@ -850,6 +955,11 @@ agg_copy(char *p, CacheVC *vc)
       }
 #endif
     }
+    if (vc->header_len) {
+      // the single fragment flag is not used in the write call.
+      // putting it in for completeness, after the data as it reads its length.
+      vc->f.single_fragment = doc->single_fragment();
+    }
     if (cache_config_enable_checksum) {
       doc->checksum = 0;
       for (char *b = doc->hdr(); b < (char *)doc + doc->len; b++) {
@@ -942,6 +1052,7 @@ Vol::periodic_scan()
 {
   evacuate_cleanup();
   scan_for_pinned_documents();
+  scan_for_hot_documents();
   if (header->write_pos == start) {
     scan_pos = start;
   }
@@ -1079,7 +1190,8 @@ Lagain:
     as all writes are serialized in the volume.  This is not necessary
     for reads proceed independently.
    */
-  io.thread = AIO_CALLBACK_THREAD_AIO;
+  io.thread       = AIO_CALLBACK_THREAD_AIO;
+  agg_write_start = cache_config_disk_latency_slow_factor ? Thread::get_hrtime_updated() : 0;
   SET_HANDLER(&Vol::aggWriteDone);
   ink_aio_write(&io);
 
@@ -1107,7 +1219,7 @@ CacheVC::openWriteCloseDir(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED *
       VC_SCHED_LOCK_RETRY();
     }
     vol->close_write(this);
-    if (closed < 0 && fragment) {
+    if (closed < 0 && fragment && !f.sparse) {
       dir_delete(&earliest_key, vol, &earliest_dir);
     }
   }
@@ -1291,6 +1403,22 @@ CacheVC::openWriteClose(int event, Event *e)
       return openWriteCloseDir(event, e);
     }
   }
+  if (f.sparse) {
+    // a chunk cut short by the end of the data is not written
+    CACHE_SUM_DYN_STAT(cache_sparse_bytes_dropped_stat, length);
+    if (closed <= 0 || !write_pos) {
+      return openWriteCloseDir(event, e);
+    }
+    if (!alternate.get_frag_offset_count()) {
+      for (int i = 1; i < chunk_map->count; ++i) {
+        alternate.push_frag_offset(i * chunk_map->chunk_size);
+      }
+    }
+    chunk_map->store(alternate.response_get());
+    f.data_done = 1;
+    length      = 0;
+    return openWriteCloseHead(event, e);
+  }
   if (closed > 0 || f.allow_empty_doc) {
     if (total_len == 0) {
       if (f.update || f.allow_empty_doc) {
@@ -1358,6 +1486,10 @@ CacheVC::openWriteWriteDone(int event, Event *e)
     DDebug("cache_insert", "WriteDone: %X, %X, %d", key.slice32(0), first_key.slice32(0), write_len);
     blocks = iobufferblock_skip(blocks.get(), &offset, &length, write_len);
     next_CacheKey(&key, &key);
+    // Readers can start reading from this writer once it has a fragment.
+    if (fragment == 1 && od) {
+      vol->open_dir.wake_readers(od);
+    }
   }
   if (closed) {
     return die();
@@ -1380,6 +1512,9 @@ CacheVC::openWriteMain(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   cancel_trigger();
   int called_user = 0;
   ink_assert(!is_io_in_progress());
+  if (f.sparse) {
+    return openWriteSparse(EVENT_NONE, nullptr);
+  }
 Lagain:
   if (!vio.buffer.writer()) {
     if (calluser(VC_EVENT_WRITE_READY) == EVENT_DONE) {
@@ -1450,6 +1585,119 @@ Lagain:
   return do_write_lock_call();
 }
 
+/*
+  The data of a sparse write starts anywhere in the object. Only the whole chunks
+  which are not in the chunk map are written, one fragment each, under the key of
+  their chunk. The data before the first chunk boundary and the chunks already
+  present are dropped.
+*/
+int
+CacheVC::openWriteSparse(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  int called_user = 0;
+Lagain:
+  if (!vio.buffer.writer()) {
+    if (calluser(VC_EVENT_WRITE_READY) == EVENT_DONE) {
+      return EVENT_DONE;
+    }
+    if (!vio.buffer.writer()) {
+      return EVENT_CONT;
+    }
+  }
+  if (vio.ntodo() <= 0) {
+    called_user = 1;
+    if (calluser(VC_EVENT_WRITE_COMPLETE) == EVENT_DONE) {
+      return EVENT_DONE;
+    }
+    if (vio.ntodo() <= 0) {
+      return EVENT_CONT;
+    }
+  }
+  IOBufferReader *reader = vio.buffer.reader();
+  int64_t avail          = std::min(reader->read_avail(), vio.ntodo());
+  while (avail > 0) {
+    if (!length && !sparse_skip) {
+      if (fragment >= chunk_map->count) {
+        sparse_skip = avail;
+      } else if (chunk_map->test(fragment)) {
+        sparse_skip = chunk_map->chunk_length(fragment);
+        CACHE_INCREMENT_DYN_STAT(cache_sparse_chunks_skipped_stat);
+        next_CacheKey(&key, &key);
+        ++fragment;
+      } else {
+        // the data of a chunk is contiguous from here
+        blocks = reader->block;
+        offset = reader->start_offset;
+      }
+    }
+    int64_t bytes;
+    if (sparse_skip) {
+      bytes = std::min(avail, sparse_skip);
+      sparse_skip -= bytes;
+    } else {
+      bytes = std::min(avail, chunk_map->chunk_length(fragment) - length);
+      length += bytes;
+    }
+    reader->consume(bytes);
+    vio.ndone += bytes;
+    avail -= bytes;
+    if (length && length == chunk_map->chunk_length(fragment)) {
+      write_len = length;
+      SET_HANDLER(&CacheVC::openWriteSparseDone);
+      return do_write_lock_call();
+    }
+  }
+  if (!called_user) {
+    if (vio.ntodo() > 0) {
+      called_user = 1;
+      if (calluser(VC_EVENT_WRITE_READY) == EVENT_DONE) {
+        return EVENT_DONE;
+      }
+    }
+    goto Lagain;
+  }
+  return EVENT_CONT;
+}
+
+int
+CacheVC::openWriteSparseDone(int event, Event *e)
+{
+  cancel_trigger();
+  if (event == AIO_EVENT_DONE) {
+    set_io_not_in_progress();
+  } else if (is_io_in_progress()) {
+    return EVENT_CONT;
+  }
+  // In the event of VC_EVENT_ERROR, the cont must do an io_close
+  if (!io.ok()) {
+    if (closed) {
+      closed = -1;
+      return die();
+    }
+    SET_HANDLER(&CacheVC::openWriteMain);
+    return calluser(VC_EVENT_ERROR);
+  }
+  {
+    CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    if (!lock.is_locked()) {
+      VC_LOCK_RETRY_EVENT();
+    }
+    chunk_map->set(fragment);
+    CACHE_INCREMENT_DYN_STAT(cache_sparse_chunks_written_stat);
+    ++fragment;
+    write_pos += write_len;
+    dir_insert(&key, vol, &dir);
+    DDebug("cache_insert", "SparseDone: %X, %X, %d", key.slice32(0), first_key.slice32(0), write_len);
+    blocks = iobufferblock_skip(blocks.get(), &offset, &length, write_len);
+    next_CacheKey(&key, &key);
+  }
+  if (closed) {
+    return die();
+  }
+  SET_HANDLER(&CacheVC::openWriteMain);
+  return openWriteMain(event, e);
+}
+
 // begin overwrite
 int
 CacheVC::openWriteOverwrite(int event, Event *e)
@@ -1647,14 +1895,22 @@ Cache::open_write(Continuation *cont, const CacheKey *key, CacheFragType frag_ty
 
   ink_assert(caches[frag_type] == this);
 
+  Vol *vol = key_to_vol(key, hostname, host_len);
+  if (!vol->online) {
+    cont->handleEvent(CACHE_EVENT_OPEN_WRITE_FAILED, (void *)-ECACHE_NOT_READY);
+    return ACTION_RESULT_DONE;
+  }
+  if (Vol *fast_vol = key_to_fast_vol(key, hostname, host_len)) {
+    cache_tier_invalidate(fast_vol, *key);
+  }
+
   intptr_t res      = 0;
   CacheVC *c        = new_CacheVC(cont);
   ProxyMutex *mutex = cont->mutex.get();
   SCOPED_MUTEX_LOCK(lock, c->mutex, this_ethread());
   c->vio.op    = VIO::WRITE;
   c->base_stat = cache_write_active_stat;
-  c->vol       = key_to_vol(key, hostname, host_len);
-  Vol *vol     = c->vol;
+  c->vol       = vol;
   CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
   c->first_key = c->key = *key;
   c->frag_type          = frag_type;
@@ -1712,6 +1968,15 @@ Cache::open_write(Continuation *cont, const CacheKey *key, CacheHTTPInfo *info,
   }
 
   ink_assert(caches[type] == this);
+  Vol *vol = key_to_vol(key, hostname, host_len);
+  if (!vol->online) {
+    cont->handleEvent(CACHE_EVENT_OPEN_WRITE_FAILED, (void *)-ECACHE_NOT_READY);
+    return ACTION_RESULT_DONE;
+  }
+  if (Vol *fast_vol = key_to_fast_vol(key, hostname, host_len)) {
+    cache_tier_invalidate(fast_vol, *key);
+  }
+
   intptr_t err      = 0;
   int if_writers    = (uintptr_t)info == CACHE_ALLOW_MULTIPLE_WRITES;
   CacheVC *c        = new_CacheVC(cont);
@@ -1730,8 +1995,7 @@ Cache::open_write(Continuation *cont, const CacheKey *key, CacheHTTPInfo *info,
   } while (DIR_MASK_TAG(c->key.slice32(2)) == DIR_MASK_TAG(c->first_key.slice32(2)));
   c->earliest_key = c->key;
   c->frag_type    = CACHE_FRAG_TYPE_HTTP;
-  c->vol          = key_to_vol(key, hostname, host_len);
-  Vol *vol        = c->vol;
+  c->vol          = vol;
   c->info         = info;
   if (c->info && (uintptr_t)info != CACHE_ALLOW_MULTIPLE_WRITES) {
     /*
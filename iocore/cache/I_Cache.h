@@ -45,8 +45,21 @@ static constexpr ts::ModuleVersion CACHE_MODULE_VERSION(1, 0);
 #define CACHE_COMPRESSION_FASTLZ 1
 #define CACHE_COMPRESSION_LIBZ 2
 #define CACHE_COMPRESSION_LIBLZMA 3
-
-enum { RAM_HIT_COMPRESS_NONE = 1, RAM_HIT_COMPRESS_FASTLZ, RAM_HIT_COMPRESS_LIBZ, RAM_HIT_COMPRESS_LIBLZMA, RAM_HIT_LAST_ENTRY };
+#define CACHE_COMPRESSION_ZSTD 4
+#define CACHE_COMPRESSION_LZ4 5
+
+#define CACHE_KEY_HASH_DEFAULT 0
+#define CACHE_KEY_HASH_XXH3 1
+
+enum {
+  RAM_HIT_COMPRESS_NONE = 1,
+  RAM_HIT_COMPRESS_FASTLZ,
+  RAM_HIT_COMPRESS_LIBZ,
+  RAM_HIT_COMPRESS_LIBLZMA,
+  RAM_HIT_COMPRESS_ZSTD,
+  RAM_HIT_COMPRESS_LZ4,
+  RAM_HIT_LAST_ENTRY
+};
 
 struct CacheVC;
 struct CacheDisk;
@@ -210,6 +223,12 @@ struct CacheVConnection : public VConnection {
   */
   virtual bool is_pread_capable() = 0;
 
+  /** Write the data as the chunks of a sparse alternate, the data starts at byte @a offset of the
+      object. Must be called after @c set_http_info with a response holding the chunk map.
+      @return @c true if the alternate is sparse, @c false if not.
+  */
+  virtual bool set_sparse_write(int64_t offset) = 0;
+
   CacheVConnection();
 };
 
@@ -47,6 +47,13 @@ enum span_error_t {
   SPAN_ERROR_MEDIA_PROBE,
 };
 
+/// How a span is opened, see the @c direct option of storage.config.
+enum span_direct_io_t {
+  SPAN_DIRECT_IO_AUTO, ///< O_DIRECT, through the page cache if the file system does not support it.
+  SPAN_DIRECT_IO_ON,   ///< O_DIRECT, the span is not used if the file system does not support it.
+  SPAN_DIRECT_IO_OFF,  ///< Through the page cache.
+};
+
 struct span_diskid_t {
   int64_t id[2];
 
@@ -75,7 +82,9 @@ struct Span {
   unsigned hw_sector_size = DEFAULT_HW_SECTOR_SIZE;
   unsigned alignment      = 0;
   span_diskid_t disk_id;
-  int forced_volume_num = -1; ///< Force span in to specific volume.
+  int forced_volume_num      = -1;                  ///< Force span in to specific volume.
+  bool fast_tier             = false;               ///< Span belongs to the fast tier of a tiered cache.
+  span_direct_io_t direct_io = SPAN_DIRECT_IO_AUTO; ///< Open the span with O_DIRECT.
 private:
   bool is_mmapable_internal = false;
 
@@ -267,6 +276,8 @@ struct Store {
   /// Additional configuration key values.
   static const char VOLUME_KEY[];
   static const char HASH_BASE_STRING_KEY[];
+  static const char TIER_KEY[];
+  static const char DIRECT_KEY[];
 };
 
 // store either free or in the cache, can be stolen for reconfiguration
@@ -219,7 +219,7 @@ struct FreeDir {
 LINK_FORWARD_DECLARATION(CacheVC, opendir_link) // forward declaration
 struct OpenDirEntry {
   DLL<CacheVC, Link_CacheVC_opendir_link> writers; // list of all the current writers
-  DLL<CacheVC, Link_CacheVC_opendir_link> readers; // list of all the current readers - not used
+  DLL<CacheVC, Link_CacheVC_opendir_link> readers; // readers waiting for a writer, see wait()
   CacheHTTPInfoVector vector;                      // Vector for the http document. Each writer
                                                    // maintains a pointer to this vector and
                                                    // writes it down to disk.
@@ -236,6 +236,8 @@ struct OpenDirEntry {
 
   LINK(OpenDirEntry, link);
 
+  // Park the reader @a c until a writer makes progress or @a msec elapse.
+  // Until it is called back @a c is owned by the vol lock.
   int wait(CacheVC *c, int msec);
 
   bool
@@ -253,6 +255,8 @@ struct OpenDir : public Continuation {
   int close_write(CacheVC *c);
   OpenDirEntry *open_read(const CryptoHash *key);
   int signal_readers(int event, Event *e);
+  void wake_readers(OpenDirEntry *od);
+  void move_readers(OpenDirEntry *od);
 
   OpenDir();
 };
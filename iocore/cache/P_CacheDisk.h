@@ -23,6 +23,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "I_Cache.h"
 
 extern int cache_config_max_disk_errors;
@@ -100,8 +102,16 @@ struct CacheDisk : public Continuation {
 
   // Extra configuration values
   int forced_volume_num = -1;      ///< Volume number for this disk.
+  bool fast_tier        = false;   ///< Stripes on this disk are in the fast tier.
+  bool direct_io        = false;   ///< Read and written with O_DIRECT, bypassing the page cache.
   ats_scoped_str hash_base_string; ///< Base string for hash seed.
 
+  // Latency of the reads and writes of the stripes, checked by the disk health check every few seconds.
+  std::atomic<int64_t> io_latency{0}; ///< Moving average of the latency, in usecs.
+  std::atomic<int> io_count{0};       ///< Reads and writes since the last health check.
+  int health     = 100;               ///< 100 when not slower than the median of the disks, lower when slower.
+  int hash_share = 100;               ///< Percent of its aggregation write backlog, and hash table share if lookups may move.
+
   CacheDisk() : Continuation(new_ProxyMutex()) {}
 
   ~CacheDisk() override;
@@ -120,4 +130,6 @@ struct CacheDisk : public Continuation {
   void update_header();
   DiskVol *get_diskvol(int vol_number);
   void incrErrors(const AIOCallback *io);
+  /// Account for a read or write of a stripe started at @a start.
+  void io_done(ink_hrtime start);
 };
@@ -0,0 +1,59 @@
+/** @file
+
+  Hit counting, to find the popular objects of the cache.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/// Counts hits of items to find the popular ones. An item is a 64 bit hash, two 8 bit counters per
+/// item, the smaller is the estimate, and all the counters are halved every @c size hits so old
+/// popularity fades.
+class CacheHitFilter
+{
+public:
+  CacheHitFilter() = default;
+  ~CacheHitFilter();
+
+  CacheHitFilter(const CacheHitFilter &) = delete;
+  CacheHitFilter &operator=(const CacheHitFilter &) = delete;
+
+  void init(int64_t size);
+
+  bool
+  is_initialized() const
+  {
+    return _counts != nullptr;
+  }
+
+  /// Count a hit on @a item, @c true once @a item has been hit @a threshold times.
+  bool hit(uint64_t item, int threshold);
+  /// @return The estimate of the recent hits on @a item.
+  int count(uint64_t item) const;
+  /// Forget the hits on @a item, once it is promoted.
+  void clear(uint64_t item);
+
+private:
+  uint8_t *_counts = nullptr;
+  int64_t _size    = 0;
+  int64_t _hits    = 0;
+};
@@ -43,17 +43,21 @@ struct CacheHostRecord {
   {
     ats_free(vols);
     ats_free(vol_hash_table);
+    ats_free(fast_vol_hash_table);
     ats_free(cp);
   }
 
-  CacheType type                 = CACHE_NONE_TYPE;
-  Vol **vols                     = nullptr;
-  int good_num_vols              = 0;
-  int num_vols                   = 0;
-  int num_initialized            = 0;
+  CacheType type      = CACHE_NONE_TYPE;
+  Vol **vols          = nullptr;
+  int good_num_vols   = 0;
+  int num_vols        = 0;
+  int num_initialized = 0;
+  /// Stripes of the capacity tier, or all the stripes if the record is not tiered.
   unsigned short *vol_hash_table = nullptr;
-  CacheVol **cp                  = nullptr;
-  int num_cachevols              = 0;
+  /// Stripes of the fast tier, @c nullptr unless the record has stripes in both tiers.
+  unsigned short *fast_vol_hash_table = nullptr;
+  CacheVol **cp                       = nullptr;
+  int num_cachevols                   = 0;
 
   CacheHostRecord() {}
 };
@@ -172,6 +176,7 @@ struct ConfigVol {
   off_t size;
   bool in_percent;
   int percent;
+  int compression; ///< Codec of the fragments, -1 for proxy.config.cache.compress.
   CacheVol *cachep;
   LINK(ConfigVol, link);
 };
@@ -28,6 +28,7 @@
 
 #include "HTTP.h"
 #include "P_CacheHttp.h"
+#include "P_CacheReadAhead.h"
 
 struct EvacuationBlock;
 
@@ -95,6 +96,19 @@ struct EvacuationBlock;
     return EVENT_CONT;                                                    \
   } while (0)
 
+// Park on the open directory entry @a _od until a writer commits its first fragment or closes,
+// for at most what is left of the read while writer retries. Must hold the vol lock.
+#define VC_WAIT_WRITER(_od)                                                                    \
+  do {                                                                                         \
+    int _msec = 0;                                                                             \
+    writer_lock_retry++;                                                                       \
+    for (int _n = writer_lock_retry; _n <= cache_config_read_while_writer_max_retries; ++_n) { \
+      _msec += cache_read_while_writer_retry_delay * (_n > 2 ? 2 : 1);                         \
+    }                                                                                          \
+    CACHE_INCREMENT_DYN_STAT(cache_read_busy_coalesced_stat);                                  \
+    return (_od)->wait(this, std::max(_msec, cache_read_while_writer_retry_delay));            \
+  } while (0)
+
 // cache stats definitions
 enum {
   cache_bytes_used_stat,
@@ -105,6 +119,10 @@ enum {
   cache_direntries_used_stat,
   cache_ram_cache_hits_stat,
   cache_ram_cache_misses_stat,
+  cache_ram_cache_compress_bytes_in_stat,
+  cache_ram_cache_compress_bytes_out_stat,
+  cache_ram_cache_compress_time_stat,
+  cache_ram_cache_compress_skipped_stat,
   cache_pread_count_stat,
   cache_percent_full_stat,
   cache_lookup_active_stat,
@@ -135,6 +153,7 @@ enum {
   cache_three_plus_plus_fragment_document_count_stat,
   cache_read_busy_success_stat,
   cache_read_busy_failure_stat,
+  cache_read_busy_coalesced_stat,
   cache_gc_bytes_evacuated_stat,
   cache_gc_frags_evacuated_stat,
   cache_write_bytes_stat,
@@ -155,6 +174,44 @@ enum {
   cache_span_offline_stat,
   cache_span_online_stat,
   cache_span_failing_stat,
+  /* Stripe gauges, a stripe is "loading" until its directory is read and
+   * recovered, then "online". "loading" + "online" = total number of stripes */
+  cache_stripe_loading_stat,
+  cache_stripe_online_stat,
+  /* Tiered cache, the objects opened from each tier, the reads which found
+   * neither, and the objects copied between the tiers */
+  cache_tier_fast_hits_stat,
+  cache_tier_fast_hit_bytes_stat,
+  cache_tier_capacity_hits_stat,
+  cache_tier_capacity_hit_bytes_stat,
+  cache_tier_misses_stat,
+  cache_tier_promotions_stat,
+  cache_tier_promoted_bytes_stat,
+  cache_tier_demotions_stat,
+  cache_tier_demoted_bytes_stat,
+  /* Reads ahead of the fragments of large objects, those the reader found
+   * done, those it waited for, and those it never used */
+  cache_read_ahead_reads_stat,
+  cache_read_ahead_bytes_stat,
+  cache_read_ahead_hits_stat,
+  cache_read_ahead_waits_stat,
+  cache_read_ahead_dropped_stat,
+  cache_read_ahead_over_budget_stat,
+  cache_sparse_chunks_written_stat,
+  cache_sparse_chunks_skipped_stat,
+  cache_sparse_bytes_dropped_stat,
+  /* Hot objects rewritten ahead of the write cursor by the compaction, and
+   * those left behind because the scan ran out of budget */
+  cache_compact_objects_stat,
+  cache_compact_bytes_stat,
+  cache_compact_over_budget_stat,
+  /* Fragments compressed on disk, those left uncompressed because they did
+   * not shrink, and those which failed to decompress */
+  cache_compress_fragments_stat,
+  cache_compress_skipped_stat,
+  cache_compress_bytes_in_stat,
+  cache_compress_bytes_out_stat,
+  cache_compress_errors_stat,
   cache_stat_count
 };
 
@@ -191,6 +248,15 @@ extern RecRawStatBlock *cache_rsb;
     RecIncrRawStat(vol->cache_vol->vol_rsb, this_ethread(), (int)(x), (int64_t)(y)); \
   } while (0);
 
+// vol is nullptr for the RAM caches shared by all the stripes
+#define RAM_CACHE_SUM_DYN_STAT_THREAD(x, y)                                            \
+  do {                                                                                 \
+    RecIncrRawStat(cache_rsb, this_ethread(), (int)(x), (int64_t)(y));                 \
+    if (vol) {                                                                         \
+      RecIncrRawStat(vol->cache_vol->vol_rsb, this_ethread(), (int)(x), (int64_t)(y)); \
+    }                                                                                  \
+  } while (0);
+
 #define GLOBAL_CACHE_SUM_GLOBAL_DYN_STAT(x, y) RecIncrGlobalRawStatSum(cache_rsb, (x), (y))
 
 #define CACHE_SUM_GLOBAL_DYN_STAT(x, y) \
@@ -219,9 +285,29 @@ extern int cache_config_agg_write_backlog;
 extern int cache_config_ram_cache_compress;
 extern int cache_config_ram_cache_compress_percent;
 extern int cache_config_ram_cache_use_seen_filter;
+extern int cache_config_ram_cache_shared;
+extern int cache_config_ram_cache_shards;
+extern int cache_config_init_stripes_per_disk;
+extern int cache_config_init_serve_while_recovering;
+extern int cache_config_ram_cache_compress_threads;
+extern EventType ET_RAM_CACHE_COMPRESS;
 extern int cache_config_hit_evacuate_percent;
 extern int cache_config_hit_evacuate_size_limit;
+extern int cache_config_compact_min_hits;
+extern int cache_config_compact_max_percent;
+extern int cache_config_compress;
+extern int cache_config_tier_promote_hits;
+extern int cache_config_tier_promote_max_size;
+extern int cache_config_tier_demote_percent;
+extern int cache_config_read_ahead_max_fragments;
+extern int64_t cache_config_read_ahead_stripe_memory;
+extern int64_t cache_config_sparse_chunk_size;
+extern int cache_config_disk_latency_slow_factor;
+extern int cache_config_disk_latency_min;
+extern int cache_config_disk_latency_min_share;
+extern int cache_config_disk_latency_move_lookups;
 extern int cache_config_force_sector_size;
+extern int cache_config_key_hash;
 extern int cache_config_target_fragment_size;
 extern int cache_config_mutex_retry_delay;
 extern int cache_read_while_writer_retry_delay;
@@ -336,6 +422,8 @@ struct CacheVC : public CacheVConnection {
   int openWriteWriteDone(int event, Event *e);
   int openWriteOverwrite(int event, Event *e);
   int openWriteMain(int event, Event *e);
+  int openWriteSparse(int event, Event *e);
+  int openWriteSparseDone(int event, Event *e);
   int openWriteStartDone(int event, Event *e);
   int openWriteStartBegin(int event, Event *e);
 
@@ -372,6 +460,19 @@ struct CacheVC : public CacheVConnection {
   int evacuateDocDone(int event, Event *e);
   int evacuateReadHead(int event, Event *e);
 
+  int tierCopyRead(int event, Event *e);
+  int tierCopyWrite(int event, Event *e);
+  int tierCopyDone(int event, Event *e);
+  void tier_hit(Doc *doc);
+
+  CacheReadAheadIO *read_ahead_find();
+  int read_ahead_take(CacheReadAheadIO *ra);
+  void read_ahead_fill(CacheReadAheadIO *waiting);
+  void read_ahead_drop(CacheReadAheadIO *ra);
+  void read_ahead_cancel();
+
+  void compress_fragment();
+
   void cancel_trigger();
   int64_t get_object_size() override;
   void set_http_info(CacheHTTPInfo *info) override;
@@ -386,6 +487,7 @@ struct CacheVC : public CacheVConnection {
    */
   virtual uint32_t load_http_info(CacheHTTPInfoVector *info, struct Doc *doc, RefCountObj *block_ptr = nullptr);
   bool is_pread_capable() override;
+  bool set_sparse_write(int64_t offset) override;
   bool set_pin_in_cache(time_t time_pin) override;
   time_t get_pin_in_cache() override;
 
@@ -420,6 +522,7 @@ struct CacheVC : public CacheVConnection {
   Ptr<IOBufferData> first_buf;
   Ptr<IOBufferBlock> blocks; // data available to write
   Ptr<IOBufferBlock> writer_buf;
+  Ptr<IOBufferData> compressed_buf; // data of the fragment to write, compressed
 
   OpenDirEntry *od;
   AIOCallbackInternal io;
@@ -442,18 +545,25 @@ struct CacheVC : public CacheVConnection {
   CacheHTTPInfo *info;
   CacheHTTPInfoVector *write_vector;
   OverridableHttpConfigParams *params;
-  int header_len;        // for communicating with agg_copy
-  int frag_len;          // for communicating with agg_copy
-  uint32_t write_len;    // for communicating with agg_copy
-  uint32_t agg_len;      // for communicating with aggWrite
-  uint32_t write_serial; // serial of the final write for SYNC
+  int header_len;          // for communicating with agg_copy
+  int frag_len;            // for communicating with agg_copy
+  uint32_t write_len;      // for communicating with agg_copy
+  uint32_t compressed_len; // length of compressed_buf, for communicating with agg_copy
+  int compression;         // codec of the fragments written, CACHE_COMPRESSION_NONE if not compressed
+  uint32_t agg_len;        // for communicating with aggWrite
+  uint32_t write_serial;   // serial of the final write for SYNC
   Vol *vol;
+  Vol *tier_vol; // other tier of a tiered read, source stripe of a copy between the tiers
+  uint32_t tier_generation;
+  Queue<CacheReadAheadIO> read_ahead; // fragments read ahead, in fragment order
+  int read_ahead_window;              // fragments to read ahead
   Dir *last_collision;
   Event *trigger;
   CacheKey *read_key;
   ContinuationHandler save_handler;
   uint32_t pin_in_cache;
   ink_hrtime start_time;
+  ink_hrtime io_start; // start of the read in flight, for the latency of the disk
   int base_stat;
   int recursive;
   int closed;
@@ -462,6 +572,7 @@ struct CacheVC : public CacheVConnection {
   int64_t writer_offset; // offset of the writer for reading from a writer
   int64_t length;        // length of data available to write
   int64_t doc_pos;       // read position in 'buf'
+  int64_t sparse_skip;   // data to drop before the next chunk of a sparse write
   uint64_t write_pos;    // length written
   uint64_t total_len;    // total length written and available to write
   uint64_t doc_len;      // total_length (of the selected alternate for HTTP)
@@ -488,7 +599,7 @@ struct CacheVC : public CacheVConnection {
       unsigned int update : 1;
       unsigned int remove : 1;
       unsigned int remove_aborted_writers : 1;
-      unsigned int open_read_timeout : 1; // UNUSED
+      unsigned int open_read_timeout : 1; // parked on a writer, see OpenDirEntry::wait
       unsigned int data_done : 1;
       unsigned int read_from_writer_called : 1;
       unsigned int not_from_ram_cache : 1; // entire object was from ram cache
@@ -498,8 +609,10 @@ struct CacheVC : public CacheVConnection {
       unsigned int hit_evacuate : 1;
       unsigned int compressed_in_ram : 1; // compressed state in ram cache
       unsigned int allow_empty_doc : 1;   // used for cache empty http document
+      unsigned int sparse : 1;            // writing the chunks of a sparse alternate
     } f;
   };
+  HTTPChunkMap *chunk_map; // chunks of the sparse alternate being written
   // BTF optimization used to skip reading stuff in cache partition that doesn't contain any
   // dir entries.
   char *scan_vol_map;
@@ -536,6 +649,12 @@ extern CacheSync *cacheDirSync;
 int cache_write(CacheVC *, CacheHTTPInfoVector *);
 int get_alternate_index(CacheHTTPInfoVector *cache_vector, CacheKey key);
 CacheVC *new_DocEvacuator(int nbytes, Vol *d);
+bool cache_compression_available(int codec);
+/// Compress @a in_len bytes at @a in with @a codec into @a out. @return The length of the data in
+/// @a out, 0 if the compression failed.
+uint32_t cache_compress(int codec, const char *in, uint32_t in_len, Ptr<IOBufferData> &out);
+/// Replace the compressed fragment in @a buf by a decompressed copy, fails if the data is corrupt.
+bool cache_decompress_doc(Ptr<IOBufferData> &buf);
 
 // inline Functions
 
@@ -577,6 +696,9 @@ free_CacheVC(CacheVC *cont)
   }
   ink_assert(!cont->is_io_in_progress());
   ink_assert(!cont->od);
+  if (cont->read_ahead.head) {
+    cont->read_ahead_cancel();
+  }
   /* calling cont->io.action = nullptr causes compile problem on 2.6 solaris
      release build....weird??? For now, null out continuation and mutex
      of the action separately */
@@ -601,10 +723,12 @@ free_CacheVC(CacheVC *cont)
   cont->first_buf.clear();
   cont->blocks.clear();
   cont->writer_buf.clear();
+  cont->compressed_buf.clear();
   cont->alternate_index = CACHE_ALT_INDEX_DEFAULT;
   if (cont->scan_vol_map) {
     ats_free(cont->scan_vol_map);
   }
+  delete cont->chunk_map;
   memset((char *)&cont->vio, 0, cont->size_to_init);
 #ifdef CACHE_STAT_PAGES
   ink_assert(!cont->stat_link.next && !cont->stat_link.prev);
@@ -728,6 +852,10 @@ CacheVC::do_write_lock()
 TS_INLINE int
 CacheVC::do_write_lock_call()
 {
+  // compress before taking the stripe lock
+  if (compression != CACHE_COMPRESSION_NONE && write_len) {
+    compress_fragment();
+  }
   PUSH_HANDLER(&CacheVC::handleWriteLock);
   return handleWriteLock(EVENT_CALL, nullptr);
 }
@@ -764,6 +892,12 @@ Vol::close_write(CacheVC *cont)
   return open_dir.close_write(cont);
 }
 
+TS_INLINE int
+Vol::agg_write_backlog() const
+{
+  return static_cast<int64_t>(cache_config_agg_write_backlog) * disk->hash_share / 100;
+}
+
 // Returns 0 on success or a positive error code on failure
 TS_INLINE int
 Vol::open_write(CacheVC *cont, int allow_if_writers, int max_writers)
@@ -771,7 +905,7 @@ Vol::open_write(CacheVC *cont, int allow_if_writers, int max_writers)
   Vol *vol       = this;
   bool agg_error = false;
   if (!cont->f.remove) {
-    agg_error = (!cont->f.update && agg_todo_size > cache_config_agg_write_backlog);
+    agg_error = (!cont->f.update && agg_todo_size > agg_write_backlog());
 #ifdef CACHE_AGG_FAIL_RATE
     agg_error = agg_error || ((uint32_t)mutex->thread_holding->generator.random() < (uint32_t)(UINT_MAX * CACHE_AGG_FAIL_RATE));
 #endif
@@ -976,6 +1110,7 @@ struct Cache {
   CacheHostTable *hosttable = nullptr;
   int total_initialized_vol = 0;
   CacheType scheme          = CACHE_NONE_TYPE;
+  Vol **vols                = nullptr; // all the stripes, in load order
 
   int open(bool reconfigure, bool fix);
   int close();
@@ -1000,11 +1135,12 @@ struct Cache {
                int host_len);
   Action *deref(Continuation *cont, const CacheKey *key, CacheFragType type, const char *hostname, int host_len);
 
-  void vol_initialized(bool result);
+  void vol_initialized(Vol *vol, bool result);
 
   int open_done();
 
   Vol *key_to_vol(const CacheKey *key, const char *hostname, int host_len);
+  Vol *key_to_fast_vol(const CacheKey *key, const char *hostname, int host_len);
 
   Cache() {}
 };
@@ -0,0 +1,64 @@
+/** @file
+
+  Sequential read-ahead of the fragments of large objects.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  A reader of a multi-fragment object reads a fragment only once its consumer drained the previous
+  one, so a single stream gets one fragment per disk round trip. When a reader goes to the disk for
+  a fragment it also starts the reads of the fragments that follow, up to its window, into buffers
+  of its own. The read of a fragment which was read ahead takes the buffer, or waits for the read
+  still in flight. A seek, or a fragment found elsewhere, drops the reads ahead which are skipped.
+
+  The window starts at one fragment. It doubles when the reader has to wait for a read ahead, the
+  consumer is faster than the disk, and shrinks by one when all the reads ahead are already done,
+  the consumer is the slower one. The memory of the reads ahead of a stripe is bounded by
+  proxy.config.cache.read_ahead.stripe_memory.
+
+ */
+
+#pragma once
+
+#include "P_AIO.h"
+#include "P_CacheDir.h"
+
+struct Vol;
+struct CacheVC;
+
+/// A fragment read ahead by a reader, owned by the reader until it is dropped. A read dropped
+/// while in flight deletes itself when it completes.
+struct CacheReadAheadIO : public Continuation {
+  CacheVC *vc; ///< The reader, nullptr once dropped.
+  Vol *vol;
+  CacheKey key;
+  Dir dir;
+  Ptr<IOBufferData> buf;
+  AIOCallbackInternal io;
+  bool done    = false; ///< The read completed.
+  bool waiting = false; ///< The reader waits for the read to complete.
+
+  LINK(CacheReadAheadIO, link);
+
+  CacheReadAheadIO(CacheVC *c, const CacheKey &k, Dir *d);
+
+  int io_done(int event, void *data);
+
+  /// Release the memory of the read from the budget of the stripe and delete it.
+  void free();
+};
@@ -0,0 +1,60 @@
+/** @file
+
+  Tiered cache, a fast tier of stripes in front of the capacity tier.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Spans marked @c tier=fast in storage.config hold the fast tier. A hosting record with stripes in
+  both tiers hashes every key to a capacity stripe and to a fast stripe. Objects are always written
+  to the capacity stripe. A single fragment object which is hit repeatedly in the capacity tier is
+  copied to the fast tier (promotion), and HTTP reads probe the fast stripe before the capacity
+  stripe. When the write cursor of a fast stripe comes around to an object that was hit recently,
+  the evacuation moves it to the capacity stripe instead of rewriting it in place (demotion), unless
+  the capacity stripe still has a copy.
+
+  A write or a removal of a key deletes the fast tier copy and bumps a generation shared by the
+  keys of a slot, copies between the tiers started before that are dropped.
+
+ */
+
+#pragma once
+
+#include "tscore/CryptoHash.h"
+
+struct Vol;
+struct Dir;
+struct CacheVC;
+
+/// The generation of the slot of @a key, a write or removal of any key of the slot changes it.
+uint32_t cache_tier_generation(const CryptoHash &key);
+
+/// Note a write or removal of @a key and delete its copy in the fast stripe @a fast_vol.
+void cache_tier_invalidate(Vol *fast_vol, const CryptoHash &key);
+
+/// Probe the fast stripe @a tier_vol for @a key. On a hit @a vol and @a tier_vol are swapped, so the
+/// read goes to the fast stripe and @a tier_vol is the capacity stripe. A busy fast stripe is skipped.
+bool cache_tier_probe(const CryptoHash &key, Vol *&vol, Vol *&tier_vol, Dir *result, Dir **last_collision);
+
+/// Copy the single fragment object at @a dir of the capacity stripe @a from to the fast stripe @a to.
+/// Must hold the @a from lock.
+void cache_tier_promote(Vol *from, Vol *to, Dir *dir, const CryptoHash &key);
+
+/// Move the object at @a dir of the fast stripe @a from, read by @a evacuator, to the capacity stripe
+/// @a to. Consumes @a evacuator, must hold the @a from lock.
+void cache_tier_demote(Vol *from, Vol *to, Dir *dir, CacheVC *evacuator);
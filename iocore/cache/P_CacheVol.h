@@ -25,6 +25,9 @@
 
 #include <atomic>
 
+#include "P_CacheHitFilter.h"
+#include "P_CacheTier.h"
+
 #define CACHE_BLOCK_SHIFT 9
 #define CACHE_BLOCK_SIZE (1 << CACHE_BLOCK_SHIFT) // 512, smallest sector size
 #define ROUND_TO_STORE_BLOCK(_x) INK_ALIGN((_x), STORE_BLOCK_SIZE)
@@ -88,7 +91,7 @@ struct VolHeaderFooter {
   uint32_t write_serial;
   uint32_t dirty;
   uint32_t sector_size;
-  uint32_t unused; // pad out to 8 byte boundary
+  uint32_t key_hash; // proxy.config.cache.key_hash of the keys, 0 (default hash) in older stripes
   uint16_t freelist[1];
 };
 
@@ -113,6 +116,7 @@ struct EvacuationBlock {
   int readers;
   Dir dir;
   Dir new_dir;
+  Vol *tier_vol; // capacity stripe to demote the head to, instead of evacuating it in place
   // we need to have a list of evacuationkeys because of collision.
   EvacuationKey evac_frags;
   CacheVC *earliest_evacuator;
@@ -145,8 +149,9 @@ struct Vol : public Continuation {
   Queue<CacheVC, Continuation::Link_link> stat_cache_vcs;
   Queue<CacheVC, Continuation::Link_link> sync;
   char *agg_buffer  = nullptr;
-  int agg_todo_size = 0;
-  int agg_buf_pos   = 0;
+  int agg_todo_size          = 0;
+  int agg_buf_pos            = 0;
+  ink_hrtime agg_write_start = 0; ///< Start of the aggregation write in flight.
 
   Event *trigger = nullptr;
 
@@ -159,6 +164,15 @@ struct Vol : public Continuation {
 
   VolInitInfo *init_info = nullptr;
 
+  /// Set once the directory is loaded and recovered, the stripe is not used before that.
+  std::atomic<bool> online = false;
+  int stripe_index         = 0;       ///< Position of the stripe in the load order.
+  bool load_clear          = false;   ///< Clear the directory instead of loading it.
+  Vol *load_next           = nullptr; ///< Stripe of the same disk to load after this one.
+  ink_hrtime load_start    = 0;       ///< Start of the directory read.
+  ink_hrtime recover_start = 0;       ///< Start of the recovery of the data written after the last sync.
+  ink_hrtime load_done     = 0;       ///< The stripe went online.
+
   CacheDisk *disk            = nullptr;
   Cache *cache               = nullptr;
   CacheVol *cache_vol        = nullptr;
@@ -174,6 +188,11 @@ struct Vol : public Continuation {
   int64_t first_fragment_offset = 0;
   Ptr<IOBufferData> first_fragment_data;
 
+  CacheHitFilter tier_filter;    ///< Hits of the keys of a capacity stripe, for promotion to the fast tier.
+  CacheHitFilter compact_filter; ///< Hits of the objects of the stripe by location, for compaction.
+
+  std::atomic<int64_t> read_ahead_bytes{0}; ///< Memory of the reads ahead of the fragments of the stripe.
+
   void cancel_trigger();
 
   int recover_data();
@@ -194,6 +213,7 @@ struct Vol : public Continuation {
   int clear_dir();
 
   int init(char *s, off_t blocks, off_t dir_skip, bool clear);
+  int load();
 
   int handle_dir_clear(int event, void *data);
   int handle_dir_read(int event, void *data);
@@ -238,10 +258,14 @@ struct Vol : public Continuation {
   int evac_range(off_t start, off_t end, int evac_phase);
   void periodic_scan();
   void scan_for_pinned_documents();
+  void scan_for_hot_documents();
+  void compact_hit(Dir *dir);
   void evacuate_cleanup_blocks(int i);
   void evacuate_cleanup();
   EvacuationBlock *force_evacuate_head(Dir *dir, int pinned);
   int within_hit_evacuate_window(Dir *dir);
+  int hit_evacuate_percent() const;
+  int agg_write_backlog() const; ///< Bytes waiting to be written past which writes fail, less for a slow disk.
   uint32_t round_to_approx_size(uint32_t l);
 
   // inline functions
@@ -285,6 +309,7 @@ struct CacheVol {
   int num_vols        = 0;
   Vol **vols          = nullptr;
   DiskVol **disk_vols = nullptr;
+  int compression     = CACHE_COMPRESSION_NONE; ///< Codec of the fragments written to this volume.
   LINK(CacheVol, link);
   // per volume stats
   RecRawStatBlock *vol_rsb = nullptr;
@@ -306,11 +331,11 @@ struct Doc {
   CryptoHash first_key; ///< first key in object.
   CryptoHash key;       ///< Key for this doc.
 #endif
-  uint32_t hlen;         ///< Length of this header.
-  uint32_t doc_type : 8; ///< Doc type - indicates the format of this structure and its content.
-  uint32_t v_major : 8;  ///< Major version number.
-  uint32_t v_minor : 8;  ///< Minor version number.
-  uint32_t unused : 8;   ///< Unused, forced to zero.
+  uint32_t hlen;            ///< Length of this header.
+  uint32_t doc_type : 8;    ///< Doc type - indicates the format of this structure and its content.
+  uint32_t v_major : 8;     ///< Major version number.
+  uint32_t v_minor : 8;     ///< Minor version number.
+  uint32_t compression : 8; ///< Codec of the data, CACHE_COMPRESSION_NONE if stored as is.
   uint32_t sync_serial;
   uint32_t write_serial;
   uint32_t pinned; // pinned until
@@ -320,6 +345,7 @@ struct Doc {
 #endif
 
   uint32_t data_len();
+  uint32_t raw_data_len(); ///< Length of the data once decompressed.
   uint32_t prefix_len();
   int single_fragment();
   int no_data_in_fragment();
@@ -429,10 +455,21 @@ Doc::data_len()
   return len - sizeof(Doc) - hlen;
 }
 
+// Compressed data starts with its decompressed length.
+TS_INLINE uint32_t
+Doc::raw_data_len()
+{
+  uint32_t l = data_len();
+  if (compression != CACHE_COMPRESSION_NONE && l >= sizeof(uint32_t)) {
+    memcpy(&l, data(), sizeof(l));
+  }
+  return l;
+}
+
 TS_INLINE int
 Doc::single_fragment()
 {
-  return data_len() == total_len;
+  return raw_data_len() == total_len;
 }
 
 TS_INLINE char *
@@ -478,6 +515,7 @@ new_EvacuationBlock(EThread *t)
   b->init                 = 0;
   b->readers              = 0;
   b->earliest_evacuator   = nullptr;
+  b->tier_vol             = nullptr;
   b->evac_frags.link.next = nullptr;
   return b;
 }
@@ -30,15 +30,23 @@
 struct RamCache {
   // returns 1 on found/stored, 0 on not found/stored, if provided auxkey1 and auxkey2 must match
   virtual int get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0) = 0;
+  // as get() but ignores the auxkeys, only for keys which are never reused for other data (e.g. fragment keys)
+  virtual int get_fragment(CryptoHash *key, Ptr<IOBufferData> *ret_data)                                    = 0;
+  // compressible is false if compressing the data is known to be pointless (e.g. compressed media)
   virtual int put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0,
-                  uint32_t auxkey2 = 0)                                                                     = 0;
+                  uint32_t auxkey2 = 0, bool compressible = true)                                           = 0;
   virtual int fixup(const CryptoHash *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1,
                     uint32_t new_auxkey2)                                                                   = 0;
   virtual int64_t size() const                                                                              = 0;
 
+  // vol is only used for stats and may be nullptr if the cache is not owned by a stripe
   virtual void init(int64_t max_bytes, Vol *vol) = 0;
   virtual ~RamCache(){};
+
+  // protects the cache, the stripe mutex unless set before init()
+  Ptr<ProxyMutex> mutex;
 };
 
 RamCache *new_RamCacheLRU();
 RamCache *new_RamCacheCLFUS();
+RamCache *new_RamCacheShared(int algorithm, int shards);
@@ -33,12 +33,19 @@
 #ifdef HAVE_LZMA_H
 #include <lzma.h>
 #endif
+#ifdef HAVE_ZSTD_H
+#include <zstd.h>
+#endif
+#ifdef HAVE_LZ4_H
+#include <lz4.h>
+#endif
 
 #define REQUIRED_COMPRESSION 0.9 // must get to this size or declared incompressible
 #define REQUIRED_SHRINK 0.8      // must get to this size or keep original buffer (with padding)
 #define HISTORY_HYSTERIA 10      // extra temporary history
 #define ENTRY_OVERHEAD 256       // per-entry overhead to consider when computing cache value/size
 #define LZMA_BASE_MEMLIMIT (64 * 1024 * 1024)
+#define ZSTD_LEVEL 1 // favor speed, entries are compressed again whenever they are replaced
 //#define CHECK_ACOUNTING 1 // very expensive double checking of all sizes
 
 #define REQUEUE_HITS(_h) ((_h) ? ((_h)-1) : 0)
@@ -77,8 +84,9 @@ struct RamCacheCLFUS : public RamCache {
 
   // returns 1 on found/stored, 0 on not found/stored, if provided auxkey1 and auxkey2 must match
   int get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0) override;
-  int put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0,
-          uint32_t auxkey2 = 0) override;
+  int get_fragment(CryptoHash *key, Ptr<IOBufferData> *ret_data) override;
+  int put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0,
+          bool compressible = true) override;
   int fixup(const CryptoHash *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2) override;
   int64_t size() const override;
 
@@ -95,6 +103,7 @@ struct RamCacheCLFUS : public RamCache {
   uint16_t *seen                 = nullptr;
   int ncompressed                = 0;
   RamCacheCLFUSEntry *compressed = nullptr; // first uncompressed lru[0] entry
+  int lookup(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1, uint32_t auxkey2, bool match_aux);
   void compress_entries(EThread *thread, int do_at_most = INT_MAX);
   void resize_hashtable();
   void victimize(RamCacheCLFUSEntry *e);
@@ -131,6 +140,19 @@ public:
   RamCacheCLFUSCompressor(RamCacheCLFUS *arc) : rc(arc) { SET_HANDLER(&RamCacheCLFUSCompressor::mainEvent); }
 };
 
+// CPU time of the calling thread, compression runs on a dedicated or task thread so this is the cost of compressing
+static ink_hrtime
+thread_cpu_time()
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+    return ink_hrtime_from_timespec(&ts);
+  }
+#endif
+  return Thread::get_hrtime_updated();
+}
+
 int
 RamCacheCLFUSCompressor::mainEvent(int /* event ATS_UNUSED */, Event *e)
 {
@@ -148,6 +170,16 @@ RamCacheCLFUSCompressor::mainEvent(int /* event ATS_UNUSED */, Event *e)
   case CACHE_COMPRESSION_LIBLZMA:
 #ifndef HAVE_LZMA_H
     Warning("lzma not available for RAM cache compression");
+#endif
+    break;
+  case CACHE_COMPRESSION_ZSTD:
+#ifndef HAVE_ZSTD_H
+    Warning("zstd not available for RAM cache compression");
+#endif
+    break;
+  case CACHE_COMPRESSION_LZ4:
+#ifndef HAVE_LZ4_H
+    Warning("lz4 not available for RAM cache compression");
 #endif
     break;
   }
@@ -193,8 +225,11 @@ RamCacheCLFUS::resize_hashtable()
 void
 RamCacheCLFUS::init(int64_t abytes, Vol *avol)
 {
-  ink_assert(avol != nullptr);
-  vol       = avol;
+  ink_assert(avol != nullptr || mutex);
+  vol = avol;
+  if (!mutex) {
+    mutex = vol->mutex;
+  }
   max_bytes = abytes;
   DDebug("ram_cache", "initializing ram_cache %" PRId64 " bytes", abytes);
   if (!max_bytes) {
@@ -202,7 +237,7 @@ RamCacheCLFUS::init(int64_t abytes, Vol *avol)
   }
   resize_hashtable();
   if (cache_config_ram_cache_compress) {
-    eventProcessor.schedule_every(new RamCacheCLFUSCompressor(this), HRTIME_SECOND, ET_TASK);
+    eventProcessor.schedule_every(new RamCacheCLFUSCompressor(this), HRTIME_SECOND, ET_RAM_CACHE_COMPRESS);
   }
 }
 
@@ -232,6 +267,18 @@ check_accounting(RamCacheCLFUS *c)
 
 int
 RamCacheCLFUS::get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1, uint32_t auxkey2)
+{
+  return lookup(key, ret_data, auxkey1, auxkey2, true);
+}
+
+int
+RamCacheCLFUS::get_fragment(CryptoHash *key, Ptr<IOBufferData> *ret_data)
+{
+  return lookup(key, ret_data, 0, 0, false);
+}
+
+int
+RamCacheCLFUS::lookup(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1, uint32_t auxkey2, bool match_aux)
 {
   if (!max_bytes) {
     return 0;
@@ -240,7 +287,7 @@ RamCacheCLFUS::get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey
   RamCacheCLFUSEntry *e = bucket[i].head;
   char *b               = nullptr;
   while (e) {
-    if (e->key == *key && e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2) {
+    if (e->key == *key && (!match_aux || (e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2))) {
       move_compressed(e);
       if (!e->flag_bits.lru) { // in memory
         if (CACHE_VALUE(e) > average_value) {
@@ -283,6 +330,26 @@ RamCacheCLFUS::get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey
             ram_hit_state = RAM_HIT_COMPRESS_LIBLZMA;
             break;
           }
+#endif
+#ifdef HAVE_ZSTD_H
+          case CACHE_COMPRESSION_ZSTD: {
+            size_t l = ZSTD_decompress(b, e->len, e->data->data(), e->compressed_len);
+            if (ZSTD_isError(l) || l != e->len) {
+              goto Lfailed;
+            }
+            ram_hit_state = RAM_HIT_COMPRESS_ZSTD;
+            break;
+          }
+#endif
+#ifdef HAVE_LZ4_H
+          case CACHE_COMPRESSION_LZ4: {
+            int l = (int)e->len;
+            if (l != LZ4_decompress_safe(e->data->data(), b, (int)e->compressed_len, l)) {
+              goto Lfailed;
+            }
+            ram_hit_state = RAM_HIT_COMPRESS_LZ4;
+            break;
+          }
 #endif
           }
           IOBufferData *data = new_xmalloc_IOBufferData(b, e->len);
@@ -290,7 +357,7 @@ RamCacheCLFUS::get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey
           if (!e->flag_bits.copy) { // don't bother if we have to copy anyway
             int64_t delta = ((int64_t)e->compressed_len) - (int64_t)e->size;
             bytes += delta;
-            CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, delta);
+            RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, delta);
             e->size = e->compressed_len;
             check_accounting(this);
             e->flag_bits.compressed = 0;
@@ -300,16 +367,16 @@ RamCacheCLFUS::get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey
         } else {
           IOBufferData *data = e->data.get();
           if (e->flag_bits.copy) {
-            data = new_IOBufferData(iobuffer_size_to_index(e->len, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+            data = new_sized_IOBufferData(e->len, MEMALIGNED);
             ::memcpy(data->data(), e->data->data(), e->len);
           }
           (*ret_data) = data;
         }
-        CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_hits_stat, 1);
+        RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_hits_stat, 1);
         DDebug("ram_cache", "get %X %d %d size %d HIT", key->slice32(3), auxkey1, auxkey2, e->size);
         return ram_hit_state;
       } else {
-        CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_misses_stat, 1);
+        RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_misses_stat, 1);
         DDebug("ram_cache", "get %X %d %d HISTORY", key->slice32(3), auxkey1, auxkey2);
         return 0;
       }
@@ -319,7 +386,7 @@ RamCacheCLFUS::get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey
   }
   DDebug("ram_cache", "get %X %d %d MISS", key->slice32(3), auxkey1, auxkey2);
 Lerror:
-  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_misses_stat, 1);
+  RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_misses_stat, 1);
   return 0;
 Lfailed:
   ats_free(b);
@@ -391,7 +458,7 @@ RamCacheCLFUS::destroy(RamCacheCLFUSEntry *e)
   if (!e->flag_bits.lru) {
     objects--;
     bytes -= e->size + ENTRY_OVERHEAD;
-    CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, -(int64_t)e->size);
+    RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, -(int64_t)e->size);
     e->data = nullptr;
   } else {
     history--;
@@ -409,8 +476,7 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
   if (!cache_config_ram_cache_compress) {
     return;
   }
-  ink_assert(vol != nullptr);
-  MUTEX_TAKE_LOCK(vol->mutex, thread);
+  MUTEX_TAKE_LOCK(mutex, thread);
   if (!compressed) {
     compressed  = lru[0].head;
     ncompressed = 0;
@@ -446,15 +512,26 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
       case CACHE_COMPRESSION_LIBLZMA:
         l = e->len;
         break;
+#endif
+#ifdef HAVE_ZSTD_H
+      case CACHE_COMPRESSION_ZSTD:
+        l = (uint32_t)ZSTD_compressBound(e->len);
+        break;
+#endif
+#ifdef HAVE_LZ4_H
+      case CACHE_COMPRESSION_LZ4:
+        l = (uint32_t)LZ4_compressBound(e->len);
+        break;
 #endif
       }
       // store transient data for lock release
       Ptr<IOBufferData> edata = e->data;
       uint32_t elen           = e->len;
       CryptoHash key          = e->key;
-      MUTEX_UNTAKE_LOCK(vol->mutex, thread);
-      b           = (char *)ats_malloc(l);
-      bool failed = false;
+      MUTEX_UNTAKE_LOCK(mutex, thread);
+      ink_hrtime cpu_start = thread_cpu_time();
+      b                    = (char *)ats_malloc(l);
+      bool failed          = false;
       switch (ctype) {
       default:
         goto Lfailed;
@@ -486,9 +563,30 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
         l = (int)pos;
         break;
       }
+#endif
+#ifdef HAVE_ZSTD_H
+      case CACHE_COMPRESSION_ZSTD: {
+        size_t ll = ZSTD_compress(b, l, edata->data(), elen, ZSTD_LEVEL);
+        if (ZSTD_isError(ll)) {
+          failed = true;
+        }
+        l = (uint32_t)ll;
+        break;
+      }
+#endif
+#ifdef HAVE_LZ4_H
+      case CACHE_COMPRESSION_LZ4: {
+        int ll = LZ4_compress_default(edata->data(), b, (int)elen, (int)l);
+        if (ll <= 0) {
+          failed = true;
+        }
+        l = (uint32_t)ll;
+        break;
+      }
 #endif
       }
-      MUTEX_TAKE_LOCK(vol->mutex, thread);
+      RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_time_stat, thread_cpu_time() - cpu_start);
+      MUTEX_TAKE_LOCK(mutex, thread);
       // see if the entry is till around
       {
         if (failed) {
@@ -522,7 +620,9 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
         e->compressed_len = l;
         int64_t delta     = ((int64_t)l) - (int64_t)e->size;
         bytes += delta;
-        CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, delta);
+        RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, delta);
+        RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_bytes_in_stat, e->len);
+        RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_bytes_out_stat, l);
         e->size = l;
       } else {
         ats_free(b);
@@ -531,7 +631,7 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
         memcpy(bb, e->data->data(), e->len);
         int64_t delta = ((int64_t)e->len) - (int64_t)e->size;
         bytes += delta;
-        CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, delta);
+        RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, delta);
         e->size = e->len;
         l       = e->len;
       }
@@ -552,7 +652,7 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
     compressed = e->lru_link.next;
     ncompressed++;
   }
-  MUTEX_UNTAKE_LOCK(vol->mutex, thread);
+  MUTEX_UNTAKE_LOCK(mutex, thread);
   return;
 }
 
@@ -561,14 +661,15 @@ void RamCacheCLFUS::requeue_victims(Que(RamCacheCLFUSEntry, lru_link) & victims)
   RamCacheCLFUSEntry *victim = nullptr;
   while ((victim = victims.dequeue())) {
     bytes += victim->size + ENTRY_OVERHEAD;
-    CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, victim->size);
+    RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, victim->size);
     victim->hits = REQUEUE_HITS(victim->hits);
     lru[0].enqueue(victim);
   }
 }
 
 int
-RamCacheCLFUS::put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy, uint32_t auxkey1, uint32_t auxkey2)
+RamCacheCLFUS::put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy, uint32_t auxkey1, uint32_t auxkey2,
+                   bool compressible)
 {
   if (!max_bytes) {
     return 0;
@@ -596,7 +697,7 @@ RamCacheCLFUS::put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy,
       lru[e->flag_bits.lru].enqueue(e);
       int64_t delta = ((int64_t)size) - (int64_t)e->size;
       bytes += delta;
-      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, delta);
+      RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, delta);
       if (!copy) {
         e->size = size;
         e->data = data;
@@ -610,6 +711,9 @@ RamCacheCLFUS::put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy,
       check_accounting(this);
       e->flag_bits.copy       = copy;
       e->flag_bits.compressed = 0;
+      if (!compressible) {
+        e->flag_bits.incompressible = true;
+      }
       DDebug("ram_cache", "put %X %d %d size %d HIT", key->slice32(3), auxkey1, auxkey2, e->size);
       return 1;
     } else {
@@ -657,7 +761,7 @@ RamCacheCLFUS::put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy,
       continue;
     }
     bytes -= victim->size + ENTRY_OVERHEAD;
-    CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, -(int64_t)victim->size);
+    RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, -(int64_t)victim->size);
     victims.enqueue(victim);
     if (victim == compressed) {
       compressed = nullptr;
@@ -685,7 +789,7 @@ Linsert:
   while ((victim = victims.dequeue())) {
     if (bytes + size + victim->size <= max_bytes) {
       bytes += victim->size + ENTRY_OVERHEAD;
-      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, victim->size);
+      RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, victim->size);
       victim->hits = REQUEUE_HITS(victim->hits);
       lru[0].enqueue(victim);
     } else {
@@ -716,9 +820,13 @@ Linsert:
     e->data            = new_xmalloc_IOBufferData(b, len);
     e->data->_mem_type = DEFAULT_ALLOC;
   }
-  e->flag_bits.copy = copy;
+  e->flag_bits.copy           = copy;
+  e->flag_bits.incompressible = !compressible;
+  if (!compressible && cache_config_ram_cache_compress) {
+    RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_skipped_stat, 1);
+  }
   bytes += size + ENTRY_OVERHEAD;
-  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, size);
+  RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, size);
   e->size = size;
   objects++;
   lru[0].enqueue(e);
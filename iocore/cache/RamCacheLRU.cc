@@ -41,8 +41,9 @@ struct RamCacheLRU : public RamCache {
 
   // returns 1 on found/stored, 0 on not found/stored, if provided auxkey1 and auxkey2 must match
   int get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0) override;
-  int put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0,
-          uint32_t auxkey2 = 0) override;
+  int get_fragment(CryptoHash *key, Ptr<IOBufferData> *ret_data) override;
+  int put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0,
+          bool compressible = true) override;
   int fixup(const CryptoHash *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2) override;
   int64_t size() const override;
 
@@ -56,6 +57,7 @@ struct RamCacheLRU : public RamCache {
   int ibuckets                               = 0;
   Vol *vol                                   = nullptr;
 
+  int lookup(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1, uint32_t auxkey2, bool match_aux);
   void resize_hashtable();
   RamCacheLRUEntry *remove(RamCacheLRUEntry *e);
 };
@@ -109,7 +111,11 @@ RamCacheLRU::resize_hashtable()
 void
 RamCacheLRU::init(int64_t abytes, Vol *avol)
 {
-  vol       = avol;
+  ink_assert(avol != nullptr || mutex);
+  vol = avol;
+  if (!mutex) {
+    mutex = vol->mutex;
+  }
   max_bytes = abytes;
   DDebug("ram_cache", "initializing ram_cache %" PRId64 " bytes", abytes);
   if (!max_bytes) {
@@ -120,6 +126,18 @@ RamCacheLRU::init(int64_t abytes, Vol *avol)
 
 int
 RamCacheLRU::get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1, uint32_t auxkey2)
+{
+  return lookup(key, ret_data, auxkey1, auxkey2, true);
+}
+
+int
+RamCacheLRU::get_fragment(CryptoHash *key, Ptr<IOBufferData> *ret_data)
+{
+  return lookup(key, ret_data, 0, 0, false);
+}
+
+int
+RamCacheLRU::lookup(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1, uint32_t auxkey2, bool match_aux)
 {
   if (!max_bytes) {
     return 0;
@@ -127,18 +145,18 @@ RamCacheLRU::get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1,
   uint32_t i          = key->slice32(3) % nbuckets;
   RamCacheLRUEntry *e = bucket[i].head;
   while (e) {
-    if (e->key == *key && e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2) {
+    if (e->key == *key && (!match_aux || (e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2))) {
       lru.remove(e);
       lru.enqueue(e);
       (*ret_data) = e->data;
       DDebug("ram_cache", "get %X %d %d HIT", key->slice32(3), auxkey1, auxkey2);
-      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_hits_stat, 1);
+      RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_hits_stat, 1);
       return 1;
     }
     e = e->hash_link.next;
   }
   DDebug("ram_cache", "get %X %d %d MISS", key->slice32(3), auxkey1, auxkey2);
-  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_misses_stat, 1);
+  RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_misses_stat, 1);
   return 0;
 }
 
@@ -150,7 +168,7 @@ RamCacheLRU::remove(RamCacheLRUEntry *e)
   bucket[b].remove(e);
   lru.remove(e);
   bytes -= ENTRY_OVERHEAD + e->data->block_size();
-  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, -(ENTRY_OVERHEAD + e->data->block_size()));
+  RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, -(ENTRY_OVERHEAD + e->data->block_size()));
   DDebug("ram_cache", "put %X %d %d FREED", e->key.slice32(3), e->auxkey1, e->auxkey2);
   e->data = nullptr;
   THREAD_FREE(e, ramCacheLRUEntryAllocator, this_thread());
@@ -158,9 +176,9 @@ RamCacheLRU::remove(RamCacheLRUEntry *e)
   return ret;
 }
 
-// ignore 'copy' since we don't touch the data
+// ignore 'copy' and 'compressible' since we don't touch the data
 int
-RamCacheLRU::put(CryptoHash *key, IOBufferData *data, uint32_t len, bool, uint32_t auxkey1, uint32_t auxkey2)
+RamCacheLRU::put(CryptoHash *key, IOBufferData *data, uint32_t len, bool, uint32_t auxkey1, uint32_t auxkey2, bool)
 {
   if (!max_bytes) {
     return 0;
@@ -198,7 +216,7 @@ RamCacheLRU::put(CryptoHash *key, IOBufferData *data, uint32_t len, bool, uint32
   lru.enqueue(e);
   bytes += ENTRY_OVERHEAD + data->block_size();
   objects++;
-  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, ENTRY_OVERHEAD + data->block_size());
+  RAM_CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, ENTRY_OVERHEAD + data->block_size());
   while (bytes > max_bytes) {
     RamCacheLRUEntry *ee = lru.dequeue();
     if (ee) {
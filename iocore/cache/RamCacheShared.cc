@@ -0,0 +1,154 @@
+/** @file
+
+  RAM cache shared by all the stripes.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// A single RAM cache budget for all the stripes instead of a fixed slice per stripe. Objects are
+// spread over shards by key, each shard is a regular (CLFUS or LRU) RAM cache with its own mutex, so
+// the stripe mutex is not needed to access it and hot objects of different shards do not contend.
+// A shard which is busy is not waited for: a get is a miss, a put is dropped and a fixup leaves the
+// entry at its old location, where it is never found again.
+
+#include "P_Cache.h"
+
+#define SHARD_MIN_BYTES (1 << 20) // smaller shards do not hold enough objects for the replacement policy
+
+struct RamCacheShared : public RamCache {
+  int get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0) override;
+  int get_fragment(CryptoHash *key, Ptr<IOBufferData> *ret_data) override;
+  int put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0,
+          bool compressible = true) override;
+  int fixup(const CryptoHash *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2) override;
+  int64_t size() const override;
+
+  void init(int64_t max_bytes, Vol *vol) override;
+
+  RamCacheShared(int aalgorithm, int ashards) : algorithm(aalgorithm), nshards(std::max(ashards, 1)) {}
+  ~RamCacheShared() override;
+
+  // private
+  int algorithm;
+  int nshards;
+  RamCache **shards = nullptr;
+
+  RamCache *
+  shard(const CryptoHash *key) const
+  {
+    // slice32(3) selects the bucket within the shard
+    return shards[key->slice32(2) % nshards];
+  }
+};
+
+RamCacheShared::~RamCacheShared()
+{
+  if (shards) {
+    for (int i = 0; i < nshards; i++) {
+      delete shards[i];
+    }
+    ats_free(shards);
+  }
+}
+
+void
+RamCacheShared::init(int64_t max_bytes, Vol * /* vol ATS_UNUSED */)
+{
+  if (max_bytes / nshards < SHARD_MIN_BYTES) {
+    nshards = std::max<int64_t>(max_bytes / SHARD_MIN_BYTES, 1);
+  }
+  Debug("ram_cache", "initializing shared ram_cache %" PRId64 " bytes, %d shards", max_bytes, nshards);
+  shards = (RamCache **)ats_malloc(nshards * sizeof(RamCache *));
+  for (int i = 0; i < nshards; i++) {
+    switch (algorithm) {
+    default:
+    case RAM_CACHE_ALGORITHM_CLFUS:
+      shards[i] = new_RamCacheCLFUS();
+      break;
+    case RAM_CACHE_ALGORITHM_LRU:
+      shards[i] = new_RamCacheLRU();
+      break;
+    }
+    shards[i]->mutex = new_ProxyMutex();
+    shards[i]->init(max_bytes / nshards, nullptr);
+  }
+}
+
+int
+RamCacheShared::get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1, uint32_t auxkey2)
+{
+  RamCache *c = shard(key);
+  MUTEX_TRY_LOCK(lock, c->mutex, this_ethread());
+  if (!lock.is_locked()) {
+    return 0;
+  }
+  return c->get(key, ret_data, auxkey1, auxkey2);
+}
+
+int
+RamCacheShared::get_fragment(CryptoHash *key, Ptr<IOBufferData> *ret_data)
+{
+  RamCache *c = shard(key);
+  MUTEX_TRY_LOCK(lock, c->mutex, this_ethread());
+  if (!lock.is_locked()) {
+    return 0;
+  }
+  return c->get_fragment(key, ret_data);
+}
+
+int
+RamCacheShared::put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy, uint32_t auxkey1, uint32_t auxkey2,
+                    bool compressible)
+{
+  RamCache *c = shard(key);
+  MUTEX_TRY_LOCK(lock, c->mutex, this_ethread());
+  if (!lock.is_locked()) {
+    return 0;
+  }
+  return c->put(key, data, len, copy, auxkey1, auxkey2, compressible);
+}
+
+int
+RamCacheShared::fixup(const CryptoHash *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2)
+{
+  RamCache *c = shard(key);
+  MUTEX_TRY_LOCK(lock, c->mutex, this_ethread());
+  if (!lock.is_locked()) {
+    return 0;
+  }
+  return c->fixup(key, old_auxkey1, old_auxkey2, new_auxkey1, new_auxkey2);
+}
+
+// Only used by the regression tests, it may block.
+int64_t
+RamCacheShared::size() const
+{
+  int64_t s = 0;
+  for (int i = 0; i < nshards; i++) {
+    SCOPED_MUTEX_LOCK(lock, shards[i]->mutex, this_ethread());
+    s += shards[i]->size();
+  }
+  return s;
+}
+
+RamCache *
+new_RamCacheShared(int algorithm, int shards)
+{
+  return new RamCacheShared(algorithm, shards);
+}
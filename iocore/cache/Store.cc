@@ -39,6 +39,8 @@
 
 const char Store::VOLUME_KEY[]           = "volume";
 const char Store::HASH_BASE_STRING_KEY[] = "id";
+const char Store::TIER_KEY[]             = "tier";
+const char Store::DIRECT_KEY[]           = "direct";
 
 static span_error_t
 make_span_error(int error)
@@ -366,6 +368,8 @@ Store::read_config()
 
     int64_t size   = -1;
     int volume_num = -1;
+    bool fast_tier             = false;
+    span_direct_io_t direct_io = SPAN_DIRECT_IO_AUTO;
     const char *e;
     while (nullptr != (e = tokens.getNext())) {
       if (ParseRules::is_digit(*e)) {
@@ -393,14 +397,40 @@ Store::read_config()
           Error("storage.config failed to load");
           return Result::failure("failed to parse volume number '%s'", e);
         }
+      } else if (0 == strncasecmp(TIER_KEY, e, sizeof(TIER_KEY) - 1)) {
+        e += sizeof(TIER_KEY) - 1;
+        if ('=' == *e) {
+          ++e;
+        }
+        if (0 == strcasecmp(e, "fast")) {
+          fast_tier = true;
+        } else if (0 != strcasecmp(e, "capacity")) {
+          delete sd;
+          Error("storage.config failed to load");
+          return Result::failure("failed to parse tier '%s'", e);
+        }
+      } else if (0 == strncasecmp(DIRECT_KEY, e, sizeof(DIRECT_KEY) - 1)) {
+        e += sizeof(DIRECT_KEY) - 1;
+        if ('=' == *e) {
+          ++e;
+        }
+        if (0 == strcasecmp(e, "on")) {
+          direct_io = SPAN_DIRECT_IO_ON;
+        } else if (0 == strcasecmp(e, "off")) {
+          direct_io = SPAN_DIRECT_IO_OFF;
+        } else if (0 != strcasecmp(e, "auto")) {
+          delete sd;
+          Error("storage.config failed to load");
+          return Result::failure("failed to parse direct '%s'", e);
+        }
       }
     }
 
     std::string pp = Layout::get()->relative(path);
 
     ns = new Span;
-    Debug("cache_init", "Store::read_config - ns = new Span; ns->init(\"%s\",%" PRId64 "), forced volume=%d%s%s", pp.c_str(), size,
-          volume_num, seed ? " id=" : "", seed ? seed : "");
+    Debug("cache_init", "Store::read_config - ns = new Span; ns->init(\"%s\",%" PRId64 "), forced volume=%d%s%s%s", pp.c_str(),
+          size, volume_num, seed ? " id=" : "", seed ? seed : "", fast_tier ? " tier=fast" : "");
     if ((err = ns->init(pp.c_str(), size))) {
       RecSignalWarning(REC_SIGNAL_SYSTEM_ERROR, "could not initialize storage \"%s\" [%s]", pp.c_str(), err);
       Debug("cache_init", "Store::read_config - could not initialize storage \"%s\" [%s]", pp.c_str(), err);
@@ -417,6 +447,8 @@ Store::read_config()
     if (volume_num > 0) {
       ns->volume_number_set(volume_num);
     }
+    ns->fast_tier = fast_tier;
+    ns->direct_io = direct_io;
 
     // new Span
     {
@@ -0,0 +1,121 @@
+/** @file
+
+  Compaction of the objects hit ahead of the write cursor.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "main.h"
+
+#include <vector>
+
+#define MIN_HITS 2
+#define MAX_PERCENT 10
+
+// Insert a single fragment head at @a offset, written in the pass before the one of the write cursor,
+// and hit it @a hits times.
+static void
+insert_head(Vol *vol, int i, off_t offset, int64_t size, int hits, Dir *dir)
+{
+  CryptoHash key;
+  CryptoContext().hash_immediate(key, &i, sizeof(i));
+
+  dir_clear(dir);
+  dir_set_offset(dir, offset);
+  dir_set_approx_size(dir, size);
+  dir_set_head(dir, 1);
+  dir_set_phase(dir, !vol->header->phase);
+  REQUIRE(dir_insert(&key, vol, dir));
+  for (int h = 0; h < hits; h++) {
+    vol->compact_hit(dir);
+  }
+}
+
+class CacheCompactInit : public CacheInit
+{
+public:
+  CacheCompactInit() {}
+  int
+  cache_init_success_callback(int event, void *e) override
+  {
+    Vol *vol = gvol[0];
+    {
+      SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+
+      // the scan covers the region from past the aggregation buffer to the next scan
+      off_t ps = vol->offset_to_vol_offset(vol->header->write_pos + AGG_SIZE);
+      off_t pe = vol->offset_to_vol_offset(vol->header->write_pos + 2 * EVACUATION_SIZE + (vol->len / PIN_SCAN_EVERY));
+      REQUIRE(pe < vol->offset_to_vol_offset(vol->len + vol->skip));
+      int64_t budget = (vol->len / PIN_SCAN_EVERY) * MAX_PERCENT / 100;
+
+      // one more hot object in the window than the budget allows
+      Dir dir;
+      dir_clear(&dir);
+      dir_set_approx_size(&dir, budget * 2 / 5);
+      int64_t size = dir_approx_size(&dir);
+      int fit      = budget / size;
+      off_t stride = size / CACHE_BLOCK_SIZE + 1;
+      REQUIRE(fit >= 1);
+      REQUIRE(ps + (fit + 2) * stride < pe);
+
+      std::vector<Dir> hot(fit + 1);
+      for (int i = 0; i <= fit; i++) {
+        insert_head(vol, i, ps + i * stride, size, MIN_HITS, &hot[i]);
+      }
+      Dir cold, outside;
+      insert_head(vol, fit + 1, ps + (fit + 1) * stride, size, MIN_HITS - 1, &cold);
+      insert_head(vol, fit + 2, pe, size, MIN_HITS, &outside);
+
+      vol->scan_for_hot_documents();
+
+      int queued = 0;
+      for (Dir &d : hot) {
+        queued += evacuation_block_exists(&d, vol) != nullptr;
+      }
+      CHECK(queued == fit);
+      CHECK(!evacuation_block_exists(&cold, vol));
+      CHECK(!evacuation_block_exists(&outside, vol));
+
+      // the next scan has a new budget and skips the objects queued already
+      vol->scan_for_hot_documents();
+      queued = 0;
+      for (Dir &d : hot) {
+        queued += evacuation_block_exists(&d, vol) != nullptr;
+      }
+      CHECK(queued == fit + 1);
+      CHECK(!evacuation_block_exists(&cold, vol));
+    }
+
+    CacheTestHandler *h = new TerminalTest;
+    this_ethread()->schedule_imm(h);
+    delete this;
+    return 0;
+  }
+};
+
+TEST_CASE("compaction of hot objects ahead of the write cursor", "cache")
+{
+  RecSetRecordInt("proxy.config.cache.compact.min_hits", MIN_HITS, REC_SOURCE_EXPLICIT);
+  RecSetRecordInt("proxy.config.cache.compact.max_percent", MAX_PERCENT, REC_SOURCE_EXPLICIT);
+  init_cache(256 * 1024 * 1024);
+  CacheCompactInit *init = new CacheCompactInit;
+
+  this_ethread()->schedule_imm(init);
+  this_thread()->execute();
+}
@@ -0,0 +1,338 @@
+/** @file
+
+  Promotion to and demotion from the fast cache tier.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "main.h"
+
+#include <functional>
+#include <sys/stat.h>
+
+#define OBJECT_SIZE 16 * 1024
+#define OBJECT_URL "http://www.scw50.com/"
+
+static CryptoHash object_key;
+static Vol *capacity_vol = nullptr;
+static Vol *fast_vol     = nullptr;
+
+// The sum of a cache stat over the test thread and the event threads. Unlike a stat sync, a thread
+// with a negative sum is not counted as 0, the active counts are decremented on other threads.
+static int64_t
+cache_stat(int id)
+{
+  auto thread_sum = [id](EThread *t) {
+    return (reinterpret_cast<RecRawStat *>(reinterpret_cast<char *>(t) + cache_rsb->ethr_stat_offset) + id)->sum;
+  };
+  int64_t sum = thread_sum(this_ethread());
+  for (EThread *t : eventProcessor.active_ethreads()) {
+    sum += thread_sum(t);
+  }
+  for (EThread *t : eventProcessor.active_dthreads()) {
+    sum += thread_sum(t);
+  }
+  return sum;
+}
+
+// Must hold the lock of @a vol.
+static bool
+object_probe(Vol *vol, Dir *dir)
+{
+  Dir *last_collision = nullptr;
+  return dir_probe(&object_key, vol, dir, &last_collision);
+}
+
+// Must hold the lock of @a vol.
+static void
+object_remove(Vol *vol)
+{
+  Dir dir;
+  while (object_probe(vol, &dir)) {
+    dir_delete(&object_key, vol, &dir);
+  }
+}
+
+// The object was written out of the aggregation buffer of @a vol.
+static bool
+object_on_disk(Vol *vol)
+{
+  Dir dir;
+  CACHE_TRY_LOCK(lock, vol->mutex, this_ethread());
+  return lock.is_locked() && object_probe(vol, &dir) && dir_valid(vol, &dir) && !dir_agg_buf_valid(vol, &dir);
+}
+
+// Write the object with an unknown length, as a chunked response is, so the data stays in the head fragment.
+class CacheTierWrite : public CacheTestBase
+{
+public:
+  CacheTierWrite(size_t size, CacheTestHandler *cont, const char *url) : CacheTestBase(cont), _size(size)
+  {
+    this->_write_buffer = new_MIOBuffer(BUFFER_SIZE_INDEX_32K);
+    this->info.create();
+    build_hdrs(this->info, url);
+  }
+
+  ~CacheTierWrite() override
+  {
+    free_MIOBuffer(this->_write_buffer);
+    this->info.destroy();
+  }
+
+  int
+  start_test(int event, void *e) override
+  {
+    HttpCacheKey key = generate_key(this->info);
+    SET_HANDLER(&CacheTierWrite::write_event);
+    cacheProcessor.open_write(this, 0, &key, (CacheHTTPHdr *)this->info.request_get(), nullptr);
+    return 0;
+  }
+
+  int
+  write_event(int event, void *e)
+  {
+    switch (event) {
+    case CACHE_EVENT_OPEN_WRITE:
+      this->vc = (CacheVC *)e;
+      this->vc->set_http_info(&this->info);
+      this->_write_buffer->write(GLOBAL_DATA, this->_size);
+      this->vio = this->vc->do_io_write(this, INT64_MAX, this->_write_buffer->alloc_reader());
+      break;
+    case VC_EVENT_WRITE_READY:
+      this->process_event(this->vio->ndone < static_cast<int64_t>(this->_size) ? event : VC_EVENT_WRITE_COMPLETE);
+      break;
+    default:
+      CHECK(false);
+      this->close();
+      break;
+    }
+    return 0;
+  }
+
+  HTTPInfo info;
+
+private:
+  size_t _size             = 0;
+  MIOBuffer *_write_buffer = nullptr;
+};
+
+class CacheTierWriteTest : public CacheTestHandler
+{
+public:
+  CacheTierWriteTest(size_t size, const char *url)
+  {
+    this->_wt        = new CacheTierWrite(size, this, url);
+    this->_wt->mutex = this->mutex;
+    SET_HANDLER(&CacheTierWriteTest::start_test);
+  }
+
+  void
+  handle_cache_event(int event, CacheTestBase *base) override
+  {
+    if (event == VC_EVENT_WRITE_COMPLETE) {
+      base->close();
+      delete this;
+      return;
+    }
+    CacheTestHandler::handle_cache_event(event, base);
+  }
+};
+
+class CacheTierReadTest : public CacheTestHandler
+{
+public:
+  CacheTierReadTest(size_t size, const char *url)
+  {
+    this->_rt        = new CacheReadTest(size, this, url);
+    this->_rt->mutex = this->mutex;
+    SET_HANDLER(&CacheTierReadTest::start_test);
+  }
+
+  int
+  start_test(int event, void *e)
+  {
+    this_ethread()->schedule_imm(this->_rt);
+    return 0;
+  }
+};
+
+// Run @a step every 10ms until it is done.
+class CacheTierStep : public CacheTestHandler
+{
+public:
+  CacheTierStep(const char *name, std::function<bool()> step) : name(name), step(std::move(step))
+  {
+    SET_HANDLER(&CacheTierStep::step_event);
+  }
+
+  int
+  step_event(int event, void *e)
+  {
+    if (this->step()) {
+      delete this;
+      return 0;
+    }
+    INFO(this->name);
+    REQUIRE(++this->tries < 1000);
+    this_ethread()->schedule_in(this, HRTIME_MSECONDS(10));
+    return 0;
+  }
+
+  const char *name;
+  std::function<bool()> step;
+  int tries = 0;
+};
+
+// Evacuate every block of the fast stripe marked for evacuation, as the write cursor would.
+static bool
+evacuate_fast_vol()
+{
+  static int evacuated = 0;
+  CACHE_TRY_LOCK(lock, fast_vol->mutex, this_ethread());
+  if (!lock.is_locked() || fast_vol->is_io_in_progress()) {
+    return false;
+  }
+  for (int i = 0; i < fast_vol->evacuate_size; i++) {
+    for (EvacuationBlock *b = fast_vol->evacuate[i].head; b; b = b->link.next) {
+      if (!b->f.done) {
+        ++evacuated;
+        fast_vol->evac_range(fast_vol->start, fast_vol->start + fast_vol->len, fast_vol->header->phase);
+        return false;
+      }
+    }
+  }
+  if (!evacuated) {
+    // the read has not closed yet
+    return false;
+  }
+  SET_CONTINUATION_HANDLER(fast_vol, &Vol::aggWrite);
+  return true;
+}
+
+class CacheTierInit : public CacheInit
+{
+public:
+  CacheTierInit() {}
+  int
+  cache_init_success_callback(int event, void *e) override
+  {
+    HTTPInfo info;
+    info.create();
+    build_hdrs(info, OBJECT_URL);
+    HttpCacheKey key = generate_key(info);
+    object_key       = key.hash;
+    capacity_vol     = caches[CACHE_FRAG_TYPE_HTTP]->key_to_vol(&key.hash, key.hostname, key.hostlen);
+    fast_vol         = caches[CACHE_FRAG_TYPE_HTTP]->key_to_fast_vol(&key.hash, key.hostname, key.hostlen);
+    info.destroy();
+    REQUIRE(fast_vol != nullptr);
+    REQUIRE(fast_vol->disk->fast_tier);
+    REQUIRE(!capacity_vol->disk->fast_tier);
+
+    static int64_t active = 0;
+    CacheTestHandler *h   = new CacheTierWriteTest(OBJECT_SIZE, OBJECT_URL);
+    h->add(new CacheTierStep("write to the capacity tier", [] { return object_on_disk(capacity_vol); }));
+
+    // a copy of a directory entry which was written over since is dropped after the read
+    h->add(new CacheTierStep("promote an overwritten entry", [] {
+      Dir dir;
+      CACHE_TRY_LOCK(lock, capacity_vol->mutex, this_ethread());
+      if (!lock.is_locked()) {
+        return false;
+      }
+      REQUIRE(object_probe(capacity_vol, &dir));
+      dir_set_phase(&dir, !dir_phase(&dir));
+      REQUIRE(!dir_valid(capacity_vol, &dir));
+      active = cache_stat(cache_evacuate_active_stat + CACHE_STAT_ACTIVE);
+      cache_tier_promote(capacity_vol, fast_vol, &dir, object_key);
+      return true;
+    }));
+    h->add(new CacheTierStep("drop the overwritten copy", [] {
+      if (cache_stat(cache_evacuate_active_stat + CACHE_STAT_ACTIVE) != active) {
+        return false;
+      }
+      CACHE_TRY_LOCK(lock, fast_vol->mutex, this_ethread());
+      if (!lock.is_locked()) {
+        return false;
+      }
+      Dir dir;
+      CHECK(cache_stat(cache_tier_promotions_stat) == 0);
+      CHECK(!object_probe(fast_vol, &dir));
+      return true;
+    }));
+
+    // the second hit in the capacity tier promotes the object
+    h->add(new CacheTierReadTest(OBJECT_SIZE, OBJECT_URL));
+    h->add(new CacheTierReadTest(OBJECT_SIZE, OBJECT_URL));
+    h->add(new CacheTierStep("promote", [] { return cache_stat(cache_tier_promotions_stat) == 1; }));
+    h->add(new CacheTierStep("write to the fast tier", [] { return object_on_disk(fast_vol); }));
+
+    // without a capacity copy, the hit in the fast tier moves the object back when the cursor reaches it
+    h->add(new CacheTierStep("lose the capacity copy", [] {
+      CACHE_TRY_LOCK(lock, capacity_vol->mutex, this_ethread());
+      if (lock.is_locked()) {
+        object_remove(capacity_vol);
+      }
+      return lock.is_locked();
+    }));
+    h->add(new CacheTierReadTest(OBJECT_SIZE, OBJECT_URL));
+    h->add(new CacheTierStep("evacuate the fast tier", evacuate_fast_vol));
+    h->add(new CacheTierStep("demote", [] {
+      if (cache_stat(cache_tier_demotions_stat) != 1) {
+        return false;
+      }
+      CHECK(cache_stat(cache_tier_capacity_hits_stat) == 2);
+      CHECK(cache_stat(cache_tier_fast_hits_stat) == 1);
+      return true;
+    }));
+
+    // the demoted copy is read once the fast copy is gone
+    h->add(new CacheTierStep("lose the fast copy", [] {
+      CACHE_TRY_LOCK(lock, fast_vol->mutex, this_ethread());
+      if (lock.is_locked()) {
+        object_remove(fast_vol);
+      }
+      return lock.is_locked();
+    }));
+    h->add(new CacheTierReadTest(OBJECT_SIZE, OBJECT_URL));
+    h->add(new CacheTierStep("hit the demoted copy", [] { return cache_stat(cache_tier_capacity_hits_stat) == 3; }));
+    h->add(new TerminalTest);
+    this_ethread()->schedule_imm(h);
+    delete this;
+    return 0;
+  }
+};
+
+TEST_CASE("cache tier promotion and demotion", "cache")
+{
+  // a span for each tier
+  std::string fast_dir = std::string(Layout::get()->prefix) + "/var/trafficserver/fast";
+  mkdir(fast_dir.c_str(), 0755);
+  ::remove((fast_dir + "/cache.db").c_str());
+  RecSetRecordString("proxy.config.cache.storage_filename", const_cast<char *>("storage_tier.config"), REC_SOURCE_EXPLICIT);
+
+  RecSetRecordInt("proxy.config.cache.tier.promote_hits", 2, REC_SOURCE_EXPLICIT);
+  RecSetRecordInt("proxy.config.cache.tier.demote_percent", 100, REC_SOURCE_EXPLICIT);
+  // the directory sync writes out the partial aggregation buffers
+  RecSetRecordInt("proxy.config.cache.dir.sync_frequency", 1, REC_SOURCE_EXPLICIT);
+  init_cache(256 * 1024 * 1024);
+  CacheTierInit *init = new CacheTierInit;
+
+  this_ethread()->schedule_imm(init);
+  this_thread()->execute();
+}
@@ -0,0 +1,198 @@
+/** @file
+
+  Writes and reads of objects whose fragments are compressed on disk.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "main.h"
+
+#define LARGE_FILE 10 * 1024 * 1024
+#define SMALL_FILE 10 * 1024
+
+// Check the fragments took less space on the disk than the data written.
+class CacheCompressCheck : public CacheTestHandler
+{
+public:
+  CacheCompressCheck() { SET_HANDLER(&CacheCompressCheck::check_event); }
+
+  int
+  check_event(int event, void *e)
+  {
+    CHECK(written() - start < (LARGE_FILE + SMALL_FILE) / 2);
+    delete this;
+    return 0;
+  }
+
+  static off_t
+  written()
+  {
+    return gvol[0]->header->write_pos + gvol[0]->agg_buf_pos;
+  }
+
+  off_t start = written();
+};
+
+// Write an object which is not compressed, to push the fragments before it out of the aggregation buffer to the disk.
+class CacheCompressFill : public CacheTestHandler
+{
+public:
+  CacheCompressFill(size_t size, const char *url)
+  {
+    auto wt   = new CacheWriteTest(size, this, url);
+    wt->mutex = this->mutex;
+    wt->info.destroy();
+    wt->info.create();
+    build_hdrs(wt->info, url, "application/octet-stream");
+    this->_wt = wt;
+    SET_HANDLER(&CacheCompressFill::start_test);
+  }
+
+  void
+  handle_cache_event(int event, CacheTestBase *base) override
+  {
+    switch (event) {
+    case VC_EVENT_WRITE_COMPLETE:
+      base->close();
+      delete this;
+      break;
+    default:
+      CacheTestHandler::handle_cache_event(event, base);
+      break;
+    }
+  }
+};
+
+// Evacuate the fragments the reads marked for evacuation, as the write cursor would when it reaches them, and check the
+// evacuation of the compressed fragments completed.
+class CacheCompressEvacuate : public CacheTestHandler
+{
+public:
+  CacheCompressEvacuate() { SET_HANDLER(&CacheCompressEvacuate::evac_event); }
+
+  int
+  evac_event(int event, void *e)
+  {
+    Vol *vol = gvol[0];
+    {
+      CACHE_TRY_LOCK(lock, vol->mutex, this_ethread());
+      if (lock.is_locked() && !vol->is_io_in_progress()) {
+        if (!pending(vol)) {
+          SET_CONTINUATION_HANDLER(vol, &Vol::aggWrite);
+          CHECK(evacuated > 2);
+          CHECK(lookaside_empty(vol));
+          delete this;
+          return 0;
+        }
+        ++evacuated;
+        vol->evac_range(vol->start, vol->start + vol->len, vol->header->phase);
+      }
+    }
+    REQUIRE(evacuated < 1000);
+    this_ethread()->schedule_in(this, HRTIME_MSECONDS(10));
+    return 0;
+  }
+
+  static bool
+  pending(Vol *vol)
+  {
+    for (int i = 0; i < vol->evacuate_size; i++) {
+      for (EvacuationBlock *b = vol->evacuate[i].head; b; b = b->link.next) {
+        if (!b->f.done) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // the earliest fragment stays in the lookaside until the whole object was evacuated
+  static bool
+  lookaside_empty(Vol *vol)
+  {
+    for (auto &l : vol->lookaside) {
+      if (l.head) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  int evacuated = 0;
+};
+
+// Read the object back once its fragments were evacuated.
+class CacheCompressReadAgain : public CacheTestHandler
+{
+public:
+  CacheCompressReadAgain(size_t size, const char *url)
+  {
+    this->_rt        = new CacheReadTest(size, this, url);
+    this->_rt->mutex = this->mutex;
+    SET_HANDLER(&CacheCompressReadAgain::start_test);
+  }
+
+  int
+  start_test(int event, void *e)
+  {
+    this_ethread()->schedule_imm(this->_rt);
+    return 0;
+  }
+};
+
+class CacheCompressInit : public CacheInit
+{
+public:
+  CacheCompressInit() {}
+  int
+  cache_init_success_callback(int event, void *e) override
+  {
+    // text which compresses, the data read back is compared with it
+    char *p = const_cast<char *>(GLOBAL_DATA);
+    for (int i = 0; i < LARGE_FILE; ++i) {
+      p[i] = "<html><body>compressed fragments</body></html>\n"[i % 48];
+    }
+
+    CacheTestHandler *h   = new CacheTestHandler(LARGE_FILE, "http://www.scw33.com/");
+    CacheTestHandler *h2  = new CacheTestHandler(SMALL_FILE, "http://www.scw34.com/");
+    CacheCompressCheck *c = new CacheCompressCheck;
+    TerminalTest *tt      = new TerminalTest;
+    h->add(h2);
+    h->add(c);
+    h->add(new CacheCompressFill(AGG_SIZE, "http://www.scw35.com/"));
+    h->add(new CacheCompressEvacuate);
+    h->add(new CacheCompressReadAgain(LARGE_FILE, "http://www.scw33.com/"));
+    h->add(tt);
+    this_ethread()->schedule_imm(h);
+    delete this;
+    return 0;
+  }
+};
+
+TEST_CASE("cache compressed write -> read", "cache")
+{
+  RecSetRecordInt("proxy.config.cache.compress", CACHE_COMPRESSION_FASTLZ, REC_SOURCE_EXPLICIT);
+  // every read marks the object it read for evacuation
+  RecSetRecordInt("proxy.config.cache.hit_evacuate_percent", 100, REC_SOURCE_EXPLICIT);
+  init_cache(256 * 1024 * 1024);
+  CacheCompressInit *init = new CacheCompressInit;
+
+  this_ethread()->schedule_imm(init);
+  this_thread()->execute();
+}
@@ -391,6 +391,58 @@ private:
   bool _is_read_start = false;
 };
 
+class CacheRWWWaitTest : public CacheRWWTest
+{
+public:
+  CacheRWWWaitTest(size_t size, const char *url = DEFAULT_URL) : CacheRWWTest(size, url) {}
+  /*
+   * test the reader waiting in openReadFromWriter for the writer to store its first fragment,
+   * it must be woken up by the writer instead of timing out.
+   */
+
+  void
+  process_write_event(int event, CacheTestBase *base) override
+  {
+    switch (event) {
+    case CACHE_EVENT_OPEN_WRITE:
+      // open the read before the writer has the http info or any fragment
+      this->_start = Thread::get_hrtime_updated();
+      this->_rt->handleEvent(EVENT_IMMEDIATE, nullptr);
+      base->do_io_write();
+      break;
+    case VC_EVENT_WRITE_READY:
+      if (!this->_is_read_start) {
+        // the read is already open or waiting for the first fragment
+        if (!this->_wt->vc->fragment) {
+          base->reenable();
+        }
+        return;
+      }
+      CacheRWWTest::process_write_event(event, base);
+      break;
+    default:
+      CacheRWWTest::process_write_event(event, base);
+      break;
+    }
+  }
+
+  void
+  process_read_event(int event, CacheTestBase *base) override
+  {
+    if (event == CACHE_EVENT_OPEN_READ) {
+      REQUIRE(this->_wt != nullptr);
+      REQUIRE(this->_wt->vc->fragment >= 1);
+      // woken up by the writer, a timed out wait takes all the read while writer retries
+      REQUIRE(Thread::get_hrtime_updated() - this->_start <
+              HRTIME_MSECONDS(cache_read_while_writer_retry_delay * cache_config_read_while_writer_max_retries));
+    }
+    CacheRWWTest::process_read_event(event, base);
+  }
+
+private:
+  ink_hrtime _start = 0;
+};
+
 class CacheRWWCacheInit : public CacheInit
 {
 public:
@@ -398,13 +450,15 @@ public:
   int
   cache_init_success_callback(int event, void *e) override
   {
-    CacheRWWTest *crww        = new CacheRWWTest(LARGE_FILE);
-    CacheRWWErrorTest *crww_l = new CacheRWWErrorTest(LARGE_FILE, "http://www.scw22.com/");
-    CacheRWWEOSTest *crww_eos = new CacheRWWEOSTest(LARGE_FILE, "ttp://www.scw44.com/");
-    TerminalTest *tt          = new TerminalTest();
+    CacheRWWTest *crww          = new CacheRWWTest(LARGE_FILE);
+    CacheRWWErrorTest *crww_l   = new CacheRWWErrorTest(LARGE_FILE, "http://www.scw22.com/");
+    CacheRWWEOSTest *crww_eos   = new CacheRWWEOSTest(LARGE_FILE, "ttp://www.scw44.com/");
+    CacheRWWWaitTest *crww_wait = new CacheRWWWaitTest(LARGE_FILE, "http://www.scw66.com/");
+    TerminalTest *tt            = new TerminalTest();
 
     crww->add(crww_l);
     crww->add(crww_eos);
+    crww->add(crww_wait);
     crww->add(tt);
     this_ethread()->schedule_imm(crww);
     delete this;
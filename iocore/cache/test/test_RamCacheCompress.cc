@@ -0,0 +1,118 @@
+/** @file
+
+  The content type policy of the RAM cache compression for the objects read from disk.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "main.h"
+
+#define SMALL_FILE 10 * 1024
+
+// The skipped entries counted by all the threads, the test thread is not one of the event threads.
+static int64_t
+compress_skipped()
+{
+  RecData data;
+  RecRawStatSyncSum(nullptr, RECD_INT, &data, cache_rsb, cache_ram_cache_compress_skipped_stat);
+  RecRawStat *local = reinterpret_cast<RecRawStat *>(reinterpret_cast<char *>(this_ethread()) + cache_rsb->ethr_stat_offset) +
+                      cache_ram_cache_compress_skipped_stat;
+  return data.rec_int + local->sum;
+}
+
+// Write and read an object of @a content_type, the read puts its fragments in the RAM cache.
+class CacheContentTypeTest : public CacheTestHandler
+{
+public:
+  CacheContentTypeTest(size_t size, const char *url, const char *content_type)
+  {
+    auto wt = new CacheWriteTest(size, this, url);
+    auto rt = new CacheReadTest(size, this, url);
+
+    wt->info.destroy();
+    wt->info.create();
+    build_hdrs(wt->info, url, content_type);
+    rt->info.destroy();
+    rt->info.create();
+    build_hdrs(rt->info, url, content_type);
+
+    wt->mutex = this->mutex;
+    rt->mutex = this->mutex;
+    this->_wt = wt;
+    this->_rt = rt;
+    SET_HANDLER(&CacheContentTypeTest::start_test);
+  }
+};
+
+// Check the RAM cache entries skipped since the last check.
+class CacheSkippedCheck : public CacheTestHandler
+{
+public:
+  CacheSkippedCheck(int64_t expected) : expected(expected) { SET_HANDLER(&CacheSkippedCheck::check_event); }
+
+  int
+  check_event(int event, void *e)
+  {
+    CHECK(compress_skipped() - start == expected);
+    start = compress_skipped();
+    delete this;
+    return 0;
+  }
+
+  static int64_t start;
+  int64_t expected;
+};
+
+int64_t CacheSkippedCheck::start = 0;
+
+class CacheRamCompressInit : public CacheInit
+{
+public:
+  CacheRamCompressInit() {}
+  int
+  cache_init_success_callback(int event, void *e) override
+  {
+    CacheSkippedCheck::start = compress_skipped();
+
+    // neither the head nor the body of media is worth compressing
+    CacheTestHandler *h = new CacheContentTypeTest(SMALL_FILE, "http://www.scw40.com/", "image/jpeg");
+    h->add(new CacheSkippedCheck(2));
+    h->add(new CacheContentTypeTest(SMALL_FILE, "http://www.scw41.com/", "text/html"));
+    h->add(new CacheSkippedCheck(0));
+    h->add(new TerminalTest);
+    this_ethread()->schedule_imm(h);
+    delete this;
+    return 0;
+  }
+};
+
+TEST_CASE("ram cache compression policy", "cache")
+{
+  // only the CLFUS RAM cache compresses
+  RecSetRecordInt("proxy.config.cache.ram_cache.algorithm", RAM_CACHE_ALGORITHM_CLFUS, REC_SOURCE_EXPLICIT);
+  RecSetRecordInt("proxy.config.cache.ram_cache.compress", CACHE_COMPRESSION_FASTLZ, REC_SOURCE_EXPLICIT);
+  // the first read of an object puts it in the RAM cache
+  RecSetRecordInt("proxy.config.cache.ram_cache.size", 16 * 1024 * 1024, REC_SOURCE_EXPLICIT);
+  RecSetRecordInt("proxy.config.cache.ram_cache.use_seen_filter", 0, REC_SOURCE_EXPLICIT);
+  init_cache(256 * 1024 * 1024);
+  CacheRamCompressInit *init = new CacheRamCompressInit;
+
+  this_ethread()->schedule_imm(init);
+  this_thread()->execute();
+}
@@ -0,0 +1,283 @@
+/** @file
+
+  Sparse writes of the chunks of an object and reads of the chunks present.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#define CHUNK_SIZE 256 * 1024
+#define OBJECT_SIZE 4 * CHUNK_SIZE
+
+#include "main.h"
+
+static const char *SPARSE_URL = "http://www.scw22.com/";
+
+// Write @a size bytes of the object from @a offset, only the whole chunks are stored.
+class CacheSparseWriteTest : public CacheTestBase
+{
+public:
+  CacheSparseWriteTest(int64_t offset, size_t size, CacheTestHandler *cont)
+    : CacheTestBase(cont), _offset(offset), _size(size), _cursor(GLOBAL_DATA + offset)
+  {
+    this->_write_buffer = new_MIOBuffer(BUFFER_SIZE_INDEX_4K);
+    this->info.create();
+    build_hdrs(this->info, SPARSE_URL);
+  }
+
+  int
+  start_test(int event, void *e) override
+  {
+    HttpCacheKey key   = generate_key(this->info);
+    HTTPInfo *old_info = this->old_info.valid() ? &this->old_info : nullptr;
+
+    if (!old_info) {
+      HTTPChunkMap map;
+      REQUIRE(map.init(CHUNK_SIZE, OBJECT_SIZE));
+      this->info.response_get()->set_content_length(OBJECT_SIZE);
+      map.store(this->info.response_get());
+    }
+    SET_HANDLER(&CacheSparseWriteTest::write_event);
+    cacheProcessor.open_write(this, 0, &key, (CacheHTTPHdr *)this->info.request_get(), old_info);
+    return 0;
+  }
+
+  int
+  write_event(int event, void *e)
+  {
+    switch (event) {
+    case CACHE_EVENT_OPEN_WRITE:
+      this->vc = static_cast<CacheVC *>(e);
+      this->process_event(event);
+      break;
+    case VC_EVENT_WRITE_READY:
+      this->process_event(event);
+      this->fill_data();
+      break;
+    case VC_EVENT_WRITE_COMPLETE:
+      this->process_event(event);
+      break;
+    default:
+      this->close();
+      CHECK(false);
+      break;
+    }
+    return 0;
+  }
+
+  void
+  fill_data()
+  {
+    size_t size = std::min(WRITE_LIMIT, this->_size);
+    auto n      = this->_write_buffer->write(this->_cursor, size);
+    this->_size -= n;
+    this->_cursor += n;
+  }
+
+  void
+  do_io_write(size_t size = 0) override
+  {
+    this->vc->set_http_info(&this->info);
+    REQUIRE(this->vc->set_sparse_write(this->_offset));
+    this->vio = this->vc->do_io_write(this, this->_size, this->_write_buffer->alloc_reader());
+  }
+
+  HTTPInfo info;
+  HTTPInfo old_info;
+
+private:
+  int64_t _offset          = 0;
+  size_t _size             = 0;
+  const char *_cursor      = nullptr;
+  MIOBuffer *_write_buffer = nullptr;
+};
+
+// Read @a size bytes of the object from @a offset and check the chunks present in the map.
+class CacheSparseReadTest : public CacheTestBase
+{
+public:
+  CacheSparseReadTest(int64_t offset, size_t size, int first_chunk, CacheTestHandler *cont)
+    : CacheTestBase(cont), _offset(offset), _size(size), _first_chunk(first_chunk), _cursor(GLOBAL_DATA + offset)
+  {
+    this->_read_buffer = new_MIOBuffer(BUFFER_SIZE_INDEX_4K);
+    this->_reader      = this->_read_buffer->alloc_reader();
+    this->info.create();
+    build_hdrs(this->info, SPARSE_URL);
+  }
+
+  int
+  start_test(int event, void *e) override
+  {
+    HttpCacheKey key = generate_key(this->info);
+
+    SET_HANDLER(&CacheSparseReadTest::read_event);
+    cacheProcessor.open_read(this, &key, (CacheHTTPHdr *)this->info.request_get(), &this->params);
+    return 0;
+  }
+
+  int
+  read_event(int event, void *e)
+  {
+    switch (event) {
+    case CACHE_EVENT_OPEN_READ: {
+      this->vc = static_cast<CacheVC *>(e);
+
+      HTTPChunkMap map;
+      REQUIRE(map.load(this->vc->alternate.response_get(), OBJECT_SIZE));
+      CHECK(map.first() == this->_first_chunk);
+      CHECK(map.covers(this->_first_chunk * CHUNK_SIZE, OBJECT_SIZE - 1));
+      this->process_event(event);
+      break;
+    }
+    case VC_EVENT_READ_READY:
+      while (this->_reader->block_read_avail()) {
+        auto str = this->_reader->block_read_view();
+        if (memcmp(str.data(), this->_cursor, str.size()) != 0) {
+          CHECK(false);
+          this->close();
+          TEST_DONE();
+          return 0;
+        }
+        this->_reader->consume(str.size());
+        this->_cursor += str.size();
+      }
+      this->process_event(event);
+      break;
+    case VC_EVENT_READ_COMPLETE:
+      this->process_event(event);
+      break;
+    default:
+      CHECK(false);
+      this->close();
+      break;
+    }
+    return 0;
+  }
+
+  void
+  do_io_read(size_t size = 0) override
+  {
+    this->vio = this->vc->do_io_pread(this, this->_size, this->_read_buffer, this->_offset);
+  }
+
+  HTTPInfo info;
+
+private:
+  int64_t _offset         = 0;
+  size_t _size            = 0;
+  int _first_chunk        = 0;
+  const char *_cursor     = nullptr;
+  MIOBuffer *_read_buffer = nullptr;
+  IOBufferReader *_reader = nullptr;
+  OverridableHttpConfigParams params;
+};
+
+// Write the object from the middle of its first chunk, read the chunks stored and fill the first
+// chunk with an update of the alternate.
+class CacheSparseFill : public CacheTestHandler
+{
+public:
+  CacheSparseFill()
+  {
+    this->_wt    = new CacheSparseWriteTest(CHUNK_SIZE / 2, OBJECT_SIZE - CHUNK_SIZE / 2, this);
+    this->_rt    = new CacheSparseReadTest(CHUNK_SIZE, OBJECT_SIZE - CHUNK_SIZE, 1, this);
+    this->_fill  = new CacheSparseWriteTest(0, CHUNK_SIZE, this);
+    this->_check = new CacheSparseReadTest(0, OBJECT_SIZE, 0, this);
+
+    this->_wt->mutex    = this->mutex;
+    this->_rt->mutex    = this->mutex;
+    this->_fill->mutex  = this->mutex;
+    this->_check->mutex = this->mutex;
+
+    SET_HANDLER(&CacheSparseFill::start_test);
+  }
+
+  int
+  start_test(int event, void *e)
+  {
+    REQUIRE(event == EVENT_IMMEDIATE);
+    this_ethread()->schedule_imm(this->_wt);
+    return 0;
+  }
+
+  void
+  handle_cache_event(int event, CacheTestBase *base) override
+  {
+    switch (event) {
+    case CACHE_EVENT_OPEN_WRITE:
+      base->do_io_write();
+      break;
+    case CACHE_EVENT_OPEN_READ:
+      if (base == this->_rt) {
+        this->_fill->info.copy(&base->vc->alternate);
+        this->_fill->old_info.copy(&base->vc->alternate);
+      }
+      base->do_io_read();
+      break;
+    case VC_EVENT_WRITE_READY:
+    case VC_EVENT_READ_READY:
+      base->reenable();
+      break;
+    case VC_EVENT_WRITE_COMPLETE:
+      base->close();
+      this_ethread()->schedule_imm(base == this->_wt ? this->_rt : this->_check);
+      break;
+    case VC_EVENT_READ_COMPLETE:
+      base->close();
+      if (base == this->_rt) {
+        this_ethread()->schedule_imm(this->_fill);
+      } else {
+        delete this;
+      }
+      break;
+    default:
+      REQUIRE(false);
+      break;
+    }
+  }
+
+private:
+  CacheSparseWriteTest *_fill = nullptr;
+  CacheSparseReadTest *_check = nullptr;
+};
+
+class CacheSparseInit : public CacheInit
+{
+public:
+  CacheSparseInit() {}
+  int
+  cache_init_success_callback(int event, void *e) override
+  {
+    CacheSparseFill *fill = new CacheSparseFill;
+    TerminalTest *tt      = new TerminalTest;
+
+    fill->add(tt);
+    this_ethread()->schedule_imm(fill);
+    delete this;
+    return 0;
+  }
+};
+
+TEST_CASE("cache sparse write -> read", "cache")
+{
+  init_cache(256 * 1024 * 1024);
+  CacheSparseInit *init = new CacheSparseInit;
+
+  this_ethread()->schedule_imm(init);
+  this_thread()->execute();
+}
@@ -0,0 +1,233 @@
+/** @file
+
+  Loading the stripes of a disk one at a time and serving while the others recover.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "main.h"
+
+#include <functional>
+#include <string>
+
+#define OBJECT_SIZE 1024
+
+// The stripe kept from loading, and an object on it and on a stripe which is online.
+static Vol *held_vol = nullptr;
+static std::string held_url;
+static std::string online_url;
+
+// The stripes of the single disk load in one lane, each one starts once the one before it is online.
+static void
+check_lane(int from, int to)
+{
+  for (int i = from; i < to; i++) {
+    Vol *vol  = theCache->vols[i];
+    Vol *next = theCache->vols[i + 1];
+    INFO("stripe " << i);
+    CHECK(next->load_start >= vol->load_done);
+  }
+}
+
+static bool
+in_gvol(const Vol *vol)
+{
+  for (int i = 0; i < gnvol; i++) {
+    if (gvol[i] == vol) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static Vol *
+url_vol(const char *url)
+{
+  HTTPInfo info;
+  info.create();
+  build_hdrs(info, url);
+  HttpCacheKey key = generate_key(info);
+  Vol *vol         = theCache->key_to_vol(&key.hash, key.hostname, key.hostlen);
+  info.destroy();
+  return vol;
+}
+
+// Take the lock of the last stripe before its turn to load comes. The test thread is not an event thread,
+// the initialization of the stripe is retried there until the lock is released.
+class StripeHold : public Continuation
+{
+public:
+  StripeHold() : Continuation(new_ProxyMutex()) { SET_HANDLER(&StripeHold::hold_event); }
+
+  int
+  hold_event(int event, void *e)
+  {
+    if (!theCache || !theCache->cache_read_done) {
+      this_ethread()->schedule_in(this, HRTIME_MSECONDS(1));
+      return 0;
+    }
+    held_vol = theCache->vols[theCache->total_nvol - 1];
+    MUTEX_TAKE_LOCK(held_vol->mutex, this_ethread());
+    REQUIRE(held_vol->load_start == 0);
+    delete this;
+    return 0;
+  }
+};
+
+// The result of a cache operation which fails right away.
+class CacheResult : public Continuation
+{
+public:
+  CacheResult() : Continuation(new_ProxyMutex()) { SET_HANDLER(&CacheResult::result_event); }
+
+  int
+  result_event(int event, void *e)
+  {
+    this->event = event;
+    this->data  = reinterpret_cast<intptr_t>(e);
+    return 0;
+  }
+
+  int event     = 0;
+  intptr_t data = 0;
+};
+
+// Run @a step every 10ms until it is done.
+class StripeLoadStep : public CacheTestHandler
+{
+public:
+  StripeLoadStep(const char *name, std::function<bool()> step) : name(name), step(std::move(step))
+  {
+    SET_HANDLER(&StripeLoadStep::step_event);
+  }
+
+  int
+  step_event(int event, void *e)
+  {
+    if (this->step()) {
+      delete this;
+      return 0;
+    }
+    INFO(this->name);
+    REQUIRE(++this->tries < 1000);
+    this_ethread()->schedule_in(this, HRTIME_MSECONDS(10));
+    return 0;
+  }
+
+  const char *name;
+  std::function<bool()> step;
+  int tries = 0;
+};
+
+class StripeLoadInit : public CacheInit
+{
+public:
+  StripeLoadInit() {}
+  int
+  cache_init_success_callback(int event, void *e) override
+  {
+    // the cache is ready with the first stripe
+    REQUIRE(theCache->total_nvol == 4);
+    REQUIRE(held_vol != nullptr);
+    REQUIRE(!held_vol->online);
+
+    char url[64];
+    for (int i = 0; i < 1000 && (held_url.empty() || online_url.empty()); i++) {
+      snprintf(url, sizeof(url), "http://www.scw41-%d.com/", i);
+      (url_vol(url) == held_vol ? held_url : online_url) = url;
+    }
+    REQUIRE(!held_url.empty());
+    REQUIRE(!online_url.empty());
+
+    CacheTestHandler *h = new StripeLoadStep("load the other stripes", [] {
+      for (int i = 0; i < theCache->total_nvol - 1; i++) {
+        if (!theCache->vols[i]->online) {
+          return false;
+        }
+      }
+      CHECK(gnvol == theCache->total_nvol - 1);
+      CHECK(!held_vol->online);
+      CHECK(!in_gvol(held_vol));
+      CHECK(held_vol->load_done == 0);
+      check_lane(0, theCache->total_nvol - 2);
+      return true;
+    });
+
+    h->add(new StripeLoadStep("refuse the held stripe", [] {
+      HTTPInfo info;
+      info.create();
+      build_hdrs(info, held_url.c_str());
+      HttpCacheKey key      = generate_key(info);
+      CacheHTTPHdr *request = info.request_get();
+      CacheResult result;
+      SCOPED_MUTEX_LOCK(lock, result.mutex, this_ethread());
+
+      cacheProcessor.open_read(&result, &key, request, nullptr);
+      CHECK(result.event == CACHE_EVENT_OPEN_READ_FAILED);
+      CHECK(result.data == -ECACHE_NOT_READY);
+      cacheProcessor.open_write(&result, 0, &key, request, nullptr);
+      CHECK(result.event == CACHE_EVENT_OPEN_WRITE_FAILED);
+      CHECK(result.data == -ECACHE_NOT_READY);
+      cacheProcessor.lookup(&result, &key);
+      CHECK(result.event == CACHE_EVENT_LOOKUP_FAILED);
+      cacheProcessor.remove(&result, &key);
+      CHECK(result.event == CACHE_EVENT_REMOVE_FAILED);
+      info.destroy();
+      return true;
+    }));
+
+    // the stripes which are online serve meanwhile
+    h->add(new CacheTestHandler(OBJECT_SIZE, online_url.c_str()));
+    h->add(new StripeLoadStep("release the held stripe", [] {
+      MUTEX_UNTAKE_LOCK(held_vol->mutex, this_ethread());
+      return true;
+    }));
+    h->add(new StripeLoadStep("load the held stripe", [] {
+      if (!held_vol->online) {
+        return false;
+      }
+      CHECK(gnvol == theCache->total_nvol);
+      CHECK(in_gvol(held_vol));
+      check_lane(theCache->total_nvol - 2, theCache->total_nvol - 1);
+      CHECK(held_vol->load_done != 0);
+      return true;
+    }));
+    h->add(new CacheTestHandler(OBJECT_SIZE, held_url.c_str()));
+    h->add(new TerminalTest);
+    this_ethread()->schedule_imm(h);
+    delete this;
+    return 0;
+  }
+};
+
+TEST_CASE("stripe load lanes and serving while recovering", "cache")
+{
+  // four stripes on a single disk
+  RecSetRecordString("proxy.config.cache.storage_filename", const_cast<char *>("storage_lanes.config"), REC_SOURCE_EXPLICIT);
+  RecSetRecordString("proxy.config.cache.volume_filename", const_cast<char *>("volume_lanes.config"), REC_SOURCE_EXPLICIT);
+
+  RecSetRecordInt("proxy.config.cache.init.stripes_per_disk", 1, REC_SOURCE_EXPLICIT);
+  RecSetRecordInt("proxy.config.cache.init.serve_while_recovering", 1, REC_SOURCE_EXPLICIT);
+  init_cache(768 * 1024 * 1024);
+  StripeLoadInit *init = new StripeLoadInit;
+
+  this_ethread()->schedule_imm(new StripeHold);
+  this_ethread()->schedule_imm(init);
+  this_thread()->execute();
+}
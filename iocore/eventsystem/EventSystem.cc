@@ -63,4 +63,12 @@ ink_event_system_init(ts::ModuleVersion v)
 #endif
 
   init_buffer_allocators(iobuffer_advice);
+
+  int slabs_enabled     = 0;
+  int64_t slab_min_size = 16384;
+  REC_ReadConfigInteger(slabs_enabled, "proxy.config.allocator.iobuffer_slabs");
+  REC_ReadConfigInteger(slab_min_size, "proxy.config.allocator.iobuffer_slab_min_size");
+  if (slabs_enabled) {
+    init_buffer_slab_allocator(slab_min_size, iobuffer_advice);
+  }
 }
@@ -33,6 +33,7 @@
 // General Buffer Allocator
 //
 inkcoreapi Allocator ioBufAllocator[DEFAULT_BUFFER_SIZES];
+inkcoreapi SlabAllocator *ioBufSlabAllocator = nullptr;
 inkcoreapi ClassAllocator<MIOBuffer> ioAllocator("ioAllocator", DEFAULT_BUFFER_NUMBER);
 inkcoreapi ClassAllocator<IOBufferData> ioDataAllocator("ioDataAllocator", DEFAULT_BUFFER_NUMBER);
 inkcoreapi ClassAllocator<IOBufferBlock> ioBlockAllocator("ioBlockAllocator", DEFAULT_BUFFER_NUMBER);
@@ -60,6 +61,16 @@ init_buffer_allocators(int iobuffer_advice)
   }
 }
 
+void
+init_buffer_slab_allocator(int64_t min_size, int iobuffer_advice)
+{
+  // Slabs of at least a huge page, objects aligned for direct disk I/O.
+  ioBufSlabAllocator = new SlabAllocator("ioBufSlabAllocator", std::max<int64_t>(min_size, DEFAULT_BUFFER_BASE_SIZE),
+                                         DEFAULT_MAX_BUFFER_SIZE, ats_pagesize(), 2 * 1024 * 1024, iobuffer_advice);
+  Debug("iobuffer", "slab allocator enabled for sizes %" PRId64 " to %d in %zu classes", min_size, DEFAULT_MAX_BUFFER_SIZE,
+        ioBufSlabAllocator->n_classes());
+}
+
 int64_t
 MIOBuffer::remove_append(IOBufferReader *r)
 {
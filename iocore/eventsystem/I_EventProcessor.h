@@ -272,6 +272,13 @@ public:
   */
   void shutdown() override;
 
+  /// NUMA node the ET_NET threads are bound to, or -1 if they are not restricted to a node.
+  int net_numa_node() const;
+
+  /// Bind the calling thread to the NUMA node of the ET_NET threads, if there is one.
+  /// This is intended for dedicated threads (e.g. accept and disk threads) which serve the net threads.
+  void bind_to_net_numa_node();
+
   /**
     Allocates size bytes on the event threads. This function is thread
     safe.
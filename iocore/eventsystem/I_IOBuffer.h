@@ -42,6 +42,7 @@
 #include "tscore/ink_platform.h"
 #include "tscore/ink_apidefs.h"
 #include "tscore/Allocator.h"
+#include "tscore/SlabAllocator.h"
 #include "tscore/Ptr.h"
 #include "tscore/ink_assert.h"
 #include "tscore/ink_resource.h"
@@ -70,6 +71,7 @@ enum AllocType {
   MEMALIGNED,
   DEFAULT_ALLOC,
   CONSTANT,
+  SLAB_ALLOCATED,
 };
 
 #define DEFAULT_BUFFER_NUMBER 128
@@ -124,8 +126,12 @@ enum AllocType {
 #define BUFFER_SIZE_INDEX_FOR_CONSTANT_SIZE(_size) (_size + DEFAULT_BUFFER_SIZES)
 
 inkcoreapi extern Allocator ioBufAllocator[DEFAULT_BUFFER_SIZES];
+/// Slab allocator for sized buffers, @c nullptr if not enabled.
+inkcoreapi extern SlabAllocator *ioBufSlabAllocator;
 
 void init_buffer_allocators(int iobuffer_advice);
+/// Enable the slab allocator for sized buffers from @a min_size up to the largest buffer size.
+void init_buffer_slab_allocator(int64_t min_size, int iobuffer_advice);
 
 /**
   A reference counted wrapper around fast allocated or malloced memory.
@@ -198,8 +204,10 @@ public:
 
     @param size_index
     @param type of allocation to use; see remarks section.
+    @param requested bytes the caller asked for, only used for the
+    statistics of SLAB_ALLOCATED memory. 0 for the size of size_index.
   */
-  void alloc(int64_t size_index, AllocType type = DEFAULT_ALLOC);
+  void alloc(int64_t size_index, AllocType type = DEFAULT_ALLOC, int64_t requested = 0);
 
   /**
     Provides access to the allocated memory. Returns the address of the
@@ -1459,7 +1467,7 @@ extern IOBufferData *new_IOBufferData_internal(
 #ifdef TRACK_BUFFER_USER
   const char *location,
 #endif
-  int64_t size_index = default_large_iobuffer_size, AllocType type = DEFAULT_ALLOC);
+  int64_t size_index = default_large_iobuffer_size, AllocType type = DEFAULT_ALLOC, int64_t requested = 0);
 
 extern IOBufferData *new_xmalloc_IOBufferData_internal(
 #ifdef TRACK_BUFFER_USER
@@ -1473,6 +1481,18 @@ extern IOBufferData *new_constant_IOBufferData_internal(
 #endif
   void *b, int64_t size);
 
+/** Allocate an IOBufferData for at least @a size bytes.
+
+    If the slab allocator is enabled and covers @a size, the block comes from the slab size
+    class for @a size, which is much closer to @a size than the power of two size classes.
+    Otherwise this is the same as allocating with the size index for @a size.
+*/
+extern IOBufferData *new_sized_IOBufferData_internal(
+#ifdef TRACK_BUFFER_USER
+  const char *location,
+#endif
+  int64_t size, AllocType type = MEMALIGNED);
+
 #ifdef TRACK_BUFFER_USER
 class IOBufferData_tracker
 {
@@ -1492,10 +1512,12 @@ public:
 #define new_IOBufferData IOBufferData_tracker(RES_PATH("memory/IOBuffer/"))
 #define new_xmalloc_IOBufferData(b, size) new_xmalloc_IOBufferData_internal(RES_PATH("memory/IOBuffer/"), (b), (size))
 #define new_constant_IOBufferData(b, size) new_constant_IOBufferData_internal(RES_PATH("memory/IOBuffer/"), (b), (size))
+#define new_sized_IOBufferData(size, type) new_sized_IOBufferData_internal(RES_PATH("memory/IOBuffer/"), (size), (type))
 #else
 #define new_IOBufferData new_IOBufferData_internal
 #define new_xmalloc_IOBufferData new_xmalloc_IOBufferData_internal
 #define new_constant_IOBufferData new_constant_IOBufferData_internal
+#define new_sized_IOBufferData new_sized_IOBufferData_internal
 #endif
 
 extern int64_t iobuffer_size_to_index(int64_t size, int64_t max = max_iobuffer_size);
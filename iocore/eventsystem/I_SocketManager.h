@@ -84,6 +84,9 @@ struct SocketManager {
   int recv(int s, void *buf, int len, int flags);
   int recvfrom(int fd, void *buf, int size, int flags, struct sockaddr *addr, socklen_t *addrlen);
   int recvmsg(int fd, struct msghdr *m, int flags, void *pOLP = nullptr);
+#if HAVE_RECVMMSG
+  int recvmmsg(int fd, struct mmsghdr *msgs, unsigned int vlen, int flags);
+#endif
 
   int64_t write(int fd, void *buf, int len, void *pOLP = nullptr);
   int64_t writev(int fd, struct iovec *vector, size_t count);
@@ -93,6 +96,9 @@ struct SocketManager {
   int send(int fd, void *buf, int len, int flags);
   int sendto(int fd, void *buf, int len, int flags, struct sockaddr const *to, int tolen);
   int sendmsg(int fd, struct msghdr *m, int flags, void *pOLP = nullptr);
+#if HAVE_SENDMMSG
+  int sendmmsg(int fd, struct mmsghdr *msgs, unsigned int vlen, int flags);
+#endif
   int64_t lseek(int fd, off_t offset, int whence);
   int fstat(int fd, struct stat *);
   int unlink(char *buf);
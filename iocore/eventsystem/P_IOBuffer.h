@@ -263,22 +263,44 @@ new_IOBufferData_internal(
 #ifdef TRACK_BUFFER_USER
   const char *loc,
 #endif
-  int64_t size_index, AllocType type)
+  int64_t size_index, AllocType type, int64_t requested)
 {
   IOBufferData *d = THREAD_ALLOC(ioDataAllocator, this_thread());
 #ifdef TRACK_BUFFER_USER
   d->_location = loc;
 #endif
-  d->alloc(size_index, type);
+  d->alloc(size_index, type, requested);
   return d;
 }
 
+TS_INLINE IOBufferData *
+new_sized_IOBufferData_internal(
+#ifdef TRACK_BUFFER_USER
+  const char *loc,
+#endif
+  int64_t size, AllocType type)
+{
+  int64_t size_index;
+  if (ioBufSlabAllocator && ioBufSlabAllocator->covers(size)) {
+    type       = SLAB_ALLOCATED;
+    size_index = BUFFER_SIZE_INDEX_FOR_XMALLOC_SIZE(ioBufSlabAllocator->class_size(size));
+  } else {
+    size_index = iobuffer_size_to_index(size, MAX_BUFFER_SIZE_INDEX);
+  }
+  // Pass the size on so the slab statistics see the real request, not the class size.
+  return new_IOBufferData_internal(
+#ifdef TRACK_BUFFER_USER
+    loc,
+#endif
+    size_index, type, size);
+}
+
 // IRIX has a compiler bug which prevents this function
 // from being compiled correctly at -O3
 // so it is DUPLICATED in IOBuffer.cc
 // ****** IF YOU CHANGE THIS FUNCTION change that one as well.
 TS_INLINE void
-IOBufferData::alloc(int64_t size_index, AllocType type)
+IOBufferData::alloc(int64_t size_index, AllocType type, int64_t requested)
 {
   if (_data) {
     dealloc();
@@ -305,6 +327,17 @@ IOBufferData::alloc(int64_t size_index, AllocType type)
       _data = (char *)ats_malloc(BUFFER_SIZE_FOR_XMALLOC(size_index));
     }
     break;
+  case SLAB_ALLOCATED:
+    // The size index is the exact size of a slab class.
+    ink_assert(BUFFER_SIZE_INDEX_IS_XMALLOCED(size_index));
+    if (ioBufSlabAllocator) {
+      _data = (char *)ioBufSlabAllocator->alloc(requested ? requested : BUFFER_SIZE_FOR_XMALLOC(size_index));
+    }
+    if (_data == nullptr) {
+      _mem_type = MEMALIGNED;
+      _data     = (char *)ats_memalign(ats_pagesize(), BUFFER_SIZE_FOR_XMALLOC(size_index));
+    }
+    break;
   }
 }
 
@@ -332,6 +365,9 @@ IOBufferData::dealloc()
       ats_free(_data);
     }
     break;
+  case SLAB_ALLOCATED:
+    ioBufSlabAllocator->free(_data, BUFFER_SIZE_FOR_XMALLOC(_size_index));
+    break;
   }
   _data       = nullptr;
   _size_index = BUFFER_SIZE_NOT_ALLOCATED;
@@ -195,6 +195,20 @@ SocketManager::recvmsg(int fd, struct msghdr *m, int flags, void * /* pOLP ATS_U
   return r;
 }
 
+#if HAVE_RECVMMSG
+TS_INLINE int
+SocketManager::recvmmsg(int fd, struct mmsghdr *msgs, unsigned int vlen, int flags)
+{
+  int r;
+  do {
+    if (unlikely((r = ::recvmmsg(fd, msgs, vlen, flags, nullptr)) < 0)) {
+      r = -errno;
+    }
+  } while (r == -EINTR);
+  return r;
+}
+#endif
+
 TS_INLINE int64_t
 SocketManager::write(int fd, void *buf, int size, void * /* pOLP ATS_UNUSED */)
 {
@@ -275,6 +289,20 @@ SocketManager::sendmsg(int fd, struct msghdr *m, int flags, void * /* pOLP ATS_U
   return r;
 }
 
+#if HAVE_SENDMMSG
+TS_INLINE int
+SocketManager::sendmmsg(int fd, struct mmsghdr *msgs, unsigned int vlen, int flags)
+{
+  int r;
+  do {
+    if (unlikely((r = ::sendmmsg(fd, msgs, vlen, flags)) < 0)) {
+      r = -errno;
+    }
+  } while (r == -EINTR);
+  return r;
+}
+#endif
+
 TS_INLINE int64_t
 SocketManager::lseek(int fd, off_t offset, int whence)
 {
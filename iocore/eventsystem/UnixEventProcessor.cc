@@ -46,11 +46,16 @@ public:
   void init();
   /// Set the affinity for the current thread.
   int set_affinity(int, Event *);
+  /// Bind the current (dedicated) thread to the NUMA node of the ET_NET threads.
+  void bind_to_net_node();
   /// Allocate a stack.
   /// @internal This is the external entry point and is different depending on
   /// whether HWLOC is enabled.
   void *alloc_stack(EThread *t, size_t stacksize);
 
+  /// NUMA node the ET_NET threads are restricted to, -1 for all nodes.
+  int net_node = -1;
+
 protected:
   /// Allocate a hugepage stack.
   /// If huge pages are not enable, allocate a basic stack.
@@ -62,9 +67,13 @@ protected:
   void *alloc_numa_stack(EThread *t, size_t stacksize);
 
 private:
+  /// Find the object to bind @a t to.
+  hwloc_obj_t thread_obj(EThread *t);
+
   hwloc_obj_type_t obj_type = HWLOC_OBJ_MACHINE;
   int obj_count             = 0;
   char const *obj_name      = nullptr;
+  hwloc_obj_t net_node_obj  = nullptr; ///< NUMA node object for @a net_node.
 #endif
 };
 
@@ -118,6 +127,19 @@ EventMetricStatSync(const char *, RecDataT, RecData *, RecRawStatBlock *rsb, int
   return REC_ERR_OKAY;
 }
 
+int
+NumaMetricStatSync(const char *, RecDataT, RecData *, RecRawStatBlock *rsb, int)
+{
+  ink_mutex_acquire(&(rsb->mutex));
+  for (int node = 0; node < ink_freelist_numa_nodes(); ++node) {
+    rsb->global[node]->sum   = ink_freelists_numa_allocated(node);
+    rsb->global[node]->count = 1;
+    RecRawStatUpdateSum(rsb, node);
+  }
+  ink_mutex_release(&(rsb->mutex));
+  return REC_ERR_OKAY;
+}
+
 /// This is a wrapper used to convert a static function into a continuation. The function pointer is
 /// passed in the cookie. For this reason the class is used as a singleton.
 /// @internal This is the implementation for @c schedule_spawn... overloads.
@@ -181,6 +203,41 @@ ThreadAffinityInitializer::init()
 
   obj_count = hwloc_get_nbobjs_by_type(ink_get_topology(), obj_type);
   Debug("iocore_thread", "Affinity: %d %ss: %d PU: %d", affinity, obj_name, obj_count, ink_number_of_processors());
+
+  int numa_aware = 0;
+  int n_nodes    = hwloc_get_nbobjs_by_type(ink_get_topology(), HWLOC_OBJ_NODE);
+  REC_ReadConfigInteger(numa_aware, "proxy.config.allocator.numa_aware");
+  REC_ReadConfigInteger(net_node, "proxy.config.exec_thread.numa_node");
+
+  if (net_node >= 0) {
+    net_node_obj = hwloc_get_obj_by_type(ink_get_topology(), HWLOC_OBJ_NODE, net_node);
+    if (net_node_obj == nullptr || obj_count <= 0) {
+      Warning("NUMA node %d is not available -- ET_NET threads will not be bound to a node", net_node);
+      net_node     = -1;
+      net_node_obj = nullptr;
+    }
+  }
+
+  if (numa_aware && n_nodes > 1) {
+    ink_freelist_numa_init(n_nodes);
+  }
+  Debug("iocore_thread", "NUMA nodes: %d ET_NET node: %d NUMA aware free lists: %d", n_nodes, net_node, ink_freelist_numa_nodes());
+}
+
+hwloc_obj_t
+ThreadAffinityInitializer::thread_obj(EThread *t)
+{
+  if (net_node_obj != nullptr && t->is_event_type(ET_CALL)) { // ET_CALL is the ET_NET group.
+    // Spread the threads over the objects inside the node, or use the node itself if the
+    // configured affinity is coarser than a node.
+    int n = hwloc_get_nbobjs_inside_cpuset_by_type(ink_get_topology(), net_node_obj->cpuset, obj_type);
+    if (n > 0) {
+      return hwloc_get_obj_inside_cpuset_by_type(ink_get_topology(), net_node_obj->cpuset, obj_type, t->id % n);
+    }
+    return net_node_obj;
+  }
+  // Get our `obj` instance with index based on the thread number we are on.
+  return hwloc_get_obj_by_type(ink_get_topology(), obj_type, t->id % obj_count);
 }
 
 int
@@ -189,8 +246,7 @@ ThreadAffinityInitializer::set_affinity(int, Event *)
   EThread *t = this_ethread();
 
   if (obj_count > 0) {
-    // Get our `obj` instance with index based on the thread number we are on.
-    hwloc_obj_t obj = hwloc_get_obj_by_type(ink_get_topology(), obj_type, t->id % obj_count);
+    hwloc_obj_t obj = this->thread_obj(t);
 #if HWLOC_API_VERSION >= 0x00010100
     int cpu_mask_len = hwloc_bitmap_snprintf(nullptr, 0, obj->cpuset) + 1;
     char *cpu_mask   = (char *)alloca(cpu_mask_len);
@@ -200,12 +256,37 @@ ThreadAffinityInitializer::set_affinity(int, Event *)
     Debug("iocore_thread", "EThread: %d %s: %d", _name, obj->logical_index);
 #endif // HWLOC_API_VERSION
     hwloc_set_thread_cpubind(ink_get_topology(), t->tid, obj->cpuset, HWLOC_CPUBIND_STRICT);
+
+    // If the thread lives in a single NUMA node, use the free lists of that node.
+    if (ink_freelist_numa_nodes() > 0 &&
+        hwloc_get_nbobjs_inside_cpuset_by_type(ink_get_topology(), obj->cpuset, HWLOC_OBJ_NODE) == 1) {
+      hwloc_obj_t node = hwloc_get_obj_inside_cpuset_by_type(ink_get_topology(), obj->cpuset, HWLOC_OBJ_NODE, 0);
+      ink_freelist_set_thread_numa_node(node->logical_index);
+      Debug("iocore_thread", "EThread: %p using free lists of NUMA node %d", t, ink_freelist_thread_numa_node());
+    }
   } else {
     Warning("hwloc returned an unexpected number of objects -- CPU affinity disabled");
   }
   return 0;
 }
 
+void
+ThreadAffinityInitializer::bind_to_net_node()
+{
+  if (net_node_obj == nullptr) {
+    return;
+  }
+
+  hwloc_set_cpubind(ink_get_topology(), net_node_obj->cpuset, HWLOC_CPUBIND_THREAD);
+#if HWLOC_API_VERSION >= 0x00020000
+  hwloc_set_membind(ink_get_topology(), net_node_obj->nodeset, HWLOC_MEMBIND_BIND, HWLOC_MEMBIND_THREAD | HWLOC_MEMBIND_BYNODESET);
+#else
+  hwloc_set_membind_nodeset(ink_get_topology(), net_node_obj->nodeset, HWLOC_MEMBIND_BIND, HWLOC_MEMBIND_THREAD);
+#endif
+  ink_freelist_set_thread_numa_node(net_node_obj->logical_index);
+  Debug("iocore_thread", "Dedicated thread bound to NUMA node %d", net_node);
+}
+
 void *
 ThreadAffinityInitializer::alloc_numa_stack(EThread *t, size_t stacksize)
 {
@@ -213,7 +294,7 @@ ThreadAffinityInitializer::alloc_numa_stack(EThread *t, size_t stacksize)
   hwloc_nodeset_t nodeset           = hwloc_bitmap_alloc();
   int num_nodes                     = 0;
   void *stack                       = nullptr;
-  hwloc_obj_t obj                   = hwloc_get_obj_by_type(ink_get_topology(), obj_type, t->id % obj_count);
+  hwloc_obj_t obj                   = this->thread_obj(t);
 
   // Find the NUMA node set that correlates to our next thread CPU set
   hwloc_cpuset_to_nodeset(ink_get_topology(), obj->cpuset, nodeset);
@@ -266,6 +347,11 @@ ThreadAffinityInitializer::set_affinity(int, Event *)
   return 0;
 }
 
+void
+ThreadAffinityInitializer::bind_to_net_node()
+{
+}
+
 void *
 ThreadAffinityInitializer::alloc_stack(EThread *, size_t stacksize)
 {
@@ -446,6 +532,16 @@ EventProcessor::start(int n_event_threads, size_t stacksize)
   // Name must be that of a stat, pick one at random since we do all of them in one pass/callback.
   RecRegisterRawStatSyncCb(name, EventMetricStatSync, rsb, 0);
 
+  // Per NUMA node free list memory, only if the free lists are NUMA aware.
+  if (ink_freelist_numa_nodes() > 0) {
+    RecRawStatBlock *numa_rsb = RecAllocateRawStatBlock(ink_freelist_numa_nodes());
+    for (int node = 0; node < ink_freelist_numa_nodes(); ++node) {
+      snprintf(name, sizeof(name), "proxy.process.allocator.numa.node_%d.allocated", node);
+      RecRegisterRawStat(numa_rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, node, nullptr);
+    }
+    RecRegisterRawStatSyncCb(name, NumaMetricStatSync, numa_rsb, 0);
+  }
+
   this->spawn_event_threads(ET_CALL, n_event_threads, stacksize);
 
   Debug("iocore_thread", "Created event thread group id %d with %d threads", ET_CALL, n_event_threads);
@@ -457,6 +553,18 @@ EventProcessor::shutdown()
 {
 }
 
+int
+EventProcessor::net_numa_node() const
+{
+  return Thread_Affinity_Initializer.net_node;
+}
+
+void
+EventProcessor::bind_to_net_numa_node()
+{
+  Thread_Affinity_Initializer.bind_to_net_node();
+}
+
 Event *
 EventProcessor::spawn_thread(Continuation *cont, const char *thr_name, size_t stacksize)
 {
@@ -60,5 +60,22 @@ main(int /* argc ATS_UNUSED */, const char * /* argv ATS_UNUSED */ [])
     free_MIOBuffer(b1);
   }
 
+  // The slab statistics count the size asked for, not the size of the class.
+  init_buffer_slab_allocator(32 * 1024, 0);
+  int64_t size = 40 * 1024 + 1;
+  size_t idx   = 0;
+  while (ioBufSlabAllocator->stats(idx).size < ioBufSlabAllocator->class_size(size)) {
+    ++idx;
+  }
+  for (unsigned i = 0; i < 10; ++i) {
+    Ptr<IOBufferData> d = make_ptr(new_sized_IOBufferData(size, MEMALIGNED));
+    ink_release_assert(d->_mem_type == SLAB_ALLOCATED);
+    ink_release_assert(d->block_size() == static_cast<int64_t>(ioBufSlabAllocator->class_size(size)));
+  }
+  auto stats = ioBufSlabAllocator->stats(idx);
+  ink_release_assert(stats.allocs == 10);
+  ink_release_assert(stats.requested == 10 * static_cast<uint64_t>(size));
+  ink_release_assert(stats.in_use == 0);
+
   exit(0);
 }
@@ -0,0 +1,282 @@
+/** @file
+
+  Connection and handshake admission control.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "P_Net.h"
+#include "tscore/TestBox.h"
+
+#include <algorithm>
+
+namespace
+{
+constexpr int SHARD_ENTRIES = AdmissionControl::TABLE_SIZE / AdmissionControl::TABLE_SHARDS;
+constexpr int SHARD_SETS    = SHARD_ENTRIES / AdmissionControl::TABLE_WAYS;
+
+AdmissionControl::Config global_config;
+
+uint64_t
+mask_bits(uint64_t value, int bits)
+{
+  return bits <= 0 ? 0 : bits >= 64 ? value : value & ~(~uint64_t(0) >> bits);
+}
+
+uint64_t
+load_be64(const uint8_t *p)
+{
+  uint64_t v = 0;
+  for (int i = 0; i < 8; ++i) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+} // namespace
+
+bool
+TokenBucket::take(int rate, int burst, ink_hrtime now)
+{
+  if (rate <= 0) {
+    return true;
+  }
+
+  double cap = burst > 0 ? burst : rate;
+  if (tokens < 0) {
+    tokens = cap;
+    stamp  = now;
+  } else if (now > stamp) {
+    // The clock of the calling thread may lag behind the last caller, never refill backwards.
+    tokens = std::min(cap, tokens + static_cast<double>(rate) * (now - stamp) / HRTIME_SECOND);
+    stamp  = now;
+  }
+
+  if (tokens >= 1) {
+    tokens -= 1;
+    return true;
+  }
+  return false;
+}
+
+AdmissionControl::~AdmissionControl()
+{
+  for (auto &shard : _shards) {
+    delete[] shard.entries;
+  }
+}
+
+bool
+AdmissionControl::make_key(sockaddr const *addr, Key &key) const
+{
+  if (ats_is_ip4(addr)) {
+    int prefix = std::clamp(_config.ipv4_prefix, 0, 32);
+    key.hi     = 0;
+    key.lo     = mask_bits(static_cast<uint64_t>(ntohl(ats_ip4_addr_cast(addr))) << 32, prefix);
+    key.tag    = (AF_INET << 8) | prefix;
+    return true;
+  } else if (ats_is_ip6(addr)) {
+    const uint8_t *bytes = ats_ip_addr8_cast(addr);
+    int prefix           = std::clamp(_config.ipv6_prefix, 0, 128);
+    key.hi               = mask_bits(load_be64(bytes), prefix);
+    key.lo               = mask_bits(load_be64(bytes + 8), prefix - 64);
+    key.tag              = (AF_INET6 << 8) | prefix;
+    return true;
+  }
+  return false;
+}
+
+AdmissionControl::Shard &
+AdmissionControl::shard_for(const Key &key, uint64_t &hash)
+{
+  hash = (key.hi * 0x9e3779b97f4a7c15ULL) ^ (key.lo * 0xc2b2ae3d27d4eb4fULL) ^ key.tag;
+  hash ^= hash >> 29;
+  return _shards[hash % TABLE_SHARDS];
+}
+
+AdmissionControl::Entry *
+AdmissionControl::lookup(Shard &shard, uint64_t hash, const Key &key, ink_hrtime now, bool insert)
+{
+  if (shard.entries == nullptr) {
+    if (!insert) {
+      return nullptr;
+    }
+    shard.entries = new Entry[SHARD_ENTRIES];
+  }
+
+  Entry *set    = shard.entries + ((hash / TABLE_SHARDS) % SHARD_SETS) * TABLE_WAYS;
+  Entry *victim = set;
+  for (int i = 0; i < TABLE_WAYS; ++i) {
+    if (set[i].key == key) {
+      set[i].last_used = now;
+      return set + i;
+    }
+    if (set[i].last_used < victim->last_used) {
+      victim = set + i;
+    }
+  }
+  if (!insert) {
+    return nullptr;
+  }
+
+  *victim           = Entry();
+  victim->key       = key;
+  victim->last_used = now;
+  return victim;
+}
+
+bool
+AdmissionControl::admit_connection(sockaddr const *addr, ink_hrtime now)
+{
+  Key key;
+  if (!_config.enabled || _config.conn_rate <= 0 || !this->make_key(addr, key)) {
+    return true;
+  }
+
+  uint64_t hash;
+  Shard &shard = this->shard_for(key, hash);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  return this->lookup(shard, hash, key, now, true)->conn.take(_config.conn_rate, _config.conn_burst, now);
+}
+
+bool
+AdmissionControl::admit_handshake(sockaddr const *addr, ink_hrtime now)
+{
+  if (!_config.enabled || _config.handshake_rate <= 0) {
+    return true;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_handshake_mutex);
+    if (_handshakes.take(_config.handshake_rate, _config.handshake_burst, now)) {
+      return true;
+    }
+  }
+
+  // The budget is used up, still let in the prefixes that recently completed a handshake.
+  Key key;
+  if (_config.handshake_trust_sec <= 0 || !this->make_key(addr, key)) {
+    return false;
+  }
+  uint64_t hash;
+  Shard &shard = this->shard_for(key, hash);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  Entry *entry = this->lookup(shard, hash, key, now, false);
+  return entry && entry->last_handshake && now - entry->last_handshake < HRTIME_SECONDS(_config.handshake_trust_sec);
+}
+
+void
+AdmissionControl::handshake_completed(sockaddr const *addr, ink_hrtime now)
+{
+  Key key;
+  if (!_config.enabled || _config.handshake_rate <= 0 || _config.handshake_trust_sec <= 0 || !this->make_key(addr, key)) {
+    return;
+  }
+
+  uint64_t hash;
+  Shard &shard = this->shard_for(key, hash);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  this->lookup(shard, hash, key, now, true)->last_handshake = now;
+}
+
+AdmissionControl &
+AdmissionControl::global()
+{
+  static AdmissionControl instance(global_config);
+  return instance;
+}
+
+void
+AdmissionControl::config_init()
+{
+  REC_EstablishStaticConfigInt32(global_config.enabled, "proxy.config.net.admission.enabled");
+  REC_EstablishStaticConfigInt32(global_config.conn_rate, "proxy.config.net.admission.conn_rate");
+  REC_EstablishStaticConfigInt32(global_config.conn_burst, "proxy.config.net.admission.conn_burst");
+  REC_EstablishStaticConfigInt32(global_config.ipv4_prefix, "proxy.config.net.admission.ipv4_prefix");
+  REC_EstablishStaticConfigInt32(global_config.ipv6_prefix, "proxy.config.net.admission.ipv6_prefix");
+  REC_EstablishStaticConfigInt32(global_config.handshake_rate, "proxy.config.net.admission.handshake_rate");
+  REC_EstablishStaticConfigInt32(global_config.handshake_burst, "proxy.config.net.admission.handshake_burst");
+  REC_EstablishStaticConfigInt32(global_config.handshake_trust_sec, "proxy.config.net.admission.handshake_trust_period");
+}
+
+REGRESSION_TEST(AdmissionControl_TokenBucket)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  TokenBucket bucket;
+  ink_hrtime now = HRTIME_SECONDS(1000);
+  int taken      = 0;
+
+  box = REGRESSION_TEST_PASSED;
+
+  while (taken < 100 && bucket.take(10, 5, now)) {
+    ++taken;
+  }
+  box.check(taken == 5, "a full bucket holds the burst, took %d", taken);
+  box.check(!bucket.take(10, 5, now + HRTIME_MSECONDS(50)), "half a token after 50ms");
+  box.check(bucket.take(10, 5, now + HRTIME_MSECONDS(100)), "one token after 100ms");
+  box.check(!bucket.take(10, 5, now), "time going backwards does not refill");
+
+  taken = 0;
+  while (taken < 100 && bucket.take(10, 5, now + HRTIME_SECONDS(60))) {
+    ++taken;
+  }
+  box.check(taken == 5, "refill is capped at the burst, took %d", taken);
+  box.check(bucket.take(0, 0, now), "a rate of 0 is unlimited");
+}
+
+REGRESSION_TEST(AdmissionControl_Prefix)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  AdmissionControl::Config config;
+  IpEndpoint a, b, c, d;
+  ink_hrtime now = HRTIME_SECONDS(1000);
+
+  box = REGRESSION_TEST_PASSED;
+
+  config.enabled         = 1;
+  config.conn_rate       = 1;
+  config.conn_burst      = 2;
+  config.handshake_rate  = 1;
+  config.handshake_burst = 1;
+  AdmissionControl ac(config);
+
+  ats_ip_pton("192.0.2.1", &a);
+  ats_ip_pton("192.0.2.200", &b);
+  ats_ip_pton("198.51.100.1", &c);
+  ats_ip_pton("2001:db8::1", &d);
+
+  box.check(ac.admit_connection(&a.sa, now) && ac.admit_connection(&b.sa, now), "burst admitted");
+  box.check(!ac.admit_connection(&a.sa, now), "same /24 shares the bucket");
+  box.check(ac.admit_connection(&c.sa, now), "other /24 has its own bucket");
+  box.check(ac.admit_connection(&d.sa, now), "IPv6 has its own bucket");
+  box.check(ac.admit_connection(&b.sa, now + HRTIME_SECONDS(1)), "bucket refilled");
+
+  box.check(ac.admit_handshake(&c.sa, now), "handshake within budget");
+  box.check(!ac.admit_handshake(&c.sa, now), "handshake budget used up");
+  ac.handshake_completed(&a.sa, now);
+  box.check(ac.admit_handshake(&b.sa, now), "prefix with a completed handshake is exempt");
+  now += HRTIME_SECONDS(config.handshake_trust_sec);
+  box.check(ac.admit_handshake(&c.sa, now), "handshake budget refilled");
+  box.check(!ac.admit_handshake(&b.sa, now), "exemption expires");
+
+  config.ipv4_prefix = 32;
+  box.check(ac.admit_connection(&a.sa, now), "prefix length change starts new buckets");
+
+  config.enabled = 0;
+  box.check(ac.admit_connection(&a.sa, now) && ac.admit_handshake(&a.sa, now), "disabled admits everything");
+}
@@ -60,6 +60,8 @@ extern int net_event_period;
 extern int net_accept_period;
 extern int net_retry_delay;
 extern int net_throttle_delay;
+extern int net_listen_per_thread;
+extern int net_accept_batch_size;
 
 extern std::string_view net_ccp_in;
 extern std::string_view net_ccp_out;
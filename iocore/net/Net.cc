@@ -39,6 +39,8 @@ int net_event_period        = 10;
 int net_accept_period       = 10;
 int net_retry_delay         = 10;
 int net_throttle_delay      = 50; /* milliseconds */
+int net_listen_per_thread   = 0;
+int net_accept_batch_size   = 0;
 
 // For the in/out congestion control: ToDo: this probably would be better as ports: specifications
 std::string_view net_ccp_in;
@@ -56,6 +58,9 @@ configure_net()
   // These are not reloadable
   REC_ReadConfigInteger(net_event_period, "proxy.config.net.event_period");
   REC_ReadConfigInteger(net_accept_period, "proxy.config.net.accept_period");
+  REC_ReadConfigInteger(net_listen_per_thread, "proxy.config.net.listen_per_thread");
+  REC_ReadConfigInteger(net_accept_batch_size, "proxy.config.net.accept_batch_size");
+  AdmissionControl::config_init();
 
   // This is kinda fugly, but better than it was before (on every connection in and out)
   // Note that these would need to be ats_free()'d if we ever want to clean that up, but
@@ -90,6 +95,8 @@ register_net_stats()
     {"proxy.process.net.write_bytes", net_write_bytes_stat},
     {"proxy.process.net.fastopen_out.attempts", net_fastopen_attempts_stat},
     {"proxy.process.net.fastopen_out.successes", net_fastopen_successes_stat},
+    {"proxy.process.net.admission.connections_rejected", net_admission_connections_rejected_stat},
+    {"proxy.process.net.admission.handshakes_rejected", net_admission_handshakes_rejected_stat},
     {"proxy.process.socks.connections_successful", socks_connections_successful_stat},
     {"proxy.process.socks.connections_unsuccessful", socks_connections_unsuccessful_stat},
   };
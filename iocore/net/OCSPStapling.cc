@@ -25,6 +25,11 @@
 #include <openssl/bio.h>
 #include <openssl/ssl.h>
 #include <openssl/ocsp.h>
+#include <memory>
+#include <vector>
+#include <poll.h>
+#include <sys/stat.h>
+#include "tscore/ink_rand.h"
 #include "P_Net.h"
 #include "P_SSLConfig.h"
 #include "P_SSLUtils.h"
@@ -47,6 +52,8 @@ struct certinfo {
   bool is_prefetched;
   bool is_expire;
   time_t expire_time;
+  time_t fetch_time;   // When the cached response was fetched
+  time_t refresh_time; // When to fetch a new response, before expire_time
 };
 
 /*
@@ -143,8 +150,77 @@ end:
   return issuer;
 }
 
+// Time of the nextUpdate of the response for @a cinf, 0 if it is not known.
+static time_t
+stapling_next_update(OCSP_RESPONSE *rsp, certinfo *cinf, time_t now)
+{
+  time_t next_update = 0;
+  int status, reason, days, secs;
+  ASN1_GENERALIZEDTIME *rev, *thisupd, *nextupd = nullptr;
+
+  if (cinf->cid == nullptr || OCSP_response_status(rsp) != OCSP_RESPONSE_STATUS_SUCCESSFUL) {
+    return 0;
+  }
+
+  OCSP_BASICRESP *bs = OCSP_response_get1_basic(rsp);
+  if (bs == nullptr) {
+    return 0;
+  }
+  if (OCSP_resp_find_status(bs, cinf->cid, &status, &reason, &rev, &thisupd, &nextupd) && nextupd &&
+      ASN1_TIME_diff(&days, &secs, nullptr, nextupd)) {
+    next_update = now + days * 86400 + secs;
+  }
+  OCSP_BASICRESP_free(bs);
+
+  return next_update;
+}
+
+static std::string
+stapling_cache_file(const certinfo *cinf)
+{
+  char hex[sizeof(cinf->idx) * 2 + 1];
+
+  for (size_t i = 0; i < sizeof(cinf->idx); ++i) {
+    snprintf(hex + i * 2, 3, "%02x", cinf->idx[i]);
+  }
+  return std::string(SSLConfigParams::ssl_ocsp_response_cache_path) + "/" + hex + ".der";
+}
+
+// Save the response so a restart does not need to fetch it again.
+static void
+stapling_save_response(const certinfo *cinf, const unsigned char *der, unsigned int derlen)
+{
+  std::string path = stapling_cache_file(cinf);
+  std::string tmp  = path + ".tmp";
+  FILE *f          = fopen(tmp.c_str(), "w");
+
+  if (f == nullptr) {
+    Warning("OCSP: cannot save response for %s to %s: %s", cinf->certname, tmp.c_str(), strerror(errno));
+    return;
+  }
+  bool ok = fwrite(der, 1, derlen, f) == derlen;
+  ok      = fclose(f) == 0 && ok;
+  if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+    Warning("OCSP: cannot save response for %s to %s: %s", cinf->certname, path.c_str(), strerror(errno));
+    unlink(tmp.c_str());
+  }
+}
+
+/*
+ * Refresh at a random point of the last quarter of the response lifetime, so the refreshes of responses fetched
+ * together spread over time and a response is replaced before it expires.
+ */
+static time_t
+stapling_refresh_time(time_t fetched, time_t expire)
+{
+  static thread_local InkRand jitter(static_cast<uint64_t>(ink_get_hrtime_internal()));
+
+  time_t lifetime = expire - fetched;
+  return expire - lifetime / 10 - static_cast<time_t>(jitter.random() % (lifetime / 6 + 1));
+}
+
 static bool
-stapling_cache_response(OCSP_RESPONSE *rsp, certinfo *cinf)
+stapling_cache_response(OCSP_RESPONSE *rsp, certinfo *cinf, time_t fetched, bool persist)
 {
   unsigned char resp_der[MAX_STAPLING_DER];
   unsigned char *p;
@@ -163,17 +239,62 @@ stapling_cache_response(OCSP_RESPONSE *rsp, certinfo *cinf)
     return false;
   }
 
+  // Do not staple past the nextUpdate of the response.
+  time_t expire_time = fetched + SSLConfigParams::ssl_ocsp_cache_timeout;
+  time_t next_update = stapling_next_update(rsp, cinf, time(nullptr));
+  if (next_update > fetched && next_update < expire_time) {
+    expire_time = next_update;
+  }
+
   ink_mutex_acquire(&cinf->stapling_mutex);
   memcpy(cinf->resp_der, resp_der, resp_derlen);
-  cinf->resp_derlen = resp_derlen;
-  cinf->is_expire   = false;
-  cinf->expire_time = time(nullptr) + SSLConfigParams::ssl_ocsp_cache_timeout;
+  cinf->resp_derlen  = resp_derlen;
+  cinf->is_expire    = false;
+  cinf->expire_time  = expire_time;
+  cinf->fetch_time   = fetched;
+  cinf->refresh_time = stapling_refresh_time(fetched, expire_time);
   ink_mutex_release(&cinf->stapling_mutex);
 
+  if (persist && SSLConfigParams::ssl_ocsp_response_cache_path) {
+    stapling_save_response(cinf, resp_der, resp_derlen);
+  }
+
   Debug("ssl_ocsp", "stapling_cache_response: success to cache response");
   return true;
 }
 
+// Load the response saved by a previous run if it has not expired.
+static bool
+stapling_load_response(certinfo *cinf)
+{
+  std::string path = stapling_cache_file(cinf);
+  struct stat st;
+  BIO *rsp_bio       = nullptr;
+  OCSP_RESPONSE *rsp = nullptr;
+  bool loaded        = false;
+  time_t now         = time(nullptr);
+
+  if (stat(path.c_str(), &st) != 0 || (rsp_bio = BIO_new_file(path.c_str(), "r")) == nullptr) {
+    return false;
+  }
+
+  rsp = d2i_OCSP_RESPONSE_bio(rsp_bio, nullptr);
+  if (rsp && OCSP_response_status(rsp) == OCSP_RESPONSE_STATUS_SUCCESSFUL && st.st_mtime <= now &&
+      st.st_mtime + SSLConfigParams::ssl_ocsp_cache_timeout > now) {
+    time_t next_update = stapling_next_update(rsp, cinf, now);
+    if (next_update == 0 || next_update > now) {
+      loaded = stapling_cache_response(rsp, cinf, st.st_mtime, false);
+    }
+  }
+  Debug("ssl_ocsp", "%s saved OCSP response for %s from %s", loaded ? "using" : "ignoring", cinf->certname, path.c_str());
+
+  if (rsp) {
+    OCSP_RESPONSE_free(rsp);
+  }
+  BIO_free(rsp_bio);
+  return loaded;
+}
+
 bool
 ssl_stapling_init_cert(SSL_CTX *ctx, X509 *cert, const char *certname, const char *rsp_file)
 {
@@ -212,6 +333,8 @@ ssl_stapling_init_cert(SSL_CTX *ctx, X509 *cert, const char *certname, const cha
   cinf->is_prefetched = rsp_file ? true : false;
   cinf->is_expire     = true;
   cinf->expire_time   = 0;
+  cinf->fetch_time    = 0;
+  cinf->refresh_time  = 0;
 
   if (cinf->is_prefetched) {
     Debug("ssl_ocsp", "using OCSP prefetched response file %s", rsp_file);
@@ -225,7 +348,7 @@ ssl_stapling_init_cert(SSL_CTX *ctx, X509 *cert, const char *certname, const cha
       goto err;
     }
 
-    if (!stapling_cache_response(rsp, cinf)) {
+    if (!stapling_cache_response(rsp, cinf, time(nullptr), false)) {
       Error("stapling_refresh_response: can not cache response");
       goto err;
     } else {
@@ -261,6 +384,10 @@ ssl_stapling_init_cert(SSL_CTX *ctx, X509 *cert, const char *certname, const cha
     goto err;
   }
 
+  if (!cinf->is_prefetched && SSLConfigParams::ssl_ocsp_response_cache_path) {
+    stapling_load_response(cinf);
+  }
+
   map->insert(std::make_pair(cert, cinf));
   SSL_CTX_set_ex_data(ctx, ssl_stapling_index, map);
 
@@ -352,165 +479,219 @@ stapling_check_response(certinfo *cinf, OCSP_RESPONSE *rsp)
   return SSL_TLSEXT_ERR_OK;
 }
 
-static OCSP_RESPONSE *
-query_responder(BIO *b, char *host, char *path, OCSP_REQUEST *req, int req_timeout)
-{
-  ink_hrtime start, end;
-  OCSP_RESPONSE *resp = nullptr;
-  OCSP_REQ_CTX *ctx;
-  int rv;
-
-  start = Thread::get_hrtime();
-  end   = ink_hrtime_add(start, ink_hrtime_from_sec(req_timeout));
-
-  ctx = OCSP_sendreq_new(b, path, nullptr, -1);
-  OCSP_REQ_CTX_add1_header(ctx, "Host", host);
-  OCSP_REQ_CTX_set1_req(ctx, req);
-
-  do {
-    rv = OCSP_sendreq_nbio(&resp, ctx);
-    ink_hrtime_sleep(HRTIME_MSECONDS(1));
-  } while ((rv == -1) && BIO_should_retry(b) && (Thread::get_hrtime() < end));
-
-  OCSP_REQ_CTX_free(ctx);
-
-  if (rv) {
-    return resp;
-  }
-
-  return nullptr;
-}
+// A request to the OCSP responder of one certificate, polled until it completes.
+struct OCSPFetch {
+  certinfo *cinf     = nullptr;
+  OCSP_REQUEST *req  = nullptr;
+  BIO *bio           = nullptr;
+  OCSP_REQ_CTX *ctx  = nullptr;
+  char *host         = nullptr;
+  char *port         = nullptr;
+  char *path         = nullptr;
+  ink_hrtime timeout = 0;
+
+  explicit OCSPFetch(certinfo *c) : cinf(c) {}
+  ~OCSPFetch();
+
+  bool start();
+  int poll(OCSP_RESPONSE **prsp);
+};
 
-static OCSP_RESPONSE *
-process_responder(OCSP_REQUEST *req, char *host, char *path, char *port, int req_timeout)
+OCSPFetch::~OCSPFetch()
 {
-  BIO *cbio           = nullptr;
-  OCSP_RESPONSE *resp = nullptr;
-  cbio                = BIO_new_connect(host);
-  if (!cbio) {
-    goto end;
+  if (ctx) {
+    OCSP_REQ_CTX_free(ctx);
   }
-  if (port) {
-    BIO_set_conn_port(cbio, port);
-  }
-
-  BIO_set_nbio(cbio, 1);
-  if (BIO_do_connect(cbio) <= 0 && !BIO_should_retry(cbio)) {
-    Debug("ssl_ocsp", "process_responder: failed to connect to OCSP response server. host=%s port=%s path=%s", host, port, path);
-    goto end;
+  if (bio) {
+    BIO_free_all(bio);
   }
-  resp = query_responder(cbio, host, path, req, req_timeout);
-
-end:
-  if (cbio) {
-    BIO_free_all(cbio);
+  if (req) {
+    OCSP_REQUEST_free(req);
   }
-  return resp;
+  OPENSSL_free(host);
+  OPENSSL_free(path);
+  OPENSSL_free(port);
 }
 
-static bool
-stapling_refresh_response(certinfo *cinf, OCSP_RESPONSE **prsp)
+bool
+OCSPFetch::start()
 {
-  bool rv           = true;
-  OCSP_REQUEST *req = nullptr;
-  OCSP_CERTID *id   = nullptr;
-  char *host = nullptr, *port = nullptr, *path = nullptr;
+  OCSP_CERTID *id = nullptr;
   int ssl_flag    = 0;
-  int req_timeout = -1;
 
-  Debug("ssl_ocsp", "stapling_refresh_response: querying responder");
-  *prsp = nullptr;
+  Debug("ssl_ocsp", "OCSPFetch::start: querying responder %s for %s", cinf->uri, cinf->certname);
 
   if (!OCSP_parse_url(cinf->uri, &host, &port, &path, &ssl_flag)) {
-    goto err;
+    return false;
   }
 
   req = OCSP_REQUEST_new();
   if (!req) {
-    goto err;
+    return false;
   }
   id = OCSP_CERTID_dup(cinf->cid);
   if (!id) {
-    goto err;
+    return false;
   }
   if (!OCSP_request_add0_id(req, id)) {
-    goto err;
+    OCSP_CERTID_free(id);
+    return false;
+  }
+
+  bio = BIO_new_connect(host);
+  if (!bio) {
+    return false;
+  }
+  if (port) {
+    BIO_set_conn_port(bio, port);
+  }
+  BIO_set_nbio(bio, 1);
+  if (BIO_do_connect(bio) <= 0 && !BIO_should_retry(bio)) {
+    Debug("ssl_ocsp", "OCSPFetch::start: failed to connect to OCSP response server. host=%s port=%s path=%s", host, port, path);
+    return false;
   }
 
-  req_timeout = SSLConfigParams::ssl_ocsp_request_timeout;
-  *prsp       = process_responder(req, host, path, port, req_timeout);
+  ctx = OCSP_sendreq_new(bio, path, nullptr, -1);
+  if (!ctx) {
+    return false;
+  }
+  OCSP_REQ_CTX_add1_header(ctx, "Host", host);
+  OCSP_REQ_CTX_set1_req(ctx, req);
 
-  if (*prsp == nullptr) {
-    goto done;
+  timeout = ink_hrtime_add(Thread::get_hrtime_updated(), ink_hrtime_from_sec(SSLConfigParams::ssl_ocsp_request_timeout));
+  return true;
+}
+
+// Advance the request, -1 while it is in progress, 1 with the response in @a prsp, 0 on failure.
+int
+OCSPFetch::poll(OCSP_RESPONSE **prsp)
+{
+  int rv = OCSP_sendreq_nbio(prsp, ctx);
+
+  if (rv == -1 && !(BIO_should_retry(bio) && Thread::get_hrtime_updated() < timeout)) {
+    rv = 0;
   }
+  return rv;
+}
 
-  if (OCSP_response_status(*prsp) == OCSP_RESPONSE_STATUS_SUCCESSFUL) {
-    Debug("ssl_ocsp", "stapling_refresh_response: query response received");
-    stapling_check_response(cinf, *prsp);
-  } else {
-    // TODO: We should log the actual openssl error
-    Error("stapling_refresh_response: responder error");
+static void
+stapling_refresh_done(certinfo *cinf, OCSP_RESPONSE *rsp)
+{
+  bool cached = false;
+
+  if (rsp) {
+    bool successful = OCSP_response_status(rsp) == OCSP_RESPONSE_STATUS_SUCCESSFUL;
+    if (successful) {
+      Debug("ssl_ocsp", "stapling_refresh_done: query response received");
+      stapling_check_response(cinf, rsp);
+    } else {
+      // TODO: We should log the actual openssl error
+      Error("stapling_refresh_done: responder error");
+    }
+
+    // An error response is not saved, a restart would staple it again.
+    if (!(cached = stapling_cache_response(rsp, cinf, time(nullptr), successful))) {
+      Error("stapling_refresh_done: can not cache response");
+    } else {
+      Debug("ssl_ocsp", "stapling_refresh_done: successful refresh OCSP response");
+    }
+    OCSP_RESPONSE_free(rsp);
   }
 
-  if (!stapling_cache_response(*prsp, cinf)) {
-    Error("stapling_refresh_response: can not cache response");
+  if (cached) {
+    Debug("ssl_ocsp", "Successfully refreshed OCSP for %s certificate. url=%s", cinf->certname, cinf->uri);
+    SSL_INCREMENT_DYN_STAT(ssl_ocsp_refreshed_cert_stat);
   } else {
-    Debug("ssl_ocsp", "stapling_refresh_response: successful refresh OCSP response");
+    Error("Failed to refresh OCSP for %s certificate. url=%s", cinf->certname, cinf->uri);
+    SSL_INCREMENT_DYN_STAT(ssl_ocsp_refresh_cert_failure_stat);
   }
-  goto done;
-
-err:
-  rv = false;
-  Error("stapling_refresh_response: failed to refresh OCSP response");
+}
 
-done:
-  if (req) {
-    OCSP_REQUEST_free(req);
+/*
+ * Wait until the socket of one of the @a active requests is ready for the I/O the request is blocked on, or until the
+ * earliest request timeout.
+ */
+static void
+stapling_wait_responses(const std::vector<std::unique_ptr<OCSPFetch>> &active)
+{
+  std::vector<struct pollfd> fds;
+  ink_hrtime now  = Thread::get_hrtime_updated();
+  ink_hrtime wait = HRTIME_SECONDS(1);
+
+  for (auto &fetch : active) {
+    int fd = BIO_get_fd(fetch->bio, nullptr);
+    wait   = std::min(wait, fetch->timeout - now);
+    if (fd < 0) {
+      // No socket yet, check again shortly.
+      wait = std::min(wait, HRTIME_MSECONDS(1));
+      continue;
+    }
+    // A connect in progress waits for the socket to be writable.
+    fds.push_back({fd, static_cast<short>(BIO_should_read(fetch->bio) ? POLLIN : POLLOUT), 0});
   }
-  if (*prsp) {
-    OCSP_RESPONSE_free(*prsp);
+
+  if (wait > 0) {
+    ::poll(fds.data(), fds.size(), static_cast<int>(ink_hrtime_to_msec(wait + HRTIME_MSECONDS(1) - 1)));
   }
-  OPENSSL_free(host);
-  OPENSSL_free(path);
-  OPENSSL_free(port);
-  return rv;
 }
 
-void
-ocsp_update()
+/*
+ * Fetch the responses of @a due with up to proxy.config.ssl.ocsp.max_concurrent_requests requests in flight. The
+ * requests are non blocking and advanced when their sockets are ready, so a slow responder does not hold up the others.
+ */
+static void
+stapling_refresh_responses(const std::vector<certinfo *> &due)
 {
-  shared_SSL_CTX ctx;
-  OCSP_RESPONSE *resp = nullptr;
-  time_t current_time;
+  std::vector<std::unique_ptr<OCSPFetch>> active;
+  size_t max_active = std::max(SSLConfigParams::ssl_ocsp_max_concurrent_requests, 1);
+  size_t next       = 0;
+
+  while (next < due.size() || !active.empty()) {
+    while (active.size() < max_active && next < due.size()) {
+      std::unique_ptr<OCSPFetch> fetch(new OCSPFetch(due[next++]));
+      if (fetch->start()) {
+        active.push_back(std::move(fetch));
+      } else {
+        Error("stapling_refresh_responses: failed to start OCSP request for %s", fetch->cinf->certname);
+        stapling_refresh_done(fetch->cinf, nullptr);
+      }
+    }
 
-  SSLCertificateConfig::scoped_config certLookup;
+    for (size_t i = 0; i < active.size();) {
+      OCSP_RESPONSE *rsp = nullptr;
+      int rv             = active[i]->poll(&rsp);
+      if (rv == -1) {
+        ++i;
+        continue;
+      }
+      stapling_refresh_done(active[i]->cinf, rv == 1 ? rsp : nullptr);
+      active[i] = std::move(active.back());
+      active.pop_back();
+    }
+
+    if (!active.empty()) {
+      stapling_wait_responses(active);
+    }
+  }
+}
+
+// Call @a fn for each stapling certificate of the current configuration.
+template <typename F>
+static void
+stapling_for_each(SSLCertificateConfig::scoped_config &certLookup, F &&fn)
+{
   const unsigned ctxCount = certLookup->count();
 
   for (unsigned i = 0; i < ctxCount; i++) {
     SSLCertContext *cc = certLookup->get(i);
     if (cc) {
-      ctx = cc->getCtx();
+      shared_SSL_CTX ctx = cc->getCtx();
       if (ctx) {
-        certinfo *cinf    = nullptr;
         certinfo_map *map = stapling_get_cert_info(ctx.get());
         if (map) {
           // Walk over all certs associated with this CTX
-          for (certinfo_map::iterator iter = map->begin(); iter != map->end(); ++iter) {
-            cinf = iter->second;
-            ink_mutex_acquire(&cinf->stapling_mutex);
-            current_time = time(nullptr);
-            if (cinf->resp_derlen == 0 || cinf->is_expire || cinf->expire_time < current_time) {
-              ink_mutex_release(&cinf->stapling_mutex);
-              if (stapling_refresh_response(cinf, &resp)) {
-                Debug("Successfully refreshed OCSP for %s certificate. url=%s", cinf->certname, cinf->uri);
-                SSL_INCREMENT_DYN_STAT(ssl_ocsp_refreshed_cert_stat);
-              } else {
-                Error("Failed to refresh OCSP for %s certificate. url=%s", cinf->certname, cinf->uri);
-                SSL_INCREMENT_DYN_STAT(ssl_ocsp_refresh_cert_failure_stat);
-              }
-            } else {
-              ink_mutex_release(&cinf->stapling_mutex);
-            }
+          for (auto &&[cert, cinf] : *map) {
+            fn(cinf);
           }
         }
       }
@@ -518,6 +699,47 @@ ocsp_update()
   }
 }
 
+void
+ocsp_update()
+{
+  SSLCertificateConfig::scoped_config certLookup;
+  std::vector<certinfo *> due;
+  time_t current_time = time(nullptr);
+
+  stapling_for_each(certLookup, [&](certinfo *cinf) {
+    ink_mutex_acquire(&cinf->stapling_mutex);
+    if (cinf->resp_derlen == 0 || cinf->is_expire || cinf->refresh_time <= current_time) {
+      due.push_back(cinf);
+    }
+    ink_mutex_release(&cinf->stapling_mutex);
+  });
+
+  if (!due.empty()) {
+    Debug("ssl_ocsp", "ocsp_update: refreshing %zu OCSP responses", due.size());
+    stapling_refresh_responses(due);
+  }
+
+  // Staple freshness: certificates with and without a response to staple, and the age of the oldest response.
+  int64_t fresh = 0, stale = 0, oldest = 0;
+  current_time  = time(nullptr);
+  stapling_for_each(certLookup, [&](certinfo *cinf) {
+    ink_mutex_acquire(&cinf->stapling_mutex);
+    if (cinf->resp_derlen == 0 || cinf->is_expire || (cinf->expire_time < current_time && !cinf->is_prefetched)) {
+      ++stale;
+    } else {
+      ++fresh;
+      oldest = std::max<int64_t>(oldest, current_time - cinf->fetch_time);
+    }
+    ink_mutex_release(&cinf->stapling_mutex);
+  });
+
+  if (ssl_rsb) {
+    RecSetGlobalRawStatSum(ssl_rsb, ssl_ocsp_staple_fresh_stat, fresh);
+    RecSetGlobalRawStatSum(ssl_rsb, ssl_ocsp_staple_stale_stat, stale);
+    RecSetGlobalRawStatSum(ssl_rsb, ssl_ocsp_staple_oldest_age_stat, oldest);
+  }
+}
+
 // RFC 6066 Section-8: Certificate Status Request
 int
 ssl_callback_ocsp_stapling(SSL *ssl)
@@ -560,4 +782,304 @@ ssl_callback_ocsp_stapling(SSL *ssl)
   }
 }
 
+#if TS_HAS_TESTS
+#include "tscore/TestBox.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace
+{
+EVP_PKEY *
+test_key()
+{
+  EVP_PKEY *key     = nullptr;
+  EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+
+  if (ctx && EVP_PKEY_keygen_init(ctx) > 0 && EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx, NID_X9_62_prime256v1) > 0) {
+    EVP_PKEY_keygen(ctx, &key);
+  }
+  EVP_PKEY_CTX_free(ctx);
+  return key;
+}
+
+// A certificate for @a key, self signed without an @a issuer.
+X509 *
+test_cert(long serial, EVP_PKEY *key, X509 *issuer, EVP_PKEY *issuer_key)
+{
+  X509 *cert = X509_new();
+
+  X509_set_version(cert, 2);
+  ASN1_INTEGER_set(X509_get_serialNumber(cert), serial);
+  X509_gmtime_adj(X509_get_notBefore(cert), 0);
+  X509_gmtime_adj(X509_get_notAfter(cert), 86400);
+  X509_NAME_add_entry_by_txt(X509_get_subject_name(cert), "CN", MBSTRING_ASC,
+                             reinterpret_cast<const unsigned char *>(issuer ? "server" : "issuer"), -1, -1, 0);
+  X509_set_issuer_name(cert, X509_get_subject_name(issuer ? issuer : cert));
+  X509_set_pubkey(cert, key);
+  X509_sign(cert, issuer_key, EVP_sha256());
+  return cert;
+}
+
+certinfo *
+test_certinfo(X509 *cert, X509 *issuer, const std::string &uri)
+{
+  certinfo *cinf = static_cast<certinfo *>(OPENSSL_malloc(sizeof(certinfo)));
+
+  memset(cinf, 0, sizeof(certinfo));
+  cinf->cid      = OCSP_cert_to_id(nullptr, cert, issuer);
+  cinf->uri      = OPENSSL_strdup(uri.c_str());
+  cinf->certname = ats_strdup(uri.c_str());
+  ink_mutex_init(&cinf->stapling_mutex);
+  cinf->is_expire = true;
+  X509_digest(cert, EVP_sha1(), cinf->idx, nullptr);
+  return cinf;
+}
+
+void
+test_certinfo_free(certinfo *cinf)
+{
+  OCSP_CERTID_free(cinf->cid);
+  OPENSSL_free(cinf->uri);
+  ats_free(cinf->certname);
+  ink_mutex_destroy(&cinf->stapling_mutex);
+  OPENSSL_free(cinf);
+}
+
+/**
+   An OCSP responder on a local port, the path of the request selects the answer:
+   - /good: a good status for the certificate, valid for an hour.
+   - /close: the connection is closed without an answer.
+   - /silent: the connection is kept open without an answer.
+   - /trylater: an error status.
+*/
+class MockOCSPResponder
+{
+public:
+  MockOCSPResponder(X509 *cert, EVP_PKEY *key) : _cert(cert), _key(key) {}
+
+  ~MockOCSPResponder()
+  {
+    if (_fd >= 0) {
+      shutdown(_fd, SHUT_RDWR);
+      _acceptor.join();
+      close(_fd);
+    }
+    for (auto &c : _connections) {
+      c.join();
+    }
+  }
+
+  bool
+  start()
+  {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    _fd                  = socket(AF_INET, SOCK_STREAM, 0);
+    if (_fd < 0 || bind(_fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0 || listen(_fd, 16) != 0 ||
+        getsockname(_fd, reinterpret_cast<struct sockaddr *>(&addr), &len) != 0) {
+      return false;
+    }
+    _port     = ntohs(addr.sin_port);
+    _acceptor = std::thread([this]() {
+      for (int fd; (fd = accept(_fd, nullptr, nullptr)) >= 0;) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _connections.emplace_back([this, fd]() { this->serve(fd); });
+      }
+    });
+    return true;
+  }
+
+  std::string
+  url(const char *path) const
+  {
+    return "http://127.0.0.1:" + std::to_string(_port) + path;
+  }
+
+  std::atomic<int> requests{0};
+
+private:
+  void
+  serve(int fd)
+  {
+    std::string request;
+    size_t body = std::string::npos;
+    size_t length = 0;
+    char buf[4096];
+    ssize_t n;
+
+    // Read the headers and the body of the request.
+    while ((body == std::string::npos || request.size() < body + length) && (n = read(fd, buf, sizeof(buf))) > 0) {
+      request.append(buf, n);
+      if (body == std::string::npos && (body = request.find("\r\n\r\n")) != std::string::npos) {
+        body += 4;
+        size_t field = request.find("Content-Length:");
+        length       = field < body ? strtoul(request.c_str() + field + 15, nullptr, 10) : 0;
+      }
+    }
+    ++requests;
+
+    if (request.find(" /good ") != std::string::npos && body != std::string::npos) {
+      const unsigned char *p = reinterpret_cast<const unsigned char *>(request.data() + body);
+      OCSP_REQUEST *req      = d2i_OCSP_REQUEST(nullptr, &p, length);
+      OCSP_RESPONSE *rsp     = req ? this->respond(req) : nullptr;
+
+      this->reply(fd, rsp);
+      OCSP_RESPONSE_free(rsp);
+      OCSP_REQUEST_free(req);
+    } else if (request.find(" /trylater ") != std::string::npos) {
+      OCSP_RESPONSE *rsp = OCSP_response_create(OCSP_RESPONSE_STATUS_TRYLATER, nullptr);
+
+      this->reply(fd, rsp);
+      OCSP_RESPONSE_free(rsp);
+    } else if (request.find(" /silent ") != std::string::npos) {
+      // Until the client gives up.
+      while (read(fd, buf, sizeof(buf)) > 0) {
+      }
+    }
+    close(fd);
+  }
+
+  void
+  reply(int fd, OCSP_RESPONSE *rsp)
+  {
+    unsigned char *der = nullptr;
+    int derlen         = rsp ? i2d_OCSP_RESPONSE(rsp, &der) : 0;
+
+    if (derlen > 0) {
+      std::string reply = "HTTP/1.0 200 OK\r\nContent-Type: application/ocsp-response\r\nContent-Length: " +
+                          std::to_string(derlen) + "\r\n\r\n" + std::string(reinterpret_cast<char *>(der), derlen);
+      write(fd, reply.data(), reply.size());
+    }
+    OPENSSL_free(der);
+  }
+
+  OCSP_RESPONSE *
+  respond(OCSP_REQUEST *req)
+  {
+    OCSP_CERTID *cid   = OCSP_onereq_get0_id(OCSP_request_onereq_get0(req, 0));
+    OCSP_BASICRESP *bs = OCSP_BASICRESP_new();
+    ASN1_TIME *thisupd = X509_gmtime_adj(nullptr, 0);
+    ASN1_TIME *nextupd = X509_gmtime_adj(nullptr, 3600);
+    OCSP_RESPONSE *rsp = nullptr;
+
+    if (OCSP_basic_add1_status(bs, cid, V_OCSP_CERTSTATUS_GOOD, 0, nullptr, thisupd, nextupd) &&
+        OCSP_basic_sign(bs, _cert, _key, EVP_sha256(), nullptr, 0)) {
+      rsp = OCSP_response_create(OCSP_RESPONSE_STATUS_SUCCESSFUL, bs);
+    }
+    ASN1_TIME_free(thisupd);
+    ASN1_TIME_free(nextupd);
+    OCSP_BASICRESP_free(bs);
+    return rsp;
+  }
+
+  X509 *_cert;
+  EVP_PKEY *_key;
+  int _fd        = -1;
+  uint16_t _port = 0;
+  std::thread _acceptor;
+  std::mutex _mutex;
+  std::vector<std::thread> _connections;
+};
+} // namespace
+
+REGRESSION_TEST(OCSPStaplingRefresh)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+
+  box = REGRESSION_TEST_PASSED;
+
+  EVP_PKEY *key = test_key();
+  X509 *issuer  = test_cert(1, key, nullptr, key);
+  X509 *certs[4];
+  for (int i = 0; i < 4; ++i) {
+    certs[i] = test_cert(i + 2, key, issuer, key);
+  }
+
+  {
+    MockOCSPResponder responder(issuer, key);
+    if (!responder.start()) {
+      box.check(false, "unable to start the OCSP responder: %s", strerror(errno));
+    } else {
+      int request_timeout  = SSLConfigParams::ssl_ocsp_request_timeout;
+      int max_concurrent   = SSLConfigParams::ssl_ocsp_max_concurrent_requests;
+      int cache_timeout    = SSLConfigParams::ssl_ocsp_cache_timeout;
+      char *response_cache = SSLConfigParams::ssl_ocsp_response_cache_path;
+
+      SSLConfigParams::ssl_ocsp_request_timeout         = 1;
+      SSLConfigParams::ssl_ocsp_max_concurrent_requests = 2;
+      SSLConfigParams::ssl_ocsp_cache_timeout           = 7200;
+      SSLConfigParams::ssl_ocsp_response_cache_path     = nullptr;
+
+      // The silent responder holds one of the two request slots until it times out, the other requests go on.
+      std::vector<certinfo *> due = {test_certinfo(certs[0], issuer, responder.url("/good")),
+                                     test_certinfo(certs[1], issuer, responder.url("/close")),
+                                     test_certinfo(certs[2], issuer, responder.url("/silent")),
+                                     test_certinfo(certs[3], issuer, responder.url("/good"))};
+      ink_hrtime start = ink_get_hrtime_internal();
+      stapling_refresh_responses(due);
+      ink_hrtime elapsed = ink_get_hrtime_internal() - start;
+      time_t now         = time(nullptr);
+
+      for (certinfo *cinf : {due[0], due[3]}) {
+        box.check(cinf->resp_derlen > 0 && !cinf->is_expire, "response of %s cached", cinf->uri);
+        box.check(cinf->expire_time > now + 3500 && cinf->expire_time <= now + 3600, "%s expires at the nextUpdate, in %ld s",
+                  cinf->uri, static_cast<long>(cinf->expire_time - now));
+        box.check(cinf->refresh_time > now && cinf->refresh_time < cinf->expire_time, "%s refreshed before it expires", cinf->uri);
+      }
+      for (certinfo *cinf : {due[1], due[2]}) {
+        box.check(cinf->resp_derlen == 0 && cinf->is_expire, "no response for %s", cinf->uri);
+      }
+      box.check(responder.requests == 4, "4 requests, got %d", responder.requests.load());
+      box.check(elapsed >= HRTIME_SECONDS(1) && elapsed < HRTIME_SECONDS(3), "the silent request timed out in %" PRId64 " ms",
+                ink_hrtime_to_msec(elapsed));
+
+      for (certinfo *cinf : due) {
+        test_certinfo_free(cinf);
+      }
+
+      // Only the successful responses are saved for the next start.
+      char cache_dir[] = "/tmp/ocsp_cache.XXXXXX";
+      if (mkdtemp(cache_dir) == nullptr) {
+        box.check(false, "unable to create the response cache directory: %s", strerror(errno));
+      } else {
+        SSLConfigParams::ssl_ocsp_response_cache_path = cache_dir;
+        due = {test_certinfo(certs[0], issuer, responder.url("/good")),
+               test_certinfo(certs[1], issuer, responder.url("/trylater"))};
+        stapling_refresh_responses(due);
+
+        std::string good_file  = stapling_cache_file(due[0]);
+        std::string error_file = stapling_cache_file(due[1]);
+        box.check(access(good_file.c_str(), F_OK) == 0, "response of %s saved", due[0]->uri);
+        box.check(access(error_file.c_str(), F_OK) != 0, "error response of %s not saved", due[1]->uri);
+        unlink(good_file.c_str());
+        unlink(error_file.c_str());
+        rmdir(cache_dir);
+        for (certinfo *cinf : due) {
+          test_certinfo_free(cinf);
+        }
+      }
+      SSLConfigParams::ssl_ocsp_request_timeout         = request_timeout;
+      SSLConfigParams::ssl_ocsp_max_concurrent_requests = max_concurrent;
+      SSLConfigParams::ssl_ocsp_cache_timeout           = cache_timeout;
+      SSLConfigParams::ssl_ocsp_response_cache_path     = response_cache;
+    }
+  }
+
+  for (X509 *cert : certs) {
+    X509_free(cert);
+  }
+  X509_free(issuer);
+  EVP_PKEY_free(key);
+}
+#endif
+
 #endif /* TS_USE_TLS_OCSP */
@@ -0,0 +1,123 @@
+/** @file
+
+  Connection and handshake admission control.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Inbound connections are admitted against a token bucket per client address prefix, checked right
+  after @c accept. New TLS handshakes are admitted against a process wide token bucket, checked
+  before @c SSL_accept, so a handshake flood is turned away before it costs any crypto. Prefixes
+  which recently completed a handshake are exempt from the handshake budget so known clients keep
+  getting through while the budget is exhausted.
+
+  The per prefix buckets are kept in a fixed size set associative table, the least recently used
+  entry of a set is reused for a new prefix. Memory use is bounded no matter how many sources
+  connect, a source evicted from the table simply starts over with a full bucket.
+
+ */
+
+#pragma once
+
+#include <mutex>
+
+#include "tscore/ink_hrtime.h"
+#include "tscore/ink_inet.h"
+
+/// A token bucket, @a rate tokens per second up to @a burst tokens.
+struct TokenBucket {
+  double tokens    = -1; ///< Tokens available, negative if the bucket was never used.
+  ink_hrtime stamp = 0;  ///< Time of the last refill.
+
+  /// Take a token at time @a now, @c false if the bucket is empty. A @a rate of 0 is unlimited.
+  bool take(int rate, int burst, ink_hrtime now);
+};
+
+class AdmissionControl
+{
+public:
+  /// Number of entries of the prefix table.
+  static constexpr int TABLE_SIZE = 1 << 16;
+  /// Entries in a set of the prefix table.
+  static constexpr int TABLE_WAYS = 4;
+  /// Number of independently locked shards of the prefix table.
+  static constexpr int TABLE_SHARDS = 64;
+
+  struct Config {
+    int enabled             = 0;
+    int conn_rate           = 0; ///< New connections per second per prefix, 0 for unlimited.
+    int conn_burst          = 0;
+    int ipv4_prefix         = 24;
+    int ipv6_prefix         = 64;
+    int handshake_rate      = 0; ///< New TLS handshakes per second for the process, 0 for unlimited.
+    int handshake_burst     = 0;
+    int handshake_trust_sec = 60; ///< How long a completed handshake exempts its prefix from the handshake budget.
+  };
+
+  explicit AdmissionControl(const Config &config) : _config(config) {}
+  ~AdmissionControl();
+
+  AdmissionControl(const AdmissionControl &) = delete;
+  AdmissionControl &operator=(const AdmissionControl &) = delete;
+
+  /// Check if a connection from @a addr is admitted at @a now.
+  bool admit_connection(sockaddr const *addr, ink_hrtime now);
+  /// Check if a new TLS handshake from @a addr is admitted at @a now.
+  bool admit_handshake(sockaddr const *addr, ink_hrtime now);
+  /// Note that a TLS handshake from @a addr completed at @a now.
+  void handshake_completed(sockaddr const *addr, ink_hrtime now);
+
+  /// Process wide instance, configured by @c proxy.config.net.admission.*.
+  static AdmissionControl &global();
+  /// Establish the configuration records of the process wide instance.
+  static void config_init();
+
+private:
+  struct Key {
+    uint64_t hi  = 0;
+    uint64_t lo  = 0;
+    uint32_t tag = 0; ///< Family and prefix length, 0 for an unused entry.
+
+    bool
+    operator==(const Key &that) const
+    {
+      return hi == that.hi && lo == that.lo && tag == that.tag;
+    }
+  };
+
+  struct Entry {
+    Key key;
+    TokenBucket conn;
+    ink_hrtime last_used      = 0;
+    ink_hrtime last_handshake = 0;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    Entry *entries = nullptr;
+  };
+
+  bool make_key(sockaddr const *addr, Key &key) const;
+  Shard &shard_for(const Key &key, uint64_t &hash);
+  Entry *lookup(Shard &shard, uint64_t hash, const Key &key, ink_hrtime now, bool insert);
+
+  const Config &_config;
+  Shard _shards[TABLE_SHARDS];
+  std::mutex _handshake_mutex;
+  TokenBucket _handshakes;
+};
@@ -167,6 +167,9 @@ struct Server : public Connection {
   /// If set, a kernel HTTP accept filter
   bool http_accept_filter = false;
 
+  /// If set, other sockets can listen on the same address (SO_REUSEPORT).
+  bool reuseport = false;
+
   int accept(Connection *c);
 
   //
@@ -57,6 +57,8 @@ enum Net_Stats {
   net_tcp_accept_stat,
   net_connections_throttled_in_stat,
   net_connections_throttled_out_stat,
+  net_admission_connections_rejected_stat,
+  net_admission_handshakes_rejected_stat,
   Net_Stat_Count
 };
 
@@ -98,6 +100,7 @@ extern RecRawStatBlock *net_rsb;
 #include "P_UnixNet.h"
 #include "P_UnixNetProcessor.h"
 #include "P_NetAccept.h"
+#include "P_AdmissionControl.h"
 #include "P_UnixNetVConnection.h"
 #include "P_UnixPollDescriptor.h"
 #include "P_Socks.h"
@@ -25,6 +25,10 @@
 
 #include <openssl/ssl.h>
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "ProxyConfig.h"
 
 struct SSLConfigParams;
@@ -119,11 +123,43 @@ public:
   shared_ssl_ticket_key_block keyblock       = nullptr;                        ///< session keys associated with this address
 };
 
+/** A context built from one ssl_multicert.config line.
+
+    The lookup keeps these so that the next reload can reuse the contexts of the lines for which
+    neither the line nor any of the files it was built from changed.
+*/
+struct SSLCertContextBuild {
+  struct File {
+    std::string path;
+    time_t mtime = 0;
+    off_t size   = 0;
+    std::string digest; ///< SHA-256 of the content.
+  };
+
+  std::vector<File> files; ///< Files the context was built from.
+  shared_SSL_CTX ctx;
+  shared_ssl_ticket_key_block keyblock;
+  std::vector<X509 *> certs; ///< Certificates of the context, used to index the names.
+  bool valid = true;         ///< All the certificates passed the validity checks.
+
+  SSLCertContextBuild() = default;
+  SSLCertContextBuild(const SSLCertContextBuild &) = delete;
+  SSLCertContextBuild &operator=(const SSLCertContextBuild &) = delete;
+  ~SSLCertContextBuild();
+};
+
+using shared_SSLCertContextBuild = std::shared_ptr<SSLCertContextBuild>;
+
 struct SSLCertLookup : public ConfigInfo {
   SSLContextStorage *ssl_storage;
   shared_SSL_CTX ssl_default;
   bool is_valid = true;
 
+  /// Contexts built for this lookup, keyed by their ssl_multicert.config line.
+  std::unordered_map<std::string, shared_SSLCertContextBuild> builds;
+  /// Generation of the @c SSLConfigParams the contexts were built with.
+  unsigned params_generation = 0;
+
   int insert(const char *name, SSLCertContext const &cc);
   int insert(const IpEndpoint &address, SSLCertContext const &cc);
 
@@ -140,6 +176,12 @@ struct SSLCertLookup : public ConfigInfo {
   */
   SSLCertContext *find(const char *name) const;
 
+  /** Build the compiled name index used by @c find.
+      This is done once the configuration is loaded, before the lookup is published. Inserting a name
+      afterwards is supported but drops the compiled index.
+  */
+  void compile();
+
   // Return the last-resort default TLS context if there is no name or address match.
   SSL_CTX *
   defaultContext() const
@@ -74,6 +74,7 @@ struct SSLConfigParams : public ConfigInfo {
   char *cipherSuite;
   char *client_cipherSuite;
   int configExitOnLoadError;
+  int configLoadThreads;
   int clientCertLevel;
   int verify_depth;
   int ssl_session_cache; // SSL_SESSION_CACHE_MODE
@@ -100,6 +101,8 @@ struct SSLConfigParams : public ConfigInfo {
   char *server_groups_list;
   char *client_groups_list;
 
+  unsigned generation; ///< Distinct for each load of the parameters.
+
   static int ssl_maxrecord;
   static bool ssl_allow_client_renegotiation;
 
@@ -107,12 +110,15 @@ struct SSLConfigParams : public ConfigInfo {
   static int ssl_ocsp_cache_timeout;
   static int ssl_ocsp_request_timeout;
   static int ssl_ocsp_update_period;
+  static int ssl_ocsp_max_concurrent_requests;
+  static char *ssl_ocsp_response_cache_path;
   static int ssl_handshake_timeout_in;
   char *ssl_ocsp_response_path_only;
 
   static size_t session_cache_number_buckets;
   static size_t session_cache_max_bucket_size;
   static bool session_cache_skip_on_lock_contention;
+  static char *session_cache_file;
 
   static IpMap *proxy_protocol_ipmap;
 
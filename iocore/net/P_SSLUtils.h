@@ -48,7 +48,10 @@ public:
   SSLMultiCertConfigLoader(const SSLConfigParams *p) : _params(p) {}
   virtual ~SSLMultiCertConfigLoader(){};
 
-  bool load(SSLCertLookup *lookup);
+  /** Load the configuration into @a lookup.
+      The contexts of @a current, the lookup in use, are shared for the entries whose files did not change.
+  */
+  bool load(SSLCertLookup *lookup, const SSLCertLookup *current = nullptr);
 
   virtual SSL_CTX *default_server_ssl_ctx();
   virtual SSL_CTX *init_server_ssl_ctx(std::vector<X509 *> &certList, const SSLMultiCertConfigParams *sslMultCertSettings);
@@ -66,7 +69,9 @@ protected:
   const SSLConfigParams *_params;
 
 private:
-  virtual SSL_CTX *_store_ssl_ctx(SSLCertLookup *lookup, const shared_SSLMultiCertConfigParams ssl_multi_cert_params);
+  shared_SSLCertContextBuild _build_ssl_ctx(const shared_SSLMultiCertConfigParams &ssl_multi_cert_params);
+  virtual SSL_CTX *_store_ssl_ctx(SSLCertLookup *lookup, const shared_SSLMultiCertConfigParams ssl_multi_cert_params,
+                                  const shared_SSLCertContextBuild &build, bool reused);
   virtual void _set_handshake_callbacks(SSL_CTX *ctx);
 };
 
@@ -41,6 +41,14 @@ static inline PollCont *get_UDPPollCont(EThread *);
 #include "P_UDPIOEvent.h"
 
 class UDPNetHandler;
+struct UDPRecvBatch;
+
+/// Most datagrams read or written with one system call.
+#define UDP_MAX_BATCH 64
+
+extern int32_t g_udp_batch_size;
+extern int32_t g_udp_enable_gso;
+extern int32_t g_udp_enable_gro;
 
 struct UDPNetProcessorInternal : public UDPNetProcessor {
   int start(int n_udp_threads, size_t stacksize) override;
@@ -284,9 +292,10 @@ public:
 
   void SendPackets();
   void SendUDPPacket(UDPPacketInternal *p, int32_t pktLen);
+  void SendUDPPackets(UDPPacketInternal **packets, int n);
 
-  // Interface exported to the outside world
-  void send(UDPPacket *p);
+  // Interface exported to the outside world, true if the queue was empty
+  bool send(UDPPacket *p);
 
   UDPQueue();
   ~UDPQueue();
@@ -309,6 +318,9 @@ public:
   // to be called back with data
   Que(UnixUDPConnection, callback_link) udp_callbacks;
 
+  // buffers for batched reads, allocated on the first read
+  UDPRecvBatch *recv_batch = nullptr;
+
   Event *trigger_event = nullptr;
   EThread *thread      = nullptr;
   ink_hrtime nextCheck;
@@ -40,6 +40,8 @@
 
 #include <unordered_map>
 #include <vector>
+#include <map>
+#include <memory>
 #include <algorithm>
 
 struct SSLAddressLookupKey {
@@ -79,6 +81,40 @@ private:
   unsigned char sep = 0; // offset of address/port separator
 };
 
+/** Compiled, read only index of the certificate names.
+
+    The names are stored as a trie of their labels, top level domain first, so the exact match and the
+    one level wildcard match are found in a single walk without copying or lower casing the name. The
+    nodes and the label text are kept in two flat arrays that refer to each other by offset.
+*/
+struct SSLNameIndex {
+  struct Node {
+    uint32_t label      = 0;  ///< Offset of the label in @a labels.
+    uint32_t label_len  = 0;  ///< Length of the label.
+    uint32_t child      = 0;  ///< Index of the first child. Children are contiguous and sorted by label.
+    uint32_t n_children = 0;  ///< Number of children.
+    int exact           = -1; ///< Context for the name ending at this node.
+    int wild            = -1; ///< Context for a wildcard of the name ending at this node.
+  };
+
+  using Names = std::unordered_map<std::string, int>;
+
+  SSLNameIndex(Names const &hostnames, Names const &wilddomains);
+
+  /// @return The context index for @a name or -1 if there is no match.
+  int lookup(std::string_view name) const;
+
+  /// Put the indexed names back in the tables they were built from.
+  void restore(Names &hostnames, Names &wilddomains) const;
+
+private:
+  const Node *child(const Node *node, std::string_view label) const;
+  void restore(const Node *node, std::string const &name, Names &hostnames, Names &wilddomains) const;
+
+  std::vector<Node> nodes; ///< Breadth first, the root is the first node.
+  std::string labels;      ///< Text of the labels, lower case.
+};
+
 struct SSLContextStorage {
 public:
   SSLContextStorage();
@@ -96,6 +132,9 @@ public:
   int insert(const char *name, int idx);
   SSLCertContext *lookup(const char *name);
   void printWildDomains() const;
+
+  /// Replace the name tables with a compiled index.
+  void compile();
   unsigned
   count() const
   {
@@ -129,6 +168,8 @@ private:
   std::unordered_map<std::string, int> wilddomains;
   /// Contexts stored by IP address or FQDN
   std::unordered_map<std::string, int> hostnames;
+  /// Compiled index of @a wilddomains and @a hostnames, which are empty while it is set.
+  std::unique_ptr<SSLNameIndex> name_index;
   /// List for cleanup.
   /// Exactly one pointer to each SSL context is stored here.
   std::vector<SSLCertContext> ctx_store;
@@ -136,6 +177,9 @@ private:
   /// Add a context to the clean up list.
   /// @return The index of the added context.
   int store(SSLCertContext const &cc);
+
+  /// Go back to the name tables so they can be updated.
+  void decompile();
 };
 
 namespace
@@ -154,8 +198,172 @@ transform_lower(std::string_view src, ts::MemSpan<char> dst)
   auto final = std::transform(src.begin(), src.end(), dst.data(), [](char c) -> char { return std::tolower(c); });
   *final++   = '\0';
 }
+
+/** Compare a lower case @a label with @a name, ignoring the case of @a name.
+ *
+ * @return Less than, equal to or greater than 0 like @c memcmp.
+ */
+inline int
+compare_label(std::string_view label, std::string_view name)
+{
+  size_t n = std::min(label.size(), name.size());
+  for (size_t i = 0; i < n; ++i) {
+    int l = static_cast<unsigned char>(label[i]);
+    int c = std::tolower(static_cast<unsigned char>(name[i]));
+    if (l != c) {
+      return l - c;
+    }
+  }
+  return label.size() < name.size() ? -1 : label.size() > name.size();
+}
+
+/** Remove the last label of @a name.
+ *
+ * @return The label, which is all of @a name if it has a single label.
+ */
+inline std::string_view
+take_last_label(std::string_view &name, bool &last)
+{
+  std::string_view label;
+  size_t dot = name.rfind('.');
+
+  if (dot == std::string_view::npos) {
+    label = name;
+    last  = true;
+  } else {
+    label = name.substr(dot + 1);
+    name  = name.substr(0, dot);
+    last  = false;
+  }
+  return label;
+}
 } // namespace
 
+SSLNameIndex::SSLNameIndex(Names const &hostnames, Names const &wilddomains)
+{
+  // Build a sorted tree first, then lay it out breadth first so the children of a node are adjacent.
+  struct Builder {
+    std::map<std::string, std::unique_ptr<Builder>> children;
+    int exact = -1;
+    int wild  = -1;
+  } root;
+
+  auto add = [&root](std::string_view name) -> Builder * {
+    Builder *b = &root;
+    bool last  = false;
+    while (!last) {
+      auto &c = b->children[std::string(take_last_label(name, last))];
+      if (!c) {
+        c = std::make_unique<Builder>();
+      }
+      b = c.get();
+    }
+    return b;
+  };
+
+  for (auto &&[name, idx] : hostnames) {
+    add(name)->exact = idx;
+  }
+  for (auto &&[name, idx] : wilddomains) {
+    add(name)->wild = idx;
+  }
+
+  // Labels such as top level domains are repeated a lot, store their text once.
+  std::unordered_map<std::string_view, uint32_t> label_offsets;
+  std::vector<const Builder *> queue{&root};
+
+  nodes.emplace_back();
+  for (size_t i = 0; i < queue.size(); ++i) {
+    const Builder *b    = queue[i];
+    nodes[i].exact      = b->exact;
+    nodes[i].wild       = b->wild;
+    nodes[i].child      = nodes.size();
+    nodes[i].n_children = b->children.size();
+    for (auto &&[label, c] : b->children) {
+      Node n;
+      if (auto spot = label_offsets.find(label); spot != label_offsets.end()) {
+        n.label = spot->second;
+      } else {
+        n.label = labels.size();
+        labels.append(label);
+        label_offsets.emplace(label, n.label);
+      }
+      n.label_len = label.size();
+      nodes.push_back(n);
+      queue.push_back(c.get());
+    }
+  }
+  nodes.shrink_to_fit();
+  labels.shrink_to_fit();
+}
+
+const SSLNameIndex::Node *
+SSLNameIndex::child(const Node *node, std::string_view label) const
+{
+  const Node *first = nodes.data() + node->child;
+  const Node *limit = first + node->n_children;
+
+  while (first < limit) {
+    const Node *mid = first + (limit - first) / 2;
+    int r           = compare_label({labels.data() + mid->label, mid->label_len}, label);
+    if (r == 0) {
+      return mid;
+    } else if (r < 0) {
+      first = mid + 1;
+    } else {
+      limit = mid;
+    }
+  }
+  return nullptr;
+}
+
+int
+SSLNameIndex::lookup(std::string_view name) const
+{
+  // A wildcard matches a single label, so it is the wildcard of the node before the first label.
+  const Node *node   = nodes.data();
+  const Node *parent = nullptr;
+  bool last          = false;
+
+  while (!last) {
+    std::string_view label = take_last_label(name, last);
+    if (last) {
+      parent = node;
+    }
+    if ((node = this->child(node, label)) == nullptr) {
+      break;
+    }
+    if (last && node->exact >= 0) {
+      return node->exact;
+    }
+  }
+  return parent ? parent->wild : -1;
+}
+
+void
+SSLNameIndex::restore(Names &hostnames, Names &wilddomains) const
+{
+  const Node &root = nodes.front();
+  for (uint32_t i = root.child; i < root.child + root.n_children; ++i) {
+    this->restore(&nodes[i], std::string(labels, nodes[i].label, nodes[i].label_len), hostnames, wilddomains);
+  }
+}
+
+void
+SSLNameIndex::restore(const Node *node, std::string const &name, Names &hostnames, Names &wilddomains) const
+{
+  if (node->exact >= 0) {
+    hostnames.emplace(name, node->exact);
+  }
+  if (node->wild >= 0) {
+    wilddomains.emplace(name, node->wild);
+  }
+  for (uint32_t i = node->child; i < node->child + node->n_children; ++i) {
+    std::string child_name(labels, nodes[i].label, nodes[i].label_len);
+    this->restore(&nodes[i], child_name.append(1, '.').append(name), hostnames, wilddomains);
+  }
+}
+
 // Zero out and free the heap space allocated for ticket keys to avoid leaking secrets.
 // The first several bytes stores the number of keys and the rest stores the ticket keys.
 void
@@ -282,6 +490,13 @@ SSLCertContext::setCtx(shared_SSL_CTX sc)
   ctx = sc;
 }
 
+SSLCertContextBuild::~SSLCertContextBuild()
+{
+  for (auto cert : certs) {
+    X509_free(cert);
+  }
+}
+
 SSLCertLookup::SSLCertLookup() : ssl_storage(new SSLContextStorage()), ssl_default(nullptr), is_valid(true) {}
 
 SSLCertLookup::~SSLCertLookup()
@@ -295,6 +510,12 @@ SSLCertLookup::find(const char *address) const
   return this->ssl_storage->lookup(address);
 }
 
+void
+SSLCertLookup::compile()
+{
+  this->ssl_storage->compile();
+}
+
 SSLCertContext *
 SSLCertLookup::find(const IpEndpoint &address) const
 {
@@ -369,6 +590,10 @@ SSLContextStorage::insert(const char *name, int idx)
   char lower_case_name[TS_MAX_HOST_NAME_LEN + 1];
   transform_lower(name, lower_case_name);
 
+  if (this->name_index) {
+    this->decompile();
+  }
+
   shared_SSL_CTX ctx = this->ctx_store[idx].getCtx();
   if (wildcard.match(lower_case_name)) {
     // Strip the wildcard and store the subdomain
@@ -409,9 +634,34 @@ SSLContextStorage::printWildDomains() const
   }
 }
 
+void
+SSLContextStorage::compile()
+{
+  if (this->name_index || (this->hostnames.empty() && this->wilddomains.empty())) {
+    return;
+  }
+  this->name_index = std::make_unique<SSLNameIndex>(this->hostnames, this->wilddomains);
+  Debug("ssl", "compiled %zu host names and %zu wildcard domains", this->hostnames.size(), this->wilddomains.size());
+  // Swap rather than clear so the table memory is released.
+  std::unordered_map<std::string, int>().swap(this->hostnames);
+  std::unordered_map<std::string, int>().swap(this->wilddomains);
+}
+
+void
+SSLContextStorage::decompile()
+{
+  this->name_index->restore(this->hostnames, this->wilddomains);
+  this->name_index.reset();
+}
+
 SSLCertContext *
 SSLContextStorage::lookup(const char *name)
 {
+  if (this->name_index) {
+    int idx = this->name_index->lookup(name);
+    return idx < 0 ? nullptr : &(this->ctx_store[idx]);
+  }
+
   // First look for an exact name match
   if (auto it = this->hostnames.find(name); it != this->hostnames.end()) {
     return &(this->ctx_store[it->second]);
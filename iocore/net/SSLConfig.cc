@@ -31,6 +31,7 @@
 
 #include "P_SSLConfig.h"
 
+#include <atomic>
 #include <cstring>
 #include <cmath>
 
@@ -58,10 +59,13 @@ bool SSLConfigParams::ssl_ocsp_enabled                      = false;
 int SSLConfigParams::ssl_ocsp_cache_timeout                 = 3600;
 int SSLConfigParams::ssl_ocsp_request_timeout               = 10;
 int SSLConfigParams::ssl_ocsp_update_period                 = 60;
+int SSLConfigParams::ssl_ocsp_max_concurrent_requests       = 16;
+char *SSLConfigParams::ssl_ocsp_response_cache_path         = nullptr;
 int SSLConfigParams::ssl_handshake_timeout_in               = 0;
 size_t SSLConfigParams::session_cache_number_buckets        = 1024;
 bool SSLConfigParams::session_cache_skip_on_lock_contention = false;
 size_t SSLConfigParams::session_cache_max_bucket_size       = 100;
+char *SSLConfigParams::session_cache_file                   = nullptr;
 init_ssl_ctx_func SSLConfigParams::init_ssl_ctx_cb          = nullptr;
 load_ssl_file_func SSLConfigParams::load_ssl_file_cb        = nullptr;
 IpMap *SSLConfigParams::proxy_protocol_ipmap                = nullptr;
@@ -72,6 +76,7 @@ char *SSLConfigParams::engine_conf_file      = nullptr;
 static std::unique_ptr<ConfigUpdateHandler<SSLCertificateConfig>> sslCertUpdate;
 static std::unique_ptr<ConfigUpdateHandler<SSLConfig>> sslConfigUpdate;
 static std::unique_ptr<ConfigUpdateHandler<SSLTicketKeyConfig>> sslTicketKey;
+static std::atomic<unsigned> sslConfigGeneration{0};
 
 SSLConfigParams::SSLConfigParams()
 {
@@ -114,6 +119,8 @@ SSLConfigParams::reset()
   ssl_session_cache_timeout            = 0;
   ssl_session_cache_auto_clear         = 1;
   configExitOnLoadError                = 1;
+  configLoadThreads                    = 0;
+  generation                           = 0;
 }
 
 void
@@ -285,6 +292,11 @@ SSLConfigParams::initialize()
 
   configFilePath = ats_stringdup(RecConfigReadConfigPath("proxy.config.ssl.server.multicert.filename"));
   REC_ReadConfigInteger(configExitOnLoadError, "proxy.config.ssl.server.multicert.exit_on_load_fail");
+  REC_ReadConfigInteger(configLoadThreads, "proxy.config.ssl.server.multicert.load_threads");
+  if (configLoadThreads <= 0) {
+    configLoadThreads = ink_number_of_processors();
+  }
+  generation = ++sslConfigGeneration;
 
   REC_ReadConfigStringAlloc(ssl_server_private_key_path, "proxy.config.ssl.server.private_key.path");
   set_paths_helper(ssl_server_private_key_path, nullptr, &serverKeyPathOnly, nullptr);
@@ -308,7 +320,12 @@ SSLConfigParams::initialize()
   SSLConfigParams::session_cache_skip_on_lock_contention = ssl_session_cache_skip_on_contention;
   SSLConfigParams::session_cache_number_buckets          = ssl_session_cache_num_buckets;
 
-  if (ssl_session_cache == SSL_SESSION_CACHE_MODE_SERVER_ATS_IMPL) {
+  // The session cache settings need a restart, keep the sessions across reloads.
+  if (ssl_session_cache == SSL_SESSION_CACHE_MODE_SERVER_ATS_IMPL && session_cache == nullptr) {
+    ats_scoped_str session_cache_file(REC_ConfigReadString("proxy.config.ssl.session_cache.file"));
+    if (session_cache_file && *session_cache_file) {
+      SSLConfigParams::session_cache_file = ats_stringdup(Layout::relative_to(RecConfigReadRuntimeDir(), session_cache_file.get()));
+    }
     session_cache = new SSLSessionCache();
   }
 
@@ -320,6 +337,13 @@ SSLConfigParams::initialize()
   REC_EstablishStaticConfigInt32(ssl_ocsp_cache_timeout, "proxy.config.ssl.ocsp.cache_timeout");
   REC_EstablishStaticConfigInt32(ssl_ocsp_request_timeout, "proxy.config.ssl.ocsp.request_timeout");
   REC_EstablishStaticConfigInt32(ssl_ocsp_update_period, "proxy.config.ssl.ocsp.update_period");
+  REC_EstablishStaticConfigInt32(ssl_ocsp_max_concurrent_requests, "proxy.config.ssl.ocsp.max_concurrent_requests");
+  if (ssl_ocsp_response_cache_path == nullptr) {
+    ats_scoped_str response_cache_path(REC_ConfigReadString("proxy.config.ssl.ocsp.response_cache.path"));
+    if (response_cache_path && *response_cache_path) {
+      ssl_ocsp_response_cache_path = ats_stringdup(Layout::relative_to(RecConfigReadRuntimeDir(), response_cache_path.get()));
+    }
+  }
   REC_ReadConfigStringAlloc(ssl_ocsp_response_path, "proxy.config.ssl.ocsp.response.path");
   set_paths_helper(ssl_ocsp_response_path, nullptr, &ssl_ocsp_response_path_only, nullptr);
   ats_free(ssl_ocsp_response_path);
@@ -515,7 +539,15 @@ SSLCertificateConfig::reconfigure()
   }
 
   SSLMultiCertConfigLoader loader(params);
-  loader.load(lookup);
+  if (configid) {
+    // Only rebuild the contexts of the entries that changed since the current lookup was loaded.
+    SSLCertificateConfig::scoped_config current;
+    loader.load(lookup, current);
+  } else {
+    loader.load(lookup);
+  }
+  // Compile the names before publishing, the handshakes only see the compiled index.
+  lookup->compile();
 
   if (!lookup->is_valid) {
     retStatus = false;
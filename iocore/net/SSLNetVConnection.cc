@@ -969,6 +969,13 @@ SSLNetVConnection::sslStartHandShake(int event, int &err)
   switch (event) {
   case SSL_EVENT_SERVER:
     if (this->ssl == nullptr) {
+      // Turn away new handshakes over the budget before they cost any crypto.
+      if (!AdmissionControl::global().admit_handshake(this->get_remote_addr(), Thread::get_hrtime())) {
+        Debug("ssl", "Handshake rejected by admission control");
+        NET_INCREMENT_DYN_STAT(net_admission_handshakes_rejected_stat);
+        return EVENT_ERROR;
+      }
+
       SSLCertificateConfig::scoped_config lookup;
       IpEndpoint dst;
       int namelen = sizeof(dst);
@@ -1258,6 +1265,7 @@ SSLNetVConnection::sslServerHandShakeEvent(int &err)
     }
 
     sslHandshakeStatus = SSL_HANDSHAKE_DONE;
+    AdmissionControl::global().handshake_completed(this->get_remote_addr(), Thread::get_hrtime());
 
     if (sslHandshakeBeginTime) {
       sslHandshakeEndTime                 = Thread::get_hrtime();
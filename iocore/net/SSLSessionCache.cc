@@ -24,97 +24,272 @@
 #include "SSLStats.h"
 
 #include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-#define SSLSESSIONCACHE_STRINGIFY0(x) #x
-#define SSLSESSIONCACHE_STRINGIFY(x) SSLSESSIONCACHE_STRINGIFY0(x)
-#define SSLSESSIONCACHE_LINENO SSLSESSIONCACHE_STRINGIFY(__LINE__)
+#include "tscore/ink_align.h"
 
-#ifdef DEBUG
-#define PRINT_BUCKET(x) this->print(x " at " __FILE__ ":" SSLSESSIONCACHE_LINENO);
-#else
-#define PRINT_BUCKET(x)
-#endif
+namespace
+{
+constexpr uint32_t SESSION_FILE_MAGIC   = 0x53534c43; // "SSLC"
+constexpr uint32_t SESSION_FILE_VERSION = 1;
+
+/// Start of the session file, the slots follow at @c SESSION_FILE_HEADER_SIZE.
+struct SSLSessionFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t nshards;
+  uint64_t slots_per_shard;
+  uint64_t slot_size;
+};
+
+constexpr size_t SESSION_FILE_HEADER_SIZE = INK_ALIGN(sizeof(SSLSessionFileHeader), 64);
+
+/// Begin an update of @a slot, readers retry until @c end_write.
+void
+begin_write(SSLSessionSlot &slot)
+{
+  slot.seq.store(slot.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void
+end_write(SSLSessionSlot &slot)
+{
+  slot.seq.store(slot.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void
+clear_slot(SSLSessionSlot &slot)
+{
+  begin_write(slot);
+  slot.id_len      = 0;
+  slot.data_len    = 0;
+  slot.insert_time = 0;
+  end_write(slot);
+}
+} // namespace
 
 /* Session Cache */
-SSLSessionCache::SSLSessionCache() : nbuckets(SSLConfigParams::session_cache_number_buckets)
+SSLSessionCache::SSLSessionCache()
+  : SSLSessionCache(SSLConfigParams::session_cache_number_buckets, SSLConfigParams::session_cache_max_bucket_size,
+                    SSLConfigParams::session_cache_file)
 {
-  Debug("ssl.session_cache", "Created new ssl session cache %p with %zu buckets each with size max size %zu", this, nbuckets,
-        SSLConfigParams::session_cache_max_bucket_size);
+}
 
-  session_bucket = new SSLSessionBucket[nbuckets];
+SSLSessionCache::SSLSessionCache(size_t nshards, size_t slots_per_shard, const char *path)
+  : nshards(std::max<size_t>(nshards, 1)), slots_per_shard(std::max<size_t>(slots_per_shard, 1))
+{
+  Debug("ssl.session_cache", "Created new ssl session cache %p with %zu shards of %zu sessions", this, this->nshards,
+        this->slots_per_shard);
+
+  this->map_slots(path);
+
+  SSLSessionSlot *slots = reinterpret_cast<SSLSessionSlot *>(static_cast<char *>(mapping) + SESSION_FILE_HEADER_SIZE);
+  shards                = new Shard[this->nshards];
+  for (size_t i = 0; i < this->nshards; ++i) {
+    ink_mutex_init(&shards[i].writer);
+    shards[i].slots = slots + i * this->slots_per_shard;
+  }
 }
 
 SSLSessionCache::~SSLSessionCache()
 {
-  delete[] session_bucket;
+  for (size_t i = 0; i < nshards; ++i) {
+    ink_mutex_destroy(&shards[i].writer);
+  }
+  delete[] shards;
+  if (mapping) {
+    munmap(mapping, mapping_size);
+  }
+}
+
+void
+SSLSessionCache::map_slots(const char *path)
+{
+  mapping_size = SESSION_FILE_HEADER_SIZE + nshards * slots_per_shard * sizeof(SSLSessionSlot);
+
+  if (path && *path) {
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+      Warning("unable to open SSL session cache file %s: %s, sessions will not persist", path, strerror(errno));
+    } else if (static_cast<size_t>(st.st_size) != mapping_size && (ftruncate(fd, 0) < 0 || ftruncate(fd, mapping_size) < 0)) {
+      Warning("unable to size SSL session cache file %s: %s, sessions will not persist", path, strerror(errno));
+    } else {
+      mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if (mapping == MAP_FAILED) {
+        Warning("unable to map SSL session cache file %s: %s, sessions will not persist", path, strerror(errno));
+        mapping = nullptr;
+      }
+    }
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+
+  if (mapping == nullptr) {
+    mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ink_release_assert(mapping != MAP_FAILED);
+  }
+
+  SSLSessionFileHeader *header = static_cast<SSLSessionFileHeader *>(mapping);
+  SSLSessionSlot *slots        = reinterpret_cast<SSLSessionSlot *>(static_cast<char *>(mapping) + SESSION_FILE_HEADER_SIZE);
+  size_t nslots                = nshards * slots_per_shard;
+
+  if (header->magic == SESSION_FILE_MAGIC && header->version == SESSION_FILE_VERSION && header->nshards == nshards &&
+      header->slots_per_shard == slots_per_shard && header->slot_size == sizeof(SSLSessionSlot)) {
+    // Drop the slots a writer was updating when the previous process stopped.
+    size_t restored = 0;
+    for (size_t i = 0; i < nslots; ++i) {
+      if ((slots[i].seq.load(std::memory_order_relaxed) & 1) || slots[i].id_len > sizeof(slots[i].id) ||
+          slots[i].data_len > sizeof(slots[i].data)) {
+        memset(static_cast<void *>(&slots[i]), 0, sizeof(SSLSessionSlot));
+      } else if (slots[i].id_len) {
+        ++restored;
+      }
+    }
+    Debug("ssl.session_cache", "restored %zu sessions from %s", restored, path);
+  } else {
+    memset(mapping, 0, mapping_size);
+    header->magic           = SESSION_FILE_MAGIC;
+    header->version         = SESSION_FILE_VERSION;
+    header->nshards         = nshards;
+    header->slots_per_shard = slots_per_shard;
+    header->slot_size       = sizeof(SSLSessionSlot);
+  }
+}
+
+SSLSessionCache::Shard &
+SSLSessionCache::shard_for(const SSLSessionID &sid, size_t &home) const
+{
+  uint64_t hash = sid.hash();
+  home          = (hash / nshards) % slots_per_shard;
+  return shards[hash % nshards];
+}
+
+/** Look for @a sid in the probe window of @a shard starting at @a home.
+
+    If @a data is set the session is copied there and its length stored in @a data_len. This does
+    not lock, a slot changed by a writer while it is read is read again.
+
+    @return The index of the slot in the shard or -1 if @a sid was not found.
+ */
+int
+SSLSessionCache::find(const Shard &shard, size_t home, const SSLSessionID &sid, unsigned char *data, uint16_t &data_len) const
+{
+  size_t probes = std::min(PROBE_LIMIT, slots_per_shard);
+
+  for (size_t i = 0; i < probes; ++i) {
+    size_t idx                 = (home + i) % slots_per_shard;
+    const SSLSessionSlot &slot = shard.slots[idx];
+
+    for (int tries = 0; tries <= READ_RETRIES; ++tries) {
+      uint32_t seq = slot.seq.load(std::memory_order_acquire);
+      if (seq & 1) {
+        ++shard.stats.contention;
+        continue;
+      }
+
+      bool match   = slot.id_len == sid.len && memcmp(slot.id, sid.bytes, sid.len) == 0;
+      uint16_t len = 0;
+      if (match && data) {
+        len = std::min<uint16_t>(slot.data_len, SSL_MAX_SESSION_SIZE);
+        memcpy(data, slot.data, len);
+      }
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.seq.load(std::memory_order_relaxed) != seq) {
+        ++shard.stats.contention;
+        continue;
+      }
+      if (match) {
+        data_len = len;
+        return idx;
+      }
+      break;
+    }
+  }
+
+  return -1;
 }
 
 int
 SSLSessionCache::getSessionBuffer(const SSLSessionID &sid, char *buffer, int &len) const
 {
-  uint64_t hash            = sid.hash();
-  uint64_t target_bucket   = hash % nbuckets;
-  SSLSessionBucket *bucket = &session_bucket[target_bucket];
+  size_t home;
+  const Shard &shard = this->shard_for(sid, home);
+  unsigned char data[SSL_MAX_SESSION_SIZE];
+  uint16_t data_len = 0;
 
-  return bucket->getSessionBuffer(sid, buffer, len);
+  if (this->find(shard, home, sid, data, data_len) < 0) {
+    return 0;
+  }
+  if (buffer) {
+    if (data_len < len) {
+      len = data_len;
+    }
+    memcpy(buffer, data, len);
+  }
+  return data_len;
 }
 
 bool
 SSLSessionCache::getSession(const SSLSessionID &sid, SSL_SESSION **sess) const
 {
-  uint64_t hash            = sid.hash();
-  uint64_t target_bucket   = hash % nbuckets;
-  SSLSessionBucket *bucket = &session_bucket[target_bucket];
+  size_t home;
+  const Shard &shard = this->shard_for(sid, home);
+  unsigned char data[SSL_MAX_SESSION_SIZE];
+  uint16_t data_len = 0;
 
   if (is_debug_tag_set("ssl.session_cache")) {
     char buf[sid.len * 2 + 1];
     sid.toString(buf, sizeof(buf));
-    Debug("ssl.session_cache.get", "SessionCache looking in bucket %" PRId64 " (%p) for session '%s' (hash: %" PRIX64 ").",
-          target_bucket, bucket, buf, hash);
+    Debug("ssl.session_cache.get", "SessionCache looking in shard %zu slot %zu for session '%s' (hash: %" PRIX64 ").",
+          &shard - shards, home, buf, sid.hash());
+  }
+
+  if (this->find(shard, home, sid, data, data_len) < 0) {
+    ++shard.stats.misses;
+    return false;
   }
 
-  return bucket->getSession(sid, sess);
+  const unsigned char *loc = data;
+  *sess                    = d2i_SSL_SESSION(nullptr, &loc, data_len);
+  ++shard.stats.hits;
+  return *sess != nullptr;
 }
 
 void
 SSLSessionCache::removeSession(const SSLSessionID &sid)
 {
-  uint64_t hash            = sid.hash();
-  uint64_t target_bucket   = hash % nbuckets;
-  SSLSessionBucket *bucket = &session_bucket[target_bucket];
+  size_t home;
+  Shard &shard = this->shard_for(sid, home);
+  uint16_t data_len;
 
   if (is_debug_tag_set("ssl.session_cache")) {
     char buf[sid.len * 2 + 1];
     sid.toString(buf, sizeof(buf));
-    Debug("ssl.session_cache.remove", "SessionCache using bucket %" PRId64 " (%p): Removing session '%s' (hash: %" PRIX64 ").",
-          target_bucket, bucket, buf, hash);
+    Debug("ssl.session_cache.remove", "SessionCache using shard %zu: Removing session '%s' (hash: %" PRIX64 ").", &shard - shards,
+          buf, sid.hash());
   }
 
   if (ssl_rsb) {
     SSL_INCREMENT_DYN_STAT(ssl_session_cache_eviction);
   }
-  bucket->removeSession(sid);
-}
-
-void
-SSLSessionCache::insertSession(const SSLSessionID &sid, SSL_SESSION *sess)
-{
-  uint64_t hash            = sid.hash();
-  uint64_t target_bucket   = hash % nbuckets;
-  SSLSessionBucket *bucket = &session_bucket[target_bucket];
 
-  if (is_debug_tag_set("ssl.session_cache")) {
-    char buf[sid.len * 2 + 1];
-    sid.toString(buf, sizeof(buf));
-    Debug("ssl.session_cache.insert", "SessionCache using bucket %" PRId64 " (%p): Inserting session '%s' (hash: %" PRIX64 ").",
-          target_bucket, bucket, buf, hash);
+  // We can't bail on contention here because this session MUST be removed.
+  ink_scoped_mutex_lock lock(shard.writer);
+  int idx = this->find(shard, home, sid, nullptr, data_len);
+  if (idx >= 0) {
+    clear_slot(shard.slots[idx]);
   }
-
-  bucket->insertSession(sid, sess);
 }
 
 void
-SSLSessionBucket::insertSession(const SSLSessionID &id, SSL_SESSION *sess)
+SSLSessionCache::insertSession(const SSLSessionID &sid, SSL_SESSION *sess)
 {
   size_t len = i2d_SSL_SESSION(sess, nullptr); // make sure we're not going to need more than SSL_MAX_SESSION_SIZE bytes
   /* do not cache a session that's too big. */
@@ -122,183 +297,196 @@ SSLSessionBucket::insertSession(const SSLSessionID &id, SSL_SESSION *sess)
     Debug("ssl.session_cache", "Unable to save SSL session because size of %zd exceeds the max of %d", len, SSL_MAX_SESSION_SIZE);
     return;
   }
+  if (len == 0 || sid.len == 0 || sid.len > sizeof(SSLSessionSlot::id)) {
+    return;
+  }
+
+  size_t home;
+  Shard &shard = this->shard_for(sid, home);
 
   if (is_debug_tag_set("ssl.session_cache")) {
-    char buf[id.len * 2 + 1];
-    id.toString(buf, sizeof(buf));
-    Debug("ssl.session_cache", "Inserting session '%s' to bucket %p.", buf, this);
+    char buf[sid.len * 2 + 1];
+    sid.toString(buf, sizeof(buf));
+    Debug("ssl.session_cache.insert", "SessionCache using shard %zu: Inserting session '%s' (hash: %" PRIX64 ").", &shard - shards,
+          buf, sid.hash());
   }
 
-  MUTEX_TRY_LOCK(lock, mutex, this_ethread());
-  if (!lock.is_locked()) {
+  // Serialize before taking the lock.
+  unsigned char data[SSL_MAX_SESSION_SIZE];
+  unsigned char *loc = data;
+  i2d_SSL_SESSION(sess, &loc);
+
+  if (!ink_mutex_try_acquire(&shard.writer)) {
+    ++shard.stats.contention;
     if (ssl_rsb) {
       SSL_INCREMENT_DYN_STAT(ssl_session_cache_lock_contention);
     }
     if (SSLConfigParams::session_cache_skip_on_lock_contention) {
       return;
     }
-    lock.acquire(this_ethread());
-  }
-
-  PRINT_BUCKET("insertSession before")
-  if (queue.size >= static_cast<int>(SSLConfigParams::session_cache_max_bucket_size)) {
-    removeOldestSession();
+    ink_mutex_acquire(&shard.writer);
   }
 
   // Don't insert if it is already there
-  SSLSession *node = queue.tail;
-  while (node) {
-    if (node->session_id == id) {
-      return;
+  uint16_t data_len;
+  if (this->find(shard, home, sid, nullptr, data_len) < 0) {
+    // Take the first free slot in the probe window, or evict the oldest one.
+    size_t probes         = std::min(PROBE_LIMIT, slots_per_shard);
+    SSLSessionSlot *slot  = nullptr;
+    SSLSessionSlot *older = nullptr;
+    for (size_t i = 0; i < probes && slot == nullptr; ++i) {
+      SSLSessionSlot *s = &shard.slots[(home + i) % slots_per_shard];
+      if (s->id_len == 0) {
+        slot = s;
+      } else if (older == nullptr || s->insert_time < older->insert_time) {
+        older = s;
+      }
+    }
+    if (slot == nullptr) {
+      slot = older;
+      ++shard.stats.evictions;
     }
-    node = node->link.prev;
-  }
-
-  Ptr<IOBufferData> buf;
-  buf = new_IOBufferData(buffer_size_to_index(len, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
-  ink_release_assert(static_cast<size_t>(buf->block_size()) >= len);
-  unsigned char *loc = reinterpret_cast<unsigned char *>(buf->data());
-  i2d_SSL_SESSION(sess, &loc);
-
-  ats_scoped_obj<SSLSession> ssl_session(new SSLSession(id, buf, len));
 
-  /* do the actual insert */
-  queue.enqueue(ssl_session.release());
+    begin_write(*slot);
+    slot->id_len      = sid.len;
+    slot->data_len    = len;
+    slot->insert_time = ink_time();
+    memcpy(slot->id, sid.bytes, sid.len);
+    memcpy(slot->data, data, len);
+    end_write(*slot);
+  }
 
-  PRINT_BUCKET("insertSession after")
+  ink_mutex_release(&shard.writer);
 }
 
-int
-SSLSessionBucket::getSessionBuffer(const SSLSessionID &id, char *buffer, int &len)
+void
+SSLSessionCache::dump_stats(FILE *f) const
 {
-  int true_len = 0;
-  MUTEX_TRY_LOCK(lock, mutex, this_ethread());
-  if (!lock.is_locked()) {
-    if (ssl_rsb) {
-      SSL_INCREMENT_DYN_STAT(ssl_session_cache_lock_contention);
-    }
-    if (SSLConfigParams::session_cache_skip_on_lock_contention) {
-      return true_len;
+  uint64_t total[4] = {0, 0, 0, 0};
+
+  fprintf(f, "     Shard |         Hits |       Misses |   Contention |    Evictions | SSL session cache\n");
+  fprintf(f, "-----------|--------------|--------------|--------------|--------------|------------------\n");
+  for (size_t i = 0; i < nshards; ++i) {
+    const SSLSessionShardStats &s = shards[i].stats;
+    uint64_t v[4]                 = {s.hits.load(), s.misses.load(), s.contention.load(), s.evictions.load()};
+    fprintf(f, " %9zu | %12" PRIu64 " | %12" PRIu64 " | %12" PRIu64 " | %12" PRIu64 " |\n", i, v[0], v[1], v[2], v[3]);
+    for (int j = 0; j < 4; ++j) {
+      total[j] += v[j];
     }
-
-    lock.acquire(this_ethread());
   }
+  fprintf(f, "     TOTAL | %12" PRIu64 " | %12" PRIu64 " | %12" PRIu64 " | %12" PRIu64 " |\n", total[0], total[1], total[2],
+          total[3]);
+}
 
-  // We work backwards because that's the most likely place we'll find our session...
-  SSLSession *node = queue.tail;
-  while (node) {
-    if (node->session_id == id) {
-      true_len = node->len_asn1_data;
-      if (buffer) {
-        const unsigned char *loc = reinterpret_cast<const unsigned char *>(node->asn1_data->data());
-        if (true_len < len) {
-          len = true_len;
-        }
-        memcpy(buffer, loc, len);
-        return true_len;
-      }
-    }
-    node = node->link.prev;
-  }
-  return 0;
+#if TS_HAS_TESTS
+#include "tscore/TestBox.h"
+
+#include <vector>
+
+namespace
+{
+SSL_SESSION *
+make_test_session(const SSLSessionID &sid)
+{
+  SSL_CTX *ctx      = SSL_CTX_new(SSLv23_server_method());
+  SSL *ssl          = SSL_new(ctx);
+  SSL_SESSION *sess = SSL_SESSION_new();
+  unsigned char key[48];
+
+  // A session needs a version and a cipher to be serialized.
+  memset(key, sid.bytes[0], sizeof(key));
+  SSL_SESSION_set1_id(sess, reinterpret_cast<const unsigned char *>(sid.bytes), sid.len);
+  SSL_SESSION_set1_master_key(sess, key, sizeof(key));
+  SSL_SESSION_set_protocol_version(sess, TLS1_2_VERSION);
+  SSL_SESSION_set_cipher(sess, sk_SSL_CIPHER_value(SSL_get_ciphers(ssl), 0));
+  SSL_free(ssl);
+  SSL_CTX_free(ctx);
+  return sess;
 }
 
 bool
-SSLSessionBucket::getSession(const SSLSessionID &id, SSL_SESSION **sess)
+has_session(const SSLSessionCache &cache, const SSLSessionID &sid)
 {
-  char buf[id.len * 2 + 1];
-  buf[0] = '\0'; // just to be safe.
-  if (is_debug_tag_set("ssl.session_cache")) {
-    id.toString(buf, sizeof(buf));
+  SSL_SESSION *sess = nullptr;
+  if (!cache.getSession(sid, &sess)) {
+    return false;
   }
+  unsigned int len;
+  const unsigned char *id = SSL_SESSION_get_id(sess, &len);
+  bool match              = len == sid.len && memcmp(id, sid.bytes, len) == 0;
+  SSL_SESSION_free(sess);
+  return match;
+}
+} // namespace
 
-  Debug("ssl.session_cache", "Looking for session with id '%s' in bucket %p", buf, this);
-
-  MUTEX_TRY_LOCK(lock, mutex, this_ethread());
-  if (!lock.is_locked()) {
-    if (ssl_rsb) {
-      SSL_INCREMENT_DYN_STAT(ssl_session_cache_lock_contention);
-    }
-    if (SSLConfigParams::session_cache_skip_on_lock_contention) {
-      return false;
-    }
-
-    lock.acquire(this_ethread());
+REGRESSION_TEST(SSLSessionCacheSlots)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  unsigned char bytes[32];
+
+  box = REGRESSION_TEST_PASSED;
+
+  // One shard with a single probe window, the fourth session evicts the oldest one.
+  SSLSessionCache cache(1, 3);
+  std::vector<SSLSessionID> ids;
+  for (int i = 0; i < 4; ++i) {
+    memset(bytes, 'a' + i, sizeof(bytes));
+    ids.emplace_back(bytes, sizeof(bytes));
+    SSL_SESSION *sess = make_test_session(ids.back());
+    cache.insertSession(ids.back(), sess);
+    cache.insertSession(ids.back(), sess);
+    SSL_SESSION_free(sess);
   }
 
-  PRINT_BUCKET("getSession")
-
-  // We work backwards because that's the most likely place we'll find our session...
-  SSLSession *node = queue.tail;
-  while (node) {
-    if (node->session_id == id) {
-      const unsigned char *loc = reinterpret_cast<const unsigned char *>(node->asn1_data->data());
-      *sess                    = d2i_SSL_SESSION(nullptr, &loc, node->len_asn1_data);
-
-      return true;
-    }
-    node = node->link.prev;
+  box.check(cache.shard_stats(0).evictions == 1, "one eviction, got %" PRIu64, cache.shard_stats(0).evictions.load());
+  int found = 0;
+  for (auto &id : ids) {
+    found += has_session(cache, id);
   }
+  box.check(found == 3, "three of four sessions cached, found %d", found);
+  box.check(has_session(cache, ids.back()), "latest session cached");
+
+  cache.removeSession(ids.back());
+  box.check(!has_session(cache, ids.back()), "removed session not found");
 
-  Debug("ssl.session_cache", "Session with id '%s' not found in bucket %p.", buf, this);
-  return false;
+  char buffer[SSL_MAX_SESSION_SIZE];
+  int len = sizeof(buffer);
+  box.check(cache.getSessionBuffer(ids[1], buffer, len) > 0 && len > 0, "session buffer copied");
 }
 
-void inline SSLSessionBucket::print(const char *ref_str) const
+REGRESSION_TEST(SSLSessionCachePersist)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
 {
-  /* NOTE: This method assumes you're already holding the bucket lock */
-  if (!is_debug_tag_set("ssl.session_cache.bucket")) {
+  TestBox box(t, pstatus);
+  char path[] = "/tmp/ssl_session_cache_XXXXXX";
+  int fd      = mkstemp(path);
+  unsigned char bytes[32];
+
+  box = REGRESSION_TEST_PASSED;
+  if (fd < 0) {
+    box.check(false, "unable to create %s", path);
     return;
   }
-
-  fprintf(stderr, "-------------- BUCKET %p (%s) ----------------\n", this, ref_str);
-  fprintf(stderr, "Current Size: %d, Max Size: %zd\n", queue.size, SSLConfigParams::session_cache_max_bucket_size);
-  fprintf(stderr, "Queue: \n");
-
-  SSLSession *node = queue.head;
-  while (node) {
-    char s_buf[2 * node->session_id.len + 1];
-    node->session_id.toString(s_buf, sizeof(s_buf));
-    fprintf(stderr, "  %s\n", s_buf);
-    node = node->link.next;
+  close(fd);
+
+  memset(bytes, 'x', sizeof(bytes));
+  SSLSessionID sid(bytes, sizeof(bytes));
+  {
+    SSLSessionCache cache(4, 16, path);
+    SSL_SESSION *sess = make_test_session(sid);
+    cache.insertSession(sid, sess);
+    SSL_SESSION_free(sess);
+    box.check(has_session(cache, sid), "session cached");
   }
-}
-
-void inline SSLSessionBucket::removeOldestSession()
-{
-  // Caller must hold the bucket lock.
-  ink_assert(this_ethread() == mutex->thread_holding);
-
-  PRINT_BUCKET("removeOldestSession before")
-  while (queue.head && queue.size >= static_cast<int>(SSLConfigParams::session_cache_max_bucket_size)) {
-    SSLSession *old_head = queue.pop();
-    if (is_debug_tag_set("ssl.session_cache")) {
-      char buf[old_head->session_id.len * 2 + 1];
-      old_head->session_id.toString(buf, sizeof(buf));
-      Debug("ssl.session_cache", "Removing session '%s' from bucket %p because the bucket has size %d and max %zd", buf, this,
-            (queue.size + 1), SSLConfigParams::session_cache_max_bucket_size);
-    }
-    delete old_head;
+  {
+    SSLSessionCache cache(4, 16, path);
+    box.check(has_session(cache, sid), "session restored from %s", path);
   }
-  PRINT_BUCKET("removeOldestSession after")
-}
-
-void
-SSLSessionBucket::removeSession(const SSLSessionID &id)
-{
-  SCOPED_MUTEX_LOCK(lock, mutex, this_ethread()); // We can't bail on contention here because this session MUST be removed.
-  SSLSession *node = queue.head;
-  while (node) {
-    if (node->session_id == id) {
-      queue.remove(node);
-      delete node;
-      return;
-    }
-    node = node->link.next;
+  {
+    SSLSessionCache cache(8, 16, path);
+    box.check(!has_session(cache, sid), "file reset on geometry change");
   }
-}
 
-/* Session Bucket */
-SSLSessionBucket::SSLSessionBucket() : mutex(new_ProxyMutex()) {}
+  unlink(path);
+}
 
-SSLSessionBucket::~SSLSessionBucket() {}
+#endif // TS_HAS_TESTS
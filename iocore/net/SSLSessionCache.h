@@ -21,7 +21,6 @@
 
 #pragma once
 
-#include "tscore/List.h"
 #include "tscore/ink_mutex.h"
 #include "P_EventSystem.h"
 #include "records/I_RecProcess.h"
@@ -29,6 +28,7 @@
 #include "P_SSLUtils.h"
 #include "ts/apidefs.h"
 #include <openssl/ssl.h>
+#include <atomic>
 
 #define SSL_MAX_SESSION_SIZE 256
 
@@ -109,38 +109,26 @@ struct SSLSessionID : public TSSslSessionID {
   }
 };
 
-class SSLSession
-{
-public:
-  SSLSessionID session_id;
-  Ptr<IOBufferData> asn1_data; /* this is the ASN1 representation of the SSL_CTX */
-  size_t len_asn1_data;
-
-  SSLSession(const SSLSessionID &id, const Ptr<IOBufferData> &ssl_asn1_data, size_t len_asn1)
-    : session_id(id), asn1_data(ssl_asn1_data), len_asn1_data(len_asn1)
-  {
-  }
+/** Fixed size slot holding one serialized session.
 
-  LINK(SSLSession, link);
+    Slots are written under the shard writer lock and read without any lock. @a seq is odd while a
+    writer updates the slot, readers copy the slot and retry if @a seq changed meanwhile.
+ */
+struct SSLSessionSlot {
+  std::atomic<uint32_t> seq;
+  uint16_t id_len;
+  uint16_t data_len;
+  int64_t insert_time; ///< Seconds since the epoch, used to pick the slot to evict.
+  char id[TS_SSL_MAX_SSL_SESSION_ID_LENGTH];
+  unsigned char data[SSL_MAX_SESSION_SIZE];
 };
 
-class SSLSessionBucket
-{
-public:
-  SSLSessionBucket();
-  ~SSLSessionBucket();
-  void insertSession(const SSLSessionID &, SSL_SESSION *ctx);
-  bool getSession(const SSLSessionID &, SSL_SESSION **ctx);
-  int getSessionBuffer(const SSLSessionID &, char *buffer, int &len);
-  void removeSession(const SSLSessionID &);
-
-private:
-  /* these method must be used while hold the lock */
-  void print(const char *) const;
-  void removeOldestSession();
-
-  Ptr<ProxyMutex> mutex;
-  CountQueue<SSLSession> queue;
+/// Per shard counters, updated without a lock.
+struct SSLSessionShardStats {
+  std::atomic<uint64_t> hits{0};
+  std::atomic<uint64_t> misses{0};
+  std::atomic<uint64_t> contention{0};
+  std::atomic<uint64_t> evictions{0};
 };
 
 class SSLSessionCache
@@ -150,13 +138,53 @@ public:
   int getSessionBuffer(const SSLSessionID &sid, char *buffer, int &len) const;
   void insertSession(const SSLSessionID &sid, SSL_SESSION *sess);
   void removeSession(const SSLSessionID &sid);
+
+  /** Create a cache with @a nshards shards of @a slots_per_shard sessions.
+
+      If @a path is set the slots are kept in that file so the sessions survive a restart. The
+      file is recreated if it was written with a different geometry.
+   */
+  SSLSessionCache(size_t nshards, size_t slots_per_shard, const char *path = nullptr);
   SSLSessionCache();
   ~SSLSessionCache();
 
   SSLSessionCache(const SSLSessionCache &) = delete;
   SSLSessionCache &operator=(const SSLSessionCache &) = delete;
 
+  size_t
+  shard_count() const
+  {
+    return nshards;
+  }
+
+  const SSLSessionShardStats &
+  shard_stats(size_t shard) const
+  {
+    return shards[shard].stats;
+  }
+
+  /// Write the per shard counters to @a f.
+  void dump_stats(FILE *f) const;
+
+  /// Number of slots probed for a session starting at its home slot.
+  static constexpr size_t PROBE_LIMIT = 8;
+  /// Number of times a reader retries a slot a writer is updating.
+  static constexpr int READ_RETRIES = 4;
+
 private:
-  SSLSessionBucket *session_bucket = nullptr;
-  size_t nbuckets;
+  struct Shard {
+    ink_mutex writer; ///< Serializes the writers of the shard, readers do not take it.
+    SSLSessionSlot *slots;
+    mutable SSLSessionShardStats stats;
+  };
+
+  void map_slots(const char *path);
+  Shard &shard_for(const SSLSessionID &sid, size_t &home) const;
+  int find(const Shard &shard, size_t home, const SSLSessionID &sid, unsigned char *data, uint16_t &data_len) const;
+
+  size_t nshards         = 0;
+  size_t slots_per_shard = 0;
+  Shard *shards          = nullptr;
+  void *mapping          = nullptr;
+  size_t mapping_size    = 0;
 };
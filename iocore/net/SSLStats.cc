@@ -27,10 +27,45 @@
 
 #include "P_SSLConfig.h"
 #include "P_SSLUtils.h"
+#include "SSLSessionCache.h"
 
-RecRawStatBlock *ssl_rsb = nullptr;
+RecRawStatBlock *ssl_rsb               = nullptr;
+RecRawStatBlock *ssl_session_cache_rsb = nullptr;
 std::unordered_map<std::string, intptr_t> cipher_map;
 
+// The counters of a session cache shard, in the order of their stats in ssl_session_cache_rsb.
+static constexpr int SESSION_CACHE_SHARD_STAT_COUNT                          = 4;
+static const char *session_cache_shard_stats[SESSION_CACHE_SHARD_STAT_COUNT] = {"hits", "misses", "lock_contention", "evictions"};
+
+static uint64_t
+SSLSessionShardStat(const SSLSessionShardStats &stats, int id)
+{
+  switch (id) {
+  case 0:
+    return stats.hits.load(std::memory_order_relaxed);
+  case 1:
+    return stats.misses.load(std::memory_order_relaxed);
+  case 2:
+    return stats.contention.load(std::memory_order_relaxed);
+  default:
+    return stats.evictions.load(std::memory_order_relaxed);
+  }
+}
+
+static int
+SSLSessionCacheStatSync(const char *name, RecDataT data_type, RecData *data, RecRawStatBlock *rsb, int id)
+{
+  // The shards count without a lock, take their counters instead of summing the per thread stats. The busiest
+  // shard is the one to compare with the total over num_buckets.
+  uint64_t value = 0;
+
+  for (size_t shard = 0; shard < session_cache->shard_count(); ++shard) {
+    value = std::max(value, SSLSessionShardStat(session_cache->shard_stats(shard), id));
+  }
+  RecDataSetFromInt64(data_type, data, value);
+  return REC_ERR_OKAY;
+}
+
 static int
 SSLRecRawStatSyncCount(const char *name, RecDataT data_type, RecData *data, RecRawStatBlock *rsb, int id)
 {
@@ -204,6 +239,12 @@ SSLInitializeStatistics()
                      (int)ssl_ocsp_refreshed_cert_stat, RecRawStatSyncCount);
   RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ssl_ocsp_refresh_cert_failure", RECD_INT, RECP_PERSISTENT,
                      (int)ssl_ocsp_refresh_cert_failure_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ssl_ocsp_staple_fresh", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)ssl_ocsp_staple_fresh_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ssl_ocsp_staple_stale", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)ssl_ocsp_staple_stale_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ssl_ocsp_staple_oldest_age", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)ssl_ocsp_staple_oldest_age_stat, RecRawStatSyncSum);
 
   /* SSL Version stats */
   RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ssl_total_sslv3", RECD_COUNTER, RECP_PERSISTENT,
@@ -253,4 +294,17 @@ SSLInitializeStatistics()
 
   SSL_free(ssl);
   SSLReleaseContext(ctx);
+
+  // Per shard counters of the ATS session cache, to find the shards that are too small or contended. There are
+  // too many shards for a metric each, only the busiest shard of every counter is registered.
+  if (session_cache && ssl_session_cache_rsb == nullptr) {
+    ssl_session_cache_rsb = RecAllocateRawStatBlock(SESSION_CACHE_SHARD_STAT_COUNT);
+    ink_assert(ssl_session_cache_rsb != nullptr);
+
+    for (int id = 0; id < SESSION_CACHE_SHARD_STAT_COUNT; ++id) {
+      std::string statName = std::string("proxy.process.ssl.session_cache.shard_max.") + session_cache_shard_stats[id];
+      RecRegisterRawStat(ssl_session_cache_rsb, RECT_PROCESS, statName.c_str(), RECD_COUNTER, RECP_NON_PERSISTENT, id,
+                         SSLSessionCacheStatSync);
+    }
+  }
 }
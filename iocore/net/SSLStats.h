@@ -101,6 +101,9 @@ enum SSL_Stats {
   ssl_ocsp_unknown_cert_stat,
   ssl_ocsp_refreshed_cert_stat,
   ssl_ocsp_refresh_cert_failure_stat,
+  ssl_ocsp_staple_fresh_stat,
+  ssl_ocsp_staple_stale_stat,
+  ssl_ocsp_staple_oldest_age_stat,
 
   /* SSL/TLS versions */
   ssl_total_sslv3,
@@ -116,6 +119,7 @@ enum SSL_Stats {
 };
 
 extern RecRawStatBlock *ssl_rsb;
+extern RecRawStatBlock *ssl_session_cache_rsb;
 extern std::unordered_map<std::string, intptr_t> cipher_map;
 
 // Initialize SSL statistics.
@@ -41,10 +41,14 @@
 #include "SSLDiags.h"
 #include "SSLStats.h"
 
+#include <atomic>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unistd.h>
 #include <termios.h>
 #include <vector>
+#include <sys/stat.h>
 
 #include <openssl/asn1.h>
 #include <openssl/bio.h>
@@ -97,6 +101,18 @@ static int ssl_vc_index = -1;
 static ink_mutex *mutex_buf      = nullptr;
 static bool open_ssl_initialized = false;
 
+// Contexts are built on several threads, the callbacks into the rest of the system are not reentrant.
+static std::mutex ssl_load_callback_mutex;
+
+static void
+ssl_loaded_file(const char *path)
+{
+  if (SSLConfigParams::load_ssl_file_cb) {
+    std::lock_guard<std::mutex> lock(ssl_load_callback_mutex);
+    SSLConfigParams::load_ssl_file_cb(path);
+  }
+}
+
 /* Using pthread thread ID and mutex functions directly, instead of
  * ATS this_ethread / ProxyMutex, so that other linked libraries
  * may use pthreads and openssl without confusing us here. (TS-2271).
@@ -952,9 +968,7 @@ SSLPrivateKeyHandler(SSL_CTX *ctx, const SSLConfigParams *params, const std::str
       SSLError("failed to load server private key from %s", (const char *)completeServerKeyPath);
       return false;
     }
-    if (SSLConfigParams::load_ssl_file_cb) {
-      SSLConfigParams::load_ssl_file_cb(completeServerKeyPath);
-    }
+    ssl_loaded_file(completeServerKeyPath);
   } else {
     SSLError("empty SSL private key path in records.config");
     return false;
@@ -1376,6 +1390,7 @@ SSLMultiCertConfigLoader::init_server_ssl_ctx(std::vector<X509 *> &cert_list, co
   SSL_CTX_set_alpn_select_cb(ctx, SSLNetVConnection::select_next_protocol, nullptr);
 
   if (SSLConfigParams::init_ssl_ctx_cb) {
+    std::lock_guard<std::mutex> lock(ssl_load_callback_mutex);
     SSLConfigParams::init_ssl_ctx_cb(ctx, true);
   }
 
@@ -1422,25 +1437,155 @@ SSLCreateServerContext(const SSLConfigParams *params, const SSLMultiCertConfigPa
   return ctx.release();
 }
 
+/**
+   Collect the files a context for @a sslMultCertSettings is built from, in @a files.
+   Only the paths are set, use @c ssl_stamp_file to fill in the rest.
+ */
+static void
+ssl_context_files(const SSLConfigParams *params, const SSLMultiCertConfigParams *sslMultCertSettings,
+                  std::vector<SSLCertContextBuild::File> &files)
+{
+  auto add = [&files](std::string &&path) {
+    files.emplace_back();
+    files.back().path = std::move(path);
+  };
+  auto add_list = [&add](const char *list, const char *dir) {
+    SimpleTokenizer tok(list, SSL_CERT_SEPARATE_DELIM);
+    for (const char *name = tok.getNext(); name; name = tok.getNext()) {
+      add(Layout::relative_to(dir, name));
+    }
+  };
+
+  if (sslMultCertSettings->cert) {
+    add_list(sslMultCertSettings->cert, params->serverCertPathOnly);
+    if (sslMultCertSettings->key && params->serverKeyPathOnly) {
+      add_list(sslMultCertSettings->key, params->serverKeyPathOnly);
+    }
+    if (sslMultCertSettings->ca) {
+      add_list(sslMultCertSettings->ca, params->serverCertPathOnly);
+    }
+    if (sslMultCertSettings->ocsp_response && params->ssl_ocsp_response_path_only) {
+      add_list(sslMultCertSettings->ocsp_response, params->ssl_ocsp_response_path_only);
+    }
+    if (params->serverCertChainFilename) {
+      add(Layout::relative_to(params->serverCertPathOnly, params->serverCertChainFilename));
+    }
+  }
+  if (params->serverCACertFilename) {
+    add(params->serverCACertFilename);
+  }
+  if (params->dhparamsFile) {
+    add(params->dhparamsFile);
+  }
+}
+
+/// SHA-256 of the content of the file at @a path, empty if it can not be read.
+static std::string
+ssl_file_digest(const std::string &path)
+{
+  scoped_BIO bio(BIO_new_file(path.c_str(), "r"));
+  EVP_MD_CTX *digest = EVP_MD_CTX_new();
+  unsigned char buf[16384];
+  unsigned int len = 0;
+  int n;
+  std::string result;
+
+  if (bio && EVP_DigestInit_ex(digest, EVP_sha256(), nullptr)) {
+    while ((n = BIO_read(bio.get(), buf, sizeof(buf))) > 0) {
+      EVP_DigestUpdate(digest, buf, n);
+    }
+    if (n == 0 && EVP_DigestFinal_ex(digest, buf, &len)) {
+      result.assign(reinterpret_cast<char *>(buf), len);
+    }
+  }
+  EVP_MD_CTX_free(digest);
+  return result;
+}
+
+static bool
+ssl_stamp_file(SSLCertContextBuild::File &file)
+{
+  struct stat st;
+
+  if (stat(file.path.c_str(), &st) != 0) {
+    return false;
+  }
+  file.mtime = st.st_mtime;
+  file.size  = st.st_size;
+  return true;
+}
+
+/**
+   Check if the files @a build was made from are unchanged.
+   A file with a new modification time is still unchanged if its content is the same, so rewriting
+   certificates with identical content does not force a rebuild.
+ */
+static bool
+ssl_build_unchanged(const SSLCertContextBuild &build)
+{
+  for (auto const &file : build.files) {
+    SSLCertContextBuild::File now;
+    now.path = file.path;
+    if (!ssl_stamp_file(now) || file.digest.empty()) {
+      return false;
+    }
+    if ((now.mtime != file.mtime || now.size != file.size) && ssl_file_digest(file.path) != file.digest) {
+      Debug("ssl_load", "%s changed", file.path.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+   Build the context for one ssl_multicert.config entry.
+   This does not touch any lookup so several entries can be built at the same time.
+ */
+shared_SSLCertContextBuild
+SSLMultiCertConfigLoader::_build_ssl_ctx(const shared_SSLMultiCertConfigParams &sslMultCertSettings)
+{
+  auto build = std::make_shared<SSLCertContextBuild>();
+
+  // Stamp the files before reading them so that a change made while loading is seen by the next reload.
+  ssl_context_files(this->_params, sslMultCertSettings.get(), build->files);
+  for (auto &file : build->files) {
+    if (ssl_stamp_file(file)) {
+      file.digest = ssl_file_digest(file.path);
+    }
+  }
+
+  build->ctx = shared_SSL_CTX(this->init_server_ssl_ctx(build->certs, sslMultCertSettings.get()), SSL_CTX_free);
+  if (!build->ctx) {
+    // The certificates were released on failure.
+    build->certs.clear();
+  } else if (sslMultCertSettings->session_ticket_enabled != 0) {
+    // Load the session ticket key if session tickets are not disabled
+    build->keyblock = shared_ssl_ticket_key_block(ssl_context_enable_tickets(build->ctx.get(), nullptr), ticket_block_free);
+  }
+
+  return build;
+}
+
 /**
    Insert SSLCertContext (SSL_CTX ans options) into SSLCertLookup with key.
    Do NOT call SSL_CTX_set_* functions from here. SSL_CTX should be set up by SSLMultiCertConfigLoader::init_server_ssl_ctx().
+   @a reused is set if @a build comes from the previous lookup, it was already handed to the plugins then.
  */
 SSL_CTX *
-SSLMultiCertConfigLoader::_store_ssl_ctx(SSLCertLookup *lookup, const shared_SSLMultiCertConfigParams sslMultCertSettings)
+SSLMultiCertConfigLoader::_store_ssl_ctx(SSLCertLookup *lookup, const shared_SSLMultiCertConfigParams sslMultCertSettings,
+                                         const shared_SSLCertContextBuild &build, bool reused)
 {
-  std::vector<X509 *> cert_list;
-  shared_ssl_ticket_key_block keyblock = nullptr;
-  bool inserted                        = false;
-  shared_SSL_CTX ctx(this->init_server_ssl_ctx(cert_list, sslMultCertSettings.get()), SSL_CTX_free);
+  bool inserted = false;
 
-  if (!ctx || !sslMultCertSettings) {
+  if (!build || !build->ctx || !sslMultCertSettings) {
     lookup->is_valid = false;
     return nullptr;
   }
 
-  const char *certname = sslMultCertSettings->cert.get();
-  for (auto cert : cert_list) {
+  shared_SSL_CTX ctx                   = build->ctx;
+  shared_ssl_ticket_key_block keyblock = build->keyblock;
+  const char *certname                 = sslMultCertSettings->cert.get();
+  for (auto cert : build->certs) {
     if (0 > SSLMultiCertConfigLoader::check_server_cert_now(cert, certname)) {
       /* At this point, we know cert is bad, and we've already printed a
          descriptive reason as to why cert is bad to the log file */
@@ -1449,11 +1594,6 @@ SSLMultiCertConfigLoader::_store_ssl_ctx(SSLCertLookup *lookup, const shared_SSL
     }
   }
 
-  // Load the session ticket key if session tickets are not disabled
-  if (sslMultCertSettings->session_ticket_enabled != 0) {
-    keyblock = shared_ssl_ticket_key_block(ssl_context_enable_tickets(ctx.get(), nullptr), ticket_block_free);
-  }
-
   // Index this certificate by the specified IP(v6) address. If the address is "*", make it the default context.
   if (sslMultCertSettings->addr) {
     if (strcmp(sslMultCertSettings->addr, "*") == 0) {
@@ -1481,13 +1621,13 @@ SSLMultiCertConfigLoader::_store_ssl_ctx(SSLCertLookup *lookup, const shared_SSL
   // this code is updated to reconfigure the SSL certificates, it will need some sort of
   // refcounting or alternate way of avoiding double frees.
   Debug("ssl", "importing SNI names from %s", (const char *)certname);
-  for (auto cert : cert_list) {
+  for (auto cert : build->certs) {
     if (SSLMultiCertConfigLoader::index_certificate(lookup, SSLCertContext(ctx, sslMultCertSettings), cert, certname)) {
       inserted = true;
     }
   }
 
-  if (inserted) {
+  if (inserted && !reused) {
     if (SSLConfigParams::init_ssl_ctx_cb) {
       SSLConfigParams::init_ssl_ctx_cb(ctx.get(), true);
     }
@@ -1497,10 +1637,6 @@ SSLMultiCertConfigLoader::_store_ssl_ctx(SSLCertLookup *lookup, const shared_SSL
     ctx = nullptr;
   }
 
-  for (auto &i : cert_list) {
-    X509_free(i);
-  }
-
   return ctx.get();
 }
 
@@ -1571,8 +1707,22 @@ ssl_extract_certificate(const matcher_line *line_info, SSLMultiCertConfigParams
   return true;
 }
 
+/// Key of an ssl_multicert.config entry, made of all its settings.
+static std::string
+ssl_entry_key(const SSLMultiCertConfigParams &settings)
+{
+  std::string key;
+  for (const char *value : {settings.addr.get(), settings.cert.get(), settings.key.get(), settings.ca.get(),
+                            settings.ocsp_response.get(), settings.dialog.get(), settings.servername.get()}) {
+    key.append(value ? value : "").push_back('\n');
+  }
+  key.append(std::to_string(settings.session_ticket_enabled)).push_back('\n');
+  key.append(std::to_string(static_cast<int>(settings.opt)));
+  return key;
+}
+
 bool
-SSLMultiCertConfigLoader::load(SSLCertLookup *lookup)
+SSLMultiCertConfigLoader::load(SSLCertLookup *lookup, const SSLCertLookup *current)
 {
   const SSLConfigParams *params = this->_params;
 
@@ -1584,6 +1734,14 @@ SSLMultiCertConfigLoader::load(SSLCertLookup *lookup)
 
   const matcher_tags sslCertTags = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, false};
 
+  struct Entry {
+    std::string key; ///< Identifies the entry across reloads.
+    shared_SSLMultiCertConfigParams settings;
+    shared_SSLCertContextBuild build;
+    bool reused;
+  };
+  std::vector<Entry> entries;
+
   Note("ssl_multicert.config loading ...");
 
   if (params->configFilePath) {
@@ -1623,7 +1781,7 @@ SSLMultiCertConfigLoader::load(SSLCertLookup *lookup)
         if (ssl_extract_certificate(&line_info, sslMultiCertSettings.get())) {
           // There must be a certificate specified unless the tunnel action is set
           if (sslMultiCertSettings->cert || sslMultiCertSettings->opt != SSLCertContextOption::OPT_TUNNEL) {
-            this->_store_ssl_ctx(lookup, sslMultiCertSettings);
+            entries.push_back({ssl_entry_key(*sslMultiCertSettings), sslMultiCertSettings, nullptr, false});
           } else {
             Warning("No ssl_cert_name specified and no tunnel action set");
           }
@@ -1634,13 +1792,71 @@ SSLMultiCertConfigLoader::load(SSLCertLookup *lookup)
     line = tokLine(nullptr, &tok_state);
   }
 
+  // Reuse the contexts of the current lookup for the entries that did not change. The contexts also
+  // depend on the global settings, they can only be reused if those were not reloaded in between.
+  std::vector<Entry *> pending;
+  std::vector<Entry *> serial;
+  bool reusable = current != nullptr && current->params_generation == params->generation;
+  for (auto &entry : entries) {
+    if (reusable) {
+      if (auto spot = current->builds.find(entry.key); spot != current->builds.end() && ssl_build_unchanged(*spot->second)) {
+        entry.build  = spot->second;
+        entry.reused = true;
+        continue;
+      }
+    }
+    // The pass phrase dialog reads the terminal and changes its settings, it cannot run on several threads.
+    (entry.settings->dialog ? serial : pending).push_back(&entry);
+  }
+  for (auto entry : serial) {
+    entry->build = this->_build_ssl_ctx(entry->settings);
+  }
+
+  // Loading the keys and certificates is the bulk of the work, spread it over threads. The workers
+  // get an EThread so the code they run can use stats and other per thread state.
+  std::atomic<size_t> next{0};
+  auto build = [&](bool worker) {
+#if TS_USE_POSIX_CAP
+    // Capabilities are per thread, the elevation above only covers this thread.
+    ElevateAccess worker_access(worker && elevate_setting ? ElevateAccess::FILE_PRIVILEGE : 0);
+#else
+    (void)worker;
+#endif
+    for (size_t i = next++; i < pending.size(); i = next++) {
+      pending[i]->build = this->_build_ssl_ctx(pending[i]->settings);
+    }
+  };
+  size_t nthreads = std::min<size_t>(std::max(params->configLoadThreads, 1), pending.size());
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < nthreads; ++i) {
+    workers.emplace_back([&build]() {
+      std::unique_ptr<EThread> thread(new EThread);
+      thread->set_specific();
+      build(true);
+    });
+  }
+  build(false);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  // Insert in configuration order, the first entry for a name wins.
+  lookup->params_generation = params->generation;
+  for (auto &entry : entries) {
+    if (this->_store_ssl_ctx(lookup, entry.settings, entry.build, entry.reused) != nullptr) {
+      lookup->builds.emplace(std::move(entry.key), entry.build);
+    }
+  }
+  Note("ssl_multicert.config: %zu contexts reused, %zu built with %zu threads, %zu with a pass phrase dialog",
+       entries.size() - pending.size() - serial.size(), pending.size(), std::max<size_t>(nthreads, 1), serial.size());
+
   // We *must* have a default context even if it can't possibly work. The default context is used to
   // bootstrap the SSL handshake so that we can subsequently do the SNI lookup to switch to the real
   // context.
   if (lookup->ssl_default == nullptr) {
     shared_SSLMultiCertConfigParams sslMultiCertSettings(new SSLMultiCertConfigParams);
     sslMultiCertSettings->addr = ats_strdup("*");
-    if (this->_store_ssl_ctx(lookup, sslMultiCertSettings) == nullptr) {
+    if (this->_store_ssl_ctx(lookup, sslMultiCertSettings, this->_build_ssl_ctx(sslMultiCertSettings), false) == nullptr) {
       Error("failed set default context");
       return false;
     }
@@ -1842,9 +2058,7 @@ SSLMultiCertConfigLoader::load_certs(SSL_CTX *ctx, std::vector<X509 *> &cert_lis
     }
 
     cert_list.push_back(cert);
-    if (SSLConfigParams::load_ssl_file_cb) {
-      SSLConfigParams::load_ssl_file_cb(completeServerCertPath.c_str());
-    }
+    ssl_loaded_file(completeServerCertPath.c_str());
 
     // Must load all the intermediate certificates before starting the next chain
 
@@ -1857,9 +2071,7 @@ SSLMultiCertConfigLoader::load_certs(SSL_CTX *ctx, std::vector<X509 *> &cert_lis
         SSLError("failed to load global certificate chain from %s", (const char *)completeServerCertChainPath);
         return false;
       }
-      if (SSLConfigParams::load_ssl_file_cb) {
-        SSLConfigParams::load_ssl_file_cb(completeServerCertChainPath);
-      }
+      ssl_loaded_file(completeServerCertChainPath);
     }
 
     // Now, load any additional certificate chains specified in this entry.
@@ -1871,9 +2083,7 @@ SSLMultiCertConfigLoader::load_certs(SSL_CTX *ctx, std::vector<X509 *> &cert_lis
           SSLError("failed to load certificate chain from %s", (const char *)completeServerCertChainPath);
           return false;
         }
-        if (SSLConfigParams::load_ssl_file_cb) {
-          SSLConfigParams::load_ssl_file_cb(completeServerCertChainPath);
-        }
+        ssl_loaded_file(completeServerCertChainPath);
       }
     }
 #if TS_USE_TLS_OCSP
@@ -1973,3 +2183,71 @@ SSLMultiCertConfigLoader::clear_pw_references(SSL_CTX *ssl_ctx)
   SSL_CTX_set_default_passwd_cb(ssl_ctx, nullptr);
   SSL_CTX_set_default_passwd_cb_userdata(ssl_ctx, nullptr);
 }
+
+#if TS_HAS_TESTS
+#include "tscore/TestBox.h"
+
+#include <fstream>
+#include <utime.h>
+
+REGRESSION_TEST(SSLMultiCertReuse)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  char path[] = "/tmp/ssl_multicert_XXXXXX";
+  int fd      = mkstemp(path);
+
+  box = REGRESSION_TEST_PASSED;
+  if (fd < 0) {
+    box.check(false, "unable to create %s", path);
+    return;
+  }
+  close(fd);
+  std::ofstream(path) << "certificate";
+
+  SSLCertContextBuild build;
+  build.files.emplace_back();
+  build.files.back().path = path;
+  ssl_stamp_file(build.files.back());
+  build.files.back().digest = ssl_file_digest(path);
+  box.check(ssl_build_unchanged(build), "untouched file is unchanged");
+
+  // Rewriting the same content only moves the modification time.
+  struct utimbuf times = {build.files.back().mtime - 10, build.files.back().mtime - 10};
+  utime(path, &times);
+  box.check(ssl_build_unchanged(build), "file with the same content is unchanged");
+
+  std::ofstream(path) << "other certificate";
+  box.check(!ssl_build_unchanged(build), "file with a new content changed");
+
+  unlink(path);
+  box.check(!ssl_build_unchanged(build), "removed file changed");
+
+  // A file which could not be read when the context was built is never reused.
+  build.files.back().digest.clear();
+  box.check(!ssl_build_unchanged(build), "file without a digest changed");
+
+  SSLMultiCertConfigParams a, b;
+  a.addr = ats_strdup("*");
+  a.cert = ats_strdup("server.pem");
+  b.addr = ats_strdup("*");
+  b.cert = ats_strdup("server.pem");
+  box.check(ssl_entry_key(a) == ssl_entry_key(b), "entries with the same settings have the same key");
+
+  b.dialog = ats_strdup("builtin");
+  box.check(ssl_entry_key(a) != ssl_entry_key(b), "the dialog is part of the key");
+  b.dialog = nullptr;
+
+  b.opt = SSLCertContextOption::OPT_TUNNEL;
+  box.check(ssl_entry_key(a) != ssl_entry_key(b), "the action is part of the key");
+  b.opt = a.opt;
+
+  b.session_ticket_enabled = !a.session_ticket_enabled;
+  box.check(ssl_entry_key(a) != ssl_entry_key(b), "the session ticket setting is part of the key");
+  b.session_ticket_enabled = a.session_ticket_enabled;
+
+  // The values are delimited, moving text from one setting to the next one changes the key.
+  a.key = ats_strdup("b");
+  b.cert = ats_strdup("server.pemb");
+  box.check(ssl_entry_key(a) != ssl_entry_key(b), "settings are delimited in the key");
+}
+#endif
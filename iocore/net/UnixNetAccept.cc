@@ -25,6 +25,10 @@
 
 #include "P_Net.h"
 
+#if defined(linux)
+#include <linux/filter.h>
+#endif
+
 #ifdef ROUNDUP
 #undef ROUNDUP
 #endif
@@ -81,6 +85,11 @@ net_accept(NetAccept *na, void *ep, bool blockable)
       goto Ldone;
     }
     NET_SUM_GLOBAL_DYN_STAT(net_tcp_accept_stat, 1);
+    if (!na->opt.backdoor && !AdmissionControl::global().admit_connection(&con.addr.sa, Thread::get_hrtime())) {
+      con.close();
+      NET_SUM_GLOBAL_DYN_STAT(net_admission_connections_rejected_stat, 1);
+      continue;
+    }
 
     vc = static_cast<UnixNetVConnection *>(na->getNetProcessor()->allocate_vc(e->ethread));
     if (!vc) {
@@ -200,14 +209,41 @@ NetAccept::init_accept(EThread *t)
   t->schedule_every(this, period);
 }
 
+#if defined(SO_ATTACH_REUSEPORT_CBPF)
+//
+// Steer each connection to the listener with the index of the CPU that received it, so that
+// it is accepted and handled by the thread running on that CPU.
+//
+static void
+attach_reuseport_cpu_filter(int fd, int n)
+{
+  struct sock_filter code[] = {
+    {BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+    {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(n)},
+    {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  struct sock_fprog prog = {static_cast<unsigned short>(countof(code)), code};
+
+  if (safe_setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, reinterpret_cast<char *>(&prog), sizeof(prog)) < 0) {
+    Warning("unable to attach the CPU steering filter to listen socket %d: %s", fd, strerror(errno));
+  }
+}
+#endif
+
 void
 NetAccept::init_accept_per_thread()
 {
   int i, n;
+  int listeners     = 0;
+  NetAccept *shared = nullptr;
 
   ink_assert(opt.etype >= 0);
 
-  if (do_listen(NON_BLOCKING)) {
+  if (net_listen_per_thread) {
+    // Each thread listens on its own socket in the same SO_REUSEPORT group. The kernel spreads
+    // the connections over the sockets so only the thread owning a socket is woken for it.
+    server.reuseport = true;
+  } else if (do_listen(NON_BLOCKING)) {
     return;
   }
 
@@ -225,6 +261,28 @@ NetAccept::init_accept_per_thread()
     EThread *t         = eventProcessor.thread_group[opt.etype]._thread[i];
     PollDescriptor *pd = get_PollDescriptor(t);
 
+    if (net_listen_per_thread) {
+      // The first thread takes over a socket passed in, if any.
+      if (i > 0) {
+        a->server.fd = NO_FD;
+      }
+      if (a->do_listen(NON_BLOCKING) == 0) {
+        ++listeners;
+        if (!shared) {
+          shared = a;
+        }
+      } else if (shared) {
+        Warning("[NetAccept::init_accept_per_thread]:sharing a listen socket for port %d",
+                ats_ip_port_host_order(&server.accept_addr));
+        a->server.fd = shared->server.fd;
+      } else if (i == n - 1) {
+        return;
+      } else {
+        delete a;
+        continue;
+      }
+    }
+
     if (a->ep.start(pd, a, EVENTIO_READ) < 0) {
       Warning("[NetAccept::init_accept_per_thread]:error starting EventIO");
     }
@@ -232,6 +290,18 @@ NetAccept::init_accept_per_thread()
     a->mutex = get_NetHandler(t)->mutex;
     t->schedule_every(a, period);
   }
+
+  if (net_listen_per_thread) {
+    Debug("iocore_net_accept_start", "Listening on port %d with %d sockets for %d threads",
+          ats_ip_port_host_order(&server.accept_addr), listeners, n);
+#if defined(SO_ATTACH_REUSEPORT_CBPF)
+    // The index of a socket in the group is its listen order, which matches the thread index only
+    // if every thread got its own socket.
+    if (net_listen_per_thread == 2 && listeners == n) {
+      attach_reuseport_cpu_filter(server.fd, n);
+    }
+#endif
+  }
 }
 
 void
@@ -299,6 +369,11 @@ NetAccept::do_blocking_accept(EThread *t)
       NET_SUM_DYN_STAT(net_connections_throttled_in_stat, 1);
       continue;
     }
+    if (!opt.backdoor && !AdmissionControl::global().admit_connection(&con.addr.sa, Thread::get_hrtime())) {
+      con.close();
+      NET_SUM_DYN_STAT(net_admission_connections_rejected_stat, 1);
+      continue;
+    }
 
     if (TSSystemState::is_event_system_shut_down()) {
       return -1;
@@ -401,6 +476,7 @@ NetAccept::acceptFastEvent(int event, void *ep)
 
   UnixNetVConnection *vc = nullptr;
   int loop               = accept_till_done;
+  int count              = 0;
 
   do {
     if (!opt.backdoor && check_net_throttle(ACCEPT)) {
@@ -415,6 +491,12 @@ NetAccept::acceptFastEvent(int event, void *ep)
     if (likely(fd >= 0)) {
       Debug("iocore_net", "accepted a new socket: %d", fd);
       NET_SUM_GLOBAL_DYN_STAT(net_tcp_accept_stat, 1);
+      if (!opt.backdoor && !AdmissionControl::global().admit_connection(&con.addr.sa, Thread::get_hrtime())) {
+        Debug("iocore_net", "connection on socket %d rejected by admission control", fd);
+        con.close();
+        NET_SUM_DYN_STAT(net_admission_connections_rejected_stat, 1);
+        continue;
+      }
       if (opt.send_bufsize > 0) {
         if (unlikely(socketManager.set_sndbuf_size(fd, opt.send_bufsize))) {
           bufsz = ROUNDUP(opt.send_bufsize, 1024);
@@ -496,7 +578,9 @@ NetAccept::acceptFastEvent(int event, void *ep)
     SCOPED_MUTEX_LOCK(lock, vc->mutex, e->ethread);
     vc->handleEvent(EVENT_NONE, nullptr);
     vc = nullptr;
-  } while (loop);
+    // Stop after a batch so the thread gets back to its connections, this event runs again on
+    // the next loop of the thread and picks up the rest of the queue.
+  } while (loop && (net_accept_batch_size <= 0 || ++count < net_accept_batch_size));
 
 Ldone:
   return EVENT_CONT;
@@ -516,6 +600,9 @@ NetAccept::acceptLoopEvent(int event, Event *e)
   (void)e;
   EThread *t = this_ethread();
 
+  // Accept on the NUMA node where the connections will be handled.
+  eventProcessor.bind_to_net_numa_node();
+
   while (do_blocking_accept(t) >= 0) {
     ;
   }
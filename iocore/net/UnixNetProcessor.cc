@@ -137,7 +137,7 @@ UnixNetProcessor::accept_internal(Continuation *cont, int fd, AcceptOptions cons
   na->action_->server = &na->server;
 
   if (opt.frequent_accept) { // true
-    if (accept_threads > 0) {
+    if (accept_threads > 0 && !net_listen_per_thread) {
       na->init_accept_loop();
     } else {
       na->init_accept_per_thread();
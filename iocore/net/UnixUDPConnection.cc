@@ -131,7 +131,11 @@ UDPConnection::send(Continuation *c, UDPPacket *xp)
   ink_assert(conn->continuation != nullptr);
   mutex               = c->mutex;
   p->reqGenerationNum = conn->sendGenerationNum;
-  get_UDPNetHandler(conn->ethread)->udpOutQueue.send(p);
+  UDPNetHandler *nh   = get_UDPNetHandler(conn->ethread);
+  // Wake up the UDP thread for the first packet queued from another thread, it sends the whole queue.
+  if (nh->udpOutQueue.send(p) && conn->ethread != this_ethread()) {
+    nh->signalActivity();
+  }
   return ACTION_RESULT_NONE;
 }
 
@@ -32,6 +32,8 @@
 #include "P_Net.h"
 #include "P_UDPNet.h"
 
+#include <netinet/udp.h>
+
 using UDPNetContHandler = int (UDPNetHandler::*)(int, void *);
 
 inkcoreapi ClassAllocator<UDPPacketInternal> udpPacketAllocator("udpPacketAllocator");
@@ -47,6 +49,148 @@ UDPNetProcessor &udpNet = udpNetInternal;
 int32_t g_udp_periodicCleanupSlots;
 int32_t g_udp_periodicFreeCancelledPkts;
 int32_t g_udp_numSendRetries;
+int32_t g_udp_batch_size = UDP_MAX_BATCH;
+int32_t g_udp_enable_gso = 1;
+int32_t g_udp_enable_gro = 1;
+
+#if HAVE_RECVMMSG || HAVE_SENDMMSG
+using UDPMsgHdr = struct mmsghdr;
+#else
+struct UDPMsgHdr {
+  struct msghdr msg_hdr;
+  unsigned int msg_len;
+};
+#endif
+
+// The largest datagram is 65527 bytes, 32 blocks of 2K hold any of them.
+#define UDP_RECV_MAX_IOV 32
+// Segments of a GSO send, the kernel takes at most 64 and 64K in total. Segments must fit
+// the path MTU, larger packets are sent on their own.
+#define UDP_GSO_MAX_SEGMENTS 64
+#define UDP_GSO_MAX_BYTES 65507
+#define UDP_GSO_MAX_SEGMENT_SIZE 1452
+#define UDP_SEND_MAX_IOV 1024
+
+/// Buffers to receive a batch of datagrams, the blocks not filled by a read are kept for the next one.
+struct UDPRecvBatch {
+  Ptr<IOBufferBlock> chain[UDP_MAX_BATCH];
+  bool ready[UDP_MAX_BATCH] = {false};
+  UDPMsgHdr msgs[UDP_MAX_BATCH];
+  struct iovec iov[UDP_MAX_BATCH][UDP_RECV_MAX_IOV];
+  IpEndpoint from[UDP_MAX_BATCH];
+  char control[UDP_MAX_BATCH][CMSG_SPACE(sizeof(int))];
+
+  void prepare(int n);
+  Ptr<IOBufferBlock> take(int i, int64_t len);
+};
+
+void
+UDPRecvBatch::prepare(int n)
+{
+  for (int i = 0; i < n; ++i) {
+    if (!ready[i]) {
+      // top up the chain of the slot, reusing the blocks left from the last read
+      IOBufferBlock *b    = chain[i].get();
+      IOBufferBlock *last = nullptr;
+      for (int niov = 0; niov < UDP_RECV_MAX_IOV; niov++) {
+        if (b == nullptr) {
+          b = new_IOBufferBlock();
+          b->alloc(BUFFER_SIZE_INDEX_2K);
+          if (last == nullptr) {
+            chain[i] = b;
+          } else {
+            last->next = b;
+          }
+        }
+        iov[i][niov].iov_base = b->buf();
+        iov[i][niov].iov_len  = b->block_size();
+
+        last = b;
+        b    = b->next.get();
+      }
+      ready[i] = true;
+    }
+
+    struct msghdr *msg  = &msgs[i].msg_hdr;
+    msg->msg_name       = &from[i];
+    msg->msg_namelen    = sizeof(from[i]);
+    msg->msg_iov        = iov[i];
+    msg->msg_iovlen     = UDP_RECV_MAX_IOV;
+    msg->msg_control    = control[i];
+    msg->msg_controllen = sizeof(control[i]);
+    msg->msg_flags      = 0;
+  }
+}
+
+/// Fill the blocks of slot @a i with the @a len bytes read and split them off.
+Ptr<IOBufferBlock>
+UDPRecvBatch::take(int i, int64_t len)
+{
+  Ptr<IOBufferBlock> data = chain[i];
+  IOBufferBlock *b        = data.get();
+
+  for (;;) {
+    int64_t n = std::min(len, b->block_size());
+    b->fill(n);
+    len -= n;
+    if (len == 0 || b->next == nullptr) {
+      break;
+    }
+    b = b->next.get();
+  }
+  chain[i] = b->next;
+  b->next  = nullptr;
+  ready[i] = false;
+  return data;
+}
+
+/// Size of the datagrams coalesced by GRO into the read of @a msg, 0 if there are none.
+static int64_t
+udp_gro_segment_size(struct msghdr *msg)
+{
+#ifdef UDP_GRO
+  for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+    if (cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO) {
+      int segment;
+      memcpy(&segment, CMSG_DATA(cmsg), sizeof(segment));
+      return segment;
+    }
+  }
+#else
+  (void)msg;
+#endif
+  return 0;
+}
+
+/// Clone @a len bytes at @a offset of the filled blocks of @a b without copying the data.
+static IOBufferBlock *
+clone_block_range(IOBufferBlock *b, int64_t offset, int64_t len)
+{
+  IOBufferBlock *head = nullptr;
+  IOBufferBlock *tail = nullptr;
+
+  for (; b != nullptr && len > 0; b = b->next.get()) {
+    int64_t avail = b->read_avail();
+    if (offset >= avail) {
+      offset -= avail;
+      continue;
+    }
+
+    int64_t n        = std::min(avail - offset, len);
+    IOBufferBlock *c = b->clone();
+    c->_start += offset;
+    c->_buf_end = c->_end = c->_start + n;
+    if (tail == nullptr) {
+      head = c;
+    } else {
+      tail->next = c;
+    }
+    tail = c;
+    len -= n;
+    offset = 0;
+  }
+  return head;
+}
 
 //
 // Public functions
@@ -86,6 +230,11 @@ initialize_thread_for_udp_net(EThread *thread)
   REC_ReadConfigInt32(g_udp_numSendRetries, "proxy.config.udp.send_retries");
   g_udp_numSendRetries = g_udp_numSendRetries < 0 ? 0 : g_udp_numSendRetries;
 
+  // Datagrams read and written per system call, and the use of UDP segmentation offloads.
+  REC_ReadConfigInt32(g_udp_batch_size, "proxy.config.udp.batch_size");
+  REC_ReadConfigInt32(g_udp_enable_gso, "proxy.config.udp.enable_gso");
+  REC_ReadConfigInt32(g_udp_enable_gro, "proxy.config.udp.enable_gro");
+
   thread->set_tail_handler(nh);
   thread->ep = (EventIO *)ats_malloc(sizeof(EventIO));
   new (thread->ep) EventIO();
@@ -119,97 +268,71 @@ UDPNetProcessorInternal::udp_read_from_net(UDPNetHandler *nh, UDPConnection *xuc
 {
   UnixUDPConnection *uc = (UnixUDPConnection *)xuc;
 
-  // receive packet and queue onto UDPConnection.
+  // receive packets and queue onto UDPConnection.
   // don't call back connection at this time.
-  int64_t r;
-  int iters         = 0;
-  unsigned max_niov = 32;
-
-  struct msghdr msg;
-  Ptr<IOBufferBlock> chain, next_chain;
-  struct iovec tiovec[max_niov];
-  int64_t size_index  = BUFFER_SIZE_INDEX_2K;
-  int64_t buffer_size = BUFFER_SIZE_FOR_INDEX(size_index);
-  // The max length of receive buffer is 32 * buffer_size (2048) = 65536 bytes.
-  // Because the 'UDP Length' is type of uint16_t defined in RFC 768.
-  // And there is 8 octets in 'User Datagram Header' which means the max length of payload is no more than 65527 bytes.
-  do {
-    // create IOBufferBlock chain to receive data
-    unsigned int niov;
-    IOBufferBlock *b, *last;
-
-    // build struct iov
-    // reuse the block in chain if available
-    b    = chain.get();
-    last = nullptr;
-    for (niov = 0; niov < max_niov; niov++) {
-      if (b == nullptr) {
-        b = new_IOBufferBlock();
-        b->alloc(size_index);
-        if (last == nullptr) {
-          chain = b;
-        } else {
-          last->next = b;
-        }
-      }
+  int r;
+  int iters = 0;
+  int npkts = 0;
+#if HAVE_RECVMMSG
+  int batch = std::clamp(g_udp_batch_size, 1, UDP_MAX_BATCH);
+#else
+  int batch = 1;
+#endif
 
-      tiovec[niov].iov_base = b->buf();
-      tiovec[niov].iov_len  = b->block_size();
+  if (nh->recv_batch == nullptr) {
+    nh->recv_batch = new UDPRecvBatch;
+  }
+  UDPRecvBatch *rb = nh->recv_batch;
 
-      last = b;
-      b    = b->next.get();
+  do {
+    rb->prepare(batch);
+#if HAVE_RECVMMSG
+    r = socketManager.recvmmsg(uc->getFd(), rb->msgs, batch, 0);
+#else
+    r = socketManager.recvmsg(uc->getFd(), &rb->msgs[0].msg_hdr, 0);
+    if (r >= 0) {
+      rb->msgs[0].msg_len = r;
+      r                   = 1;
     }
-
-    // build struct msghdr
-    sockaddr_in6 fromaddr;
-    msg.msg_name       = &fromaddr;
-    msg.msg_namelen    = sizeof(fromaddr);
-    msg.msg_iov        = tiovec;
-    msg.msg_iovlen     = niov;
-    msg.msg_control    = nullptr;
-    msg.msg_controllen = 0;
-
-    // receive data by recvmsg
-    r = socketManager.recvmsg(uc->getFd(), &msg, 0);
+#endif
     if (r <= 0) {
       // error
       break;
     }
 
-    // truncated check
-    if (msg.msg_flags & MSG_TRUNC) {
-      Debug("udp-read", "The UDP packet is truncated");
-    }
+    for (int i = 0; i < r; ++i) {
+      struct msghdr *msg = &rb->msgs[i].msg_hdr;
+      int64_t len        = rb->msgs[i].msg_len;
 
-    // fill the IOBufferBlock chain
-    int64_t saved = r;
-    b             = chain.get();
-    while (b && saved > 0) {
-      if (saved > buffer_size) {
-        b->fill(buffer_size);
-        saved -= buffer_size;
-        b = b->next.get();
+      // truncated check
+      if (msg->msg_flags & MSG_TRUNC) {
+        Debug("udp-read", "The UDP packet is truncated");
+      }
+
+      Ptr<IOBufferBlock> chain = rb->take(i, len);
+      int64_t segment          = udp_gro_segment_size(msg);
+
+      if (segment > 0 && segment < len) {
+        // Several datagrams coalesced by GRO, hand them out one by one.
+        for (int64_t offset = 0; offset < len; offset += segment) {
+          Ptr<IOBufferBlock> data(clone_block_range(chain.get(), offset, std::min(segment, len - offset)));
+          UDPPacket *p = new_incoming_UDPPacket(&rb->from[i].sa, data);
+          p->setConnection(uc);
+          uc->inQueue.push((UDPPacketInternal *)p);
+          ++npkts;
+        }
       } else {
-        b->fill(saved);
-        saved      = 0;
-        next_chain = b->next.get();
-        b->next    = nullptr;
+        UDPPacket *p = new_incoming_UDPPacket(&rb->from[i].sa, chain);
+        p->setConnection(uc);
+        // queue onto the UDPConnection
+        uc->inQueue.push((UDPPacketInternal *)p);
+        ++npkts;
       }
     }
-
-    // create packet
-    UDPPacket *p = new_incoming_UDPPacket(ats_ip_sa_cast(&fromaddr), chain);
-    p->setConnection(uc);
-    // queue onto the UDPConnection
-    uc->inQueue.push((UDPPacketInternal *)p);
-
-    // reload the unused block
-    chain      = next_chain;
-    next_chain = nullptr;
     iters++;
-  } while (r > 0);
+  } while (r == batch);
   if (iters >= 1) {
-    Debug("udp-read", "read %d at a time", iters);
+    Debug("udp-read", "read %d packets in %d calls", npkts, iters);
   }
   // if not already on to-be-called-back queue, then add it.
   if (!uc->onCallbackQueue) {
@@ -696,6 +819,16 @@ UDPNetProcessor::UDPBind(Continuation *cont, sockaddr const *addr, int send_bufs
     goto Lerror;
   }
 
+#ifdef UDP_GRO
+  // Let the kernel coalesce datagrams of a flow, they are split again when read.
+  if (g_udp_enable_gro) {
+    int enable_gro = 1;
+    if (safe_setsockopt(fd, IPPROTO_UDP, UDP_GRO, (char *)&enable_gro, sizeof(enable_gro)) < 0) {
+      Debug("udpnet", "enabling UDP GRO failed: %s", strerror(errno));
+    }
+  }
+#endif
+
   if (recv_bufsize) {
     if (unlikely(socketManager.set_rcvbuf_size(fd, recv_bufsize))) {
       Debug("udpnet", "set_dnsbuf_size(%d) failed", recv_bufsize);
@@ -794,6 +927,9 @@ UDPQueue::SendPackets()
   int32_t bytesThisSlot = INT_MAX, bytesUsed = 0;
   int32_t bytesThisPipe, sentOne;
   int64_t pktLen;
+  UDPPacketInternal *batch[UDP_MAX_BATCH];
+  int nbatch     = 0;
+  int batch_size = std::clamp(g_udp_batch_size, 1, UDP_MAX_BATCH);
 
   bytesThisSlot = INT_MAX;
 
@@ -805,25 +941,30 @@ sendPackets:
     p      = pipeInfo.getFirstPacket();
     pktLen = p->getPktLength();
 
-    if (p->conn->shouldDestroy()) {
-      goto next_pkt;
-    }
-    if (p->conn->GetSendGenerationNumber() != p->reqGenerationNum) {
-      goto next_pkt;
+    if (p->conn->shouldDestroy() || p->conn->GetSendGenerationNumber() != p->reqGenerationNum) {
+      p->free();
+    } else {
+      // the packets are freed once the batch is sent
+      batch[nbatch++] = p;
+      if (nbatch >= batch_size) {
+        SendUDPPackets(batch, nbatch);
+        nbatch = 0;
+      }
+      bytesUsed += pktLen;
+      bytesThisPipe -= pktLen;
     }
-
-    SendUDPPacket(p, pktLen);
-    bytesUsed += pktLen;
-    bytesThisPipe -= pktLen;
-  next_pkt:
     sentOne = true;
-    p->free();
 
     if (bytesThisPipe < 0) {
       break;
     }
   }
 
+  if (nbatch > 0) {
+    SendUDPPackets(batch, nbatch);
+    nbatch = 0;
+  }
+
   bytesThisSlot -= bytesUsed;
 
   if ((bytesThisSlot > 0) && sentOne) {
@@ -858,7 +999,7 @@ UDPQueue::SendUDPPacket(UDPPacketInternal *p, int32_t /* pktLen ATS_UNUSED */)
   msg.msg_flags      = 0;
 #endif
   msg.msg_name    = (caddr_t)&p->to.sa;
-  msg.msg_namelen = sizeof(p->to.sa);
+  msg.msg_namelen = ats_ip_size(&p->to.sa);
   iov_len         = 0;
 
   for (IOBufferBlock *b = p->chain.get(); b != nullptr; b = b->next.get()) {
@@ -889,11 +1030,170 @@ UDPQueue::SendUDPPacket(UDPPacketInternal *p, int32_t /* pktLen ATS_UNUSED */)
   }
 }
 
+/*
+ * Send and free @a n packets. Packets to the same socket are sent with one sendmmsg(), consecutive
+ * packets of the same size to the same destination are coalesced into one GSO send.
+ */
 void
+UDPQueue::SendUDPPackets(UDPPacketInternal **packets, int n)
+{
+#if HAVE_SENDMMSG
+  struct MsgInfo {
+    int first;            ///< Index of the first packet.
+    int segments;         ///< Number of packets.
+    int64_t segment_size; ///< Size of the first packet, the size of all but the last segment.
+    int64_t bytes;
+    int iov_start;
+    bool closed; ///< A short packet was added, no more segments can follow.
+  };
+
+  UDPMsgHdr msgs[UDP_MAX_BATCH];
+  MsgInfo info[UDP_MAX_BATCH];
+  struct iovec iov[UDP_SEND_MAX_IOV];
+  char control[UDP_MAX_BATCH][CMSG_SPACE(sizeof(uint16_t))];
+
+  for (int i = 0; i < n;) {
+    // Build the messages for a run of packets on the same socket.
+    int fd   = packets[i]->conn->getFd();
+    int nmsg = 0;
+    int niov = 0;
+    int j    = i;
+
+    for (; j < n; ++j) {
+      UDPPacketInternal *p = packets[j];
+      int64_t len          = p->getPktLength();
+      int nblocks          = 0;
+
+      if (p->conn->getFd() != fd) {
+        break;
+      }
+      for (IOBufferBlock *b = p->chain.get(); b != nullptr; b = b->next.get()) {
+        ++nblocks;
+      }
+      if (niov + nblocks > UDP_SEND_MAX_IOV) {
+        break;
+      }
+
+      MsgInfo *m    = nmsg > 0 ? &info[nmsg - 1] : nullptr;
+      bool coalesce = false;
+#ifdef UDP_SEGMENT
+      coalesce = g_udp_enable_gso && m && !m->closed && len > 0 && len <= m->segment_size &&
+                 m->segment_size <= UDP_GSO_MAX_SEGMENT_SIZE && m->segments < UDP_GSO_MAX_SEGMENTS &&
+                 m->bytes + len <= UDP_GSO_MAX_BYTES && ats_ip_addr_port_eq(&packets[m->first]->to.sa, &p->to.sa);
+#endif
+      if (coalesce) {
+        ++m->segments;
+        m->bytes += len;
+        m->closed = len < m->segment_size;
+      } else {
+        if (nmsg == UDP_MAX_BATCH) {
+          break;
+        }
+        m               = &info[nmsg++];
+        m->first        = j;
+        m->segments     = 1;
+        m->segment_size = len;
+        m->bytes        = len;
+        m->iov_start    = niov;
+        m->closed       = false;
+      }
+
+      p->conn->lastSentPktStartTime = p->delivery_time;
+      Debug("udp-send", "Sending %p", p);
+      for (IOBufferBlock *b = p->chain.get(); b != nullptr; b = b->next.get()) {
+        iov[niov].iov_base = b->start();
+        iov[niov].iov_len  = b->size();
+        ++niov;
+      }
+    }
+
+    if (nmsg == 0) {
+      // A single packet with more blocks than the batch can hold.
+      SendUDPPacket(packets[i], 0);
+      packets[i]->free();
+      ++i;
+      continue;
+    }
+
+    for (int k = 0; k < nmsg; ++k) {
+      struct msghdr *msg  = &msgs[k].msg_hdr;
+      int iov_end         = k + 1 < nmsg ? info[k + 1].iov_start : niov;
+      msg->msg_name       = &packets[info[k].first]->to.sa;
+      msg->msg_namelen    = ats_ip_size(&packets[info[k].first]->to.sa);
+      msg->msg_iov        = iov + info[k].iov_start;
+      msg->msg_iovlen     = iov_end - info[k].iov_start;
+      msg->msg_control    = nullptr;
+      msg->msg_controllen = 0;
+      msg->msg_flags      = 0;
+#ifdef UDP_SEGMENT
+      if (info[k].segments > 1) {
+        uint16_t segment_size = info[k].segment_size;
+        msg->msg_control      = control[k];
+        msg->msg_controllen   = sizeof(control[k]);
+        struct cmsghdr *cmsg  = CMSG_FIRSTHDR(msg);
+        cmsg->cmsg_level      = IPPROTO_UDP;
+        cmsg->cmsg_type       = UDP_SEGMENT;
+        cmsg->cmsg_len        = CMSG_LEN(sizeof(segment_size));
+        memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+      }
+#endif
+    }
+
+    int sent  = 0;
+    int count = 0;
+    while (sent < nmsg) {
+      int r = socketManager.sendmmsg(fd, msgs + sent, nmsg - sent, 0);
+      if (r > 0) {
+        sent += r;
+        count = 0;
+        continue;
+      }
+      if (r == -EAGAIN) {
+        // stupid Linux problem: sendmsg can return EAGAIN
+        if ((g_udp_numSendRetries > 0) && (++count >= g_udp_numSendRetries)) {
+          // tried too many times; give up on this message
+          Debug("udpnet", "Send failed: too many retries");
+          ++sent;
+          count = 0;
+        }
+        continue;
+      }
+
+      // The first message of the rest failed, send its packets one by one if they were coalesced.
+      MsgInfo &m = info[sent];
+      if (m.segments > 1) {
+        Debug("udpnet", "GSO send of %d packets failed: %s", m.segments, strerror(-r));
+        if (r == -EIO) {
+          // The device can not do the checksums of the segments.
+          g_udp_enable_gso = 0;
+        }
+        for (int k = m.first; k < m.first + m.segments; ++k) {
+          SendUDPPacket(packets[k], 0);
+        }
+      } else {
+        Debug("udpnet", "Send failed: %s", strerror(-r));
+      }
+      ++sent;
+      count = 0;
+    }
+
+    for (; i < j; ++i) {
+      packets[i]->free();
+    }
+  }
+#else
+  for (int i = 0; i < n; ++i) {
+    SendUDPPacket(packets[i], 0);
+    packets[i]->free();
+  }
+#endif
+}
+
+bool
 UDPQueue::send(UDPPacket *p)
 {
   // XXX: maybe fastpath for immediate send?
-  outQueue.push((UDPPacketInternal *)p);
+  return ink_atomiclist_push(&outQueue.al, p) == nullptr;
 }
 
 #undef LINK
@@ -965,9 +1265,6 @@ UDPNetHandler::waitForActivity(ink_hrtime timeout)
     }
   }
 
-  // handle UDP outgoing engine
-  udpOutQueue.service(this);
-
   // handle UDP read operations
   int i, nread = 0;
   EventIO *epd = nullptr;
@@ -1035,6 +1332,9 @@ UDPNetHandler::waitForActivity(ink_hrtime timeout)
     }
   }
 
+  // handle UDP outgoing engine, after the callbacks so their replies go out in this pass
+  udpOutQueue.service(this);
+
   return EVENT_CONT;
 }
 
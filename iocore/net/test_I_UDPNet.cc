@@ -21,6 +21,8 @@
   limitations under the License.
  */
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
@@ -124,7 +126,7 @@ signal_handler(int signum)
 }
 
 void
-udp_echo_server()
+udp_echo_server(const char *debug_tags)
 {
   Layout::create();
   RecModeT mode_type = RECM_STAND_ALONE;
@@ -134,7 +136,7 @@ udp_echo_server()
   main_thread->set_specific();
   net_config_poll_timeout = 10;
 
-  init_diags("udp-.*", nullptr);
+  init_diags(debug_tags, nullptr);
   ink_event_system_init(EVENT_SYSTEM_MODULE_PUBLIC_VERSION);
   eventProcessor.start(2);
   udpNet.start(1, 1048576);
@@ -186,12 +188,10 @@ udp_client(char *buf)
   close(sock);
 }
 
-REGRESSION_TEST(UDPNet_echo)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+// Fork the echo server and wait for its port.
+pid_t
+start_echo_server(const char *debug_tags)
 {
-  TestBox box(t, pstatus);
-  box         = REGRESSION_TEST_PASSED;
-  char buf[8] = {0};
-
   int z = pipe(pfd);
   if (z < 0) {
     std::cout << "Unable to create pipe" << std::endl;
@@ -204,26 +204,133 @@ REGRESSION_TEST(UDPNet_echo)(RegressionTest *t, int /* atype ATS_UNUSED */, int
     std::exit(EXIT_FAILURE);
   } else if (pid == 0) {
     close(pfd[0]);
-    udp_echo_server();
-  } else {
-    close(pfd[1]);
-    if (read(pfd[0], &port, sizeof(port)) <= 0) {
-      std::cout << "Failed to get signal with port data [" << errno << ']' << std::endl;
-      std::exit(EXIT_FAILURE);
+    udp_echo_server(debug_tags);
+  }
+
+  close(pfd[1]);
+  if (read(pfd[0], &port, sizeof(port)) <= 0) {
+    std::cout << "Failed to get signal with port data [" << errno << ']' << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  close(pfd[0]);
+  return pid;
+}
+
+void
+stop_echo_server(pid_t pid)
+{
+  kill(pid, SIGTERM);
+  int status;
+  wait(&status);
+
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    std::cout << "UDP Echo Server exit failure" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+}
+
+REGRESSION_TEST(UDPNet_echo)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box         = REGRESSION_TEST_PASSED;
+  char buf[8] = {0};
+
+  pid_t pid = start_echo_server("udp-.*");
+  udp_client(buf);
+  stop_echo_server(pid);
+
+  box.check(strncmp(buf, payload, sizeof(payload)) == 0, "echo doesn't match");
+}
+
+static const int THROUGHPUT_PACKETS = 100000;
+static const int THROUGHPUT_SIZE    = 1200;
+static const int THROUGHPUT_WINDOW  = 256;
+
+/* Send a stream of packets through the echo server with a window of packets in flight, so the server
+   reads and writes them in batches. Each packet carries its sequence number and a fill byte derived
+   from it, a packet mangled on the way (e.g. by splitting GRO reads) does not count as echoed.
+*/
+int
+udp_throughput_client(double &seconds)
+{
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock < 0) {
+    std::cout << "Couldn't create socket" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  int bufsize = 4 * 1024 * 1024;
+  setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &bufsize, sizeof(bufsize));
+  setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize));
+
+  struct timeval tv;
+  tv.tv_sec  = 1;
+  tv.tv_usec = 0;
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (char *)&tv, sizeof(tv));
+
+  sockaddr_in addr;
+  addr.sin_family      = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port        = htons(port);
+  if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    std::cout << "Couldn't connect udp socket" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  char out[THROUGHPUT_SIZE];
+  char in[THROUGHPUT_SIZE * 2];
+  int sent     = 0;
+  int inflight = 0;
+  int echoed   = 0;
+  auto start   = std::chrono::steady_clock::now();
+
+  while (sent < THROUGHPUT_PACKETS || inflight > 0) {
+    while (sent < THROUGHPUT_PACKETS && inflight < THROUGHPUT_WINDOW) {
+      uint32_t seq = sent;
+      memcpy(out, &seq, sizeof(seq));
+      memset(out + sizeof(seq), seq & 0xff, sizeof(out) - sizeof(seq));
+      if (send(sock, out, sizeof(out), 0) == sizeof(out)) {
+        ++inflight;
+      }
+      ++sent;
     }
-    udp_client(buf);
 
-    kill(pid, SIGTERM);
-    int status;
-    wait(&status);
+    ssize_t l = recv(sock, in, sizeof(in), 0);
+    if (l < 0) {
+      // Timed out, the rest of the window was lost.
+      inflight = 0;
+      continue;
+    }
+    inflight = std::max(inflight - 1, 0);
 
-    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
-      box.check(strncmp(buf, payload, sizeof(payload)) == 0, "echo doesn't match");
-    } else {
-      std::cout << "UDP Echo Server exit failure" << std::endl;
-      std::exit(EXIT_FAILURE);
+    uint32_t seq;
+    memcpy(&seq, in, sizeof(seq));
+    if (l == THROUGHPUT_SIZE && in[l - 1] == static_cast<char>(seq & 0xff) && in[sizeof(seq)] == static_cast<char>(seq & 0xff)) {
+      ++echoed;
     }
   }
+
+  seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  close(sock);
+  return echoed;
+}
+
+REGRESSION_TEST(UDPNet_throughput)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  // No debug output, it would take most of the time.
+  pid_t pid      = start_echo_server("");
+  double seconds = 0;
+  int echoed     = udp_throughput_client(seconds);
+  stop_echo_server(pid);
+
+  std::cout << "UDP loopback echo: " << echoed << "/" << THROUGHPUT_PACKETS << " packets of " << THROUGHPUT_SIZE << " bytes in "
+            << seconds << "s, " << static_cast<int64_t>(echoed / seconds) << " packets/s, "
+            << static_cast<int64_t>(8.0 * echoed * THROUGHPUT_SIZE / seconds / 1000000) << " Mbit/s each way" << std::endl;
+  // Loopback can still drop when the test machine is busy, require most of the packets.
+  box.check(echoed >= THROUGHPUT_PACKETS * 9 / 10, "only %d of %d packets echoed", echoed, THROUGHPUT_PACKETS);
 }
 
 int
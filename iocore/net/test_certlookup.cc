@@ -24,6 +24,8 @@
 #include "P_SSLCertLookup.h"
 #include "tscore/TestBox.h"
 #include <fstream>
+#include <string>
+#include <vector>
 
 static IpEndpoint
 make_endpoint(const char *address)
@@ -99,6 +101,66 @@ REGRESSION_TEST(SSLCertificateLookup)(RegressionTest *t, int /* atype ATS_UNUSED
   box.check(lookup.find("mixed.case.com")->getCtx().get() == foo, "lower case lookup for Mixed.Case.Com");
 }
 
+REGRESSION_TEST(SSLCompiledCertificateLookup)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  SSLCertLookup lookup;
+
+  SSL_CTX *wild      = SSL_CTX_new(SSLv23_server_method());
+  SSL_CTX *notwild   = SSL_CTX_new(SSLv23_server_method());
+  SSL_CTX *b_notwild = SSL_CTX_new(SSLv23_server_method());
+  SSL_CTX *foo       = SSL_CTX_new(SSLv23_server_method());
+  SSL_CTX *all_com   = SSL_CTX_new(SSLv23_server_method());
+  SSL_CTX *trailing  = SSL_CTX_new(SSLv23_server_method());
+  SSLCertContext wild_cc(wild);
+  SSLCertContext notwild_cc(notwild);
+  SSLCertContext b_notwild_cc(b_notwild);
+  SSLCertContext foo_cc(foo);
+  SSLCertContext all_com_cc(all_com);
+  SSLCertContext trailing_cc(trailing);
+
+  box = REGRESSION_TEST_PASSED;
+
+  box.check(lookup.insert("www.foo.com", foo_cc) >= 0, "insert host context");
+  box.check(lookup.insert("*.wild.com", wild_cc) >= 0, "insert wildcard context");
+  box.check(lookup.insert("*.notwild.com", notwild_cc) >= 0, "insert wildcard context");
+  box.check(lookup.insert("*.b.notwild.com", b_notwild_cc) >= 0, "insert wildcard context");
+  box.check(lookup.insert("*.com", all_com_cc) >= 0, "insert wildcard context");
+  box.check(lookup.insert("www.trailing.com.", trailing_cc) >= 0, "insert host context with a trailing dot");
+
+  // Nothing indexed yet is fine.
+  SSLCertLookup empty;
+  empty.compile();
+  box.check(empty.find("www.foo.com") == nullptr, "lookup in an empty compiled index");
+
+  lookup.compile();
+
+  box.check(lookup.find("a.wild.com")->getCtx().get() == wild, "compiled wildcard lookup for a.wild.com");
+  box.check(lookup.find("a.notwild.com")->getCtx().get() == notwild, "compiled wildcard lookup for a.notwild.com");
+  box.check(lookup.find("notwild.com")->getCtx().get() == all_com, "compiled wildcard lookup for notwild.com");
+  box.check(lookup.find("c.b.notwild.com")->getCtx().get() == b_notwild, "compiled wildcard lookup for c.b.notwild.com");
+  box.check(lookup.find("www.foo.com")->getCtx().get() == foo, "compiled host lookup for www.foo.com");
+  box.check(lookup.find("WWW.Foo.COM")->getCtx().get() == foo, "compiled mixed case lookup for www.foo.com");
+  box.check(lookup.find("www.trailing.com.")->getCtx().get() == trailing, "compiled host lookup with a trailing dot");
+  box.check(lookup.find("www.trailing.com") == nullptr, "compiled lookup www.trailing.com without the trailing dot");
+  box.check(lookup.find("www.bar.com") == nullptr, "compiled lookup www.bar.com only matches one level");
+  box.check(lookup.find("foo.com.net") == nullptr, "compiled lookup for foo.com.net");
+  box.check(lookup.find("com") == nullptr, "compiled lookup for com");
+  box.check(lookup.find("") == nullptr, "compiled lookup for an empty name");
+
+  // Inserting after the compilation must keep the duplicate checks and the previous names.
+  box.check(lookup.insert("*.wild.com", foo_cc) < 0, "insert wildcard duplicate after compile");
+  box.check(lookup.insert("www.foo.com", all_com_cc) < 0, "insert host duplicate after compile");
+  box.check(lookup.insert("Mixed.Case.Com", foo_cc) >= 0, "insert host after compile");
+  box.check(lookup.find("mixed.case.com")->getCtx().get() == foo, "lookup of the host inserted after compile");
+  box.check(lookup.find("a.wild.com")->getCtx().get() == wild, "wildcard lookup for a.wild.com after insert");
+  box.check(lookup.find("www.trailing.com.")->getCtx().get() == trailing, "host lookup with a trailing dot after insert");
+
+  lookup.compile();
+  box.check(lookup.find("MIXED.case.com")->getCtx().get() == foo, "recompiled lookup for Mixed.Case.Com");
+  box.check(lookup.find("c.b.notwild.com")->getCtx().get() == b_notwild, "recompiled lookup for c.b.notwild.com");
+}
+
 REGRESSION_TEST(SSLAddressLookup)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
 {
   TestBox box(t, pstatus);
@@ -152,10 +214,16 @@ REGRESSION_TEST(SSLAddressLookup)(RegressionTest *t, int /* atype ATS_UNUSED */,
   box.check(lookup.insert(endpoint.ip4p, ip4p_cc) >= 0, "insert IPv4 address w/ port");
   box.check(lookup.find(endpoint.ip4)->getCtx().get() == context.ip4, "IPv4 longest match lookup");
   box.check(lookup.find(endpoint.ip4p)->getCtx().get() == context.ip4p, "IPv4 longest match lookup w/ port");
+
+  lookup.compile();
+  box.check(lookup.find(endpoint.ip6)->getCtx().get() == context.ip6, "IPv6 compiled lookup");
+  box.check(lookup.find(endpoint.ip6p)->getCtx().get() == context.ip6p, "IPv6 compiled lookup w/ port");
+  box.check(lookup.find(endpoint.ip4)->getCtx().get() == context.ip4, "IPv4 compiled lookup");
+  box.check(lookup.find(endpoint.ip4p)->getCtx().get() == context.ip4p, "IPv4 compiled lookup w/ port");
 }
 
 static unsigned
-load_hostnames_csv(const char *fname, SSLCertLookup &lookup)
+load_hostnames_csv(const char *fname, SSLCertLookup &lookup, std::vector<std::string> &names)
 {
   std::fstream infile(fname, std::ios_base::in);
   unsigned count = 0;
@@ -190,9 +258,11 @@ load_hostnames_csv(const char *fname, SSLCertLookup &lookup)
     if (pos != std::string::npos) {
       std::string host(line.substr(pos + 1));
       lookup.insert(host.c_str(), ctx_cc);
+      names.push_back(host);
     } else {
       // No comma? Assume the whole line is the hostname
       lookup.insert(line.c_str(), ctx_cc);
+      names.push_back(line);
     }
 
     ++count;
@@ -201,6 +271,28 @@ load_hostnames_csv(const char *fname, SSLCertLookup &lookup)
   return count;
 }
 
+// Time looking up every name in @a names, with a miss on a subdomain of each of them as well.
+static void
+time_lookups(const char *label, SSLCertLookup &lookup, std::vector<std::string> const &names)
+{
+  static const int ROUNDS = 5;
+  unsigned found          = 0;
+  ink_hrtime start        = ink_get_hrtime_internal();
+
+  for (int round = 0; round < ROUNDS; ++round) {
+    for (auto const &name : names) {
+      std::string miss = "sub.miss." + name;
+      found += lookup.find(name.c_str()) != nullptr;
+      found += lookup.find(miss.c_str()) != nullptr;
+    }
+  }
+
+  ink_hrtime elapsed = ink_get_hrtime_internal() - start;
+  unsigned lookups   = ROUNDS * names.size() * 2;
+  printf("%s: %u lookups (%u found) in %.3f msec, %.1f nsec/lookup\n", label, lookups, found,
+         static_cast<double>(elapsed) / HRTIME_MSECOND, lookups ? static_cast<double>(elapsed) / lookups : 0.0);
+}
+
 // This stub version of SSLReleaseContext saves us from having to drag in a lot
 // of binary dependencies. We don't have session tickets in this test environment
 // so it's safe to do this; just a bit ugly.
@@ -222,14 +314,21 @@ main(int argc, const char **argv)
 
   if (argc > 1) {
     SSLCertLookup lookup;
+    std::vector<std::string> names;
     unsigned count = 0;
 
     for (int i = 1; i < argc; ++i) {
-      count += load_hostnames_csv(argv[i], lookup);
+      count += load_hostnames_csv(argv[i], lookup, names);
     }
 
     printf("loaded %u host names\n", count);
 
+    time_lookups("hash tables", lookup, names);
+    ink_hrtime start = ink_get_hrtime_internal();
+    lookup.compile();
+    printf("compiled in %.3f msec\n", static_cast<double>(ink_get_hrtime_internal() - start) / HRTIME_MSECOND);
+    time_lookups("compiled", lookup, names);
+
   } else {
     // Standard regression tests.
     RegressionTest::run(nullptr, REGRESSION_TEST_QUICK);
@@ -937,6 +937,15 @@ LocalManager::listenForProxy()
     return;
   }
 
+  // With a listener per thread traffic_server opens the ports itself. A socket bound here would
+  // be owned by a different user and could not join the SO_REUSEPORT group of those listeners.
+  bool found;
+  RecInt per_thread = REC_readInteger("proxy.config.net.listen_per_thread", &found);
+  if (found && per_thread) {
+    mgmt_log("[LocalManager::listenForProxy] Listening per thread, proxy ports are opened by traffic_server\n");
+    return;
+  }
+
   // We are not already bound, bind the port
   for (auto &p : lmgmt->m_proxy_ports) {
     if (ts::NO_FD == p.m_fd) {
@@ -944,7 +953,6 @@ LocalManager::listenForProxy()
     }
 
     // read backlog configuration value and overwrite the default value if found
-    bool found;
     std::string_view fam{ats_ip_family_name(p.m_family)};
     RecInt backlog = REC_readInteger("proxy.config.net.listen_backlog", &found);
     backlog        = (found && backlog >= 0) ? backlog : ats_tcp_somaxconn();
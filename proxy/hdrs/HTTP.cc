@@ -27,6 +27,7 @@
 #include <cassert>
 #include <cstdio>
 #include <cstring>
+#include <string>
 #include "HTTP.h"
 #include "HdrToken.h"
 #include "tscore/Diags.h"
@@ -2327,3 +2328,93 @@ HTTPInfo::push_frag_offset(FragOffset offset)
 
   m_alt->m_frag_offsets[m_alt->m_frag_offset_count++] = offset;
 }
+
+/*-------------------------------------------------------------------------
+  -------------------------------------------------------------------------*/
+
+bool
+HTTPChunkMap::init(int64_t size, int64_t object_size)
+{
+  if (size <= 0 || object_size <= 0 || (object_size + size - 1) / size > MAX_CHUNKS) {
+    return false;
+  }
+  chunk_size   = size;
+  count        = (object_size + size - 1) / size;
+  _object_size = object_size;
+  _present.assign(count, false);
+  return true;
+}
+
+bool
+HTTPChunkMap::load(const HTTPHdr *resp, int64_t object_size)
+{
+  int len           = 0;
+  const char *value = resp->value_get(FIELD, FIELD_LEN, &len);
+  int64_t size      = 0;
+
+  if (!value) {
+    return false;
+  }
+  const char *end = value + len;
+  for (; value < end && ParseRules::is_digit(*value); ++value) {
+    size = size * 10 + (*value - '0');
+    if (size > INT32_MAX) {
+      return false;
+    }
+  }
+  if (value == end || *value++ != ':' || !init(size, object_size) || end - value != (count + 3) / 4) {
+    return false;
+  }
+  for (int i = 0; value < end; ++value, i += 4) {
+    int nibble = ParseRules::is_digit(*value) ? *value - '0' : ParseRules::ink_tolower(*value) - 'a' + 10;
+    if (nibble < 0 || nibble > 15) {
+      return false;
+    }
+    for (int b = 0; b < 4 && i + b < count; ++b) {
+      _present[i + b] = nibble & (1 << b);
+    }
+  }
+  return true;
+}
+
+void
+HTTPChunkMap::store(HTTPHdr *resp) const
+{
+  static const char hex[] = "0123456789abcdef";
+  char buf[24];
+  std::string value(buf, snprintf(buf, sizeof(buf), "%" PRId64 ":", chunk_size));
+
+  for (int i = 0; i < count; i += 4) {
+    int nibble = 0;
+    for (int b = 0; b < 4 && i + b < count; ++b) {
+      nibble |= _present[i + b] << b;
+    }
+    value += hex[nibble];
+  }
+  resp->value_set(FIELD, FIELD_LEN, value.data(), value.size());
+}
+
+int
+HTTPChunkMap::first() const
+{
+  for (int i = 0; i < count; ++i) {
+    if (_present[i]) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool
+HTTPChunkMap::covers(int64_t start, int64_t end) const
+{
+  if (start < 0 || start > end || end >= _object_size) {
+    return false;
+  }
+  for (int64_t i = start / chunk_size; i <= end / chunk_size; ++i) {
+    if (!_present[i]) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -24,6 +24,8 @@
 #pragma once
 
 #include <cassert>
+#include <algorithm>
+#include <vector>
 #include "tscore/Arena.h"
 #include "tscore/CryptoHash.h"
 #include "MIME.h"
@@ -1556,3 +1558,53 @@ HTTPInfo::get_frag_offset_count()
 {
   return m_alt ? m_alt->m_frag_offset_count : 0;
 }
+
+/** Presence map of the chunks of a sparse alternate.
+
+    A sparse alternate holds some of the fixed size chunks of an object, chunk @c i is the @c i'th data fragment and
+    holds the bytes from @c i * @c chunk_size of the object. The map is kept in the internal @c @Ats-Chunks field of the
+    cached response as "<chunk size>:<hex digits>", chunk @c i is bit @c i % 4 of hex digit @c i / 4.
+ */
+class HTTPChunkMap
+{
+public:
+  static constexpr const char *FIELD = "@Ats-Chunks";
+  static constexpr int FIELD_LEN     = 11;
+  /// Limit on the chunks of an object, bounds the field and the fragment table.
+  static constexpr int MAX_CHUNKS = 16384;
+
+  /// Set up an empty map of an object of @a object_size bytes, fails if it has too many chunks.
+  bool init(int64_t chunk_size, int64_t object_size);
+  /// Load the map of an object of @a object_size bytes from @a resp, fails if it is not a sparse alternate.
+  bool load(const HTTPHdr *resp, int64_t object_size);
+  /// Store the map in @a resp.
+  void store(HTTPHdr *resp) const;
+
+  bool
+  test(int i) const
+  {
+    return _present[i];
+  }
+  void
+  set(int i)
+  {
+    _present[i] = true;
+  }
+  /// @return The index of the first present chunk, -1 if there is none.
+  int first() const;
+  /// @return The length of chunk @a i, the last chunk is short.
+  int64_t
+  chunk_length(int i) const
+  {
+    return std::min(chunk_size, _object_size - i * chunk_size);
+  }
+  /// @return @c true if the bytes @a start to @a end inclusive are in present chunks.
+  bool covers(int64_t start, int64_t end) const;
+
+  int64_t chunk_size = 0;
+  int count          = 0; ///< Number of chunks of the object.
+
+private:
+  int64_t _object_size = 0;
+  std::vector<bool> _present;
+};
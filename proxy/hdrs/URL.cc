@@ -1871,4 +1871,63 @@ REGRESSION_TEST(ParseRules_strict_URI)(RegressionTest *t, int /* level ATS_UNUSE
   }
 }
 
+#if TS_ENABLE_FIPS == 0
+REGRESSION_TEST(URL_CryptoHash_Benchmark)(RegressionTest *t, int level, int *pstatus)
+{
+  static constexpr int N_URLS   = 4096;
+  static constexpr int N_HASHES = 2000000;
+
+  static const CryptoContext::HashType types[] = {CryptoContext::MD5, CryptoContext::XXH3};
+  static const char *const names[]             = {"MD5", "XXH3"};
+
+  TestBox box(t, pstatus);
+
+  if (REGRESSION_TEST_EXTENDED > level) {
+    box = REGRESSION_TEST_PASSED;
+    return;
+  }
+  box = REGRESSION_TEST_PASSED;
+
+  // CDN like URLs, every other one with a query string so both the fast and the general path are used.
+  URL *urls = new URL[N_URLS];
+  for (int i = 0; i < N_URLS; ++i) {
+    char buf[512];
+    const char *s = buf;
+    int len       = snprintf(buf, sizeof(buf), "http://cdn%d.img.example-media.com/assets/v2/catalog/%d/%d/product-image-%d.jpg",
+                       i % 16, i % 97, (i * 7919) % 10007, i);
+    if (i % 2) {
+      len += snprintf(buf + len, sizeof(buf) - len, "?width=%d&height=%d&quality=85&format=webp&session=%08x", 100 + i % 900,
+                      100 + i % 700, i * 2654435761u);
+    }
+    urls[i].create(nullptr);
+    urls[i].parse(s, len);
+  }
+
+  CryptoContext::HashType saved = CryptoContext::Setting;
+  CryptoHash first[2];
+  for (int k = 0; k < 2; ++k) {
+    CryptoHash hash, check;
+
+    CryptoContext::Setting = types[k];
+    urls[0].hash_get(&first[k]);
+    ink_hrtime start = ink_get_hrtime_internal();
+    for (int i = 0; i < N_HASHES; ++i) {
+      urls[i % N_URLS].hash_get(&hash);
+    }
+    ink_hrtime time = ink_get_hrtime_internal() - start;
+    urls[0].hash_get(&check);
+
+    box.check(check == first[k], "%s hash of a URL is not stable", names[k]);
+    rprintf(t, "%d %s URL hashes in %" PRId64 " ms\n", N_HASHES, names[k], ink_hrtime_to_msec(time));
+  }
+  CryptoContext::Setting = saved;
+  box.check(!(first[0] == first[1]), "MD5 and XXH3 hashes of a URL are the same");
+
+  for (int i = 0; i < N_URLS; ++i) {
+    urls[i].destroy();
+  }
+  delete[] urls;
+}
+#endif
+
 #endif // TS_HAS_TESTS
@@ -115,3 +115,52 @@ TEST_CASE("MIMEScanner_fragments", "[proxy][mimescanner_fragments]")
 
   REQUIRE(message == output);
 }
+
+TEST_CASE("HTTPChunkMap", "[proxy][chunkmap]")
+{
+  HTTPHdr resp;
+  HTTPChunkMap map, loaded;
+
+  resp.create(HTTP_TYPE_RESPONSE);
+
+  REQUIRE(!map.init(0, 1000));
+  REQUIRE(!map.init(100, 0));
+  REQUIRE(!map.init(1, HTTPChunkMap::MAX_CHUNKS + 1));
+  REQUIRE(!loaded.load(&resp, 1000));
+
+  REQUIRE(map.init(100, 950));
+  REQUIRE(map.count == 10);
+  REQUIRE(map.chunk_length(0) == 100);
+  REQUIRE(map.chunk_length(9) == 50);
+  REQUIRE(map.first() == -1);
+
+  map.set(2);
+  map.set(3);
+  map.set(9);
+  map.store(&resp);
+
+  int len           = 0;
+  const char *value = resp.value_get(HTTPChunkMap::FIELD, HTTPChunkMap::FIELD_LEN, &len);
+  REQUIRE(std::string_view(value, len) == "100:c02");
+
+  REQUIRE(loaded.load(&resp, 950));
+  REQUIRE(loaded.chunk_size == 100);
+  REQUIRE(loaded.first() == 2);
+  REQUIRE(loaded.test(3));
+  REQUIRE(!loaded.test(4));
+  REQUIRE(loaded.covers(200, 399));
+  REQUIRE(loaded.covers(900, 949));
+  REQUIRE(!loaded.covers(150, 250));
+  REQUIRE(!loaded.covers(300, 400));
+  REQUIRE(!loaded.covers(900, 950));
+
+  // the map must match the size of the object
+  REQUIRE(!loaded.load(&resp, 1300));
+
+  for (const char *bad : {"100", "100:c0", "100:c02f", "100:c0g", ":c02", "x:c02"}) {
+    resp.value_set(HTTPChunkMap::FIELD, HTTPChunkMap::FIELD_LEN, bad, strlen(bad));
+    REQUIRE(!loaded.load(&resp, 950));
+  }
+
+  resp.destroy();
+}
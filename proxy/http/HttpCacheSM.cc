@@ -104,18 +104,36 @@ HttpCacheSM::state_cache_open_read(int event, void *data)
   switch (event) {
   case CACHE_EVENT_OPEN_READ:
     HTTP_INCREMENT_DYN_STAT(http_current_cache_connections_stat);
-    ink_assert((cache_read_vc == nullptr) || master_sm->t_state.redirect_info.redirect_in_process);
+    ink_assert((cache_read_vc == nullptr) || master_sm->t_state.redirect_info.redirect_in_process || read_retry_on_write_fail);
     if (cache_read_vc) {
-      // redirect follow in progress, close the previous cache_read_vc
+      // redirect follow or read retry in progress, close the previous cache_read_vc
       close_read();
     }
     open_read_cb  = true;
     cache_read_vc = (CacheVConnection *)data;
+    if (read_retry_on_write_fail) {
+      // Served from the object written by the transaction that holds the write lock.
+      HTTP_INCREMENT_DYN_STAT(http_cache_collapsed_requests_stat);
+      read_retry_on_write_fail = false;
+      open_write_cb            = true;
+    }
     master_sm->handleEvent(event, data);
     break;
 
   case CACHE_EVENT_OPEN_READ_FAILED:
-    if ((intptr_t)data == -ECACHE_DOC_BUSY) {
+    if (read_retry_on_write_fail) {
+      if ((intptr_t)data == -ECACHE_DOC_BUSY && open_read_tries <= master_sm->t_state.txn_conf->max_cache_open_read_retries) {
+        open_read_cb = false;
+        do_schedule_in();
+      } else {
+        // The writer did not get far enough in time, HttpSM sees the original write lock failure.
+        Debug("http_cache", "[%" PRId64 "] [state_cache_open_read] read retry after write lock failure gave up after %d tries",
+              master_sm->sm_id, open_read_tries);
+        read_retry_on_write_fail = false;
+        open_write_cb            = true;
+        master_sm->handleEvent(CACHE_EVENT_OPEN_WRITE_FAILED, (void *)-ECACHE_DOC_BUSY);
+      }
+    } else if ((intptr_t)data == -ECACHE_DOC_BUSY) {
       // Somebody else is writing the object
       if (open_read_tries <= master_sm->t_state.txn_conf->max_cache_open_read_retries) {
         // Retry to read; maybe the update finishes in time
@@ -171,7 +189,21 @@ HttpCacheSM::state_cache_open_write(int event, void *data)
     break;
 
   case CACHE_EVENT_OPEN_WRITE_FAILED:
-    if (open_write_tries <= master_sm->t_state.txn_conf->max_cache_open_write_retries) {
+    if (master_sm->t_state.txn_conf->cache_open_write_fail_action == HttpTransact::CACHE_WL_FAIL_ACTION_READ_RETRY &&
+        master_sm->t_state.txn_conf->max_cache_open_read_retries > 0 && !master_sm->t_state.redirect_info.redirect_in_process) {
+      // Another transaction is filling the object, wait for it and read instead of going to the
+      // origin as well. Write retries are skipped and a later open_write of this transaction fails
+      // right away, so a busy object can not loop between reads and writes.
+      Debug("http_cache", "[%" PRId64 "] [state_cache_open_write] cache open write failure %d. retrying as a read...",
+            master_sm->sm_id, open_write_tries);
+      read_retry_on_write_fail = true;
+      open_read_tries          = 0;
+      open_write_tries         = master_sm->t_state.txn_conf->max_cache_open_write_retries + 1;
+      open_write_cb            = false;
+      open_read_cb             = false;
+      SET_HANDLER(&HttpCacheSM::state_cache_open_read);
+      do_schedule_in();
+    } else if (open_write_tries <= master_sm->t_state.txn_conf->max_cache_open_write_retries) {
       // Retry open write;
       open_write_cb = false;
       do_schedule_in();
@@ -342,3 +374,200 @@ HttpCacheSM::open_write(const HttpCacheKey *key, URL *url, HTTPHdr *request, Cac
     return &captive_action;
   }
 }
+
+#if TS_HAS_TESTS
+#include "tscore/TestBox.h"
+
+// A transaction which misses an object and then the write lock of another writer, driving its HttpCacheSM as HttpSM does.
+// The writer holds the lock without writing, or writes the object after a while.
+class HttpCacheSMReadRetryTest : public HttpSM
+{
+public:
+  HttpCacheSMReadRetryTest(RegressionTest *t, int *pstatus, bool fill) : box(t, pstatus), fill(fill)
+  {
+    char url[256];
+
+    init();
+    mutex = new_ProxyMutex();
+    start_sub_sm();
+    t_state.setup_per_txn_configs();
+    t_state.my_txn_conf.cache_open_write_fail_action = HttpTransact::CACHE_WL_FAIL_ACTION_READ_RETRY;
+    t_state.my_txn_conf.max_cache_open_read_retries  = fill ? 20 : MAX_READ_RETRIES;
+    t_state.my_txn_conf.cache_open_read_retry_time   = READ_RETRY_TIME;
+
+    // a new object for every run, the cache is kept across runs
+    snprintf(url, sizeof(url), "http://read-retry.test/%" PRId64 "/%s", Thread::get_hrtime(), fill ? "fill" : "busy");
+    test_hdr(request, HTTP_TYPE_REQUEST, "GET %s HTTP/1.1\r\nHost: read-retry.test\r\n\r\n", url);
+    test_hdr(response, HTTP_TYPE_RESPONSE, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\nCache-Control: max-age=300\r\n\r\n",
+             OBJECT_SIZE);
+    Cache::generate_key(&key, request.url_get());
+    SET_HANDLER(&HttpCacheSMReadRetryTest::test_event);
+  }
+
+  int
+  test_event(int event, void *data)
+  {
+    switch (step) {
+    case START:
+      step = MISS;
+      cache_sm.open_read(&key, request.url_get(), &request, t_state.txn_conf, 0);
+      break;
+
+    case MISS:
+      box.check(event == CACHE_EVENT_OPEN_READ_FAILED, "the object is not in cache, got event %d", event);
+      step = LOCK;
+      cacheProcessor.open_write(this, 0, &key, &request, nullptr);
+      break;
+
+    case LOCK:
+      if (!box.check(event == CACHE_EVENT_OPEN_WRITE, "the writer got the write lock, got event %d", event)) {
+        return finish();
+      }
+      writer = static_cast<CacheVConnection *>(data);
+      step   = RETRY;
+      start  = Thread::get_hrtime_updated();
+      if (fill) {
+        // once the first read gave up waiting for the writer
+        int wait = 2 * (cache_config_read_while_writer_max_retries + 1) * cache_read_while_writer_retry_delay;
+        this_ethread()->schedule_in(this, HRTIME_MSECONDS(wait + 5 * READ_RETRY_TIME));
+      }
+      cache_sm.open_write(&key, request.url_get(), &request, nullptr, 0, false, false);
+      break;
+
+    case RETRY:
+      return retry_event(event, data);
+
+    case DONE:
+      request.destroy();
+      response.destroy();
+      t_state.hdr_info.client_request.destroy();
+      delete this;
+      break;
+    }
+    return EVENT_DONE;
+  }
+
+private:
+  enum { START, MISS, LOCK, RETRY, DONE };
+  static constexpr int MAX_READ_RETRIES = 3;
+  static constexpr int READ_RETRY_TIME  = 20;
+  static constexpr int OBJECT_SIZE      = 1024;
+
+  static void
+  test_hdr(HTTPHdr &hdr, HTTPType type, const char *format, ...) TS_PRINTFLIKE(3, 4)
+  {
+    char text[1024];
+    HTTPParser parser;
+    va_list ap;
+
+    va_start(ap, format);
+    int len = vsnprintf(text, sizeof(text), format, ap);
+    va_end(ap);
+
+    const char *start = text;
+    hdr.create(type);
+    http_parser_init(&parser);
+    if (type == HTTP_TYPE_REQUEST) {
+      hdr.parse_req(&parser, &start, text + len, true);
+    } else {
+      hdr.parse_resp(&parser, &start, text + len, true);
+    }
+    http_parser_clear(&parser);
+  }
+
+  int
+  retry_event(int event, void *data)
+  {
+    ink_hrtime elapsed = Thread::get_hrtime_updated() - start;
+
+    switch (event) {
+    case EVENT_INTERVAL: {
+      // the writer gets the response while the transaction retries its read
+      char body[OBJECT_SIZE];
+      memset(body, 'x', sizeof(body));
+      info.create();
+      info.request_set(&request);
+      info.response_set(&response);
+      writer->set_http_info(&info);
+      buffer = new_MIOBuffer(BUFFER_SIZE_INDEX_4K);
+      buffer->write(body, sizeof(body));
+      writer->do_io_write(this, sizeof(body), buffer->alloc_reader());
+      break;
+    }
+
+    case VC_EVENT_WRITE_READY:
+      static_cast<VIO *>(data)->reenable();
+      break;
+
+    case VC_EVENT_WRITE_COMPLETE:
+      writer->do_io_close();
+      writer = nullptr;
+      free_MIOBuffer(buffer);
+      info.destroy();
+      break;
+
+    case CACHE_EVENT_OPEN_WRITE_FAILED:
+      // the reads ran out of retries, the transaction goes to the origin server uncached
+      box.check(!fill, "the transaction gave up waiting for a writer which wrote its object");
+      box.check(reinterpret_cast<intptr_t>(data) == -ECACHE_DOC_BUSY, "the write lock failure is passed on");
+      box.check(cache_sm.get_open_read_tries() == MAX_READ_RETRIES + 1, "%d reads after the write lock failure, expected %d",
+                cache_sm.get_open_read_tries(), MAX_READ_RETRIES + 1);
+      box.check(elapsed >= HRTIME_MSECONDS(MAX_READ_RETRIES * READ_RETRY_TIME),
+                "the reads are %d ms apart, they took %" PRId64 " ms", READ_RETRY_TIME, ink_hrtime_to_msec(elapsed));
+      return finish();
+
+    case CACHE_EVENT_OPEN_READ:
+      // the transaction is served what the writer wrote
+      box.check(fill, "the transaction read an object which was not written");
+      box.check(writer == nullptr, "the object is read once it is written");
+      box.check(cache_sm.cache_read_vc != nullptr && !cache_sm.read_retry_on_write_fail, "the object is read from cache");
+      box.check(cache_sm.get_open_read_tries() > 1, "the read was retried %d times", cache_sm.get_open_read_tries());
+      cache_sm.close_read();
+      return finish();
+
+    default:
+      box.check(false, "unexpected event %d", event);
+      return finish();
+    }
+    return EVENT_DONE;
+  }
+
+  int
+  finish()
+  {
+    if (writer) {
+      writer->do_io_close(1);
+      writer = nullptr;
+    }
+    if (*box._status == REGRESSION_TEST_INPROGRESS) {
+      box = REGRESSION_TEST_PASSED;
+    }
+    step = DONE;
+    this_ethread()->schedule_imm(this);
+    return EVENT_DONE;
+  }
+
+  TestBox box;
+  bool fill;
+  int step = START;
+  HttpCacheKey key;
+  HTTPHdr request;
+  HTTPHdr response;
+  CacheHTTPInfo info;
+  CacheVConnection *writer = nullptr;
+  MIOBuffer *buffer        = nullptr;
+  ink_hrtime start         = 0;
+};
+
+REGRESSION_TEST(HttpCacheSM_read_retry_give_up)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  *pstatus = REGRESSION_TEST_INPROGRESS;
+  eventProcessor.schedule_imm(new HttpCacheSMReadRetryTest(t, pstatus, false), ET_NET);
+}
+
+REGRESSION_TEST(HttpCacheSM_read_retry_fill)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  *pstatus = REGRESSION_TEST_INPROGRESS;
+  eventProcessor.schedule_imm(new HttpCacheSMReadRetryTest(t, pstatus, true), ET_NET);
+}
+#endif
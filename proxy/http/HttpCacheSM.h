@@ -75,6 +75,8 @@ public:
 
   bool read_locked  = false;
   bool write_locked = false;
+  // The write lock is held by another transaction, waiting to read what it writes
+  bool read_retry_on_write_fail = false;
   // Flag to check whether read-while-write is in progress or not
   bool readwhilewrite_inprogress = false;
 
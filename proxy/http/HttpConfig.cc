@@ -518,6 +518,15 @@ register_stat_callbacks()
   RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.cache_read_error", RECD_COUNTER, RECP_PERSISTENT,
                      (int)http_cache_read_error_stat, RecRawStatSyncCount);
 
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.cache_collapsed_requests", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_cache_collapsed_requests_stat, RecRawStatSyncCount);
+
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.fanout_collapsed_requests", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_fanout_collapsed_requests_stat, RecRawStatSyncCount);
+
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.fanout_released_requests", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_fanout_released_requests_stat, RecRawStatSyncCount);
+
   /////////////////////////////////////////
   // Bandwidth Savings Transaction Stats //
   /////////////////////////////////////////
@@ -1151,6 +1160,10 @@ HttpConfig::startup()
 
   HttpEstablishStaticConfigByte(c.oride.cache_open_write_fail_action, "proxy.config.http.cache.open_write_fail_action");
 
+  HttpEstablishStaticConfigByte(c.fanout_enabled, "proxy.config.http.fanout.enabled");
+  HttpEstablishStaticConfigStringAlloc(c.fanout_vary_headers, "proxy.config.http.fanout.vary_headers");
+  HttpEstablishStaticConfigByte(c.fanout_share_private, "proxy.config.http.fanout.share_private");
+
   HttpEstablishStaticConfigByte(c.oride.cache_when_to_revalidate, "proxy.config.http.cache.when_to_revalidate");
   HttpEstablishStaticConfigByte(c.oride.cache_required_headers, "proxy.config.http.cache.required_headers");
   HttpEstablishStaticConfigByte(c.oride.cache_range_lookup, "proxy.config.http.cache.range.lookup");
@@ -1430,6 +1443,10 @@ HttpConfig::reconfigure()
 
   params->oride.cache_open_write_fail_action = m_master.oride.cache_open_write_fail_action;
 
+  params->fanout_enabled       = INT_TO_BOOL(m_master.fanout_enabled);
+  params->fanout_vary_headers  = ats_strdup(m_master.fanout_vary_headers);
+  params->fanout_share_private = INT_TO_BOOL(m_master.fanout_share_private);
+
   params->oride.cache_when_to_revalidate = m_master.oride.cache_when_to_revalidate;
   params->max_post_size                  = m_master.max_post_size;
 
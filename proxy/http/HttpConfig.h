@@ -187,6 +187,9 @@ enum {
   http_cache_miss_uncacheable_stat,
   http_cache_miss_ims_stat,
   http_cache_read_error_stat,
+  http_cache_collapsed_requests_stat,
+  http_fanout_collapsed_requests_stat,
+  http_fanout_released_requests_stat,
 
   // bandwidth savings stats
   http_tcp_hit_count_stat,
@@ -739,6 +742,8 @@ public:
   IpMap *redirect_actions_map                          = nullptr;
   RedirectEnabled::Action redirect_actions_self_action = RedirectEnabled::Action::INVALID;
 
+  char *fanout_vary_headers = nullptr;
+
   ///////////////////////////////////////////////////////////////////
   // Put all MgmtByte members down here, avoids additional padding //
   ///////////////////////////////////////////////////////////////////
@@ -774,6 +779,9 @@ public:
 
   MgmtByte server_session_sharing_pool = TS_SERVER_SESSION_SHARING_POOL_THREAD;
 
+  MgmtByte fanout_enabled       = 0;
+  MgmtByte fanout_share_private = 0;
+
   OutboundConnTrack::GlobalConfig outbound_conntrack;
 
   // bitset to hold the status codes that will BE cached with negative caching enabled
@@ -844,6 +852,7 @@ inline HttpConfigParams::~HttpConfigParams()
   ats_free(reverse_proxy_no_host_redirect);
   ats_free(redirect_actions_string);
   ats_free(oride.ssl_client_sni_policy);
+  ats_free(fanout_vary_headers);
 
   delete connect_ports;
   delete redirect_actions_map;
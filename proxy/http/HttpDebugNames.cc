@@ -221,6 +221,14 @@ HttpDebugNames::get_event_name(int event)
   case HTTP_TUNNEL_EVENT_CONSUMER_DETACH:
     return "HTTP_TUNNEL_EVENT_CONSUMER_DETACH";
 
+  /////////////////////////
+  //  HttpFanout Events  //
+  /////////////////////////
+  case HTTP_FANOUT_EVENT_SHARED:
+    return "HTTP_FANOUT_EVENT_SHARED";
+  case HTTP_FANOUT_EVENT_RELEASED:
+    return "HTTP_FANOUT_EVENT_RELEASED";
+
   /////////////////////////////
   //  Plugin Events
   /////////////////////////////
@@ -0,0 +1,619 @@
+/** @file
+
+  Fan one origin response out to the transactions waiting for the same one.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "HttpFanout.h"
+#include "HttpCompat.h"
+
+namespace
+{
+// The fan-outs whose leader waits for the response header. The table is
+// locked before the mutex of a fan-out, never the other way around.
+struct FanoutTable {
+  Ptr<ProxyMutex> mutex{new_ProxyMutex()};
+  IntrusiveHashMap<HttpFanout::Linkage> map{1023};
+};
+
+FanoutTable &
+fanout_table()
+{
+  static FanoutTable table;
+  return table;
+}
+} // namespace
+
+////
+// HttpFanout
+//
+HttpFanout::HttpFanout(CryptoHash const &akey, HTTPHdr *arequest) : key(akey), mutex(new_ProxyMutex())
+{
+  request.create(HTTP_TYPE_REQUEST);
+  request.copy(arequest);
+}
+
+HttpFanout::~HttpFanout()
+{
+  ink_assert(followers.empty());
+  request.destroy();
+  response.destroy();
+}
+
+void
+HttpFanout::make_key(CryptoHash &key, CryptoHash const &cache_key, HTTPHdr *request, const char *vary_headers)
+{
+  CryptoContext ctx;
+
+  ctx.update(&cache_key, sizeof(cache_key));
+  if (vary_headers && *vary_headers) {
+    StrList names(false);
+
+    HttpCompat::parse_comma_list(&names, vary_headers);
+    for (Str *name = names.head; name; name = name->next) {
+      ctx.update(name->str, name->len);
+      ctx.update(":", 1);
+      for (MIMEField *field = request->field_find(name->str, name->len); field; field = field->m_next_dup) {
+        int len;
+        const char *value = field->value_get(&len);
+        ctx.update(value, len);
+        ctx.update(",", 1);
+      }
+      ctx.update("\n", 1);
+    }
+  }
+  ctx.finalize(key);
+}
+
+Ptr<HttpFanout>
+HttpFanout::join(CryptoHash const &key, HTTPHdr *request, Continuation *cont, bool may_follow, HttpFanoutReadVC *&follower)
+{
+  FanoutTable &table = fanout_table();
+  EThread *thread    = this_ethread();
+  SCOPED_MUTEX_LOCK(lock, table.mutex, thread);
+
+  follower  = nullptr;
+  auto spot = table.map.find(key);
+  if (spot == table.map.end()) {
+    Ptr<HttpFanout> fanout = make_ptr(new HttpFanout(key, request));
+    table.map.insert(fanout.get());
+    return fanout;
+  }
+  if (!may_follow) {
+    return Ptr<HttpFanout>();
+  }
+
+  Ptr<HttpFanout> fanout = make_ptr(&*spot);
+  SCOPED_MUTEX_LOCK(fanout_lock, fanout->mutex, thread);
+
+  ink_assert(fanout->state == WAITING);
+  follower = new HttpFanoutReadVC(fanout.get(), cont);
+  fanout->followers.push(follower);
+  return fanout;
+}
+
+// Called with the table locked
+void
+HttpFanout::unlink()
+{
+  fanout_table().map.erase(this);
+}
+
+HttpFanoutWriteVC *
+HttpFanout::share(HTTPHdr *aresponse, ink_time_t sent_time, ink_time_t received_time, int64_t cl, bool trust_cl,
+                  Ptr<ProxyMutex> &leader_mutex)
+{
+  EThread *thread = this_ethread();
+  SCOPED_MUTEX_LOCK(table_lock, fanout_table().mutex, thread);
+  SCOPED_MUTEX_LOCK(lock, mutex, thread);
+
+  if (state != WAITING) {
+    return nullptr;
+  }
+  unlink();
+
+  // Nobody can join any more, there is nothing to share if nobody has
+  if (followers.empty()) {
+    state = RELEASED;
+    return nullptr;
+  }
+
+  response.create(HTTP_TYPE_RESPONSE);
+  response.copy(aresponse);
+  request_sent_time      = sent_time;
+  response_received_time = received_time;
+  content_length         = cl;
+  trust_content_length   = trust_cl;
+  state                  = SHARING;
+
+  for (HttpFanoutReadVC *vc = followers.head; vc; vc = vc->link.next) {
+    vc->schedule();
+  }
+
+  return new HttpFanoutWriteVC(this, leader_mutex);
+}
+
+void
+HttpFanout::release()
+{
+  EThread *thread = this_ethread();
+  SCOPED_MUTEX_LOCK(table_lock, fanout_table().mutex, thread);
+  SCOPED_MUTEX_LOCK(lock, mutex, thread);
+
+  if (state != WAITING) {
+    return;
+  }
+  unlink();
+  state = RELEASED;
+
+  for (HttpFanoutReadVC *vc = followers.head; vc; vc = vc->link.next) {
+    vc->schedule();
+  }
+}
+
+bool
+HttpFanout::has_followers()
+{
+  SCOPED_MUTEX_LOCK(lock, mutex, this_ethread());
+  return !followers.empty();
+}
+
+// Called with the fan-out locked
+void
+HttpFanout::append(IOBufferChain const &chain)
+{
+  for (HttpFanoutReadVC *vc = followers.head; vc; vc = vc->link.next) {
+    // Every follower gets its own blocks, the data is shared
+    vc->pending.write(const_cast<IOBufferBlock *>(chain.head()), chain.length());
+    vc->schedule();
+  }
+}
+
+// Called with the fan-out locked
+void
+HttpFanout::finish(bool success)
+{
+  body_done  = true;
+  body_error = !success;
+
+  for (HttpFanoutReadVC *vc = followers.head; vc; vc = vc->link.next) {
+    vc->schedule();
+  }
+}
+
+////
+// HttpFanoutWriteVC
+//
+HttpFanoutWriteVC::HttpFanoutWriteVC(HttpFanout *afanout, Ptr<ProxyMutex> &amutex) : VConnection(amutex), fanout(afanout)
+{
+  SET_HANDLER(&HttpFanoutWriteVC::state_main);
+}
+
+VIO *
+HttpFanoutWriteVC::do_io_read(Continuation * /* c ATS_UNUSED */, int64_t /* nbytes ATS_UNUSED */, MIOBuffer * /* buf ATS_UNUSED */)
+{
+  ink_release_assert(!"HttpFanoutWriteVC::do_io_read not supported");
+  return nullptr;
+}
+
+VIO *
+HttpFanoutWriteVC::do_io_write(Continuation *c, int64_t nbytes, IOBufferReader *buf, bool owner)
+{
+  ink_assert(!owner);
+
+  write_vio.buffer.reader_for(buf);
+  write_vio.mutex     = c ? c->mutex : this->mutex;
+  write_vio.cont      = c;
+  write_vio.nbytes    = nbytes;
+  write_vio.ndone     = 0;
+  write_vio.vc_server = this;
+  write_vio.op        = VIO::WRITE;
+
+  write_to_followers();
+  return &write_vio;
+}
+
+void
+HttpFanoutWriteVC::reenable(VIO *vio)
+{
+  ink_assert(vio == &write_vio);
+  write_to_followers();
+}
+
+void
+HttpFanoutWriteVC::do_io_shutdown(ShutdownHowTo_t /* howto ATS_UNUSED */)
+{
+}
+
+void
+HttpFanoutWriteVC::do_io_close(int lerrno)
+{
+  if (complete_event) {
+    complete_event->cancel();
+    complete_event = nullptr;
+  }
+
+  {
+    SCOPED_MUTEX_LOCK(lock, fanout->mutex, this_ethread());
+    fanout->finish(lerrno == -1 && write_vio.ntodo() == 0);
+  }
+
+  delete this;
+}
+
+// Take everything the tunnel has for the followers. Only the IOBufferBlocks
+// are cloned, the blocks keep the data of the tunnel buffer alive until the
+// last follower has sent it.
+void
+HttpFanoutWriteVC::write_to_followers()
+{
+  IOBufferReader *reader = write_vio.get_reader();
+
+  if (write_vio.op != VIO::WRITE || reader == nullptr) {
+    return;
+  }
+
+  int64_t n = std::min(reader->read_avail(), write_vio.ntodo());
+  if (n > 0) {
+    IOBufferChain chain;
+
+    chain.write(reader->get_current_block(), n, reader->start_offset);
+    reader->consume(n);
+    write_vio.ndone += n;
+
+    SCOPED_MUTEX_LOCK(lock, fanout->mutex, this_ethread());
+    fanout->append(chain);
+  }
+
+  // The tunnel must not be called back from the stack of a reenable
+  if (write_vio.ntodo() == 0 && complete_event == nullptr) {
+    complete_event = this_ethread()->schedule_imm(this);
+  }
+}
+
+int
+HttpFanoutWriteVC::state_main(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
+{
+  complete_event = nullptr;
+  write_vio.cont->handleEvent(VC_EVENT_WRITE_COMPLETE, &write_vio);
+  return EVENT_DONE;
+}
+
+////
+// HttpFanoutReadVC
+//
+HttpFanoutReadVC::HttpFanoutReadVC(HttpFanout *afanout, Continuation *cont)
+  : VConnection(cont->mutex), fanout(afanout), sm_cont(cont), thread(this_ethread())
+{
+  SET_HANDLER(&HttpFanoutReadVC::state_main);
+}
+
+// Called with the fan-out locked
+void
+HttpFanoutReadVC::schedule()
+{
+  if (signal_event == nullptr) {
+    signal_event = thread->schedule_imm(this);
+  }
+}
+
+VIO *
+HttpFanoutReadVC::do_io_read(Continuation *c, int64_t nbytes, MIOBuffer *buf)
+{
+  read_vio.buffer.writer_for(buf);
+  read_vio.mutex     = c ? c->mutex : this->mutex;
+  read_vio.cont      = c;
+  read_vio.nbytes    = nbytes;
+  read_vio.ndone     = 0;
+  read_vio.vc_server = this;
+  read_vio.op        = VIO::READ;
+
+  SCOPED_MUTEX_LOCK(lock, fanout->mutex, this_ethread());
+  schedule();
+  return &read_vio;
+}
+
+VIO *
+HttpFanoutReadVC::do_io_write(Continuation * /* c ATS_UNUSED */, int64_t /* nbytes ATS_UNUSED */,
+                              IOBufferReader * /* buf ATS_UNUSED */, bool /* owner ATS_UNUSED */)
+{
+  ink_release_assert(!"HttpFanoutReadVC::do_io_write not supported");
+  return nullptr;
+}
+
+void
+HttpFanoutReadVC::reenable(VIO *vio)
+{
+  ink_assert(vio == &read_vio);
+
+  SCOPED_MUTEX_LOCK(lock, fanout->mutex, this_ethread());
+  schedule();
+}
+
+void
+HttpFanoutReadVC::do_io_shutdown(ShutdownHowTo_t /* howto ATS_UNUSED */)
+{
+}
+
+void
+HttpFanoutReadVC::do_io_close(int /* lerrno ATS_UNUSED */)
+{
+  {
+    SCOPED_MUTEX_LOCK(lock, fanout->mutex, this_ethread());
+    fanout->followers.remove(this);
+    // The event needs our mutex to run, so it has not started
+    if (signal_event) {
+      signal_event->cancel();
+      signal_event = nullptr;
+    }
+    pending.clear();
+  }
+
+  delete this;
+}
+
+int
+HttpFanoutReadVC::state_main(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
+{
+  HttpFanout::State state;
+  int64_t n = 0;
+  bool done = false, error = false;
+
+  {
+    SCOPED_MUTEX_LOCK(lock, fanout->mutex, this_ethread());
+    signal_event = nullptr;
+    state        = fanout->state;
+
+    if (read_vio.op == VIO::READ && !read_done) {
+      MIOBuffer *buf = read_vio.get_writer();
+
+      // Hand the blocks over only when the consumers are ready for them, the
+      // clones are not copied into the buffer.
+      n = std::min(pending.length(), read_vio.ntodo());
+      if (n > 0 && !buf->high_water()) {
+        buf->write(&pending, n);
+        pending.consume(n);
+        read_vio.ndone += n;
+      } else {
+        n = 0;
+      }
+      done  = fanout->body_done && pending.length() == 0;
+      error = fanout->body_error;
+    }
+  }
+
+  if (read_vio.op != VIO::READ) {
+    if (state != HttpFanout::WAITING && !notified) {
+      notified = true;
+      sm_cont->handleEvent(state == HttpFanout::SHARING ? HTTP_FANOUT_EVENT_SHARED : HTTP_FANOUT_EVENT_RELEASED, this);
+    }
+    return EVENT_DONE;
+  }
+  if (read_done) {
+    return EVENT_DONE;
+  }
+
+  int event;
+  if (read_vio.ntodo() == 0) {
+    event = VC_EVENT_READ_COMPLETE;
+  } else if (done) {
+    // A body of unknown length ends with the one of the leader, one of known
+    // length which ends short of it was cut off.
+    event = (error || read_vio.nbytes != INT64_MAX) ? VC_EVENT_ERROR : VC_EVENT_EOS;
+  } else if (n > 0) {
+    event = VC_EVENT_READ_READY;
+  } else {
+    return EVENT_DONE;
+  }
+
+  read_done = event != VC_EVENT_READ_READY;
+  // The continuation may close us
+  read_vio.cont->handleEvent(event, &read_vio);
+  return EVENT_DONE;
+}
+
+#if TS_HAS_TESTS
+#include "tscore/TestBox.h"
+#include "P_Cache.h"
+#include "P_Net.h"
+
+// A leader which shares its response with two followers, and one which
+// releases its follower.
+class HttpFanoutTest : public Continuation
+{
+public:
+  HttpFanoutTest(RegressionTest *t, int *pstatus) : Continuation(new_ProxyMutex()), box(t, pstatus)
+  {
+    char url[256];
+
+    // a new key for every run
+    snprintf(url, sizeof(url), "http://fanout.test/%" PRId64, Thread::get_hrtime());
+    for (int i = 0; i < 3; ++i) {
+      test_hdr(request[i], HTTP_TYPE_REQUEST, "GET %s HTTP/1.1\r\nHost: fanout.test\r\nX-Tenant: %s\r\n\r\n", url,
+               i == 1 ? "b" : "a");
+    }
+    test_hdr(response, HTTP_TYPE_RESPONSE, "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n", BODY_SIZE);
+    SET_HANDLER(&HttpFanoutTest::test_event);
+  }
+
+  int
+  test_event(int event, void *data)
+  {
+    switch (event) {
+    case EVENT_IMMEDIATE:
+      return start();
+
+    case HTTP_FANOUT_EVENT_SHARED: {
+      HttpFanoutReadVC *vc = static_cast<HttpFanoutReadVC *>(data);
+      int i                = vc == followers[0].vc ? 0 : 1;
+
+      box.check(vc->fanout->response.status_get() == HTTP_STATUS_OK, "the followers get the response of the leader");
+      followers[i].buffer             = new_MIOBuffer(BUFFER_SIZE_INDEX_4K);
+      followers[i].buffer->water_mark = BODY_SIZE;
+      followers[i].reader             = followers[i].buffer->alloc_reader();
+      followers[i].vio                = vc->do_io_read(this, BODY_SIZE, followers[i].buffer);
+      break;
+    }
+
+    case HTTP_FANOUT_EVENT_RELEASED:
+      box.check(data == released, "the follower of the leader which released it goes to the origin server");
+      released->do_io_close();
+      released = nullptr;
+      break;
+
+    case VC_EVENT_READ_READY:
+      break;
+
+    case VC_EVENT_READ_COMPLETE: {
+      int i = data == followers[0].vio ? 0 : 1;
+      char body[BODY_SIZE];
+
+      box.check(followers[i].reader->read_avail() == BODY_SIZE, "follower %d read %" PRId64 " bytes, expected %d", i,
+                followers[i].reader->read_avail(), BODY_SIZE);
+      followers[i].reader->read(body, sizeof(body));
+      box.check(memcmp(body, expected, sizeof(body)) == 0, "follower %d read the body of the leader", i);
+      followers[i].vc->do_io_close();
+      free_MIOBuffer(followers[i].buffer);
+      followers[i].vc = nullptr;
+      break;
+    }
+
+    case VC_EVENT_WRITE_COMPLETE:
+      writer->do_io_close();
+      writer = nullptr;
+      free_MIOBuffer(buffer);
+      break;
+
+    default:
+      box.check(false, "unexpected event %d", event);
+      return finish();
+    }
+
+    if (!writer && !released && !followers[0].vc && !followers[1].vc) {
+      return finish();
+    }
+    return EVENT_DONE;
+  }
+
+private:
+  static constexpr int BODY_SIZE = 10000;
+
+  struct Follower {
+    HttpFanoutReadVC *vc   = nullptr;
+    MIOBuffer *buffer      = nullptr;
+    IOBufferReader *reader = nullptr;
+    VIO *vio               = nullptr;
+  };
+
+  static void
+  test_hdr(HTTPHdr &hdr, HTTPType type, const char *format, ...) TS_PRINTFLIKE(3, 4)
+  {
+    char text[1024];
+    HTTPParser parser;
+    va_list ap;
+
+    va_start(ap, format);
+    int len = vsnprintf(text, sizeof(text), format, ap);
+    va_end(ap);
+
+    const char *start = text;
+    hdr.create(type);
+    http_parser_init(&parser);
+    if (type == HTTP_TYPE_REQUEST) {
+      hdr.parse_req(&parser, &start, text + len, true);
+    } else {
+      hdr.parse_resp(&parser, &start, text + len, true);
+    }
+    http_parser_clear(&parser);
+  }
+
+  int
+  start()
+  {
+    HttpCacheKey cache_key;
+    CryptoHash key[3];
+    HttpFanoutReadVC *follower = nullptr;
+
+    Cache::generate_key(&cache_key, request[0].url_get());
+    for (int i = 0; i < 3; ++i) {
+      HttpFanout::make_key(key[i], cache_key.hash, &request[i], "X-Tenant");
+    }
+    box.check(key[0] == key[2], "the same values of the vary headers make the same key");
+    box.check(key[0] != key[1], "other values of the vary headers make another key");
+
+    Ptr<HttpFanout> leader = HttpFanout::join(key[0], &request[0], this, true, follower);
+    box.check(leader && follower == nullptr, "the first transaction leads");
+    box.check(!HttpFanout::join(key[0], &request[2], this, false, follower), "a transaction which may not follow does not join");
+    for (auto &f : followers) {
+      box.check(HttpFanout::join(key[0], &request[2], this, true, f.vc) == leader && f.vc, "the next transactions follow");
+    }
+
+    Ptr<HttpFanout> other = HttpFanout::join(key[1], &request[1], this, true, follower);
+    HttpFanout::join(key[1], &request[1], this, true, released);
+    other->release();
+
+    writer = leader->share(&response, 1, 2, BODY_SIZE, true, mutex);
+    if (!box.check(writer != nullptr, "the leader shares its response")) {
+      return finish();
+    }
+    Ptr<HttpFanout> again = HttpFanout::join(key[0], &request[2], this, true, follower);
+    box.check(again != leader && follower == nullptr, "nobody follows once the response is shared");
+    again->release();
+
+    for (int i = 0; i < BODY_SIZE; ++i) {
+      expected[i] = 'a' + i % 26;
+    }
+    buffer                 = new_MIOBuffer(BUFFER_SIZE_INDEX_4K);
+    IOBufferReader *reader = buffer->alloc_reader();
+    buffer->write(expected, sizeof(expected));
+    writer->do_io_write(this, BODY_SIZE, reader);
+    return EVENT_DONE;
+  }
+
+  int
+  finish()
+  {
+    if (*box._status == REGRESSION_TEST_INPROGRESS) {
+      box = REGRESSION_TEST_PASSED;
+    }
+    for (auto &r : request) {
+      r.destroy();
+    }
+    response.destroy();
+    delete this;
+    return EVENT_DONE;
+  }
+
+  TestBox box;
+  HTTPHdr request[3];
+  HTTPHdr response;
+  Follower followers[2];
+  HttpFanoutReadVC *released = nullptr;
+  HttpFanoutWriteVC *writer  = nullptr;
+  MIOBuffer *buffer          = nullptr;
+  char expected[BODY_SIZE];
+};
+
+REGRESSION_TEST(HttpFanout_share)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  *pstatus = REGRESSION_TEST_INPROGRESS;
+  eventProcessor.schedule_imm(new HttpFanoutTest(t, pstatus), ET_NET);
+}
+#endif
@@ -0,0 +1,220 @@
+/** @file
+
+  Fan one origin response out to the transactions waiting for the same one.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+/****************************************************************************
+
+   HttpFanout.h
+
+   Description:
+
+   The first transaction which goes to the origin server for a key becomes
+   the leader of the key, the transactions which go to the origin server for
+   the same key while the leader waits for the response header follow it.
+   The key is the cache key of the request and the values of the request
+   headers in proxy.config.http.fanout.vary_headers.
+
+   When the leader has the response header and the response can be shared,
+   the header is copied to the followers and the leader adds a fan-out
+   consumer to its tunnel. The consumer clones the blocks of the body the
+   leader reads, each follower reads the clones through its own
+   HttpFanoutReadVC on its own thread. The body is not copied, the followers
+   hold references to the data blocks of the leader.
+
+   If the leader does not get a response it can share, the followers are
+   released and go to the origin server themselves.
+
+ ****************************************************************************/
+
+#pragma once
+
+#include "P_EventSystem.h"
+#include "HTTP.h"
+#include "tscore/CryptoHash.h"
+#include "tscore/IntrusiveHashMap.h"
+#include "tscore/List.h"
+
+class HttpFanout;
+
+// Sent to the continuation of a follower before it reads the body
+#define HTTP_FANOUT_EVENT_SHARED (HTTP_FANOUT_EVENTS_START + 1)
+#define HTTP_FANOUT_EVENT_RELEASED (HTTP_FANOUT_EVENTS_START + 2)
+
+/** The body of the leader for one follower.
+
+    The VC runs on the thread and under the mutex of the follower. Until the
+    follower reads from it, it only tells the follower whether the response
+    was shared (HTTP_FANOUT_EVENT_SHARED) or not (HTTP_FANOUT_EVENT_RELEASED).
+ */
+class HttpFanoutReadVC : public VConnection
+{
+public:
+  HttpFanoutReadVC(HttpFanout *fanout, Continuation *cont);
+
+  VIO *do_io_read(Continuation *c, int64_t nbytes, MIOBuffer *buf) override;
+  VIO *do_io_write(Continuation *c, int64_t nbytes, IOBufferReader *buf, bool owner = false) override;
+  void do_io_close(int lerrno = -1) override;
+  void do_io_shutdown(ShutdownHowTo_t howto) override;
+  void reenable(VIO *vio) override;
+
+  Ptr<HttpFanout> fanout;
+
+private:
+  int state_main(int event, void *data);
+  void schedule();
+
+  friend class HttpFanout;
+
+  Continuation *sm_cont = nullptr;
+  EThread *thread       = nullptr;
+  VIO read_vio;
+  bool notified  = false;
+  bool read_done = false;
+
+  // Guarded by the mutex of the fan-out
+  Event *signal_event = nullptr;
+  IOBufferChain pending;
+  LINK(HttpFanoutReadVC, link);
+};
+
+/** The fan-out consumer in the tunnel of the leader.
+
+    The VC consumes what the tunnel gives it as soon as it gets it and passes
+    it on to the followers, it never holds the tunnel back.
+ */
+class HttpFanoutWriteVC : public VConnection
+{
+public:
+  HttpFanoutWriteVC(HttpFanout *fanout, Ptr<ProxyMutex> &amutex);
+
+  VIO *do_io_read(Continuation *c, int64_t nbytes, MIOBuffer *buf) override;
+  VIO *do_io_write(Continuation *c, int64_t nbytes, IOBufferReader *buf, bool owner = false) override;
+  void do_io_close(int lerrno = -1) override;
+  void do_io_shutdown(ShutdownHowTo_t howto) override;
+  void reenable(VIO *vio) override;
+
+private:
+  int state_main(int event, void *data);
+  void write_to_followers();
+
+  Ptr<HttpFanout> fanout;
+  VIO write_vio;
+  Event *complete_event = nullptr;
+};
+
+class HttpFanout : public RefCountObj
+{
+public:
+  enum State { WAITING, SHARING, RELEASED };
+
+  /** Make the fan-out key of @a request.
+
+      @a cache_key is the cache key of the request, @a vary_headers the comma
+      separated names of the request headers whose values are part of the key.
+   */
+  static void make_key(CryptoHash &key, CryptoHash const &cache_key, HTTPHdr *request, const char *vary_headers);
+
+  /** Join the fan-out of @a key.
+
+      If nobody waits for a response for @a key, a new fan-out is returned and
+      the caller leads it, @a follower is @c nullptr. Otherwise the caller
+      follows the leader through @a follower, which signals @a cont. If the
+      caller may not follow, it does not join and @c nullptr is returned.
+   */
+  static Ptr<HttpFanout> join(CryptoHash const &key, HTTPHdr *request, Continuation *cont, bool may_follow,
+                              HttpFanoutReadVC *&follower);
+
+  /// Share @a response with the followers, the body goes through the VC returned.
+  HttpFanoutWriteVC *share(HTTPHdr *response, ink_time_t request_sent_time, ink_time_t response_received_time,
+                           int64_t content_length, bool trust_content_length, Ptr<ProxyMutex> &leader_mutex);
+  /// Send the followers to the origin server, if the response was not shared.
+  void release();
+  bool has_followers();
+
+  HttpFanout(CryptoHash const &key, HTTPHdr *request);
+  ~HttpFanout() override;
+
+  CryptoHash key;
+  Ptr<ProxyMutex> mutex;
+  State state = WAITING;
+
+  // Set before the fan-out is visible to the followers, read only afterwards
+  HTTPHdr request;
+  HTTPHdr response;
+  ink_time_t request_sent_time      = 0;
+  ink_time_t response_received_time = 0;
+  int64_t content_length            = -1;
+  bool trust_content_length         = false;
+
+  struct Linkage {
+    HttpFanout *_next = nullptr;
+    HttpFanout *_prev = nullptr;
+
+    static HttpFanout *&next_ptr(HttpFanout *fanout);
+    static HttpFanout *&prev_ptr(HttpFanout *fanout);
+    static uint64_t hash_of(CryptoHash const &key);
+    static CryptoHash const &key_of(HttpFanout *fanout);
+    static bool equal(CryptoHash const &lhs, CryptoHash const &rhs);
+  } _link;
+
+private:
+  friend class HttpFanoutReadVC;
+  friend class HttpFanoutWriteVC;
+
+  void unlink();
+  void append(IOBufferChain const &chain);
+  void finish(bool success);
+
+  DLL<HttpFanoutReadVC> followers;
+  bool body_done  = false;
+  bool body_error = false;
+};
+
+inline HttpFanout *&
+HttpFanout::Linkage::next_ptr(HttpFanout *fanout)
+{
+  return fanout->_link._next;
+}
+
+inline HttpFanout *&
+HttpFanout::Linkage::prev_ptr(HttpFanout *fanout)
+{
+  return fanout->_link._prev;
+}
+
+inline uint64_t
+HttpFanout::Linkage::hash_of(CryptoHash const &key)
+{
+  return key.fold();
+}
+
+inline CryptoHash const &
+HttpFanout::Linkage::key_of(HttpFanout *fanout)
+{
+  return fanout->key;
+}
+
+inline bool
+HttpFanout::Linkage::equal(CryptoHash const &lhs, CryptoHash const &rhs)
+{
+  return lhs == rhs;
+}
@@ -1653,8 +1653,9 @@ HttpSM::handle_api_return()
 
       setup_blind_tunnel(true, initial_data);
     } else {
-      HttpTunnelProducer *p = setup_server_transfer();
+      HttpTunnelProducer *p = fanout_vc ? setup_fanout_read_transfer() : setup_server_transfer();
       perform_cache_write_action();
+      setup_fanout_write_transfer(client_response_hdr_bytes);
       tunnel.tunnel_run(p);
     }
     break;
@@ -2419,7 +2420,9 @@ HttpSM::state_cache_open_write(int event, void *data)
       t_state.cache_info.write_lock_state  = HttpTransact::CACHE_WL_FAIL;
       break;
     }
-    if (t_state.txn_conf->cache_open_write_fail_action == HttpTransact::CACHE_WL_FAIL_ACTION_DEFAULT) {
+    if (t_state.txn_conf->cache_open_write_fail_action == HttpTransact::CACHE_WL_FAIL_ACTION_DEFAULT ||
+        t_state.txn_conf->cache_open_write_fail_action == HttpTransact::CACHE_WL_FAIL_ACTION_READ_RETRY) {
+      // For READ_RETRY the cache SM already waited for the other writer without success.
       t_state.cache_info.write_lock_state = HttpTransact::CACHE_WL_FAIL;
       break;
     } else {
@@ -3136,6 +3139,11 @@ HttpSM::is_bg_fill_necessary(HttpTunnelConsumer *c)
         return false;
       }
     }
+    // The followers of our fan-out read what we read
+    if (fanout && fanout->state == HttpFanout::SHARING && c->producer->vc_type == HT_HTTP_SERVER && fanout->has_followers()) {
+      return true;
+    }
+
     // If threshold is 0.0 or negative then do background
     //   fill regardless of the content length.  Since this
     //   is floating point just make sure the number is near zero
@@ -3378,6 +3386,62 @@ HttpSM::tunnel_handler_cache_read(int event, HttpTunnelProducer *p)
   return 0;
 }
 
+int
+HttpSM::tunnel_handler_fanout_read(int event, HttpTunnelProducer *p)
+{
+  STATE_ENTER(&HttpSM::tunnel_handler_fanout_read, event);
+
+  switch (event) {
+  case VC_EVENT_ERROR:
+    // The leader did not get the whole body either
+    p->vc->do_io_close(EHTTP_ERROR);
+    p->read_vio = nullptr;
+    tunnel.chain_abort_all(p);
+    break;
+  case VC_EVENT_EOS:
+    // The body of unknown length ended with the one of the leader
+    tunnel.local_finish_all(p);
+    // fallthrough
+
+  case VC_EVENT_READ_COMPLETE:
+  case HTTP_TUNNEL_EVENT_PRECOMPLETE:
+  case HTTP_TUNNEL_EVENT_CONSUMER_DETACH:
+    p->read_success = true;
+    p->vc->do_io_close();
+    p->read_vio = nullptr;
+    break;
+  default:
+    ink_release_assert(0);
+    break;
+  }
+
+  return 0;
+}
+
+int
+HttpSM::tunnel_handler_fanout_write(int event, HttpTunnelConsumer *c)
+{
+  STATE_ENTER(&HttpSM::tunnel_handler_fanout_write, event);
+
+  switch (event) {
+  case VC_EVENT_ERROR:
+  case VC_EVENT_EOS:
+    // Abnormal termination, the followers see the error
+    c->vc->do_io_close(EHTTP_ERROR);
+    break;
+  case VC_EVENT_WRITE_COMPLETE:
+    c->write_success = true;
+    c->vc->do_io_close();
+    break;
+  default:
+    ink_release_assert(0);
+    break;
+  }
+
+  c->write_vio = nullptr;
+  return 0;
+}
+
 int
 HttpSM::tunnel_handler_cache_write(int event, HttpTunnelConsumer *c)
 {
@@ -4253,6 +4317,10 @@ HttpSM::parse_range_and_compare(MIMEField *field, int64_t content_length)
   // assume range_in_cache
   t_state.range_in_cache = true;
 
+  // a sparse object holds only some chunks of the object
+  HTTPChunkMap chunks;
+  bool sparse = chunks.load(t_state.cache_info.object_read->response_get(), content_length);
+
   for (; value; value = csv.get_next(&value_len)) {
     if (!(tmp = (const char *)memchr(value, '-', value_len))) {
       t_state.range_setup = HttpTransact::RANGE_NONE;
@@ -4374,6 +4442,14 @@ HttpSM::parse_range_and_compare(MIMEField *field, int64_t content_length)
         t_state.range_in_cache = false;
       }
     }
+    if (sparse && !chunks.covers(start, end)) {
+      Debug("http_range", "request range %" PRId64 "-%" PRId64 " not in the sparse object", start, end);
+      t_state.range_in_cache = false;
+    }
+  }
+  // the ranges of a multipart response are read from the start of the object
+  if (sparse && nr > 1) {
+    t_state.range_in_cache = false;
   }
 
   if (nr > 0) {
@@ -4734,6 +4810,11 @@ HttpSM::do_http_server_open(bool raw)
   pending_action = nullptr;
   ink_assert(server_entry == nullptr);
 
+  // Follow a transaction which is already on its way to the origin server
+  if (!raw && do_fanout_join()) {
+    return;
+  }
+
   // Clean up connection tracking info if any. Need to do it now so the selected group
   // is consistent with the actual upstream in case of retry.
   t_state.outbound_conn_track_state.clear();
@@ -5086,6 +5167,112 @@ HttpSM::do_http_server_open(bool raw)
   return;
 }
 
+//////////////////////////////////////////////////////////////////////////
+//
+//  HttpSM::do_fanout_join()
+//
+//  Join the transactions which go to the origin server for the same
+//  key. Returns true if we follow another transaction and wait for
+//  its response instead of opening a connection.
+//
+//////////////////////////////////////////////////////////////////////////
+bool
+HttpSM::do_fanout_join()
+{
+  if (fanout_joined || !t_state.http_config_param->fanout_enabled) {
+    return false;
+  }
+  fanout_joined = true;
+
+  HTTPHdr *request = &t_state.hdr_info.client_request;
+
+  // Only plain GETs without a body have a response which fits everyone
+  if (t_state.method != HTTP_WKSIDX_GET || t_state.hdr_info.request_content_length > 0 ||
+      t_state.range_setup != HttpTransact::RANGE_NONE || request->presence(MIME_PRESENCE_RANGE) ||
+      t_state.hdr_info.server_request.presence(MIME_PRESENCE_RANGE | MIME_PRESENCE_IF_MODIFIED_SINCE |
+                                               MIME_PRESENCE_IF_NONE_MATCH) ||
+      t_state.is_upgrade_request || plugin_tunnel || enable_redirection || t_state.cache_info.object_read != nullptr) {
+    return false;
+  }
+  if (!t_state.http_config_param->fanout_share_private && request->presence(MIME_PRESENCE_AUTHORIZATION)) {
+    return false;
+  }
+
+  URL *url = t_state.cache_info.lookup_url;
+  if (url == nullptr || !url->valid()) {
+    url = request->url_get();
+  }
+
+  HttpCacheKey cache_key;
+  CryptoHash key;
+  Cache::generate_key(&cache_key, url, t_state.txn_conf->cache_generation_number);
+  HttpFanout::make_key(key, cache_key.hash, request, t_state.http_config_param->fanout_vary_headers);
+
+  // The transaction which holds the cache write lock must go to the origin
+  // server itself, it may only lead
+  fanout = HttpFanout::join(key, request, this, cache_sm.cache_write_vc == nullptr, fanout_vc);
+  if (fanout_vc == nullptr) {
+    if (fanout) {
+      SMDebug("http_fanout", "[%" PRId64 "] leading the requests for %s", sm_id, url->string_get_ref());
+    }
+    return false;
+  }
+
+  SMDebug("http_fanout", "[%" PRId64 "] following the request for %s", sm_id, url->string_get_ref());
+  fanout = nullptr;
+  HTTP_SM_SET_DEFAULT_HANDLER(&HttpSM::state_fanout_wait);
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+//
+//  HttpSM::state_fanout_wait()
+//
+//  We follow the transaction which went to the origin server for our
+//  key. Either it shares its response with us, or we have to go to the
+//  origin server ourselves.
+//
+//////////////////////////////////////////////////////////////////////////
+int
+HttpSM::state_fanout_wait(int event, void *data)
+{
+  STATE_ENTER(&HttpSM::state_fanout_wait, event);
+  ink_assert(data == fanout_vc);
+
+  if (event == HTTP_FANOUT_EVENT_SHARED) {
+    HttpFanout *shared = fanout_vc->fanout.get();
+
+    // The response of the leader must fit our request as well
+    if (HttpTransactCache::CalcVariability(t_state.txn_conf, &t_state.hdr_info.client_request, &shared->request,
+                                           &shared->response) == HttpTransact::VARIABILITY_NONE) {
+      SMDebug("http_fanout", "[%" PRId64 "] reading the shared response", sm_id);
+      HTTP_INCREMENT_DYN_STAT(http_fanout_collapsed_requests_stat);
+
+      t_state.hdr_info.server_response.create(HTTP_TYPE_RESPONSE);
+      t_state.hdr_info.server_response.copy(&shared->response);
+      t_state.request_sent_time                = shared->request_sent_time;
+      t_state.response_received_time           = shared->response_received_time;
+      t_state.hdr_info.response_content_length = shared->content_length;
+      t_state.hdr_info.trust_response_cl       = shared->trust_content_length;
+
+      call_transact_and_set_next_state(HttpTransact::HandleFanoutResponse);
+      return 0;
+    }
+  } else {
+    ink_assert(event == HTTP_FANOUT_EVENT_RELEASED);
+  }
+
+  SMDebug("http_fanout", "[%" PRId64 "] going to the origin server", sm_id);
+  HTTP_INCREMENT_DYN_STAT(http_fanout_released_requests_stat);
+
+  fanout_vc->do_io_close();
+  fanout_vc = nullptr;
+
+  HTTP_SM_SET_DEFAULT_HANDLER(&HttpSM::state_http_server_open);
+  do_http_server_open();
+  return 0;
+}
+
 void
 HttpSM::do_api_callout_internal()
 {
@@ -5824,6 +6011,9 @@ HttpSM::perform_cache_write_action()
       t_state.cache_info.write_status = HttpTransact::CACHE_WRITE_IN_PROGRESS;
       setup_cache_write_transfer(&cache_sm, server_entry->vc, &t_state.cache_info.object_store, client_response_hdr_bytes,
                                  "cache write");
+    } else if (t_state.cache_info.sparse_offset >= 0) {
+      // the transformed copy of a range is not an object
+      cache_sm.abort_write();
     } else {
       // We are not caching the untransformed.  We might want to
       //  use the cache writevc to cache the transformed copy
@@ -6146,6 +6336,107 @@ HttpSM::setup_cache_transfer_to_transform()
   return p;
 }
 
+HttpTunnelProducer *
+HttpSM::setup_fanout_read_transfer()
+{
+  int64_t nbytes;
+
+  ink_assert(fanout_vc != nullptr);
+
+  MIOBuffer *buf            = new_MIOBuffer(find_server_buffer_size());
+  buf->water_mark           = (int)t_state.txn_conf->default_buffer_water_mark;
+  IOBufferReader *buf_start = buf->alloc_reader();
+
+  // Now dump the header into the buffer
+  ink_assert(t_state.hdr_info.client_response.status_get() != HTTP_STATUS_NOT_MODIFIED);
+  client_response_hdr_bytes = write_response_header_into_buffer(&t_state.hdr_info.client_response, buf);
+
+  HTTP_SM_SET_DEFAULT_HANDLER(&HttpSM::tunnel_handler);
+
+  // The body of the leader arrives dechunked, without a content length it
+  // ends when the body of the leader does
+  nbytes = t_state.hdr_info.trust_response_cl ? t_state.hdr_info.response_content_length + client_response_hdr_bytes : -1;
+
+  HttpTunnelProducer *p =
+    tunnel.add_producer(fanout_vc, nbytes, buf_start, &HttpSM::tunnel_handler_fanout_read, HT_FANOUT, "fanout read");
+  tunnel.add_consumer(ua_entry->vc, fanout_vc, &HttpSM::tunnel_handler_ua, HT_HTTP_CLIENT, "user agent");
+
+  if (t_state.client_info.receive_chunked_response) {
+    tunnel.set_producer_chunking_action(p, client_response_hdr_bytes, TCA_CHUNK_CONTENT);
+    tunnel.set_producer_chunking_size(p, t_state.txn_conf->http_chunking_size);
+  }
+  ua_entry->in_tunnel = true;
+  fanout_vc           = nullptr;
+  return p;
+}
+
+HttpTunnelProducer *
+HttpSM::setup_fanout_transfer_to_transform()
+{
+  int64_t nbytes;
+
+  ink_assert(fanout_vc != nullptr);
+  ink_assert(transform_info.vc != nullptr);
+  ink_assert(transform_info.entry->vc == transform_info.vc);
+
+  MIOBuffer *buf            = new_MIOBuffer(find_server_buffer_size());
+  IOBufferReader *buf_start = buf->alloc_reader();
+
+  HTTP_SM_SET_DEFAULT_HANDLER(&HttpSM::state_response_wait_for_transform_read);
+
+  nbytes = t_state.hdr_info.trust_response_cl ? t_state.hdr_info.response_content_length : -1;
+
+  HttpTunnelProducer *p =
+    tunnel.add_producer(fanout_vc, nbytes, buf_start, &HttpSM::tunnel_handler_fanout_read, HT_FANOUT, "fanout read");
+  tunnel.add_consumer(transform_info.vc, fanout_vc, &HttpSM::tunnel_handler_transform_write, HT_TRANSFORM, "transform write");
+
+  transform_info.entry->in_tunnel = true;
+  fanout_vc                       = nullptr;
+  return p;
+}
+
+bool
+HttpSM::is_fanout_response_shareable()
+{
+  HTTPHdr *response = &t_state.hdr_info.server_response;
+  HTTPStatus status = response->status_get();
+
+  if (status < HTTP_STATUS_OK || status == HTTP_STATUS_PARTIAL_CONTENT || status == HTTP_STATUS_NOT_MODIFIED ||
+      t_state.did_upgrade_succeed) {
+    return false;
+  }
+  if (t_state.http_config_param->fanout_share_private) {
+    return true;
+  }
+  return !response->presence(MIME_PRESENCE_SET_COOKIE) && !(response->get_cooked_cc_mask() & MIME_COOKED_MASK_CC_PRIVATE);
+}
+
+// Pass the body we read from the origin server on to the followers of the
+// fan-out we lead, or send them to the origin server if we cannot.
+void
+HttpSM::setup_fanout_write_transfer(int64_t skip_bytes)
+{
+  HttpFanoutWriteVC *vc = nullptr;
+
+  if (!fanout) {
+    return;
+  }
+
+  if (tunnel.has_free_consumer() && is_fanout_response_shareable()) {
+    int64_t cl = t_state.hdr_info.trust_response_cl ? t_state.hdr_info.response_content_length : -1;
+
+    vc = fanout->share(&t_state.hdr_info.server_response, t_state.request_sent_time, t_state.response_received_time, cl,
+                       t_state.hdr_info.trust_response_cl, mutex);
+  }
+
+  if (vc) {
+    SMDebug("http_fanout", "[%" PRId64 "] sharing the response", sm_id);
+    tunnel.add_consumer(vc, server_entry->vc, &HttpSM::tunnel_handler_fanout_write, HT_FANOUT, "fanout", skip_bytes);
+  } else {
+    fanout->release();
+  }
+}
+
 void
 HttpSM::setup_cache_write_transfer(HttpCacheSM *c_sm, VConnection *source_vc, HTTPInfo *store_info, int64_t skip_bytes,
                                    const char *name)
@@ -6160,6 +6451,14 @@ HttpSM::setup_cache_write_transfer(HttpCacheSM *c_sm, VConnection *source_vc, HT
   c_sm->cache_write_vc->set_http_info(store_info);
   store_info->clear();
 
+  // the body of a range response is written as the chunks of a sparse object
+  if (c_sm == &cache_sm && t_state.cache_info.sparse_offset >= 0 &&
+      !c_sm->cache_write_vc->set_sparse_write(t_state.cache_info.sparse_offset)) {
+    c_sm->abort_write();
+    t_state.cache_info.write_status = HttpTransact::CACHE_WRITE_ERROR;
+    return;
+  }
+
   tunnel.add_consumer(c_sm->cache_write_vc, source_vc, &HttpSM::tunnel_handler_cache_write, HT_CACHE_WRITE, name, skip_bytes);
 
   c_sm->cache_write_vc = nullptr;
@@ -6834,6 +7133,17 @@ HttpSM::kill_this()
       plugin_tunnel = nullptr;
     }
 
+    // Do not keep the followers of a fan-out waiting for us, nor the
+    // leader of the fan-out we follow
+    if (fanout) {
+      fanout->release();
+      fanout = nullptr;
+    }
+    if (fanout_vc) {
+      fanout_vc->do_io_close();
+      fanout_vc = nullptr;
+    }
+
     server_session = nullptr;
 
     // So we don't try to nuke the state machine
@@ -7188,6 +7498,27 @@ HttpSM::call_transact_and_set_next_state(TransactEntryFunc_t f)
 void
 HttpSM::set_next_state()
 {
+  // The followers of the fan-out we lead wait only as long as we may still
+  // get a response to share with them
+  if (fanout && fanout->state == HttpFanout::WAITING) {
+    switch (t_state.next_action) {
+    case HttpTransact::SM_ACTION_DNS_LOOKUP:
+    case HttpTransact::SM_ACTION_API_OS_DNS:
+    case HttpTransact::SM_ACTION_ORIGIN_SERVER_OPEN:
+    case HttpTransact::SM_ACTION_ORIGIN_SERVER_RR_MARK_DOWN:
+    case HttpTransact::SM_ACTION_API_SEND_REQUEST_HDR:
+    case HttpTransact::SM_ACTION_API_READ_RESPONSE_HDR:
+    case HttpTransact::SM_ACTION_SERVER_PARSE_NEXT_HDR:
+    case HttpTransact::SM_ACTION_INTERNAL_100_RESPONSE:
+    case HttpTransact::SM_ACTION_CACHE_ISSUE_WRITE_TRANSFORM:
+    case HttpTransact::SM_ACTION_SERVER_READ:
+      break;
+    default:
+      fanout->release();
+      break;
+    }
+  }
+
   ///////////////////////////////////////////////////////////////////////
   // Use the returned "next action" code to set the next state handler //
   ///////////////////////////////////////////////////////////////////////
@@ -7391,8 +7722,9 @@ HttpSM::set_next_state()
     if (transform_info.vc) {
       ink_assert(t_state.hdr_info.client_response.valid() == 0);
       ink_assert((t_state.hdr_info.transform_response.valid() ? true : false) == true);
-      HttpTunnelProducer *p = setup_server_transfer_to_transform();
+      HttpTunnelProducer *p = fanout_vc ? setup_fanout_transfer_to_transform() : setup_server_transfer_to_transform();
       perform_cache_write_action();
+      setup_fanout_write_transfer(0);
       tunnel.tunnel_run(p);
     } else {
       ink_assert((t_state.hdr_info.client_response.valid() ? true : false) == true);
@@ -40,6 +40,7 @@
 #include "HttpTransact.h"
 #include "UrlRewrite.h"
 #include "HttpTunnel.h"
+#include "HttpFanout.h"
 #include "InkAPIInternal.h"
 #include "../ProxyTransaction.h"
 #include "HdrUtils.h"
@@ -384,6 +385,12 @@ protected:
   HttpCacheSM cache_sm;
   HttpCacheSM transform_cache_sm;
 
+  // The fan-out this transaction leads, or the one it follows until the
+  // body is read through fanout_vc
+  Ptr<HttpFanout> fanout;
+  HttpFanoutReadVC *fanout_vc = nullptr;
+  bool fanout_joined          = false;
+
   HttpSMHandler default_handler = nullptr;
   Action *pending_action        = nullptr;
   Continuation *schedule_cont   = nullptr;
@@ -429,6 +436,7 @@ protected:
   int state_send_server_request_header(int event, void *data);
   int state_acquire_server_read(int event, void *data);
   int state_read_server_response_header(int event, void *data);
+  int state_fanout_wait(int event, void *data);
 
   // API
   int state_request_wait_for_transform_read(int event, void *data);
@@ -449,11 +457,14 @@ protected:
   int tunnel_handler_transform_write(int event, HttpTunnelConsumer *c);
   int tunnel_handler_transform_read(int event, HttpTunnelProducer *p);
   int tunnel_handler_plugin_agent(int event, HttpTunnelConsumer *c);
+  int tunnel_handler_fanout_write(int event, HttpTunnelConsumer *c);
+  int tunnel_handler_fanout_read(int event, HttpTunnelProducer *p);
 
   void do_hostdb_lookup();
   void do_hostdb_reverse_lookup();
   void do_cache_lookup_and_read();
   void do_http_server_open(bool raw = false);
+  bool do_fanout_join();
   void send_origin_throttled_response();
   void do_setup_post_tunnel(HttpVC_t to_vc_type);
   void do_cache_prepare_write();
@@ -507,6 +518,10 @@ protected:
   HttpTunnelProducer *setup_transfer_from_transform();
   HttpTunnelProducer *setup_cache_transfer_to_transform();
   HttpTunnelProducer *setup_transfer_from_transform_to_cache_only();
+  HttpTunnelProducer *setup_fanout_read_transfer();
+  HttpTunnelProducer *setup_fanout_transfer_to_transform();
+  void setup_fanout_write_transfer(int64_t skip_bytes);
+  bool is_fanout_response_shareable();
   void setup_plugin_agents(HttpTunnelProducer *p);
 
   HttpTransact::StateMachineAction_t last_action     = HttpTransact::SM_ACTION_UNDEFINED;
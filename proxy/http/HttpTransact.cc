@@ -132,6 +132,105 @@ is_request_conditional(HTTPHdr *header)
           (header->method_get_wksidx() == HTTP_WKSIDX_GET || header->method_get_wksidx() == HTTP_WKSIDX_HEAD));
 }
 
+// Parse the decimal number at @a s, skipping the white space around it. -1 if there is none.
+static int64_t
+parse_range_number(const char *&s, const char *e)
+{
+  int64_t n = 0;
+  for (; s < e && ParseRules::is_ws(*s); ++s) {
+    ;
+  }
+  if (s >= e || !ParseRules::is_digit(*s)) {
+    return -1;
+  }
+  for (; s < e && ParseRules::is_digit(*s); ++s) {
+    if (n > (INT64_MAX - 9) / 10) {
+      return -1;
+    }
+    n = n * 10 + (*s - '0');
+  }
+  for (; s < e && ParseRules::is_ws(*s); ++s) {
+    ;
+  }
+  return n;
+}
+
+// Whether the chunks of a sparse object of @a size bytes hold the single byte range of @a request.
+static bool
+is_sparse_range_cached(HTTPHdr *request, const HTTPChunkMap &chunks, int64_t size)
+{
+  int len       = 0;
+  const char *s = request->value_get(MIME_FIELD_RANGE, MIME_LEN_RANGE, &len);
+  if (!s || len < 6 || strncasecmp(s, "bytes=", 6) || request->presence(MIME_PRESENCE_IF_RANGE) ||
+      request->version_get() != HTTPVersion(1, 1)) {
+    return false;
+  }
+  const char *e = s + len;
+  s += 6;
+  int64_t start = parse_range_number(s, e);
+  if (s >= e || *s++ != '-') {
+    return false;
+  }
+  int64_t end = parse_range_number(s, e);
+  if (s != e) { // more than one range
+    return false;
+  }
+  if (start < 0) {
+    if (end <= 0) {
+      return false;
+    }
+    start = std::max<int64_t>(size - end, 0);
+    end   = size - 1;
+  } else if (end < 0 || end >= size) {
+    end = size - 1;
+  }
+  return chunks.covers(start, end);
+}
+
+// Whether the response of @a s to a GET is a single byte range which is stored as the chunks of a sparse
+// object, the first byte of the range and the size of the object are returned in @a start and @a size.
+static bool
+is_sparse_range_response(HttpTransact::State *s, HTTPHdr *response, int64_t &start, int64_t &size)
+{
+  HTTPChunkMap chunks;
+  int len = 0;
+
+  if (cache_config_sparse_chunk_size <= 0 || s->method != HTTP_WKSIDX_GET || response->status_get() != HTTP_STATUS_PARTIAL_CONTENT) {
+    return false;
+  }
+  const char *p = response->value_get(MIME_FIELD_CONTENT_RANGE, MIME_LEN_CONTENT_RANGE, &len);
+  if (!p || len < 6 || strncasecmp(p, "bytes ", 6)) {
+    return false;
+  }
+  const char *e = p + len;
+  p += 6;
+  start = parse_range_number(p, e);
+  if (start < 0 || p >= e || *p++ != '-') {
+    return false;
+  }
+  int64_t end = parse_range_number(p, e);
+  if (end < start || p >= e || *p++ != '/') {
+    return false;
+  }
+  size = parse_range_number(p, e);
+  return p == e && end < size && chunks.init(cache_config_sparse_chunk_size, size);
+}
+
+// Whether @a response is of the same object as the @a cached response, both have the same strong ETag
+// or, without one, the same Last-Modified.
+static bool
+is_same_object(HTTPHdr *cached, HTTPHdr *response)
+{
+  int clen = 0, rlen = 0;
+  const char *cetag = cached->value_get(MIME_FIELD_ETAG, MIME_LEN_ETAG, &clen);
+  const char *retag = response->value_get(MIME_FIELD_ETAG, MIME_LEN_ETAG, &rlen);
+
+  if (cetag || retag) {
+    return cetag && retag && clen == rlen && !memcmp(cetag, retag, clen) && !(clen >= 2 && cetag[0] == 'W' && cetag[1] == '/');
+  }
+  return cached->get_last_modified() > 0 && cached->get_last_modified() == response->get_last_modified();
+}
+
 static inline bool
 is_port_in_range(int port, HttpConfigPortRange *pr)
 {
@@ -2215,6 +2314,25 @@ HttpTransact::issue_revalidate(State *s)
     return;
   }
 
+  if (s->cache_info.sparse_fill) {
+    // The range is asked for only if the object did not change, so that the response adds to the
+    // chunks of the sparse object. Any other response replaces it.
+    HTTPHdr *request = &s->hdr_info.server_request;
+    request->field_delete(MIME_FIELD_IF_MODIFIED_SINCE, MIME_LEN_IF_MODIFIED_SINCE);
+    request->field_delete(MIME_FIELD_IF_NONE_MATCH, MIME_LEN_IF_NONE_MATCH);
+    if (request->presence(MIME_PRESENCE_RANGE) && !request->presence(MIME_PRESENCE_IF_RANGE)) {
+      int length       = 0;
+      const char *etag = c_resp->value_get(MIME_FIELD_ETAG, MIME_LEN_ETAG, &length);
+      if (etag && !(length >= 2 && etag[0] == 'W' && etag[1] == '/')) {
+        request->value_set(MIME_FIELD_IF_RANGE, MIME_LEN_IF_RANGE, etag, length);
+      } else if ((etag = c_resp->value_get(MIME_FIELD_LAST_MODIFIED, MIME_LEN_LAST_MODIFIED, &length)) != nullptr) {
+        request->value_set(MIME_FIELD_IF_RANGE, MIME_LEN_IF_RANGE, etag, length);
+      }
+    }
+    DUMP_HEADER("http_hdrs", request, s->state_machine_id, "Proxy's Request (Sparse Fill)");
+    return;
+  }
+
   // if the document is cached, just send a conditional request to the server
 
   // So the request does not have preconditions. It can, however
@@ -2590,6 +2708,16 @@ HttpTransact::HandleCacheOpenReadHit(State *s)
   // if the origin server still has to be looked up.
   bool response_returnable = is_cache_response_returnable(s);
 
+  // a sparse object serves only the byte ranges it holds, it is filled from the server for the others
+  HTTPChunkMap chunks;
+  if (response_returnable && s->method == HTTP_WKSIDX_GET && chunks.load(obj->response_get(), obj->object_size_get()) &&
+      !is_sparse_range_cached(&s->hdr_info.client_request, chunks, obj->object_size_get())) {
+    TxnDebug("http_trans", "[HandleCacheOpenReadHit] range not in the sparse object");
+    SET_VIA_STRING(VIA_DETAIL_CACHE_LOOKUP, VIA_DETAIL_MISS_NOT_CACHED);
+    response_returnable        = false;
+    s->cache_info.sparse_fill = true;
+  }
+
   // do we need to revalidate. in other words if the response
   // has to be authorized, is stale or can not be returned, do
   // a revalidate.
@@ -3035,7 +3163,8 @@ HttpTransact::HandleCacheOpenReadMiss(State *s)
   // We must, however, not cache the responses to these requests.
   if (does_method_require_cache_copy_deletion(s->http_config_param, s->method) && s->api_req_cacheable == false) {
     s->cache_info.action = CACHE_DO_NO_ACTION;
-  } else if ((s->hdr_info.client_request.presence(MIME_PRESENCE_RANGE) && !s->txn_conf->cache_range_write) ||
+  } else if ((s->hdr_info.client_request.presence(MIME_PRESENCE_RANGE) && !s->txn_conf->cache_range_write &&
+              cache_config_sparse_chunk_size <= 0) ||
              does_method_effect_cache(s->method) == false || s->range_setup == RANGE_NOT_SATISFIABLE ||
              s->range_setup == RANGE_NOT_HANDLED) {
     s->cache_info.action = CACHE_DO_NO_ACTION;
@@ -3214,6 +3343,44 @@ HttpTransact::HandleResponse(State *s)
   return;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Name       : HandleFanoutResponse
+// Description: called from the state machine when the response of the
+//              transaction it followed to the origin server was shared
+//
+// Details    :
+//
+//   The response header of the leader has already been copied to the
+//   server response and checked by the state machine. The response did
+//   not come from our own server connection, so there is nothing to
+//   validate or to cache, the body is passed on as it is read.
+//
+// Possible Next States From Here:
+// - HttpTransact::SM_ACTION_SERVER_READ;
+//
+///////////////////////////////////////////////////////////////////////////////
+void
+HttpTransact::HandleFanoutResponse(State *s)
+{
+  TxnDebug("http_trans", "[HttpTransact::HandleFanoutResponse]");
+  DUMP_HEADER("http_hdrs", &s->hdr_info.server_response, s->state_machine_id, "Shared O.S. Response");
+
+  s->source                            = SOURCE_HTTP_ORIGIN_SERVER;
+  s->current.now                       = s->response_received_time;
+  s->cache_info.action                 = CACHE_DO_NO_ACTION;
+  s->current.server->transfer_encoding = NO_TRANSFER_ENCODING;
+
+  SET_VIA_STRING(VIA_SERVER_RESULT, VIA_SERVER_SERVED);
+  SET_VIA_STRING(VIA_PROXY_RESULT, VIA_PROXY_SERVED);
+
+  s->next_action = SM_ACTION_SERVER_READ;
+  if (s->state_machine->do_transform_open()) {
+    set_header_for_transform(s, &s->hdr_info.server_response);
+  } else {
+    build_response(s, &s->hdr_info.server_response, &s->hdr_info.client_response, s->client_info.http_version);
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Name       : HandleUpdateCachedObject
 // Description: called from the state machine when we are going to modify
@@ -4374,6 +4541,7 @@ HttpTransact::handle_cache_operation_on_forward_server_response(State *s)
 
   if ((s->cache_info.action == CACHE_DO_WRITE) || (s->cache_info.action == CACHE_DO_REPLACE)) {
     set_headers_for_cache_write(s, &s->cache_info.object_store, &s->hdr_info.server_request, &s->hdr_info.server_response);
+    set_headers_for_sparse_write(s);
   }
   // 304, 412, and 416 responses are handled here
   if ((client_response_code == HTTP_STATUS_NOT_MODIFIED) || (client_response_code == HTTP_STATUS_PRECONDITION_FAILED)) {
@@ -4747,6 +4915,37 @@ HttpTransact::set_headers_for_cache_write(State *s, HTTPInfo *cache_info, HTTPHd
   DUMP_HEADER("http_hdrs", cache_info->request_get(), s->state_machine_id, "Cached Request Hdr");
 }
 
+// A range response is stored as the chunks of a sparse object. Its cached response is a 200 response
+// of the whole object with the map of the chunks it holds, the chunks of the cached object are kept
+// if the range response is of the same object.
+void
+HttpTransact::set_headers_for_sparse_write(State *s)
+{
+  HTTPHdr *response = s->cache_info.object_store.response_get();
+  HTTPInfo *obj     = s->cache_info.object_read;
+  HTTPChunkMap chunks;
+  int64_t start, size;
+
+  s->cache_info.sparse_offset = -1;
+  if (!is_sparse_range_response(s, &s->hdr_info.server_response, start, size)) {
+    return;
+  }
+  if (!(s->cache_info.action == CACHE_DO_REPLACE && obj && chunks.load(obj->response_get(), size) &&
+        chunks.chunk_size == cache_config_sparse_chunk_size && is_same_object(obj->response_get(), response))) {
+    chunks.init(cache_config_sparse_chunk_size, size);
+  }
+
+  const char *reason = http_hdr_reason_lookup(HTTP_STATUS_OK);
+  response->status_set(HTTP_STATUS_OK);
+  response->reason_set(reason, strlen(reason));
+  response->field_delete(MIME_FIELD_CONTENT_RANGE, MIME_LEN_CONTENT_RANGE);
+  response->value_set_int64(MIME_FIELD_CONTENT_LENGTH, MIME_LEN_CONTENT_LENGTH, size);
+  chunks.store(response);
+  s->cache_info.sparse_offset = start;
+  TxnDebug("http_trans", "[set_headers_for_sparse_write] range from %" PRId64 " of %" PRId64 " bytes, %d chunks", start, size,
+           chunks.count);
+}
+
 void
 HttpTransact::merge_response_header_with_cached_header(HTTPHdr *cached_header, HTTPHdr *response_header)
 {
@@ -5760,6 +5959,12 @@ HttpTransact::is_stale_cache_response_returnable(State *s)
 {
   HTTPHdr *cached_response = s->cache_info.object_read->response_get();
 
+  // The sparse object does not hold the range the client asked for, there is nothing to serve.
+  if (s->cache_info.sparse_fill) {
+    TxnDebug("http_trans", "[is_stale_cache_response_returnable] "
+                           "range not in the sparse object");
+    return false;
+  }
   // First check if client allows cached response
   // Note does_client_permit_lookup was set to
   // does_client_Request_permit_cached_response()
@@ -6106,8 +6311,10 @@ HttpTransact::is_response_cacheable(State *s, HTTPHdr *request, HTTPHdr *respons
       }
     }
   }
-  // do not cache partial content - Range response
-  if (response_code == HTTP_STATUS_PARTIAL_CONTENT || response_code == HTTP_STATUS_RANGE_NOT_SATISFIABLE) {
+  // do not cache partial content - Range response, unless it is stored as a sparse object
+  int64_t range_start, object_size;
+  if ((response_code == HTTP_STATUS_PARTIAL_CONTENT && !is_sparse_range_response(s, response, range_start, object_size)) ||
+      response_code == HTTP_STATUS_RANGE_NOT_SATISFIABLE) {
     TxnDebug("http_trans",
              "[is_response_cacheable] "
              "response code %d - don't cache",
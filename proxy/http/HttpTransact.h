@@ -251,6 +251,7 @@ public:
     CACHE_WL_FAIL_ACTION_STALE_ON_REVALIDATE               = 0x02,
     CACHE_WL_FAIL_ACTION_ERROR_ON_MISS_STALE_ON_REVALIDATE = 0x03,
     CACHE_WL_FAIL_ACTION_ERROR_ON_MISS_OR_REVALIDATE       = 0x04,
+    CACHE_WL_FAIL_ACTION_READ_RETRY                        = 0x05,
     TOTAL_CACHE_WL_FAIL_ACTION_TYPES
   };
 
@@ -523,6 +524,8 @@ public:
     SquidHitMissCode hit_miss_code    = SQUID_MISS_NONE;
     URL *parent_selection_url         = nullptr;
     URL parent_selection_url_storage;
+    bool sparse_fill      = false; ///< Fill the missing chunks of the cached sparse object.
+    int64_t sparse_offset = -1;    ///< Offset in the object of the range response written as chunks.
 
     _CacheLookupInfo() {}
   } CacheLookupInfo;
@@ -958,6 +961,7 @@ public:
   static void build_response_from_cache(State *s, HTTPWarningCode warning_code);
   static void handle_cache_write_lock(State *s);
   static void HandleResponse(State *s);
+  static void HandleFanoutResponse(State *s);
   static void HandleUpdateCachedObject(State *s);
   static void HandleUpdateCachedObjectContinue(State *s);
   static void HandleStatPage(State *s);
@@ -974,6 +978,7 @@ public:
   static void handle_no_cache_operation_on_forward_server_response(State *s);
   static void merge_and_update_headers_for_cache_update(State *s);
   static void set_headers_for_cache_write(State *s, HTTPInfo *cache_info, HTTPHdr *request, HTTPHdr *response);
+  static void set_headers_for_sparse_write(State *s);
   static void set_header_for_transform(State *s, HTTPHdr *base_header);
   static void merge_response_header_with_cached_header(HTTPHdr *cached_header, HTTPHdr *response_header);
   static void merge_warning_header(HTTPHdr *cached_header, HTTPHdr *response_header);
@@ -723,15 +723,16 @@ HttpTunnel::tunnel_run(HttpTunnelProducer *p_arg)
 void
 HttpTunnel::producer_run(HttpTunnelProducer *p)
 {
-  // Determine whether the producer has a cache-write consumer,
-  // since all chunked content read by the producer gets dechunked
-  // prior to being written into the cache.
-  HttpTunnelConsumer *c, *cache_write_consumer = nullptr;
+  // Determine whether the producer has a cache-write or fan-out
+  // consumer, since all chunked content read by the producer gets
+  // dechunked prior to being written into the cache or passed on to
+  // the followers.
+  HttpTunnelConsumer *c, *dechunked_consumer = nullptr;
   bool transform_consumer = false;
 
   for (c = p->consumer_list.head; c; c = c->link.next) {
-    if (c->vc_type == HT_CACHE_WRITE) {
-      cache_write_consumer = c;
+    if (c->vc_type == HT_CACHE_WRITE || c->vc_type == HT_FANOUT) {
+      dechunked_consumer = c;
       break;
     }
   }
@@ -758,7 +759,7 @@ HttpTunnel::producer_run(HttpTunnelProducer *p)
       p->do_chunked_passthru = true;
 
       // Dechunk the chunked content into the cache.
-      if (cache_write_consumer != nullptr) {
+      if (dechunked_consumer != nullptr) {
         p->do_dechunking = true;
       }
     }
@@ -817,7 +818,7 @@ HttpTunnel::producer_run(HttpTunnelProducer *p)
   for (c = p->consumer_list.head; c;) {
     // Create a reader for each consumer.  The reader allows
     // us to implement skip bytes
-    if (c->vc_type == HT_CACHE_WRITE) {
+    if (c->vc_type == HT_CACHE_WRITE || c->vc_type == HT_FANOUT) {
       switch (action) {
       case TCA_CHUNK_CONTENT:
       case TCA_PASSTHRU_DECHUNKED_CONTENT:
@@ -1424,7 +1425,7 @@ HttpTunnel::finish_all_internal(HttpTunnelProducer *p, bool chain)
 
   while (c) {
     if (c->alive) {
-      if (c->vc_type == HT_CACHE_WRITE) {
+      if (c->vc_type == HT_CACHE_WRITE || c->vc_type == HT_FANOUT) {
         switch (action) {
         case TCA_CHUNK_CONTENT:
         case TCA_PASSTHRU_DECHUNKED_CONTENT:
@@ -1474,8 +1475,9 @@ HttpTunnel::finish_all_internal(HttpTunnelProducer *p, bool chain)
 
 // void HttpTunnel::chain_abort_cache_write(HttpProducer* p)
 //
-//    Terminates all cache writes.  Used to prevent truncated
-//     documents from being stored in the cache
+//    Terminates all cache writes and fan-outs.  Used to prevent
+//     truncated documents from being stored in the cache or
+//     passed on as complete to the followers of a fan-out
 //
 void
 HttpTunnel::chain_abort_cache_write(HttpTunnelProducer *p)
@@ -1484,12 +1486,12 @@ HttpTunnel::chain_abort_cache_write(HttpTunnelProducer *p)
 
   while (c) {
     if (c->alive) {
-      if (c->vc_type == HT_CACHE_WRITE) {
+      if (c->vc_type == HT_CACHE_WRITE || c->vc_type == HT_FANOUT) {
         ink_assert(c->self_producer == nullptr);
         c->write_vio = nullptr;
         c->vc->do_io_close(EHTTP_ERROR);
         c->alive = false;
-        HTTP_DECREMENT_DYN_STAT(http_current_cache_connections_stat);
+        update_stats_after_abort(c->vc_type);
       } else if (c->self_producer) {
         chain_abort_cache_write(c->self_producer);
       }
@@ -1599,7 +1601,7 @@ HttpTunnel::update_stats_after_abort(HttpTunnelType_t t)
   default:
     // Handled here:
     // HT_HTTP_SERVER, HT_HTTP_CLIENT,
-    // HT_TRANSFORM, HT_STATIC
+    // HT_TRANSFORM, HT_STATIC, HT_FANOUT
     break;
   };
 }
@@ -65,7 +65,16 @@ struct HttpTunnelProducer;
 typedef int (HttpSM::*HttpProducerHandler)(int event, HttpTunnelProducer *p);
 typedef int (HttpSM::*HttpConsumerHandler)(int event, HttpTunnelConsumer *c);
 
-enum HttpTunnelType_t { HT_HTTP_SERVER, HT_HTTP_CLIENT, HT_CACHE_READ, HT_CACHE_WRITE, HT_TRANSFORM, HT_STATIC, HT_BUFFER_READ };
+enum HttpTunnelType_t {
+  HT_HTTP_SERVER,
+  HT_HTTP_CLIENT,
+  HT_CACHE_READ,
+  HT_CACHE_WRITE,
+  HT_TRANSFORM,
+  HT_STATIC,
+  HT_BUFFER_READ,
+  HT_FANOUT
+};
 
 enum TunnelChunkingAction_t {
   TCA_CHUNK_CONTENT,
@@ -282,6 +291,7 @@ public:
   }
   bool is_tunnel_alive() const;
   bool has_cache_writer() const;
+  bool has_free_consumer() const;
 
   HttpTunnelProducer *add_producer(VConnection *vc, int64_t nbytes, IOBufferReader *reader_start, HttpProducerHandler sm_handler,
                                    HttpTunnelType_t vc_type, const char *name);
@@ -513,6 +523,12 @@ HttpTunnel::has_cache_writer() const
   return false;
 }
 
+inline bool
+HttpTunnel::has_free_consumer() const
+{
+  return num_consumers < MAX_CONSUMERS;
+}
+
 inline bool
 HttpTunnelConsumer::is_downstream_from(VConnection *vc)
 {
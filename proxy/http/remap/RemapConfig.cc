@@ -93,9 +93,10 @@ BUILD_TABLE_INFO::~BUILD_TABLE_INFO()
 void
 BUILD_TABLE_INFO::reset()
 {
+  // Only the first paramc / argc slots are ever set, don't walk the whole arrays for every line.
+  clear_xstr_array(this->paramv, this->paramc);
+  clear_xstr_array(this->argv, this->argc);
   this->paramc = this->argc = 0;
-  clear_xstr_array(this->paramv, sizeof(this->paramv) / sizeof(char *));
-  clear_xstr_array(this->argv, sizeof(this->argv) / sizeof(char *));
 }
 
 static const char *
@@ -1186,7 +1187,8 @@ remap_parse_config_bti(const char *path, BUILD_TABLE_INFO *bti)
     map_to_start = map_to;
     tmp          = map_to;
 
-    new_mapping->toURL.create(nullptr);
+    // The mapping URLs are read only once loaded, a single heap holds both.
+    new_mapping->toURL.create(new_mapping->fromURL.m_heap);
     rparse                   = new_mapping->toURL.parse_no_path_component_breakdown(tmp, length);
     map_to_start[origLength] = '\0'; // Unwhack
 
@@ -1341,7 +1343,7 @@ remap_parse_config_bti(const char *path, BUILD_TABLE_INFO *bti)
             u_mapping->fromURL.create(nullptr);
             u_mapping->fromURL.copy(&new_mapping->fromURL);
             u_mapping->fromURL.host_set(ipb, strlen(ipb));
-            u_mapping->toURL.create(nullptr);
+            u_mapping->toURL.create(u_mapping->fromURL.m_heap);
             u_mapping->toURL.copy(&new_mapping->toURL);
 
             if (bti->paramv[3] != nullptr) {
@@ -1361,7 +1363,7 @@ remap_parse_config_bti(const char *path, BUILD_TABLE_INFO *bti)
     }
 
     // Check "remap" plugin options and load .so object
-    if ((bti->remap_optflg & REMAP_OPTFLG_PLUGIN) != 0 &&
+    if ((bti->remap_optflg & REMAP_OPTFLG_PLUGIN) != 0 && bti->rewrite->load_plugins &&
         (maptype == FORWARD_MAP || maptype == FORWARD_MAP_REFERER || maptype == FORWARD_MAP_WITH_RECV_PORT)) {
       if ((remap_check_option((const char **)bti->argv, bti->argc, REMAP_OPTFLG_PLUGIN, &tok_count) & REMAP_OPTFLG_PLUGIN) != 0) {
         int plugin_found_at = 0;
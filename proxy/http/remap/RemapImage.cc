@@ -0,0 +1,532 @@
+/** @file
+
+  Compiled remap lookup tables.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "RemapImage.h"
+#include "UrlMapping.h"
+#include "tscore/Diags.h"
+#include "tscore/HashFNV.h"
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace
+{
+constexpr uint32_t IMAGE_MAGIC   = 0x50414d52; // "RMAP"
+constexpr uint32_t IMAGE_VERSION = 1;
+
+// The image is an array of 4 byte aligned structures which refer to each other by their offset from the start
+// of the file. Strings are stored once, unterminated, and are referred to by offset and length.
+struct ImageHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t size;                         ///< Of the whole file.
+  uint32_t n_rules;                      ///< Rules without a regex, in the order remap.config inserts them.
+  uint32_t rules;                        ///< ImageRule[n_rules]
+  uint32_t stores[RemapImage::N_STORES]; ///< Host table of each store, 0 if it has no rules.
+};
+
+struct ImageRule {
+  uint32_t store;
+  int32_t rank;
+  int32_t scheme;
+  int32_t port;
+  uint32_t host;
+  uint32_t host_len;
+  uint32_t path;
+  uint32_t path_len;
+};
+
+// A host table is the number of buckets, a power of 2, followed by the buckets. Collisions go to the next bucket.
+struct ImageHost {
+  uint32_t hash;
+  uint32_t host;
+  uint32_t host_len;
+  uint32_t index; ///< Path index of the host, 0 for an empty bucket.
+};
+
+// The path index of a host, the number of tries followed by the tries ordered by scheme and port.
+struct ImageTrie {
+  int32_t scheme;
+  int32_t port;
+  uint32_t root; ///< ImageNode
+};
+
+// A node of a path compressed trie, as in Trie. The children are the offsets of their nodes followed by the first
+// byte of their labels.
+struct ImageNode {
+  int32_t rule; ///< Ordinal of the rule with the path up to this node, -1 if none.
+  int32_t rank;
+  uint32_t label;
+  uint32_t label_len;
+  uint32_t n_children;
+  uint32_t children;
+};
+
+template <typename T>
+const T *
+image_at(const char *base, uint32_t offset)
+{
+  return reinterpret_cast<const T *>(base + offset);
+}
+
+uint32_t
+host_hash(const char *host, int host_len)
+{
+  ATSHash32FNV1a hash;
+  hash.update(host, host_len);
+  hash.final();
+  return hash.get();
+}
+
+/// The path index of @a host in the host table at @a table, 0 if it has none.
+uint32_t
+find_host(const char *base, uint32_t table, const char *host, int host_len)
+{
+  if (!table) {
+    return 0;
+  }
+
+  uint32_t mask           = *image_at<uint32_t>(base, table) - 1;
+  const ImageHost *bucket = image_at<ImageHost>(base, table + sizeof(uint32_t));
+  uint32_t hash           = host_hash(host, host_len);
+
+  for (uint32_t i = hash & mask; bucket[i].index; i = (i + 1) & mask) {
+    if (bucket[i].hash == hash && bucket[i].host_len == static_cast<uint32_t>(host_len) &&
+        memcmp(base + bucket[i].host, host, host_len) == 0) {
+      return bucket[i].index;
+    }
+  }
+  return 0;
+}
+
+class ImageBuffer
+{
+public:
+  uint32_t
+  size() const
+  {
+    return _buf.size();
+  }
+
+  void
+  align()
+  {
+    _buf.resize((_buf.size() + 3) & ~size_t(3));
+  }
+
+  uint32_t
+  append(const void *data, size_t len)
+  {
+    uint32_t offset = _buf.size();
+    _buf.append(static_cast<const char *>(data), len);
+    return offset;
+  }
+
+  template <typename T>
+  uint32_t
+  append(const T &data)
+  {
+    align();
+    return append(&data, sizeof(data));
+  }
+
+  template <typename T>
+  T *
+  at(uint32_t offset)
+  {
+    return reinterpret_cast<T *>(&_buf[offset]);
+  }
+
+  const std::string &
+  data() const
+  {
+    return _buf;
+  }
+
+private:
+  std::string _buf;
+};
+
+/** Write the trie node of the rules @a ord[0, n), sorted by path, which all have the first @a depth bytes of
+    their path in common. The node has the @a label_len bytes at @a label leading to it.
+ */
+uint32_t
+write_node(ImageBuffer &img, const std::vector<RemapImage::Key> &keys, const std::vector<uint32_t> &path_offset, const int *ord,
+           int n, size_t depth, uint32_t label, uint32_t label_len)
+{
+  ImageNode node = {-1, 0, label, label_len, 0, 0};
+  std::vector<uint32_t> children;
+  std::string child_keys;
+
+  if (n > 0 && keys[ord[0]].path.size() == depth) {
+    node.rule = ord[0];
+    node.rank = keys[ord[0]].rank;
+    ++ord;
+    --n;
+  }
+
+  for (int i = 0; i < n;) {
+    std::string_view first = keys[ord[i]].path;
+    int j                  = i + 1;
+    while (j < n && keys[ord[j]].path[depth] == first[depth]) {
+      ++j;
+    }
+    // The label of the child is the common prefix of its rules, the one of the first and the last.
+    std::string_view last = keys[ord[j - 1]].path;
+    size_t end            = depth + 1;
+    while (end < first.size() && end < last.size() && first[end] == last[end]) {
+      ++end;
+    }
+    children.push_back(write_node(img, keys, path_offset, ord + i, j - i, end, path_offset[ord[i]] + depth, end - depth));
+    child_keys.push_back(first[depth]);
+    i = j;
+  }
+
+  if (!children.empty()) {
+    img.align();
+    node.n_children = children.size();
+    node.children   = img.append(children.data(), children.size() * sizeof(uint32_t));
+    img.append(child_keys.data(), child_keys.size());
+  }
+  return img.append(node);
+}
+
+} // namespace
+
+RemapImage::~RemapImage()
+{
+  close();
+}
+
+bool
+RemapImage::open(const char *path)
+{
+  ink_assert(!is_open());
+
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    Debug("url_rewrite", "no remap image at %s: %s", path, strerror(errno));
+    return false;
+  }
+
+  struct stat st;
+  void *base = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(ImageHeader))) {
+    base = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    Warning("cannot map the remap image %s: %s", path, strerror(errno));
+    return false;
+  }
+
+  const ImageHeader *header = static_cast<const ImageHeader *>(base);
+  if (header->magic != IMAGE_MAGIC || header->version != IMAGE_VERSION || header->size != static_cast<uint64_t>(st.st_size) ||
+      header->rules + static_cast<uint64_t>(header->n_rules) * sizeof(ImageRule) > header->size) {
+    Warning("%s is not a remap image of this version", path);
+    munmap(base, st.st_size);
+    return false;
+  }
+
+  _base = static_cast<const char *>(base);
+  _size = st.st_size;
+  Debug("url_rewrite", "mapped the remap image %s, %d rules", path, n_rules());
+  return true;
+}
+
+void
+RemapImage::close()
+{
+  if (_base) {
+    munmap(const_cast<char *>(_base), _size);
+    _base = nullptr;
+    _size = 0;
+  }
+}
+
+int
+RemapImage::n_rules() const
+{
+  return _base ? image_at<ImageHeader>(_base, 0)->n_rules : 0;
+}
+
+bool
+RemapImage::matches(int ordinal, const Key &key) const
+{
+  if (ordinal >= n_rules()) {
+    return false;
+  }
+
+  const ImageRule *rule = image_at<ImageRule>(_base, image_at<ImageHeader>(_base, 0)->rules) + ordinal;
+  if (rule->store != static_cast<uint32_t>(key.store) || rule->rank != key.rank || rule->scheme != key.scheme ||
+      rule->port != key.port || rule->host_len != key.host.size() || rule->path_len != key.path.size() ||
+      static_cast<uint64_t>(rule->host) + rule->host_len > _size || static_cast<uint64_t>(rule->path) + rule->path_len > _size) {
+    return false;
+  }
+  return memcmp(_base + rule->host, key.host.data(), key.host.size()) == 0 &&
+         memcmp(_base + rule->path, key.path.data(), key.path.size()) == 0;
+}
+
+bool
+RemapImage::has_host(int store, const char *host, int host_len) const
+{
+  return find_host(_base, image_at<ImageHeader>(_base, 0)->stores[store], host, host_len) != 0;
+}
+
+int
+RemapImage::find(int store, const char *host, int host_len, URL *url, int port, bool normal_search) const
+{
+  uint32_t index = find_host(_base, image_at<ImageHeader>(_base, 0)->stores[store], host, host_len);
+  if (!index) {
+    return -1;
+  }
+
+  uint32_t n_tries       = *image_at<uint32_t>(_base, index);
+  const ImageTrie *tries = image_at<ImageTrie>(_base, index + sizeof(uint32_t));
+  const ImageTrie *trie  = nullptr;
+
+  if (normal_search) {
+    // If the scheme is empty (e.g. because of a CONNECT method), guess it based on port, as UrlMappingPathIndex does.
+    int scheme = url->scheme_get_wksidx();
+    if (scheme == -1) {
+      scheme = port == 80 ? URL_WKSIDX_HTTP : URL_WKSIDX_HTTPS;
+    }
+    for (uint32_t t = 0; t < n_tries && !trie; ++t) {
+      if (tries[t].scheme == scheme && tries[t].port == port) {
+        trie = &tries[t];
+      }
+    }
+    if (!trie) {
+      Debug("url_rewrite", "No mappings exist for scheme index, port combo <%d, %d>", scheme, port);
+      return -1;
+    }
+  } else {
+    trie = &tries[0];
+  }
+
+  int path_len;
+  const char *path = url->path_get(&path_len);
+  if (!path) {
+    path_len = 0;
+  }
+
+  // Same as Trie::Search(), the best rank on the way down and the longest path on ties.
+  const ImageNode *node  = image_at<ImageNode>(_base, trie->root);
+  const ImageNode *found = nullptr;
+  int depth              = 0;
+
+  while (true) {
+    if (node->rule >= 0 && (!found || node->rank <= found->rank)) {
+      found = node;
+    }
+    if (depth == path_len) {
+      break;
+    }
+
+    const uint32_t *children  = image_at<uint32_t>(_base, node->children);
+    const unsigned char *keys = reinterpret_cast<const unsigned char *>(children + node->n_children);
+    const void *spot          = nullptr;
+    if (node->n_children) {
+      spot = memchr(keys, static_cast<unsigned char>(path[depth]), node->n_children);
+    }
+    if (!spot) {
+      break;
+    }
+
+    const ImageNode *child = image_at<ImageNode>(_base, children[static_cast<const unsigned char *>(spot) - keys]);
+    if (child->label_len > static_cast<uint32_t>(path_len - depth) ||
+        memcmp(_base + child->label + 1, path + depth + 1, child->label_len - 1) != 0) {
+      break;
+    }
+    node = child;
+    depth += child->label_len;
+  }
+
+  return found ? found->rule : -1;
+}
+
+RemapImage::Key
+RemapImage::key(int store, url_mapping *mapping)
+{
+  Key key;
+  int host_len, path_len;
+  const char *host = mapping->fromURL.host_get(&host_len);
+  const char *path = mapping->fromURL.path_get(&path_len);
+
+  key.store  = store;
+  key.rank   = mapping->getRank();
+  key.port   = mapping->fromURL.port_get();
+  key.scheme = mapping->fromURL.scheme_get_wksidx();
+  if (key.scheme == -1) {
+    key.scheme = key.port == 80 ? URL_WKSIDX_HTTP : URL_WKSIDX_HTTPS;
+  }
+  if (host) {
+    key.host = std::string_view(host, host_len);
+  }
+  if (path) {
+    key.path = std::string_view(path, path_len);
+  }
+  return key;
+}
+
+bool
+RemapImage::write(const char *path, const std::vector<Key> &keys)
+{
+  ImageBuffer img;
+  ImageHeader header = {IMAGE_MAGIC, IMAGE_VERSION, 0, static_cast<uint32_t>(keys.size()), 0, {0}};
+  std::unordered_map<std::string_view, uint32_t> strings;
+  std::vector<uint32_t> host_offset(keys.size());
+  std::vector<uint32_t> path_offset(keys.size());
+
+  img.append(header);
+
+  auto intern = [&](std::string_view s) {
+    auto spot = strings.emplace(s, 0);
+    if (spot.second) {
+      spot.first->second = img.append(s.data(), s.size());
+    }
+    return spot.first->second;
+  };
+  for (size_t i = 0; i < keys.size(); ++i) {
+    host_offset[i] = intern(keys[i].host);
+    path_offset[i] = intern(keys[i].path);
+  }
+
+  img.align();
+  header.rules = img.size();
+  for (size_t i = 0; i < keys.size(); ++i) {
+    const Key &key = keys[i];
+    ImageRule rule = {static_cast<uint32_t>(key.store),
+                      key.rank,
+                      key.scheme,
+                      key.port,
+                      host_offset[i],
+                      static_cast<uint32_t>(key.host.size()),
+                      path_offset[i],
+                      static_cast<uint32_t>(key.path.size())};
+    img.append(rule);
+  }
+
+  for (int store = 0; store < N_STORES; ++store) {
+    std::vector<int> ord;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      if (keys[i].store == store) {
+        ord.push_back(i);
+      }
+    }
+    if (ord.empty()) {
+      continue;
+    }
+
+    // By host, then by scheme and port, then by path. This groups the rules of each path trie.
+    auto trie_key = [&](int i) { return std::make_tuple(keys[i].host, keys[i].scheme, keys[i].port); };
+    std::sort(ord.begin(), ord.end(), [&](int a, int b) {
+      return std::tie(keys[a].host, keys[a].scheme, keys[a].port, keys[a].path) <
+             std::tie(keys[b].host, keys[b].scheme, keys[b].port, keys[b].path);
+    });
+
+    std::vector<std::pair<int, uint32_t>> hosts; // first rule of the host and its path index
+    for (size_t h = 0; h < ord.size();) {
+      std::vector<ImageTrie> tries;
+      size_t t = h;
+
+      while (t < ord.size() && keys[ord[t]].host == keys[ord[h]].host) {
+        size_t e = t + 1;
+        while (e < ord.size() && trie_key(ord[e]) == trie_key(ord[t])) {
+          if (keys[ord[e]].path == keys[ord[e - 1]].path) {
+            Warning("duplicate remap rules %d and %d, cannot write the remap image", ord[e - 1], ord[e]);
+            return false;
+          }
+          ++e;
+        }
+        tries.push_back({keys[ord[t]].scheme, keys[ord[t]].port, write_node(img, keys, path_offset, &ord[t], e - t, 0, 0, 0)});
+        t = e;
+      }
+
+      uint32_t n_tries = tries.size();
+      uint32_t index   = img.append(n_tries);
+      img.append(tries.data(), tries.size() * sizeof(ImageTrie));
+      hosts.emplace_back(ord[h], index);
+      h = t;
+    }
+
+    // A table at most half full.
+    uint32_t n_buckets = 2;
+    while (n_buckets < hosts.size() * 2) {
+      n_buckets *= 2;
+    }
+    std::vector<ImageHost> buckets(n_buckets, ImageHost{0, 0, 0, 0});
+    for (auto &host : hosts) {
+      const Key &key = keys[host.first];
+      uint32_t hash  = host_hash(key.host.data(), key.host.size());
+      uint32_t i     = hash & (n_buckets - 1);
+
+      while (buckets[i].index) {
+        i = (i + 1) & (n_buckets - 1);
+      }
+      buckets[i] = {hash, host_offset[host.first], static_cast<uint32_t>(key.host.size()), host.second};
+    }
+    header.stores[store] = img.append(n_buckets);
+    img.append(buckets.data(), buckets.size() * sizeof(ImageHost));
+  }
+
+  header.size             = img.size();
+  *img.at<ImageHeader>(0) = header;
+
+  const std::string &data = img.data();
+  std::string tmp_path    = std::string(path) + ".XXXXXX";
+  int fd                  = mkstemp(&tmp_path[0]);
+  bool written            = fd >= 0;
+
+  for (size_t done = 0; written && done < data.size();) {
+    ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+    if (n < 0 && errno != EINTR) {
+      written = false;
+    } else if (n > 0) {
+      done += n;
+    }
+  }
+  if (written) {
+    written = fchmod(fd, 0644) == 0 && fsync(fd) == 0;
+  }
+  if (fd >= 0 && ::close(fd) != 0) {
+    written = false;
+  }
+  if (!written || rename(tmp_path.c_str(), path) != 0) {
+    Warning("cannot write the remap image %s: %s", path, strerror(errno));
+    if (fd >= 0) {
+      unlink(tmp_path.c_str());
+    }
+    return false;
+  }
+
+  Debug("url_rewrite", "wrote the remap image %s, %zu rules in %zu bytes", path, keys.size(), data.size());
+  return true;
+}
@@ -0,0 +1,106 @@
+/** @file
+
+  Compiled remap lookup tables.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "URL.h"
+
+class url_mapping;
+
+/** The host tables and path tries of the non regex remap rules, in a file which is mapped and searched in place.
+
+    A rule is known by its ordinal, the order in which remap.config inserted it into the tables. The image holds
+    only the lookup structures, the rules themselves (URLs, plugins, filters) are still built from remap.config.
+    When they are, the key of every rule is checked against the image, any difference means the image is out of
+    date and the tables are built in memory instead.
+ */
+class RemapImage
+{
+public:
+  /// The mapping stores of UrlRewrite, in the order of their host tables in the image.
+  static constexpr int N_STORES = 5;
+
+  /// What the lookup of a rule depends on.
+  struct Key {
+    int store  = 0;
+    int rank   = 0;
+    int scheme = 0; ///< Well known scheme index, guessed from the port if the rule has none.
+    int port   = 0;
+    std::string_view host;
+    std::string_view path;
+  };
+
+  RemapImage() = default;
+  ~RemapImage();
+
+  // noncopyable
+  RemapImage(const RemapImage &) = delete;
+  RemapImage &operator=(const RemapImage &) = delete;
+
+  /** Map the image at @a path.
+
+      @return @c false if the file is missing or is not an image of this version.
+   */
+  bool open(const char *path);
+  void close();
+
+  bool
+  is_open() const
+  {
+    return _base != nullptr;
+  }
+
+  int n_rules() const;
+
+  /// Whether the rule with @a ordinal has the lookup @a key.
+  bool matches(int ordinal, const Key &key) const;
+
+  /// Whether the host table of @a store has an entry for @a host.
+  bool has_host(int store, const char *host, int host_len) const;
+
+  /** Find the rule for a request, the same way as UrlRewrite::_tableLookup().
+
+      @a host must be lower case. If @a normal_search is @c false the first path trie of the host is searched,
+      whatever the scheme and port of the request.
+
+      @return The ordinal of the rule or -1 if none matches.
+   */
+  int find(int store, const char *host, int host_len, URL *url, int port, bool normal_search) const;
+
+  /// The lookup key of @a mapping in @a store. RemapConfig inserts a rule under the host of its from URL.
+  static Key key(int store, url_mapping *mapping);
+
+  /** Write the image of the rules with the @a keys, the key of ordinal N at N.
+
+      The image is written to a temporary file which is renamed to @a path, a process which has the
+      previous image mapped keeps it.
+   */
+  static bool write(const char *path, const std::vector<Key> &keys);
+
+private:
+  const char *_base = nullptr;
+  size_t _size      = 0;
+};
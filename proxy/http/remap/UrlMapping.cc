@@ -109,7 +109,10 @@ url_mapping::~url_mapping()
     delete afr;
   }
 
-  // Destroy the URLs
+  // Destroy the URLs, they usually share a heap.
+  if (toURL.m_heap == fromURL.m_heap) {
+    toURL.clear();
+  }
   fromURL.destroy();
   toURL.destroy();
 }
@@ -79,8 +79,25 @@ UrlRewrite::load()
 
   REC_ReadConfigInteger(reverse_proxy, "proxy.config.reverse_proxy.enabled");
 
+  // Look the rules up in place in the remap image if there is one which matches remap.config.
+  std::string image_path;
+  char image_name[PATH_NAME_MAX] = "";
+  REC_ReadConfigString(image_name, "proxy.config.url_remap.image_filename", sizeof(image_name));
+  if (*image_name) {
+    image_path = Layout::relative_to(RecConfigReadRuntimeDir(), image_name);
+    this->UseImage(image_path.c_str());
+  }
+
   if (0 == this->BuildTable(config_file_path)) {
     _valid = true;
+    if (!image_path.empty()) {
+      // The first load, or remap.config changed since the image was written.
+      bool has_image = this->uses_image() || this->WriteImage(image_path.c_str());
+      // A new image from traffic_remap_compile is loaded by a configuration reload, as remap.config is.
+      if (has_image && load_remap_file_cb) {
+        load_remap_file_cb(image_path.c_str());
+      }
+    }
     if (is_debug_tag_set("url_rewrite")) {
       Print();
     }
@@ -95,6 +112,11 @@ UrlRewrite::~UrlRewrite()
   ats_free(this->ts_name);
   ats_free(this->http_default_redirect_url);
 
+  if (_image.is_open()) {
+    for (auto &rule : _rules) {
+      delete rule.mapping;
+    }
+  }
   DestroyStore(forward_mappings);
   DestroyStore(reverse_mappings);
   DestroyStore(permanent_redirects);
@@ -133,7 +155,7 @@ UrlRewrite::SetupBackdoorMapping()
   mapping->fromURL.parse(from_url, sizeof(from_url) - 1);
   mapping->fromURL.scheme_set(URL_SCHEME_HTTP, URL_LEN_HTTP);
 
-  mapping->toURL.create(nullptr);
+  mapping->toURL.create(mapping->fromURL.m_heap);
   mapping->toURL.parse(to_url, sizeof(to_url) - 1);
 
   return mapping;
@@ -182,6 +204,14 @@ UrlRewrite::Print()
 void
 UrlRewrite::PrintStore(MappingsStore &store)
 {
+  if (_image.is_open()) {
+    for (auto &rule : _rules) {
+      if (_stores[rule.store] == &store) {
+        rule.mapping->Print();
+      }
+    }
+  }
+
   if (store.hash_lookup) {
     for (auto &it : *store.hash_lookup) {
       it.second->Print();
@@ -567,7 +597,7 @@ UrlRewrite::_addToStore(MappingsStore &store, url_mapping *new_mapping, RegexMap
     store.regex_list.enqueue(reg_map);
     retval = true;
   } else {
-    retval = TableInsert(store.hash_lookup, new_mapping, src_host);
+    retval = _insertRule(store, new_mapping, src_host);
   }
   if (retval) {
     ++count;
@@ -620,9 +650,9 @@ UrlRewrite::InsertForwardMapping(mapping_type maptype, url_mapping *mapping, con
   bool success;
 
   if (maptype == FORWARD_MAP_WITH_RECV_PORT) {
-    success = TableInsert(forward_mappings_with_recv_port.hash_lookup, mapping, src_host);
+    success = _insertRule(forward_mappings_with_recv_port, mapping, src_host);
   } else {
-    success = TableInsert(forward_mappings.hash_lookup, mapping, src_host);
+    success = _insertRule(forward_mappings, mapping, src_host);
   }
 
   if (success) {
@@ -662,20 +692,31 @@ UrlRewrite::BuildTable(const char *path)
   ink_assert(num_rules_redirect_temporary == 0);
   ink_assert(num_rules_forward_with_recv_port == 0);
 
-  forward_mappings.hash_lookup.reset(new URLTable);
-  reverse_mappings.hash_lookup.reset(new URLTable);
-  permanent_redirects.hash_lookup.reset(new URLTable);
-  temporary_redirects.hash_lookup.reset(new URLTable);
-  forward_mappings_with_recv_port.hash_lookup.reset(new URLTable);
+  if (!_image.is_open()) {
+    forward_mappings.hash_lookup.reset(new URLTable);
+    reverse_mappings.hash_lookup.reset(new URLTable);
+    permanent_redirects.hash_lookup.reset(new URLTable);
+    temporary_redirects.hash_lookup.reset(new URLTable);
+    forward_mappings_with_recv_port.hash_lookup.reset(new URLTable);
+  }
 
   if (!remap_parse_config(path, this)) {
     // XXX handle file reload error
     return 3;
   }
 
+  if (_image.is_open() && (!_image_matches || _rules.size() != static_cast<size_t>(_image.n_rules()))) {
+    Note("%s the remap image does not match %s, building the lookup tables", modulePrefix, path);
+    if (!_buildTables()) {
+      return 3;
+    }
+  }
+
   // Destroy unused tables
   if (num_rules_forward == 0) {
     forward_mappings.hash_lookup.reset(nullptr);
+  } else if (_image.is_open()) {
+    nohost_rules = _image.has_host(_storeId(forward_mappings), "", 0);
   } else {
     if (forward_mappings.hash_lookup->find("") != forward_mappings.hash_lookup->end()) {
       nohost_rules = 1;
@@ -701,6 +742,91 @@ UrlRewrite::BuildTable(const char *path)
   return 0;
 }
 
+bool
+UrlRewrite::UseImage(const char *path)
+{
+  ink_assert(_rules.empty());
+  return _image.open(path);
+}
+
+bool
+UrlRewrite::WriteImage(const char *path)
+{
+  std::vector<RemapImage::Key> keys;
+
+  keys.reserve(_rules.size());
+  for (auto &rule : _rules) {
+    keys.push_back(RemapImage::key(rule.store, rule.mapping));
+  }
+  return RemapImage::write(path, keys);
+}
+
+int
+UrlRewrite::_storeId(const MappingsStore &store) const
+{
+  for (int i = 0; i < RemapImage::N_STORES; ++i) {
+    if (_stores[i] == &store) {
+      return i;
+    }
+  }
+  ink_release_assert(!"not a mapping store of this table");
+  return -1;
+}
+
+/**
+  Inserts a rule which is not a regex, in the host table of the store or,
+  if the image has the tables, checks that it has the same key as the rule
+  with its ordinal there.
+
+*/
+bool
+UrlRewrite::_insertRule(MappingsStore &store, url_mapping *mapping, const char *src_host)
+{
+  int id = _storeId(store);
+
+  if (_image.is_open()) {
+    if (_image_matches && !_image.matches(_rules.size(), RemapImage::key(id, mapping))) {
+      Debug("url_rewrite", "remap rule %zu is not the one of the remap image", _rules.size());
+      _image_matches = false;
+    }
+  } else if (!TableInsert(store.hash_lookup, mapping, src_host)) {
+    return false;
+  }
+  _rules.push_back({mapping, id});
+  return true;
+}
+
+/**
+  Builds the host tables of the rules loaded for an image which turned out
+  not to match them. The tables own the rules from then on.
+
+*/
+bool
+UrlRewrite::_buildTables()
+{
+  _image.close();
+  for (auto store : _stores) {
+    store->hash_lookup.reset(new URLTable);
+  }
+
+  for (size_t i = 0; i < _rules.size(); ++i) {
+    int host_len;
+    const char *host = _rules[i].mapping->fromURL.host_get(&host_len);
+    std::string src_host(host ? host : "", host ? host_len : 0);
+
+    if (!TableInsert(_stores[_rules[i].store]->hash_lookup, _rules[i].mapping, src_host.c_str())) {
+      Warning("%s unable to add mapping rule to lookup table", modulePrefix);
+      // The rules which are not in a table yet are still owned here.
+      for (size_t j = i; j < _rules.size(); ++j) {
+        delete _rules[j].mapping;
+      }
+      _rules.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
 /**
   Inserts arg mapping in h_table with key src_host chaining the mapping
   of existing entries bound to src_host if necessary.
@@ -764,7 +890,15 @@ UrlRewrite::_mappingLookup(MappingsStore &mappings, URL *request_url, int reques
 
   bool retval          = false;
   int rank_ceiling     = -1;
-  url_mapping *mapping = _tableLookup(mappings.hash_lookup, request_url, request_port, request_host_lower, request_host_len);
+  url_mapping *mapping = nullptr;
+  if (_image.is_open()) {
+    // for empty host don't do a normal search, get a mapping arbitrarily
+    int ordinal = _image.find(_storeId(mappings), request_host_lower, request_host_len, request_url, request_port,
+                              request_host_len ? true : false);
+    mapping = ordinal < 0 ? nullptr : _rules[ordinal].mapping;
+  } else {
+    mapping = _tableLookup(mappings.hash_lookup, request_url, request_port, request_host_lower, request_host_len);
+  }
   if (mapping != nullptr) {
     rank_ceiling = mapping->getRank();
     Debug("url_rewrite", "Found 'simple' mapping with rank %d", rank_ceiling);
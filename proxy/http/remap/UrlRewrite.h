@@ -26,6 +26,7 @@
 #include "tscore/ink_config.h"
 #include "UrlMapping.h"
 #include "UrlMappingPathIndex.h"
+#include "RemapImage.h"
 #include "HttpTransact.h"
 #include "tscore/Regex.h"
 
@@ -75,6 +76,28 @@ public:
    */
   int BuildTable(const char *path);
 
+  /** Use the lookup tables of a remap image for the next BuildTable().
+   *
+   * BuildTable() still loads the rules, and builds the tables if they are not the ones of the image.
+   *
+   * @param path Path to the image file.
+   * @return @c true if the image could be mapped.
+   */
+  bool UseImage(const char *path);
+
+  bool
+  uses_image() const
+  {
+    return _image.is_open();
+  }
+
+  /** Write the image of the lookup tables built by BuildTable().
+   *
+   * @param path Path to the image file.
+   * @return @c true on success.
+   */
+  bool WriteImage(const char *path);
+
   mapping_type Remap_redirect(HTTPHdr *request_header, URL *redirect_url);
   bool ReverseMap(HTTPHdr *response_header);
   void SetReverseFlag(int flag);
@@ -208,9 +231,27 @@ public:
   int num_rules_redirect_temporary     = 0;
   int num_rules_forward_with_recv_port = 0;
 
+  // traffic_remap_compile only needs the lookup keys of the rules.
+  bool load_plugins = true;
+
 private:
   bool _valid = false;
 
+  // A rule of the host tables, by ordinal.
+  struct TableRule {
+    url_mapping *mapping;
+    int store;
+  };
+
+  // The stores in the order of their tables in the image.
+  MappingsStore *const _stores[RemapImage::N_STORES] = {&forward_mappings, &reverse_mappings, &permanent_redirects,
+                                                         &temporary_redirects, &forward_mappings_with_recv_port};
+
+  // When the image is open the host tables are left empty and the rules are owned here.
+  RemapImage _image;
+  std::vector<TableRule> _rules;
+  bool _image_matches = true;
+
   bool _mappingLookup(MappingsStore &mappings, URL *request_url, int request_port, const char *request_host, int request_host_len,
                       UrlMappingContainer &mapping_container);
   url_mapping *_tableLookup(std::unique_ptr<URLTable> &h_table, URL *request_url, int request_port, char *request_host,
@@ -221,6 +262,9 @@ private:
                            int dest_buf_size);
   void _destroyTable(std::unique_ptr<URLTable> &h_table);
   void _destroyList(RegexMappingList &regexes);
+  int _storeId(const MappingsStore &store) const;
+  bool _insertRule(MappingsStore &store, url_mapping *mapping, const char *src_host);
+  bool _buildTables();
   inline bool _addToStore(MappingsStore &store, url_mapping *new_mapping, RegexMapping *reg_map, const char *src_host,
                           bool is_cur_mapping_regex, int &count);
 };
@@ -0,0 +1,219 @@
+/** @file
+
+  Build, reload from the remap image and lookups of a large synthetic remap table.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "catch.hpp"
+
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "UrlRewrite.h"
+#include "IPAllow.h"
+
+// The remap table sets it, the rest of IpAllow is not needed here.
+bool IpAllow::accept_check_p = true;
+
+namespace
+{
+struct TableSize {
+  int hosts;   ///< host only rules
+  int paths;   ///< path prefix rules on every tenth host
+  int dirs;    ///< path prefix rules on a single host
+  int lookups; ///< forward lookups to time
+};
+
+/// Peak resident size of the process, in KB.
+long
+peak_rss()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// The rule found for @a url, by rank and to URL.
+std::string
+lookup(UrlRewrite *table, URL *url, const char *host, int host_len)
+{
+  UrlMappingContainer mapping;
+  if (!table->forwardMappingLookup(url, 80, host, host_len, mapping)) {
+    return "";
+  }
+
+  int len;
+  const char *to = mapping.getToURL()->host_get(&len);
+  return std::to_string(mapping.getMapping()->getRank()) + " " + std::string(to, len);
+}
+
+void
+remap_table(const TableSize &size)
+{
+  static constexpr int N_URLS = 4096;
+
+  char path[]  = "/tmp/remap_table.XXXXXX";
+  char image[] = "/tmp/remap_image.XXXXXX";
+  int fd       = mkstemp(path);
+  FILE *fp     = fd >= 0 ? fdopen(fd, "w") : nullptr;
+  REQUIRE(fp != nullptr);
+  fd = mkstemp(image);
+  REQUIRE(fd >= 0);
+  close(fd);
+
+  int n_rules = 0;
+  for (int i = 0; i < size.hosts; ++i) {
+    fprintf(fp, "map http://host%d.example.com/ http://origin%d.example.net/\n", i, i % 1000);
+    ++n_rules;
+    for (int j = 0; i % 10 == 0 && j < size.paths; ++j) {
+      fprintf(fp, "map http://host%d.example.com/path/%d/ http://origin%d.example.net/p%d/\n", i, j, i % 1000, j);
+      ++n_rules;
+    }
+  }
+  for (int i = 0; i < size.dirs; ++i) {
+    fprintf(fp, "map http://dirs.example.com/static/dir%d/ http://origin.example.net/d%d/\n", i, i);
+    ++n_rules;
+  }
+  fprintf(fp, "map /fallback/ http://fallback.example.net/\n");
+  ++n_rules;
+  fclose(fp);
+
+  // Build the tables from remap.config and write their image, as traffic_remap_compile does.
+  long rss         = peak_rss();
+  ink_hrtime start = ink_get_hrtime_internal();
+  UrlRewrite *built = new UrlRewrite;
+  CHECK(built->BuildTable(path) == 0);
+  CHECK(built->num_rules_forward == n_rules);
+  CHECK(built->nohost_rules == 1);
+  printf("built %d rules in %" PRId64 " ms, peak RSS +%ld KB\n", n_rules, ink_hrtime_to_msec(ink_get_hrtime_internal() - start),
+         peak_rss() - rss);
+
+  start = ink_get_hrtime_internal();
+  REQUIRE(built->WriteImage(image));
+  printf("wrote the image in %" PRId64 " ms\n", ink_hrtime_to_msec(ink_get_hrtime_internal() - start));
+
+  // A reload with the image only builds the rules, while the previous table is alive.
+  rss               = peak_rss();
+  start             = ink_get_hrtime_internal();
+  UrlRewrite *table = new UrlRewrite;
+  REQUIRE(table->UseImage(image));
+  CHECK(table->BuildTable(path) == 0);
+  CHECK(table->uses_image());
+  CHECK(table->forward_mappings.hash_lookup == nullptr);
+  CHECK(table->num_rules_forward == n_rules);
+  CHECK(table->nohost_rules == 1);
+  printf("reloaded %d rules with the image in %" PRId64 " ms, peak RSS +%ld KB\n", n_rules,
+         ink_hrtime_to_msec(ink_get_hrtime_internal() - start), peak_rss() - rss);
+
+  URL *urls = new URL[N_URLS];
+  for (int i = 0; i < N_URLS; ++i) {
+    char buf[128];
+    const char *s = buf;
+    int len;
+
+    if (i % 2) {
+      len = snprintf(buf, sizeof(buf), "http://host%d.example.com/path/%d/object", (i * 7919) % size.hosts, i % (size.paths + 1));
+    } else {
+      len = snprintf(buf, sizeof(buf), "http://dirs.example.com/static/dir%d/object", (i * 7919) % size.dirs);
+    }
+    urls[i].create(nullptr);
+    urls[i].parse(s, len);
+  }
+
+  // The image finds the rules the tables in memory do.
+  for (int i = 0; i < N_URLS; ++i) {
+    int host_len;
+    const char *host = urls[i].host_get(&host_len);
+    std::string rule = lookup(built, &urls[i], host, host_len);
+
+    INFO(urls[i].string_get_ref());
+    CHECK(!rule.empty());
+    CHECK(lookup(table, &urls[i], host, host_len) == rule);
+  }
+  URL other;
+  other.create(nullptr);
+  other.parse("http://other.example.com/fallback/object", 40);
+  CHECK(lookup(table, &other, "", 0) == lookup(built, &other, "", 0));
+  CHECK(lookup(table, &other, "", 0) == std::to_string(n_rules - 1) + " fallback.example.net");
+  CHECK(lookup(table, &other, "other.example.com", 17) == "");
+  other.destroy();
+
+  int hits = 0;
+  start    = ink_get_hrtime_internal();
+  for (int i = 0; i < size.lookups; ++i) {
+    URL *url = &urls[i % N_URLS];
+    UrlMappingContainer mapping;
+    int host_len;
+    const char *host = url->host_get(&host_len);
+
+    if (table->forwardMappingLookup(url, 80, host, host_len, mapping)) {
+      ++hits;
+    }
+  }
+  ink_hrtime time = ink_get_hrtime_internal() - start;
+
+  CHECK(hits == size.lookups);
+  printf("%d lookups in the image in %" PRId64 " ms\n", size.lookups, ink_hrtime_to_msec(time));
+
+  // A rule which is not in the image, the tables are built in memory.
+  fp = fopen(path, "a");
+  REQUIRE(fp != nullptr);
+  fprintf(fp, "map http://added.example.com/ http://origin.example.net/\n");
+  fclose(fp);
+
+  UrlRewrite *changed = new UrlRewrite;
+  REQUIRE(changed->UseImage(image));
+  CHECK(changed->BuildTable(path) == 0);
+  CHECK(!changed->uses_image());
+  CHECK(changed->num_rules_forward == n_rules + 1);
+  other.create(nullptr);
+  other.parse("http://added.example.com/object", 31);
+  CHECK(lookup(changed, &other, "added.example.com", 17) == std::to_string(n_rules) + " origin.example.net");
+  other.destroy();
+  for (int i = 0; i < N_URLS; i += 97) {
+    int host_len;
+    const char *host = urls[i].host_get(&host_len);
+    CHECK(lookup(changed, &urls[i], host, host_len) == lookup(built, &urls[i], host, host_len));
+  }
+  unlink(path);
+  unlink(image);
+
+  for (int i = 0; i < N_URLS; ++i) {
+    urls[i].destroy();
+  }
+  delete[] urls;
+  delete built;
+  delete table;
+  delete changed;
+}
+} // namespace
+
+TEST_CASE("UrlRewrite table", "[remap]")
+{
+  remap_table({1000, 8, 500, 10000});
+}
+
+// Run with test_proxy_http_remap "[benchmark]".
+TEST_CASE("UrlRewrite benchmark", "[remap][benchmark][.]")
+{
+  remap_table({100000, 8, 5000, 1000000});
+}
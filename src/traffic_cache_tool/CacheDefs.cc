@@ -223,6 +223,27 @@ Stripe::Stripe(Span *span, Bytes start, CacheStoreBlocks len) : _span(span), _st
   printf("hash id of stripe is hash of %.*s\n", static_cast<int>(hashText.size()), hashText.data());
 }
 
+Errata
+Stripe::loadKeyHash()
+{
+  Errata zret;
+  alignas(CacheStoreBlocks::SCALE) char buff[CacheStoreBlocks::SCALE];
+  StripeMeta const *meta = reinterpret_cast<StripeMeta const *>(buff);
+
+  // Header A is at the start of the stripe, all the copies have the same key hash.
+  if (pread(_span->_fd, buff, sizeof(buff), _start) != sizeof(buff) || !this->validateMeta(meta)) {
+    return Errata::Message(0, 1, "Stripe ", hashText, " has no valid header, using the default key hash");
+  }
+#if TS_ENABLE_FIPS == 0
+  if (meta->key_hash == CACHE_KEY_HASH_XXH3) {
+    _key_hash = CryptoContext::XXH3;
+  }
+#endif
+  // The stripe placement is hashed like the keys.
+  CryptoContext(_key_hash).hash_immediate(hash_id, hashText.data(), static_cast<int>(hashText.size()));
+  return zret;
+}
+
 bool
 Stripe::isFree() const
 {
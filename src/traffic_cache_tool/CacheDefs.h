@@ -158,7 +158,7 @@ public:
   uint32_t write_serial;
   uint32_t dirty;
   uint32_t sector_size;
-  uint32_t unused; // pad out to 8 byte boundary
+  uint32_t key_hash; // proxy.config.cache.key_hash of the keys, 0 (default hash) in older stripes
   uint16_t freelist[1];
 };
 
@@ -366,6 +366,8 @@ constexpr int DIR_SIZE_WIDTH            = 6;
 constexpr int DIR_BLOCK_SIZES           = 4;
 constexpr int CACHE_BLOCK_SHIFT         = 9;
 constexpr int CACHE_BLOCK_SIZE          = (1 << CACHE_BLOCK_SHIFT); // 512, smallest sector size
+constexpr uint32_t DOC_MAGIC            = 0x5F129B13;
+constexpr uint32_t CACHE_KEY_HASH_XXH3  = 1; // proxy.config.cache.key_hash
 
 namespace ct
 {
@@ -458,7 +460,8 @@ struct Span {
 
   ts::file::path _path;     ///< File system location of span.
   ats_scoped_fd _fd;        ///< Open file descriptor for span.
-  int _vol_idx = 0;         ///< Forced volume.
+  int _vol_idx    = 0;      ///< Forced volume.
+  bool _fast_tier = false;  ///< Span is in the fast tier of a tiered cache.
   CacheStoreBlocks _base;   ///< Offset to first usable byte.
   CacheStoreBlocks _offset; ///< Offset to first content byte.
   // The space between _base and _offset is where the span information is stored.
@@ -515,6 +518,8 @@ struct Stripe {
 
   /// Load metadata for this stripe.
   Errata loadMeta();
+  /// Load the hash of the cache keys from the stripe header, and hash the stripe with it.
+  Errata loadKeyHash();
   Errata loadDir();
   int check_loop(int s);
   void dir_check();
@@ -526,6 +531,7 @@ struct Stripe {
 
   Span *_span;           ///< Hosting span.
   CryptoHash hash_id;    /// hash_id
+  CryptoContext::HashType _key_hash = CryptoContext::Setting; ///< Hash of the cache keys in the stripe.
   Bytes _start;          ///< Offset of first byte of stripe metadata.
   Bytes _content;        ///< Start of content.
   CacheStoreBlocks _len; ///< Length of stripe.
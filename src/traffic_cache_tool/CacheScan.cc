@@ -27,12 +27,45 @@
 #include "../../proxy/hdrs/MIME.h"
 #include "../../proxy/hdrs/URL.h"
 
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+
 // using namespace ct;
 
 constexpr HdrHeapMarshalBlocks HTTP_ALT_MARSHAL_SIZE = ts::round_up(sizeof(HTTPCacheAlt));
+constexpr int64_t INVENTORY_READ_SIZE                = 8 * 1024 * 1024; // sequential reads of the stripe content
+constexpr size_t INVENTORY_FLUSH_SIZE                = 1024 * 1024;     // inventory lines kept before a flush
 
 namespace ct
 {
+namespace
+{
+  // Value of the field @a name of @a mh, empty if it is missing or not in @a mem.
+  std::string_view
+  find_field(ts::MemSpan<char> &mem, MIMEHdrImpl *mh, std::string_view name)
+  {
+    if (!mh || !mem.contains((char *)mh)) {
+      return {};
+    }
+    int blocks = 0; // bound the walk of a corrupted list
+    for (MIMEFieldBlockImpl *fb = &mh->m_first_fblock; fb && mem.contains((char *)fb) && blocks < 1024;
+         fb = fb->m_next, ++blocks) {
+      for (uint32_t i = 0; i < fb->m_freetop && i < MIME_FIELD_BLOCK_SLOTS; ++i) {
+        MIMEField *f = &fb->m_field_slots[i];
+        if (f->m_readiness != MIME_FIELD_SLOT_READINESS_LIVE || f->m_len_name != name.size() || !f->m_ptr_value ||
+            !mem.contains((char *)f->m_ptr_name) || !mem.contains((char *)f->m_ptr_value + f->m_len_value)) {
+          continue;
+        }
+        if (0 == strncasecmp(f->m_ptr_name, name.data(), name.size())) {
+          return {f->m_ptr_value, f->m_len_value};
+        }
+      }
+    }
+    return {};
+  }
+} // namespace
+
 Errata
 CacheScan::Scan(bool search)
 {
@@ -76,6 +109,194 @@ CacheScan::Scan(bool search)
   return zret;
 }
 
+Errata
+CacheScan::Inventory(InventoryStats &stats, std::function<void(std::string &)> const &flush)
+{
+  Errata zret;
+  Stripe *stripe = this->stripe;
+  int fd         = stripe->_span->_fd;
+  bool fast_tier = stripe->_span->_fast_tier;
+  int64_t end    = stripe->_start.count() + Bytes(stripe->_len).count();
+
+  // Offset and approximate size of the head fragments, read in the order they are on the disk.
+  std::vector<std::pair<int64_t, int64_t>> heads;
+  int64_t n_entries  = stripe->_segments * stripe->_buckets * DIR_DEPTH;
+  CacheDirEntry *dir = stripe->dir_segment(0);
+  for (int64_t i = 0; i < n_entries; ++i) {
+    CacheDirEntry *e = dir_in_seg(dir, i);
+    if (dir_offset(e) && dir_head(e) && stripe->dir_valid(e)) {
+      heads.emplace_back(stripe->stripe_offset(e), dir_approx_size(e));
+    }
+  }
+  std::sort(heads.begin(), heads.end());
+  heads.erase(std::unique(heads.begin(), heads.end(), [](auto const &a, auto const &b) { return a.first == b.first; }),
+              heads.end());
+
+  int64_t buf_size  = INVENTORY_READ_SIZE;
+  char *buf         = static_cast<char *>(ats_memalign(ats_pagesize(), buf_size));
+  int64_t buf_start = 0;
+  int64_t buf_len   = 0;
+  std::string out;
+
+  for (auto const &[offset, size] : heads) {
+    if (offset < buf_start || offset + size > buf_start + buf_len) {
+      int64_t len = std::min(std::max(INVENTORY_READ_SIZE, size), end - offset);
+      if (len > buf_size) {
+        ats_free(buf);
+        buf_size = len;
+        buf      = static_cast<char *>(ats_memalign(ats_pagesize(), buf_size));
+      }
+      ssize_t n = pread(fd, buf, len, offset);
+      buf_start = offset;
+      buf_len   = std::max<ssize_t>(n, 0);
+      if (n < 0) {
+        zret.push(0, errno, "Failed to read content from the stripe ", stripe->hashText, ": ", strerror(errno));
+        ++stats.errors;
+        continue;
+      }
+    }
+
+    Doc *doc      = reinterpret_cast<Doc *>(buf + (offset - buf_start));
+    int64_t avail = buf_start + buf_len - offset;
+    if (avail < static_cast<int64_t>(sizeof(Doc)) || doc->magic != DOC_MAGIC || doc->len < sizeof(Doc) + doc->hlen ||
+        static_cast<int64_t>(sizeof(Doc) + doc->hlen) > avail) {
+      ++stats.errors;
+      continue;
+    }
+    ++stats.docs;
+    if (doc->hlen) {
+      this->inventory_alternates(doc, fast_tier, stats, out);
+      if (out.size() >= INVENTORY_FLUSH_SIZE) {
+        flush(out);
+      }
+    }
+  }
+  if (!out.empty()) {
+    flush(out);
+  }
+  ats_free(buf);
+
+  return zret;
+}
+
+void
+CacheScan::inventory_alternates(Doc *doc, bool fast_tier, InventoryStats &stats, std::string &out)
+{
+  char *start = doc->hdr();
+  char *buf   = start;
+  int length  = doc->hlen;
+  time_t now  = time(nullptr);
+  ts::MemSpan<char> doc_mem(start, length);
+
+  while (length - (buf - start) > (int)sizeof(HTTPCacheAlt)) {
+    HTTPCacheAlt *a = (HTTPCacheAlt *)buf;
+    if (a->m_magic != CACHE_ALT_MAGIC_MARSHALED) {
+      break;
+    }
+    if (this->unmarshal(buf, length - (buf - start), nullptr).size() || a->m_magic != CACHE_ALT_MAGIC_ALIVE ||
+        a->m_unmarshal_len <= 0 || !a->m_request_hdr.m_http || !doc_mem.contains((char *)a->m_request_hdr.m_http)) {
+      ++stats.errors;
+      break;
+    }
+
+    int64_t size;
+    memcpy(&size, a->m_object_size, sizeof(size));
+    size = std::max<int64_t>(size, 0);
+
+    std::string_view host;
+    auto *url = a->m_request_hdr.m_http->u.req.m_url_impl;
+    if (check_url(doc_mem, url) && url->m_ptr_host && doc_mem.contains((char *)url->m_ptr_host)) {
+      host = std::string_view(url->m_ptr_host, url->m_len_host);
+    } else {
+      host = find_field(doc_mem, a->m_request_hdr.m_mime, "Host");
+    }
+    std::string_view content_type;
+    if (a->m_response_hdr.m_http && doc_mem.contains((char *)a->m_response_hdr.m_http)) {
+      content_type = find_field(doc_mem, a->m_response_hdr.m_mime, "Content-Type");
+      content_type = content_type.substr(0, content_type.find(';'));
+    }
+    while (!content_type.empty() && isspace(content_type.back())) {
+      content_type.remove_suffix(1);
+    }
+
+    ts::LocalBufferWriter<512> w;
+    w.print("{}\t{}\t", doc->first_key, size);
+    if (a->m_response_received_time > 0) {
+      w.print("{}", std::max<time_t>(now - a->m_response_received_time, 0));
+    } else {
+      w.write('-');
+    }
+    w.print("\t{}\t{}\t{}\n", content_type.empty() ? "-" : content_type, fast_tier ? "fast" : "capacity",
+            host.empty() ? "-" : host);
+    out.append(w.view());
+
+    stats.total.add(size);
+    if (fast_tier) {
+      stats.fast_tier.add(size);
+    }
+    stats.sizes[size ? 64 - __builtin_clzll(size) : 0].add(size);
+    stats.hosts[std::string(host)].add(size);
+    stats.content_types[std::string(content_type)].add(size);
+
+    buf += a->m_unmarshal_len;
+  }
+}
+
+void
+InventoryStats::merge(InventoryStats const &that)
+{
+  total.objects += that.total.objects;
+  total.bytes += that.total.bytes;
+  fast_tier.objects += that.fast_tier.objects;
+  fast_tier.bytes += that.fast_tier.bytes;
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    sizes[i].objects += that.sizes[i].objects;
+    sizes[i].bytes += that.sizes[i].bytes;
+  }
+  for (auto const &[host, count] : that.hosts) {
+    hosts[host].objects += count.objects;
+    hosts[host].bytes += count.bytes;
+  }
+  for (auto const &[type, count] : that.content_types) {
+    content_types[type].objects += count.objects;
+    content_types[type].bytes += count.bytes;
+  }
+  docs += that.docs;
+  errors += that.errors;
+}
+
+void
+InventoryStats::print(std::ostream &out, size_t top) const
+{
+  // Print the @a top entries of @a counts with the most bytes.
+  auto print_top = [&](std::string_view title, std::unordered_map<std::string, Count> const &counts) {
+    std::vector<std::pair<std::string const *, Count>> v;
+    for (auto const &[name, count] : counts) {
+      v.emplace_back(&name, count);
+    }
+    auto n = std::min(top, v.size());
+    std::partial_sort(v.begin(), v.begin() + n, v.end(),
+                      [](auto const &a, auto const &b) { return a.second.bytes > b.second.bytes; });
+    out << title << " (" << counts.size() << ")" << std::endl;
+    for (size_t i = 0; i < n; ++i) {
+      out << "  " << (v[i].first->empty() ? "-" : *v[i].first) << " objects: " << v[i].second.objects
+          << " bytes: " << v[i].second.bytes << std::endl;
+    }
+  };
+
+  out << "Inventory: " << total.objects << " alternates, " << total.bytes << " bytes in " << docs << " head fragments, " << errors
+      << " errors" << std::endl;
+  out << "Fast tier: " << fast_tier.objects << " alternates, " << fast_tier.bytes << " bytes" << std::endl;
+  out << "Sizes" << std::endl;
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    if (sizes[i].objects) {
+      out << "  < " << (uint64_t(1) << i) << " objects: " << sizes[i].objects << " bytes: " << sizes[i].bytes << std::endl;
+    }
+  }
+  print_top("Top hosts", hosts);
+  print_top("Top content types", content_types);
+}
+
 Errata
 CacheScan::unmarshal(HTTPHdrImpl *obj, intptr_t offset)
 {
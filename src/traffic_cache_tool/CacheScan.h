@@ -29,6 +29,9 @@
 
 #pragma once
 
+#include <array>
+#include <functional>
+#include <iosfwd>
 #include <thread>
 #include <unordered_map>
 #include "CacheDefs.h"
@@ -37,6 +40,33 @@
 // using namespace ct;
 namespace ct
 {
+/// Totals of an inventory of the cache, kept per scanning thread and merged at the end.
+struct InventoryStats {
+  struct Count {
+    uint64_t objects = 0;
+    uint64_t bytes   = 0;
+
+    void
+    add(uint64_t size)
+    {
+      ++objects;
+      bytes += size;
+    }
+  };
+
+  Count total;                                          ///< All the alternates found.
+  Count fast_tier;                                      ///< Alternates in spans of the fast tier.
+  std::array<Count, 64> sizes;                          ///< Alternates by log2 of their size.
+  std::unordered_map<std::string, Count> hosts;         ///< Alternates by host of the URL.
+  std::unordered_map<std::string, Count> content_types; ///< Alternates by content type.
+  uint64_t docs   = 0;                                  ///< Head fragments read.
+  uint64_t errors = 0;                                  ///< Head fragments which could not be read or decoded.
+
+  void merge(InventoryStats const &that);
+  /// Print the totals, the size histogram and the @a top hosts and content types.
+  void print(std::ostream &out, size_t top) const;
+};
+
 class CacheScan
 {
   Stripe *stripe;
@@ -51,6 +81,14 @@ public:
   };
   CacheScan(Stripe *str) : stripe(str) {}
   Errata Scan(bool search = false);
+  /** Add the alternates of the stripe to @a stats and a line per alternate to the inventory.
+
+      The head fragments are read in offset order in large reads, so the stripe is read sequentially
+      instead of seeking to each directory entry. @a flush is called with the lines whenever enough
+      of them are pending and at the end of the stripe, it must empty the string.
+  */
+  Errata Inventory(InventoryStats &stats, std::function<void(std::string &)> const &flush);
+  void inventory_alternates(Doc *doc, bool fast_tier, InventoryStats &stats, std::string &out);
   Errata get_alternates(const char *buf, int length, bool search);
   int unmarshal(HdrHeap *hh, int buf_length, int obj_type, HdrHeapObjImpl **found_obj, RefCountObj *block_ref);
   Errata unmarshal(char *buf, int len, RefCountObj *block_ref);
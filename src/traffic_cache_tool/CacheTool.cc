@@ -41,6 +41,7 @@
 #include "tscore/BufferWriter.h"
 #include "tscore/CryptoHash.h"
 #include "tscore/ArgParser.h"
+#include <mutex>
 #include <thread>
 
 #include "CacheDefs.h"
@@ -58,6 +59,7 @@ using ts::MemSpan;
 using ts::Doc;
 
 enum { SILENT = 0, NORMAL, VERBOSE } Verbosity = NORMAL;
+constexpr size_t INVENTORY_TOP                  = 20; // hosts and content types in the inventory summary
 extern int cache_config_min_average_object_size;
 extern CacheStoreBlocks Vol_hash_alloc_size;
 extern int OPEN_RW_FLAG;
@@ -208,6 +210,7 @@ struct Cache {
   std::vector<Stripe *> globalVec_stripe;
   std::unordered_set<ts::CacheURL *> URLset;
   unsigned short *stripes_hash_table;
+  CryptoContext::HashType key_hash = CryptoContext::Setting; ///< Hash of the cache keys, from the stripe headers.
 };
 
 Errata
@@ -508,6 +511,7 @@ Cache::loadSpanConfig(ts::file::path const &path)
 {
   static const ts::TextView TAG_ID("id");
   static const ts::TextView TAG_VOL("volume");
+  static const ts::TextView TAG_TIER("tier");
 
   Errata zret;
   std::error_code ec;
@@ -522,7 +526,8 @@ Cache::loadSpanConfig(ts::file::path const &path)
       }
       ts::TextView path = line.take_prefix_if(&isspace);
       if (path) {
-        // After this the line is [size] [id=string] [volume=#]
+        bool fast_tier = false;
+        // After this the line is [size] [id=string] [volume=#] [tier=fast|capacity]
         while (line) {
           ts::TextView value(line.take_prefix_if(&isspace));
           if (value) {
@@ -536,10 +541,19 @@ Cache::loadSpanConfig(ts::file::path const &path)
               } else {
                 zret.push(0, 0, "Invalid volume index '", value, "'");
               }
+            } else if (0 == strcasecmp(tag, TAG_TIER)) {
+              fast_tier = 0 == strcasecmp(value, ts::TextView("fast"));
             }
           }
         }
-        zret = this->loadSpan(ts::file::path(path));
+        size_t n_spans = _spans.size();
+        zret           = this->loadSpan(ts::file::path(path));
+        // The path may load several spans, a storage file of its own for instance.
+        if (fast_tier) {
+          for (auto spot = std::next(_spans.begin(), n_spans); spot != _spans.end(); ++spot) {
+            (*spot)->_fast_tier = true;
+          }
+        }
       }
     }
   } else {
@@ -950,6 +964,20 @@ Cache::build_stripe_hash_table()
   int i                        = 0;
   uint64_t used                = 0;
 
+  // The stripes were hashed with the key hash of the cache that wrote them. A stripe written with
+  // another hash is cleared when the cache starts, so all the valid stripes agree on it.
+  bool found_key_hash = false;
+  for (auto &elt : globalVec_stripe) {
+    if (elt->loadKeyHash()) {
+      if (!found_key_hash) {
+        key_hash       = elt->_key_hash;
+        found_key_hash = true;
+      } else if (elt->_key_hash != key_hash) {
+        std::cerr << "Stripe " << elt->hashText << " was written with another key hash" << std::endl;
+      }
+    }
+  }
+
   // estimate allocation
   for (auto &elt : globalVec_stripe) {
     // printf("stripe length %" PRId64 "\n", elt->_len.count());
@@ -1191,7 +1219,7 @@ Find_Stripe(ts::file::path const &input_file_path)
     cache.dumpSpans(Cache::SpanDumpDepth::SPAN);
     cache.build_stripe_hash_table();
     for (auto host : cache.URLset) {
-      CryptoContext ctx;
+      CryptoContext ctx(cache.key_hash);
       CryptoHash hashT;
       ts::LocalBufferWriter<33> w;
       ctx.update(host->url.data(), host->url.size());
@@ -1307,7 +1335,7 @@ Get_Response(ts::file::path const &input_file_path)
     cache.dumpSpans(Cache::SpanDumpDepth::SPAN);
     cache.build_stripe_hash_table();
     for (auto host : cache.URLset) {
-      CryptoContext ctx;
+      CryptoContext ctx(cache.key_hash);
       CryptoHash hashT;
       ts::LocalBufferWriter<33> w;
       ctx.update(host->url.data(), host->url.size());
@@ -1359,10 +1387,66 @@ Scan_Cache(ts::file::path const &regex_path)
   }
 }
 
+void static inventory_span(Span *span, InventoryStats *total, std::mutex *mutex, FILE *out)
+{
+  InventoryStats stats;
+  auto flush = [&](std::string &lines) {
+    std::lock_guard<std::mutex> lock(*mutex);
+    fwrite(lines.data(), 1, lines.size(), out);
+    lines.clear();
+  };
+
+  for (auto strp : span->_stripes) {
+    strp->loadMeta();
+    strp->loadDir();
+
+    CacheScan cs(strp);
+    Errata zret = cs.Inventory(stats, flush);
+    if (zret.size()) {
+      std::lock_guard<std::mutex> lock(*mutex);
+      std::cerr << zret;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(*mutex);
+  total->merge(stats);
+}
+
+void
+Inventory_Cache(ts::file::path const &output_path)
+{
+  Cache cache;
+  std::vector<std::thread> threadPool;
+  if ((err = cache.loadSpan(SpanFile))) {
+    if (err.size()) {
+      return;
+    }
+    FILE *out = output_path.empty() ? stdout : fopen(output_path.c_str(), "w");
+    if (!out) {
+      err.push(0, errno, "Unable to open ", output_path.string(), ": ", strerror(errno));
+      return;
+    }
+    InventoryStats stats;
+    std::mutex mutex;
+    fputs("# url_hash\tsize\tage\tcontent_type\ttier\thost\n", out);
+    // One thread per span, each reads the stripes of its span sequentially.
+    for (auto sp : cache._spans) {
+      threadPool.emplace_back(inventory_span, sp, &stats, &mutex, out);
+    }
+    for (auto &th : threadPool)
+      th.join();
+    if (out != stdout) {
+      fclose(out);
+    }
+    stats.print(out == stdout ? std::cerr : std::cout, INVENTORY_TOP);
+  }
+}
+
 int
 main(int argc, const char *argv[])
 {
   ts::file::path input_url_file;
+  ts::file::path output_file;
   std::string inputFile;
 
   parser.add_global_usage(std::string(argv[0]) + " --spans <SPAN> --volume <FILE> <COMMAND> [<SUBCOMMAND> ...]\n");
@@ -1394,6 +1478,10 @@ main(int argc, const char *argv[])
   parser.add_command("init", " Initializes uninitialized span", [&]() { Init_disk(input_url_file); });
   parser.add_command("scan", " Scans the whole cache and lists the urls of the cached contents",
                      [&]() { Scan_Cache(input_url_file); });
+  parser
+    .add_command("inventory", " Scans the spans in parallel and writes a line for each alternate in the cache",
+                 [&]() { Inventory_Cache(output_file); })
+    .add_option("--output", "-f", "Inventory file, the standard output if not set", "", 1);
 
   // parse the arguments
   auto arguments = parser.parse(argv);
@@ -1406,6 +1494,9 @@ main(int argc, const char *argv[])
   if (auto data = arguments.get("input")) {
     input_url_file = data.value();
   }
+  if (auto data = arguments.get("output")) {
+    output_file = data.value();
+  }
   if (auto data = arguments.get("aos")) {
     cache_config_min_average_object_size = std::stoi(data.value());
   }
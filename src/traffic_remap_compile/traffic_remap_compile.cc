@@ -0,0 +1,109 @@
+/** @file
+
+  Compile remap.config into the remap image traffic_server looks the rules up in.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "tscore/ink_platform.h"
+#include "tscore/ink_args.h"
+#include "tscore/I_Layout.h"
+#include "tscore/I_Version.h"
+#include "tscore/runroot.h"
+#include "records/I_RecProcess.h"
+#include "RecordsConfig.h"
+#include "HTTP.h"
+#include "IPAllow.h"
+#include "UrlRewrite.h"
+#include "RemapConfig.h"
+
+#define PROGRAM_NAME "traffic_remap_compile"
+
+// The remap rules set it, the rest of IpAllow is not needed here.
+bool IpAllow::accept_check_p = true;
+
+extern int cmd_disable_pfreelist;
+
+static AppVersionInfo appVersionInfo;
+static char remap_file[1024];
+static char image_file[1024];
+
+static const ArgumentDescription argument_descriptions[] = {
+  {"remap", 'f', "The remap.config to compile", "S1023", remap_file, nullptr, nullptr},
+  {"output", 'o', "The remap image to write", "S1023", image_file, nullptr, nullptr},
+  HELP_ARGUMENT_DESCRIPTION(),
+  VERSION_ARGUMENT_DESCRIPTION(),
+  RUNROOT_ARGUMENT_DESCRIPTION()};
+
+// Included remap files are only reported to the manager by traffic_server.
+static void
+load_remap_file(const char * /* remap_file ATS_UNUSED */)
+{
+}
+
+int
+main(int /* argc ATS_UNUSED */, const char **argv)
+{
+  appVersionInfo.setup(PACKAGE_NAME, PROGRAM_NAME, PACKAGE_VERSION, __DATE__, __TIME__, BUILD_MACHINE, BUILD_PERSON, "");
+  diags = new Diags(PROGRAM_NAME, "" /* tags */, "" /* actions */, new BaseLogFile("stderr"));
+
+  process_args(&appVersionInfo, argument_descriptions, countof(argument_descriptions), argv);
+
+  runroot_handler(argv);
+  Layout::create();
+  RecProcessInit(RECM_STAND_ALONE, diags);
+  LibRecordsConfigInit();
+
+  // No thread setup, forbid use of thread local allocators.
+  cmd_disable_pfreelist = true;
+  http_init();
+  load_remap_file_cb = load_remap_file;
+
+  // The same files as traffic_server, unless they are given.
+  std::string remap_path = *remap_file ? remap_file : RecConfigReadConfigPath("proxy.config.url_remap.filename", "remap.config");
+  std::string image_path = image_file;
+  if (image_path.empty()) {
+    char image_name[PATH_NAME_MAX] = "";
+    REC_ReadConfigString(image_name, "proxy.config.url_remap.image_filename", sizeof(image_name));
+    if (!*image_name) {
+      fprintf(stderr, "%s: proxy.config.url_remap.image_filename is not set, give the image file with --output\n", PROGRAM_NAME);
+      return 1;
+    }
+    image_path = Layout::relative_to(RecConfigReadRuntimeDir(), image_name);
+  }
+
+  // The lookup keys of the rules do not depend on their plugins.
+  UrlRewrite table;
+  table.load_plugins = false;
+
+  if (table.BuildTable(remap_path.c_str()) != 0) {
+    fprintf(stderr, "%s: failed to load %s\n", PROGRAM_NAME, remap_path.c_str());
+    return 1;
+  }
+  if (!table.WriteImage(image_path.c_str())) {
+    fprintf(stderr, "%s: failed to write %s\n", PROGRAM_NAME, image_path.c_str());
+    return 1;
+  }
+
+  printf("compiled %d rules of %s into %s\n",
+         table.num_rules_forward + table.num_rules_reverse + table.num_rules_redirect_permanent +
+           table.num_rules_redirect_temporary + table.num_rules_forward_with_recv_port,
+         remap_path.c_str(), image_path.c_str());
+  return 0;
+}
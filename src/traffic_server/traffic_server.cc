@@ -97,6 +97,7 @@ extern "C" int plock(int);
 #include "tscore/ink_config.h"
 #include "P_SSLSNI.h"
 #include "P_SSLClientUtils.h"
+#include "SSLSessionCache.h"
 
 #include "tscore/ink_cap.h"
 
@@ -256,6 +257,12 @@ public:
 
       // TODO: TS-567 Integrate with debugging allocators "dump" features?
       ink_freelists_dump(stderr);
+      if (ioBufSlabAllocator) {
+        ioBufSlabAllocator->dump(stderr);
+      }
+      if (session_cache) {
+        session_cache->dump_stats(stderr);
+      }
       ResourceTracker::dump(stderr);
 
       if (!end) {
@@ -350,6 +357,9 @@ public:
     } else {
       // TODO: TS-567 Integrate with debugging allocators "dump" features?
       ink_freelists_dump(stderr);
+      if (ioBufSlabAllocator) {
+        ioBufSlabAllocator->dump(stderr);
+      }
       ResourceTracker::dump(stderr);
     }
     if (!baseline_taken && use_baseline) {
@@ -0,0 +1,337 @@
+/** @file
+
+  Slab allocator with geometric size classes.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "tscore/SlabAllocator.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <sys/mman.h>
+
+#include "tscore/ink_align.h"
+#include "tscore/ink_assert.h"
+#include "tscore/ink_memory.h"
+#include "tscore/hugepages.h"
+#include "tscore/Diags.h"
+
+#define DEBUG_TAG "slab"
+
+/// Header at the start of each slab.
+struct SlabAllocator::Slab {
+  Slab *prev      = nullptr;
+  Slab *next      = nullptr;
+  void *free_list = nullptr; ///< Objects freed back to the slab.
+  char *carve     = nullptr; ///< Start of the objects never handed out.
+  char *end       = nullptr; ///< End of the object area.
+  size_t n_used   = 0;       ///< Allocated objects.
+  size_t cls      = 0;       ///< Index of the size class.
+};
+
+namespace
+{
+size_t
+next_power_of_2(size_t n)
+{
+  size_t p = 1;
+  while (p < n) {
+    p <<= 1;
+  }
+  return p;
+}
+} // namespace
+
+SlabAllocator::SlabAllocator(const char *name, size_t min_size, size_t max_size, size_t alignment, size_t min_slab_size, int advice)
+  : _name(name), _min_size(min_size), _max_size(max_size), _alignment(alignment), _advice(advice)
+{
+  ink_release_assert(alignment && !(alignment & (alignment - 1)));
+  ink_release_assert(min_size > 0 && min_size <= max_size);
+
+  // The header is padded so the first object is aligned.
+  _header_size     = INK_ALIGN(sizeof(Slab), _alignment);
+  size_t slab_size = next_power_of_2(std::max<size_t>(min_slab_size, 1));
+
+  if (ats_hugepage_enabled()) {
+    slab_size = std::max(slab_size, next_power_of_2(ats_hugepage_size()));
+  }
+
+  // Build the classes, each at least one alignment unit larger than the previous one.
+  std::vector<size_t> sizes;
+  size_t size = INK_ALIGN(min_size, _alignment);
+  for (;;) {
+    sizes.push_back(size);
+    if (size >= max_size) {
+      break;
+    }
+    size_t next = INK_ALIGN(static_cast<size_t>(size * CLASS_SPACING), _alignment);
+    size        = std::min(std::max(next, size + _alignment), INK_ALIGN(max_size, _alignment));
+  }
+
+  _classes.resize(sizes.size());
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    SizeClass &c = _classes[i];
+    c.size       = sizes[i];
+    c.slab_size  = std::max(slab_size, next_power_of_2(_header_size + MIN_SLAB_OBJECTS * c.size));
+    c.n_objects  = (c.slab_size - _header_size) / c.size;
+    ink_mutex_init(&c.mutex);
+    c.stats.size      = c.size;
+    c.stats.slab_size = c.slab_size;
+    Debug(DEBUG_TAG "_init", "<%s> class %zu size %zu slab %zu objects %zu", _name, i, c.size, c.slab_size, c.n_objects);
+  }
+}
+
+SlabAllocator::~SlabAllocator()
+{
+  // Memory still allocated from the slabs is leaked on purpose, only the empty slabs are released.
+  for (auto &c : _classes) {
+    for (Slab *s = c.partial; s;) {
+      Slab *next = s->next;
+      if (s->n_used == 0) {
+        munmap(s, c.slab_size);
+      }
+      s = next;
+    }
+    ink_mutex_destroy(&c.mutex);
+  }
+}
+
+size_t
+SlabAllocator::class_index(size_t size) const
+{
+  if (!this->covers(size)) {
+    return _classes.size();
+  }
+  auto spot = std::lower_bound(_classes.begin(), _classes.end(), size, [](const SizeClass &c, size_t s) { return c.size < s; });
+  return spot - _classes.begin();
+}
+
+size_t
+SlabAllocator::class_size(size_t size) const
+{
+  size_t idx = this->class_index(size);
+  return idx < _classes.size() ? _classes[idx].size : 0;
+}
+
+SlabAllocator::Slab *
+SlabAllocator::map_slab(size_t idx)
+{
+  SizeClass &c = _classes[idx];
+  // Map twice the size and trim so the slab is aligned to its size.
+  size_t len    = c.slab_size * 2;
+  bool hugepage = false;
+  void *mem     = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+  if (ats_hugepage_enabled()) {
+    mem      = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    hugepage = mem != MAP_FAILED;
+  }
+#endif
+  if (mem == MAP_FAILED) {
+    mem = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  }
+  if (mem == MAP_FAILED) {
+    Warning("slab allocator %s unable to map %zu bytes", _name, len);
+    return nullptr;
+  }
+
+  uintptr_t base    = reinterpret_cast<uintptr_t>(mem);
+  uintptr_t aligned = INK_ALIGN(base, c.slab_size);
+  if (aligned > base) {
+    munmap(mem, aligned - base);
+  }
+  if (base + len > aligned + c.slab_size) {
+    munmap(reinterpret_cast<void *>(aligned + c.slab_size), base + len - (aligned + c.slab_size));
+  }
+
+#ifdef MADV_HUGEPAGE
+  if (!hugepage) {
+    ats_madvise(reinterpret_cast<caddr_t>(aligned), c.slab_size, MADV_HUGEPAGE);
+  }
+#endif
+  if (_advice) {
+    ats_madvise(reinterpret_cast<caddr_t>(aligned), c.slab_size, _advice);
+  }
+
+  Slab *slab  = new (reinterpret_cast<void *>(aligned)) Slab;
+  slab->carve = reinterpret_cast<char *>(aligned) + _header_size;
+  slab->end   = slab->carve + c.n_objects * c.size;
+  slab->cls   = idx;
+
+  ++c.stats.slabs;
+  c.stats.capacity += c.n_objects;
+  Debug(DEBUG_TAG, "<%s> mapped slab %p size %zu for class %zu", _name, slab, c.slab_size, c.size);
+  return slab;
+}
+
+void *
+SlabAllocator::alloc(size_t size)
+{
+  size_t idx = this->class_index(size);
+  if (idx >= _classes.size()) {
+    return nullptr;
+  }
+
+  SizeClass &c = _classes[idx];
+  void *ptr    = nullptr;
+
+  ink_scoped_mutex_lock lock(c.mutex);
+  Slab *slab = c.partial;
+
+  if (slab == nullptr) {
+    if ((slab = this->map_slab(idx)) == nullptr) {
+      return nullptr;
+    }
+    c.partial = slab;
+    ++c.empty;
+  }
+
+  if (slab->n_used == 0) {
+    --c.empty;
+  }
+
+  if (slab->free_list) {
+    ptr             = slab->free_list;
+    slab->free_list = *static_cast<void **>(ptr);
+  } else {
+    ink_assert(slab->carve + c.size <= slab->end);
+    ptr = slab->carve;
+    slab->carve += c.size;
+  }
+
+  // Take a full slab off the list of slabs with free objects.
+  if (++slab->n_used == c.n_objects) {
+    c.partial = slab->next;
+    if (c.partial) {
+      c.partial->prev = nullptr;
+    }
+    slab->next = slab->prev = nullptr;
+  }
+
+  ++c.stats.in_use;
+  ++c.stats.allocs;
+  c.stats.requested += size;
+  return ptr;
+}
+
+void
+SlabAllocator::free(void *ptr, size_t size)
+{
+  size_t idx = this->class_index(size);
+  ink_release_assert(idx < _classes.size());
+
+  SizeClass &c  = _classes[idx];
+  Slab *slab    = reinterpret_cast<Slab *>(reinterpret_cast<uintptr_t>(ptr) & ~(c.slab_size - 1));
+  Slab *release = nullptr;
+
+  ink_assert(slab->cls == idx);
+  {
+    ink_scoped_mutex_lock lock(c.mutex);
+
+    ink_assert(slab->n_used > 0);
+    *static_cast<void **>(ptr) = slab->free_list;
+    slab->free_list            = ptr;
+    --c.stats.in_use;
+
+    if (slab->n_used-- == c.n_objects) {
+      // Was full, make it available again. Full slabs are not on the list.
+      slab->prev = nullptr;
+      slab->next = c.partial;
+      if (c.partial) {
+        c.partial->prev = slab;
+      }
+      c.partial = slab;
+    }
+
+    if (slab->n_used == 0) {
+      if (c.empty >= _idle_slabs) {
+        if (slab->prev) {
+          slab->prev->next = slab->next;
+        } else {
+          c.partial = slab->next;
+        }
+        if (slab->next) {
+          slab->next->prev = slab->prev;
+        }
+        --c.stats.slabs;
+        c.stats.capacity -= c.n_objects;
+        ++c.stats.released;
+        release = slab;
+      } else {
+        ++c.empty;
+      }
+    }
+  }
+
+  if (release) {
+    Debug(DEBUG_TAG, "<%s> releasing idle slab %p size %zu", _name, release, c.slab_size);
+    munmap(release, c.slab_size);
+  }
+}
+
+SlabAllocator::ClassStats
+SlabAllocator::stats(size_t idx) const
+{
+  ink_release_assert(idx < _classes.size());
+  const SizeClass &c = _classes[idx];
+  ink_scoped_mutex_lock lock(c.mutex);
+  return c.stats;
+}
+
+size_t
+SlabAllocator::mapped_bytes() const
+{
+  size_t total = 0;
+  for (size_t i = 0; i < _classes.size(); ++i) {
+    ClassStats s = this->stats(i);
+    total += s.slabs * s.slab_size;
+  }
+  return total;
+}
+
+void
+SlabAllocator::dump(FILE *f) const
+{
+  if (f == nullptr) {
+    f = stderr;
+  }
+
+  fprintf(f, " Class Size |  Slab Size |  Slabs |   In-Use | Capacity | Avg Request | Internal | External | Released | %s\n", _name);
+  fprintf(f, "------------|------------|--------|----------|----------|-------------|----------|----------|----------|----------\n");
+
+  uint64_t total_mapped = 0;
+  uint64_t total_used   = 0;
+  for (size_t i = 0; i < _classes.size(); ++i) {
+    ClassStats s = this->stats(i);
+    if (s.slabs == 0 && s.allocs == 0) {
+      continue;
+    }
+    uint64_t avg_request = s.allocs ? s.requested / s.allocs : 0;
+    double internal      = s.allocs ? 100.0 * (s.size - avg_request) / s.size : 0.0;
+    double external      = s.capacity ? 100.0 * (s.capacity - s.in_use) / s.capacity : 0.0;
+    fprintf(f, " %10zu | %10zu | %6zu | %8zu | %8zu | %11" PRIu64 " | %7.1f%% | %7.1f%% | %8" PRIu64 " |\n", s.size, s.slab_size,
+            s.slabs, s.in_use, s.capacity, avg_request, internal, external, s.released);
+    total_mapped += s.slabs * s.slab_size;
+    total_used += s.in_use * s.size;
+  }
+  fprintf(f, " %" PRIu64 " bytes mapped, %" PRIu64 " bytes in use | TOTAL\n", total_mapped, total_used);
+  fprintf(f, "-----------------------------------------------------------------------------------------\n");
+}
@@ -0,0 +1,385 @@
+/** @file
+
+  XXH3 128 bit hash context.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  A portable implementation of the XXH3 128 bit hash of xxHash (BSD 2-Clause License,
+  Copyright (C) 2012-2021 Yann Collet), without a seed or a custom secret.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "tscore/XXH3.h"
+
+namespace
+{
+constexpr uint32_t PRIME32_1 = 0x9E3779B1U;
+constexpr uint32_t PRIME32_2 = 0x85EBCA77U;
+constexpr uint32_t PRIME32_3 = 0xC2B2AE3DU;
+constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+constexpr uint64_t PRIME_MX1 = 0x165667919E3779F9ULL;
+constexpr uint64_t PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+constexpr size_t SECRET_SIZE            = 192;
+constexpr size_t SECRET_SIZE_MIN        = 136;
+constexpr size_t SECRET_CONSUME_RATE    = 8;
+constexpr size_t SECRET_LIMIT           = SECRET_SIZE - XXH3Context::STRIPE_LEN;
+constexpr size_t STRIPES_PER_BLOCK      = SECRET_LIMIT / SECRET_CONSUME_RATE;
+constexpr size_t SECRET_LASTACC_START   = 7;
+constexpr size_t SECRET_MERGEACCS_START = 11;
+constexpr size_t MIDSIZE_MAX            = 240;
+constexpr size_t MIDSIZE_STARTOFFSET    = 3;
+constexpr size_t MIDSIZE_LASTOFFSET     = 17;
+constexpr size_t ACC_NB                 = XXH3Context::STRIPE_LEN / sizeof(uint64_t);
+constexpr size_t BUFFER_STRIPES         = XXH3Context::BUFFER_SIZE / XXH3Context::STRIPE_LEN;
+
+const uint8_t SECRET[SECRET_SIZE] = {
+  0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c, 0xde, 0xd4, 0x6d, 0xe9,
+  0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f, 0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78,
+  0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21, 0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6,
+  0x81, 0x3a, 0x26, 0x4c, 0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+  0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8, 0xa8, 0xfa, 0x76, 0x3f,
+  0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d, 0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+  0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64, 0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff,
+  0xfa, 0x13, 0x63, 0xeb, 0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+  0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce, 0x45, 0xcb, 0x3a, 0x8f,
+  0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+struct Hash128 {
+  uint64_t lo;
+  uint64_t hi;
+};
+
+inline uint32_t
+read32(const uint8_t *p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap32(v);
+#endif
+  return v;
+}
+
+inline uint64_t
+read64(const uint8_t *p)
+{
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64(v);
+#endif
+  return v;
+}
+
+inline uint32_t
+rotl32(uint32_t v, int r)
+{
+  return (v << r) | (v >> (32 - r));
+}
+
+inline Hash128
+mult64to128(uint64_t lhs, uint64_t rhs)
+{
+  __uint128_t product = static_cast<__uint128_t>(lhs) * rhs;
+  return {static_cast<uint64_t>(product), static_cast<uint64_t>(product >> 64)};
+}
+
+inline uint64_t
+mul128_fold64(uint64_t lhs, uint64_t rhs)
+{
+  Hash128 product = mult64to128(lhs, rhs);
+  return product.lo ^ product.hi;
+}
+
+inline uint64_t
+xorshift64(uint64_t v, int shift)
+{
+  return v ^ (v >> shift);
+}
+
+uint64_t
+xxh64_avalanche(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= PRIME64_2;
+  h ^= h >> 29;
+  h *= PRIME64_3;
+  h ^= h >> 32;
+  return h;
+}
+
+uint64_t
+avalanche(uint64_t h)
+{
+  h = xorshift64(h, 37);
+  h *= PRIME_MX1;
+  return xorshift64(h, 32);
+}
+
+inline uint64_t
+mix16B(const uint8_t *input, const uint8_t *secret, uint64_t seed)
+{
+  return mul128_fold64(read64(input) ^ (read64(secret) + seed), read64(input + 8) ^ (read64(secret + 8) - seed));
+}
+
+inline Hash128
+mix32B(Hash128 acc, const uint8_t *input_1, const uint8_t *input_2, const uint8_t *secret, uint64_t seed)
+{
+  acc.lo += mix16B(input_1, secret, seed);
+  acc.lo ^= read64(input_2) + read64(input_2 + 8);
+  acc.hi += mix16B(input_2, secret + 16, seed);
+  acc.hi ^= read64(input_1) + read64(input_1 + 8);
+  return acc;
+}
+
+Hash128
+len_1to3(const uint8_t *input, size_t len, const uint8_t *secret)
+{
+  uint32_t combinedl = (uint32_t(input[0]) << 16) | (uint32_t(input[len >> 1]) << 24) | input[len - 1] | (uint32_t(len) << 8);
+  uint32_t combinedh = rotl32(__builtin_bswap32(combinedl), 13);
+  uint64_t bitflipl  = read32(secret) ^ read32(secret + 4);
+  uint64_t bitfliph  = read32(secret + 8) ^ read32(secret + 12);
+  return {xxh64_avalanche(combinedl ^ bitflipl), xxh64_avalanche(combinedh ^ bitfliph)};
+}
+
+Hash128
+len_4to8(const uint8_t *input, size_t len, const uint8_t *secret)
+{
+  uint64_t input_64 = read32(input) + (static_cast<uint64_t>(read32(input + len - 4)) << 32);
+  uint64_t bitflip  = read64(secret + 16) ^ read64(secret + 24);
+  Hash128 m         = mult64to128(input_64 ^ bitflip, PRIME64_1 + (len << 2));
+
+  m.hi += m.lo << 1;
+  m.lo ^= m.hi >> 3;
+  m.lo = xorshift64(m.lo, 35);
+  m.lo *= PRIME_MX2;
+  m.lo = xorshift64(m.lo, 28);
+  m.hi = avalanche(m.hi);
+  return m;
+}
+
+Hash128
+len_9to16(const uint8_t *input, size_t len, const uint8_t *secret)
+{
+  uint64_t bitflipl = read64(secret + 32) ^ read64(secret + 40);
+  uint64_t bitfliph = read64(secret + 48) ^ read64(secret + 56);
+  uint64_t input_lo = read64(input);
+  uint64_t input_hi = read64(input + len - 8);
+  Hash128 m         = mult64to128(input_lo ^ input_hi ^ bitflipl, PRIME64_1);
+
+  m.lo += static_cast<uint64_t>(len - 1) << 54;
+  input_hi ^= bitfliph;
+  m.hi += input_hi + static_cast<uint64_t>(static_cast<uint32_t>(input_hi)) * (PRIME32_2 - 1);
+  m.lo ^= __builtin_bswap64(m.hi);
+
+  Hash128 h = mult64to128(m.lo, PRIME64_2);
+  h.hi += m.hi * PRIME64_2;
+  return {avalanche(h.lo), avalanche(h.hi)};
+}
+
+Hash128
+len_0to16(const uint8_t *input, size_t len, const uint8_t *secret)
+{
+  if (len > 8) {
+    return len_9to16(input, len, secret);
+  } else if (len >= 4) {
+    return len_4to8(input, len, secret);
+  } else if (len) {
+    return len_1to3(input, len, secret);
+  }
+  return {xxh64_avalanche(read64(secret + 64) ^ read64(secret + 72)), xxh64_avalanche(read64(secret + 80) ^ read64(secret + 88))};
+}
+
+Hash128
+finish_mid(Hash128 acc, size_t len)
+{
+  Hash128 h;
+  h.lo = avalanche(acc.lo + acc.hi);
+  h.hi = 0 - avalanche(acc.lo * PRIME64_1 + acc.hi * PRIME64_4 + len * PRIME64_2);
+  return h;
+}
+
+Hash128
+len_17to128(const uint8_t *input, size_t len, const uint8_t *secret)
+{
+  Hash128 acc = {len * PRIME64_1, 0};
+
+  if (len > 32) {
+    if (len > 64) {
+      if (len > 96) {
+        acc = mix32B(acc, input + 48, input + len - 64, secret + 96, 0);
+      }
+      acc = mix32B(acc, input + 32, input + len - 48, secret + 64, 0);
+    }
+    acc = mix32B(acc, input + 16, input + len - 32, secret + 32, 0);
+  }
+  acc = mix32B(acc, input, input + len - 16, secret, 0);
+  return finish_mid(acc, len);
+}
+
+Hash128
+len_129to240(const uint8_t *input, size_t len, const uint8_t *secret)
+{
+  Hash128 acc = {len * PRIME64_1, 0};
+  size_t i;
+
+  for (i = 32; i < 160; i += 32) {
+    acc = mix32B(acc, input + i - 32, input + i - 16, secret + i - 32, 0);
+  }
+  acc.lo = avalanche(acc.lo);
+  acc.hi = avalanche(acc.hi);
+  for (i = 160; i <= len; i += 32) {
+    acc = mix32B(acc, input + i - 32, input + i - 16, secret + MIDSIZE_STARTOFFSET + i - 160, 0);
+  }
+  acc = mix32B(acc, input + len - 16, input + len - 32, secret + SECRET_SIZE_MIN - MIDSIZE_LASTOFFSET - 16, 0);
+  return finish_mid(acc, len);
+}
+
+inline void
+accumulate_512(uint64_t *acc, const uint8_t *input, const uint8_t *secret)
+{
+  for (size_t i = 0; i < ACC_NB; ++i) {
+    uint64_t data_val = read64(input + i * 8);
+    uint64_t data_key = data_val ^ read64(secret + i * 8);
+    acc[i ^ 1] += data_val;
+    acc[i] += static_cast<uint64_t>(static_cast<uint32_t>(data_key)) * (data_key >> 32);
+  }
+}
+
+inline void
+scramble(uint64_t *acc, const uint8_t *secret)
+{
+  for (size_t i = 0; i < ACC_NB; ++i) {
+    acc[i] = (xorshift64(acc[i], 47) ^ read64(secret + i * 8)) * PRIME32_1;
+  }
+}
+
+// Accumulate @a n stripes of @a input, @a stripes is the count of stripes in the current block.
+const uint8_t *
+consume_stripes(uint64_t *acc, uint32_t &stripes, const uint8_t *input, size_t n)
+{
+  while (n > 0) {
+    size_t count = std::min(n, STRIPES_PER_BLOCK - stripes);
+    for (size_t i = 0; i < count; ++i) {
+      accumulate_512(acc, input + i * XXH3Context::STRIPE_LEN, SECRET + (stripes + i) * SECRET_CONSUME_RATE);
+    }
+    input += count * XXH3Context::STRIPE_LEN;
+    n -= count;
+    stripes += count;
+    if (stripes == STRIPES_PER_BLOCK) {
+      scramble(acc, SECRET + SECRET_LIMIT);
+      stripes = 0;
+    }
+  }
+  return input;
+}
+
+uint64_t
+merge_accs(const uint64_t *acc, const uint8_t *secret, uint64_t start)
+{
+  for (size_t i = 0; i < 4; ++i) {
+    start += mul128_fold64(acc[2 * i] ^ read64(secret + 16 * i), acc[2 * i + 1] ^ read64(secret + 16 * i + 8));
+  }
+  return avalanche(start);
+}
+} // namespace
+
+XXH3Context::XXH3Context()
+  : _acc{PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1},
+    _total_len(0),
+    _buffered(0),
+    _stripes(0)
+{
+}
+
+bool
+XXH3Context::update(void const *data, int length)
+{
+  const uint8_t *input = static_cast<const uint8_t *>(data);
+  const uint8_t *end   = input + length;
+
+  _total_len += length;
+  if (static_cast<size_t>(length) <= BUFFER_SIZE - _buffered) {
+    memcpy(_buffer + _buffered, input, length);
+    _buffered += length;
+    return true;
+  }
+
+  // Always keep some input buffered, the last stripe is hashed differently.
+  if (_buffered) {
+    size_t fill = BUFFER_SIZE - _buffered;
+    memcpy(_buffer + _buffered, input, fill);
+    input += fill;
+    consume_stripes(_acc, _stripes, _buffer, BUFFER_STRIPES);
+    _buffered = 0;
+  }
+  if (end - input > BUFFER_SIZE) {
+    input = consume_stripes(_acc, _stripes, input, (end - input - 1) / STRIPE_LEN);
+    // the last stripe may need bytes from before the buffered tail
+    memcpy(_buffer + BUFFER_SIZE - STRIPE_LEN, input - STRIPE_LEN, STRIPE_LEN);
+  }
+  memcpy(_buffer, input, end - input);
+  _buffered = end - input;
+  return true;
+}
+
+bool
+XXH3Context::finalize(CryptoHash &hash)
+{
+  Hash128 h;
+
+  if (_total_len <= MIDSIZE_MAX) {
+    if (_total_len <= 16) {
+      h = len_0to16(_buffer, _total_len, SECRET);
+    } else if (_total_len <= 128) {
+      h = len_17to128(_buffer, _total_len, SECRET);
+    } else {
+      h = len_129to240(_buffer, _total_len, SECRET);
+    }
+  } else {
+    uint64_t acc[ACC_NB];
+    uint8_t last_stripe[STRIPE_LEN];
+    const uint8_t *last;
+    uint32_t stripes = _stripes;
+
+    memcpy(acc, _acc, sizeof(acc));
+    if (_buffered >= STRIPE_LEN) {
+      consume_stripes(acc, stripes, _buffer, (_buffered - 1) / STRIPE_LEN);
+      last = _buffer + _buffered - STRIPE_LEN;
+    } else {
+      size_t catchup = STRIPE_LEN - _buffered;
+      memcpy(last_stripe, _buffer + BUFFER_SIZE - catchup, catchup);
+      memcpy(last_stripe + catchup, _buffer, _buffered);
+      last = last_stripe;
+    }
+    accumulate_512(acc, last, SECRET + SECRET_LIMIT - SECRET_LASTACC_START);
+    h.lo = merge_accs(acc, SECRET + SECRET_MERGEACCS_START, _total_len * PRIME64_1);
+    h.hi = merge_accs(acc, SECRET + SECRET_SIZE - sizeof(acc) - SECRET_MERGEACCS_START, ~(_total_len * PRIME64_2));
+  }
+  hash.u64[0] = h.lo;
+  hash.u64[1] = h.hi;
+  return true;
+}
@@ -53,6 +53,10 @@
 #include "tscore/Diags.h"
 #include "tscore/JeAllocator.h"
 
+#if TS_USE_HWLOC
+#include <hwloc.h>
+#endif
+
 #define DEBUG_TAG "freelist"
 
 /*
@@ -94,6 +98,11 @@ static const ink_freelist_ops *default_ops = &freelist_ops;
 static ink_freelist_list *freelists                = nullptr;
 static const ink_freelist_ops *freelist_global_ops = default_ops;
 
+// Number of NUMA nodes with private free list heads, 0 if NUMA awareness is disabled.
+static int freelist_numa_nodes = 0;
+// NUMA node of the current thread, -1 if the thread uses the shared head.
+static thread_local int freelist_thread_node = -1;
+
 const InkFreeListOps *
 ink_freelist_malloc_ops()
 {
@@ -116,6 +125,72 @@ ink_freelist_init_ops(int nofl_class, int nofl_proxy)
   freelist_global_ops = (nofl_class || nofl_proxy) ? ink_freelist_malloc_ops() : ink_freelist_freelist_ops();
 }
 
+void
+ink_freelist_numa_init(int n_nodes)
+{
+  // Like the ops, this must be set before the free lists are used so that a thread never sees
+  // a partially configured set of heads.
+  if (n_nodes > INK_FREELIST_MAX_NUMA_NODES) {
+    Warning("NUMA node count %d exceeds the free list limit %d, extra nodes will share free lists", n_nodes,
+            INK_FREELIST_MAX_NUMA_NODES);
+    n_nodes = INK_FREELIST_MAX_NUMA_NODES;
+  }
+  freelist_numa_nodes = n_nodes > 1 ? n_nodes : 0;
+  Debug(DEBUG_TAG "_init", "NUMA aware free lists for %d nodes", freelist_numa_nodes);
+}
+
+int
+ink_freelist_numa_nodes()
+{
+  return freelist_numa_nodes;
+}
+
+void
+ink_freelist_set_thread_numa_node(int node)
+{
+  freelist_thread_node = (node >= 0 && freelist_numa_nodes > 0) ? node % freelist_numa_nodes : -1;
+}
+
+int
+ink_freelist_thread_numa_node()
+{
+  return freelist_thread_node;
+}
+
+// Head to use for the current thread.
+static inline head_p *
+freelist_head(InkFreeList *f)
+{
+  return freelist_thread_node < 0 ? &f->head : &f->node_head[freelist_thread_node];
+}
+
+// Bind a newly allocated chunk to the memory of @a node. This must be done before the chunk is
+// touched, otherwise the pages are already placed by the first touch policy.
+static void
+freelist_bind_chunk(void *chunk, size_t size, int node)
+{
+#if TS_USE_HWLOC
+  hwloc_obj_t obj = hwloc_get_obj_by_type(ink_get_topology(), HWLOC_OBJ_NODE, node);
+
+  if (obj == nullptr) {
+    Debug(DEBUG_TAG, "No NUMA node %d to bind %zu bytes", node, size);
+    return;
+  }
+#if HWLOC_API_VERSION >= 0x00020000
+  int ret = hwloc_set_area_membind(ink_get_topology(), chunk, size, obj->nodeset, HWLOC_MEMBIND_BIND, HWLOC_MEMBIND_BYNODESET);
+#else
+  int ret = hwloc_set_area_membind_nodeset(ink_get_topology(), chunk, size, obj->nodeset, HWLOC_MEMBIND_BIND, 0);
+#endif
+  if (ret != 0) {
+    Debug(DEBUG_TAG, "Unable to bind %zu bytes at %p to NUMA node %d", size, chunk, node);
+  }
+#else
+  (void)chunk;
+  (void)size;
+  (void)node;
+#endif
+}
+
 void
 ink_freelist_init(InkFreeList **fl, const char *name, uint32_t type_size, uint32_t chunk_size, uint32_t alignment)
 {
@@ -152,6 +227,9 @@ ink_freelist_init(InkFreeList **fl, const char *name, uint32_t type_size, uint32
   }
   Debug(DEBUG_TAG "_init", "<%s> Chunk Size request/actual (%" PRIu32 "/%" PRIu32 ")", name, chunk_size, f->chunk_size);
   SET_FREELIST_POINTER_VERSION(f->head, FROM_PTR(0), 0);
+  for (auto &node_head : f->node_head) {
+    SET_FREELIST_POINTER_VERSION(node_head, FROM_PTR(0), 0);
+  }
 
   *fl = f;
 }
@@ -196,10 +274,11 @@ freelist_new(InkFreeList *f)
 {
   head_p item;
   head_p next;
-  int result = 0;
+  head_p *head = freelist_head(f);
+  int result   = 0;
 
   do {
-    INK_QUEUE_LD(item, f->head);
+    INK_QUEUE_LD(item, *head);
     if (TO_PTR(FREELIST_POINTER(item)) == nullptr) {
       uint32_t i;
       void *newp        = nullptr;
@@ -219,6 +298,10 @@ freelist_new(InkFreeList *f)
       if (f->advice) {
         ats_madvise((caddr_t)newp, INK_ALIGN(alloc_size, alignment), f->advice);
       }
+      if (freelist_thread_node >= 0) {
+        freelist_bind_chunk(newp, INK_ALIGN(alloc_size, alignment), freelist_thread_node);
+        ink_atomic_increment((int *)&f->node_allocated[freelist_thread_node], f->chunk_size);
+      }
       SET_FREELIST_POINTER_VERSION(item, newp, 0);
 
       ink_atomic_increment((int *)&f->allocated, f->chunk_size);
@@ -236,7 +319,7 @@ freelist_new(InkFreeList *f)
 
     } else {
       SET_FREELIST_POINTER_VERSION(next, *ADDRESS_OF_NEXT(TO_PTR(FREELIST_POINTER(item)), 0), FREELIST_VERSION(item) + 1);
-      result = ink_atomic_cas(&f->head.data, item.data, next.data);
+      result = ink_atomic_cas(&head->data, item.data, next.data);
 
 #ifdef SANITY
       if (result) {
@@ -285,7 +368,8 @@ freelist_free(InkFreeList *f, void *item)
   void **adr_of_next = (void **)ADDRESS_OF_NEXT(item, 0);
   head_p h;
   head_p item_pair;
-  int result = 0;
+  head_p *head = freelist_head(f);
+  int result   = 0;
 
   // ink_assert(!((long)item&(f->alignment-1))); XXX - why is this no longer working? -bcall
 
@@ -300,7 +384,7 @@ freelist_free(InkFreeList *f, void *item)
 #endif /* DEADBEEF */
 
   while (!result) {
-    INK_QUEUE_LD(h, f->head);
+    INK_QUEUE_LD(h, *head);
 #ifdef SANITY
     if (TO_PTR(FREELIST_POINTER(h)) == item)
       ink_abort("ink_freelist_free: trying to free item twice");
@@ -312,7 +396,7 @@ freelist_free(InkFreeList *f, void *item)
     *adr_of_next = FREELIST_POINTER(h);
     SET_FREELIST_POINTER_VERSION(item_pair, FROM_PTR(item), FREELIST_VERSION(h));
     INK_MEMORY_BARRIER;
-    result = ink_atomic_cas(&f->head.data, h.data, item_pair.data);
+    result = ink_atomic_cas(&head->data, h.data, item_pair.data);
   }
 }
 
@@ -341,7 +425,8 @@ freelist_bulkfree(InkFreeList *f, void *head, void *tail, size_t num_item)
   void **adr_of_next = (void **)ADDRESS_OF_NEXT(tail, 0);
   head_p h;
   head_p item_pair;
-  int result = 0;
+  head_p *list = freelist_head(f);
+  int result   = 0;
 
   // ink_assert(!((long)item&(f->alignment-1))); XXX - why is this no longer working? -bcall
 
@@ -361,7 +446,7 @@ freelist_bulkfree(InkFreeList *f, void *head, void *tail, size_t num_item)
 #endif /* DEADBEEF */
 
   while (!result) {
-    INK_QUEUE_LD(h, f->head);
+    INK_QUEUE_LD(h, *list);
 #ifdef SANITY
     if (TO_PTR(FREELIST_POINTER(h)) == head)
       ink_abort("ink_freelist_free: trying to free item twice");
@@ -373,7 +458,7 @@ freelist_bulkfree(InkFreeList *f, void *head, void *tail, size_t num_item)
     *adr_of_next = FREELIST_POINTER(h);
     SET_FREELIST_POINTER_VERSION(item_pair, FROM_PTR(head), FREELIST_VERSION(h));
     INK_MEMORY_BARRIER;
-    result = ink_atomic_cas(&f->head.data, h.data, item_pair.data);
+    result = ink_atomic_cas(&list->data, h.data, item_pair.data);
   }
 }
 
@@ -461,6 +546,26 @@ ink_freelists_dump(FILE *f)
   }
   fprintf(f, " %18" PRIu64 " | %18" PRIu64 " |            | TOTAL\n", total_allocated, total_used);
   fprintf(f, "-----------------------------------------------------------------------------------------\n");
+
+  for (int node = 0; node < freelist_numa_nodes; ++node) {
+    fprintf(f, " %18" PRIu64 " |                    |            | NUMA node %d\n", ink_freelists_numa_allocated(node), node);
+  }
+  if (freelist_numa_nodes > 0) {
+    fprintf(f, "-----------------------------------------------------------------------------------------\n");
+  }
+}
+
+uint64_t
+ink_freelists_numa_allocated(int node)
+{
+  uint64_t total = 0;
+
+  if (node >= 0 && node < freelist_numa_nodes) {
+    for (ink_freelist_list *fll = freelists; fll; fll = fll->next) {
+      total += (uint64_t)fll->fl->node_allocated[node] * (uint64_t)fll->fl->type_size;
+    }
+  }
+  return total;
 }
 
 void
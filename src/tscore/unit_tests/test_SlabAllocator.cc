@@ -0,0 +1,104 @@
+/** @file
+
+  SlabAllocator unit tests.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "catch.hpp"
+
+#include <cstring>
+#include <set>
+#include <vector>
+
+#include "tscore/SlabAllocator.h"
+
+TEST_CASE("SlabAllocator classes", "[libts][slab]")
+{
+  SlabAllocator slab("test", 16 * 1024, 2 * 1024 * 1024, 4096, 2 * 1024 * 1024);
+
+  REQUIRE(slab.n_classes() > 10);
+  REQUIRE(!slab.covers(1024));
+  REQUIRE(!slab.covers(4 * 1024 * 1024));
+  REQUIRE(slab.class_size(1024) == 0);
+  REQUIRE(slab.class_size(16 * 1024) == 16 * 1024);
+  REQUIRE(slab.class_size(2 * 1024 * 1024) == 2 * 1024 * 1024);
+
+  // Classes are aligned and spaced by at most the class spacing plus alignment.
+  size_t prev = 0;
+  for (size_t i = 0; i < slab.n_classes(); ++i) {
+    auto stats = slab.stats(i);
+    REQUIRE(stats.size % 4096 == 0);
+    REQUIRE(stats.size > prev);
+    if (prev) {
+      REQUIRE(stats.size <= prev * SlabAllocator::CLASS_SPACING + 4096);
+    }
+    prev = stats.size;
+  }
+
+  // A size just above a power of two wastes much less than with power of two classes.
+  size_t size = 64 * 1024 + 1;
+  REQUIRE(slab.class_size(size) < size * SlabAllocator::CLASS_SPACING + 4096);
+}
+
+TEST_CASE("SlabAllocator alloc and free", "[libts][slab]")
+{
+  SlabAllocator slab("test", 16 * 1024, 1024 * 1024, 4096, 2 * 1024 * 1024);
+  const size_t size = 40 * 1024;
+  std::vector<void *> items;
+  std::set<void *> unique;
+
+  for (int i = 0; i < 200; ++i) {
+    void *p = slab.alloc(size);
+    REQUIRE(p != nullptr);
+    REQUIRE(reinterpret_cast<uintptr_t>(p) % 4096 == 0);
+    memset(p, i, size);
+    items.push_back(p);
+    unique.insert(p);
+  }
+  REQUIRE(unique.size() == items.size());
+  REQUIRE(slab.alloc(8 * 1024) == nullptr);
+
+  size_t idx = 0;
+  while (slab.stats(idx).size < size) {
+    ++idx;
+  }
+  auto stats = slab.stats(idx);
+  REQUIRE(stats.in_use == 200);
+  REQUIRE(stats.slabs > 1);
+  REQUIRE(stats.capacity >= 200);
+  REQUIRE(stats.requested == 200 * size);
+
+  for (void *p : items) {
+    slab.free(p, stats.size);
+  }
+
+  // All but the idle slabs are returned to the OS.
+  stats = slab.stats(idx);
+  REQUIRE(stats.in_use == 0);
+  REQUIRE(stats.slabs == SlabAllocator::DEFAULT_IDLE_SLABS);
+  REQUIRE(stats.released > 0);
+  REQUIRE(slab.mapped_bytes() == stats.slabs * stats.slab_size);
+
+  // The idle slab is reused.
+  void *p = slab.alloc(size);
+  REQUIRE(p != nullptr);
+  REQUIRE(slab.stats(idx).slabs == SlabAllocator::DEFAULT_IDLE_SLABS);
+  slab.free(p, size);
+}
@@ -0,0 +1,116 @@
+/** @file
+
+  Trie unit tests.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+
+#include "tscore/Trie.h"
+
+namespace
+{
+struct Value {
+  explicit Value(int i) : id(i) {}
+  void
+  Print()
+  {
+  }
+
+  int id;
+  LINK(Value, link);
+};
+
+int
+search(const Trie<Value> &trie, const char *key)
+{
+  Value *v = trie.Search(key);
+  return v ? v->id : -1;
+}
+} // namespace
+
+TEST_CASE("Trie prefix search", "[libts][Trie]")
+{
+  Trie<Value> trie;
+
+  REQUIRE(trie.Empty());
+  REQUIRE(search(trie, "abc") == -1);
+
+  // Inserting in this order splits "images/large" at "images/" and then "images/l".
+  REQUIRE(trie.Insert("images/large", new Value(1), 1));
+  REQUIRE(trie.Insert("images/small", new Value(2), 2));
+  REQUIRE(trie.Insert("images/", new Value(3), 3));
+  REQUIRE(trie.Insert("images/l", new Value(4), 4));
+  REQUIRE(trie.Insert("video", new Value(5), 5));
+  REQUIRE_FALSE(trie.Empty());
+
+  CHECK(search(trie, "images/large") == 1);
+  CHECK(search(trie, "images/large/x.png") == 1);
+  CHECK(search(trie, "images/small.png") == 2);
+  CHECK(search(trie, "images/") == 3);
+  CHECK(search(trie, "images/medium") == 3);
+  CHECK(search(trie, "images/lar") == 3); // rank 3 beats "images/l" with rank 4
+  CHECK(search(trie, "images") == -1);
+  CHECK(search(trie, "video/1") == 5);
+  CHECK(search(trie, "vide") == -1);
+  CHECK(search(trie, "") == -1);
+
+  // Duplicates are rejected, including keys that only exist as a split point.
+  Value dup(0);
+  CHECK_FALSE(trie.Insert("images/", &dup, 0));
+  REQUIRE(trie.Insert("images/larg", new Value(6), 0));
+  CHECK(search(trie, "images/large") == 6);
+
+  // The empty key matches everything.
+  REQUIRE(trie.Insert("", new Value(7), 0));
+  CHECK(search(trie, "audio") == 7);
+  CHECK(search(trie, "images/medium") == 7);
+  CHECK(search(trie, "images/larg") == 6); // the longer key wins a tie
+
+  // Keys are 8 bit and not terminated when a length is given.
+  REQUIRE(trie.Insert("\xff\x00z", new Value(8), 0, 3));
+  CHECK(trie.Search("\xff\x00z!", 4)->id == 8);
+  CHECK(trie.Search("\xff\x00", 2)->id == 7);
+
+  trie.Clear();
+  CHECK(trie.Empty());
+  CHECK(search(trie, "video") == -1);
+}
+
+TEST_CASE("Trie many keys", "[libts][Trie]")
+{
+  Trie<Value> trie;
+  std::vector<std::string> keys;
+
+  // Keys sharing long prefixes with many branches per node.
+  for (int i = 0; i < 4096; ++i) {
+    keys.push_back("/static/assets/" + std::to_string(i % 64) + "/" + std::to_string(i) + "/");
+  }
+  for (size_t i = 0; i < keys.size(); ++i) {
+    REQUIRE(trie.Insert(keys[i].c_str(), new Value(i), static_cast<int>(i)));
+  }
+  for (size_t i = 0; i < keys.size(); ++i) {
+    CHECK(search(trie, (keys[i] + "object").c_str()) == static_cast<int>(i));
+    CHECK(search(trie, keys[i].substr(0, keys[i].size() - 1).c_str()) == -1);
+  }
+}
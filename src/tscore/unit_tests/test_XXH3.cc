@@ -0,0 +1,111 @@
+/** @file
+
+  XXH3 hash context unit tests.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "catch.hpp"
+
+#include <algorithm>
+
+#include "tscore/XXH3.h"
+
+namespace
+{
+struct Vector {
+  int len;
+  uint64_t lo;
+  uint64_t hi;
+};
+
+// XXH3_128bits() of xxHash 0.8 for the first @c len bytes of the test data, one for each code path.
+const Vector vectors[] = {
+  {0, 0x6001c324468d497fULL, 0x99aa06d3014798d8ULL},
+  {1, 0x4c5cca45d0f4811fULL, 0x495b62073ef70ca4ULL},
+  {3, 0x6e3e2670e61106acULL, 0x390cdc5b4a895dd7ULL},
+  {4, 0x3d668af6f2a44d77ULL, 0xaa6e2f274640a3f4ULL},
+  {8, 0x61ddbe7f31a6100dULL, 0x6a86a3bda6af4e3dULL},
+  {9, 0x8c7b67fd458a936bULL, 0x664c7ca18afd6255ULL},
+  {16, 0xe2ce54a7c19c730dULL, 0x7f9a218b0425449aULL},
+  {17, 0x8d96ef110fcdebb4ULL, 0x66fc23f6439dbd77ULL},
+  {128, 0xff361dec1385710aULL, 0xaec730751478556cULL},
+  {129, 0x4545b3a09738e31aULL, 0x98cd36ccbb557926ULL},
+  {240, 0x3f2c53e72293711fULL, 0x5293e17bf553903dULL},
+  {241, 0x956cae592c67279eULL, 0xb53840fe3fedf161ULL},
+  {256, 0xb15e550733c5dfacULL, 0xd0d2829a226d0edbULL},
+  {1024, 0x70bd377d9574f4bbULL, 0xf69630613f24324dULL},
+  {2048, 0x8b46caa67dab3a30ULL, 0x56b77f207158a2baULL},
+};
+
+uint8_t data[2048];
+
+void
+fill_data()
+{
+  for (int i = 0; i < static_cast<int>(sizeof(data)); ++i) {
+    data[i] = static_cast<uint8_t>(i * 131 + 7);
+  }
+}
+} // namespace
+
+TEST_CASE("XXH3 vectors", "[libts][XXH3]")
+{
+  fill_data();
+  for (auto const &v : vectors) {
+    CryptoHash hash;
+    XXH3Context().hash_immediate(hash, data, v.len);
+    INFO("length " << v.len);
+    REQUIRE(hash.u64[0] == v.lo);
+    REQUIRE(hash.u64[1] == v.hi);
+  }
+}
+
+TEST_CASE("XXH3 incremental", "[libts][XXH3]")
+{
+  fill_data();
+  // Feeding the input in pieces must not change the hash, whatever the piece size.
+  for (auto const &v : vectors) {
+    for (int step : {1, 7, 63, 64, 65, 255, 256, 300}) {
+      XXH3Context ctx;
+      CryptoHash hash;
+      for (int offset = 0; offset < v.len; offset += step) {
+        ctx.update(data + offset, std::min(step, v.len - offset));
+      }
+      ctx.finalize(hash);
+      INFO("length " << v.len << " step " << step);
+      REQUIRE(hash.u64[0] == v.lo);
+      REQUIRE(hash.u64[1] == v.hi);
+    }
+  }
+}
+
+TEST_CASE("XXH3 crypto context", "[libts][XXH3]")
+{
+  fill_data();
+  // A context of an explicit type does not depend on the global setting.
+  REQUIRE(CryptoContext::Setting != CryptoContext::XXH3);
+  for (auto const &v : vectors) {
+    CryptoHash hash;
+    CryptoContext(CryptoContext::XXH3).hash_immediate(hash, data, v.len);
+    INFO("length " << v.len);
+    REQUIRE(hash.u64[0] == v.lo);
+    REQUIRE(hash.u64[1] == v.hi);
+  }
+}
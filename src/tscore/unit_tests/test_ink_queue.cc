@@ -0,0 +1,62 @@
+/** @file
+
+  Free list unit tests.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "catch.hpp"
+
+#include "tscore/ink_queue.h"
+
+TEST_CASE("InkFreeList NUMA", "[libts][freelist]")
+{
+  InkFreeList *fl = ink_freelist_create("numa_test", 64, 16, 8);
+
+  // Without NUMA awareness the node is ignored.
+  ink_freelist_numa_init(0);
+  ink_freelist_set_thread_numa_node(1);
+  REQUIRE(ink_freelist_thread_numa_node() == -1);
+
+  ink_freelist_numa_init(2);
+  REQUIRE(ink_freelist_numa_nodes() == 2);
+
+  ink_freelist_set_thread_numa_node(0);
+  void *item0 = ink_freelist_new(fl);
+  REQUIRE(fl->node_allocated[0] == fl->chunk_size);
+  REQUIRE(fl->node_allocated[1] == 0);
+
+  ink_freelist_set_thread_numa_node(1);
+  void *item1 = ink_freelist_new(fl);
+  REQUIRE(fl->node_allocated[1] == fl->chunk_size);
+  REQUIRE(ink_freelists_numa_allocated(1) >= uint64_t(fl->chunk_size) * fl->type_size);
+  REQUIRE(item0 != item1);
+
+  // Items freed on a node are reused on that node.
+  ink_freelist_free(fl, item1);
+  REQUIRE(ink_freelist_new(fl) == item1);
+
+  ink_freelist_set_thread_numa_node(0);
+  ink_freelist_free(fl, item0);
+  REQUIRE(ink_freelist_new(fl) == item0);
+  REQUIRE(fl->allocated == 2 * fl->chunk_size);
+
+  ink_freelist_set_thread_numa_node(-1);
+  ink_freelist_numa_init(0);
+}
@@ -0,0 +1,127 @@
+'''
+'''
+#  Licensed to the Apache Software Foundation (ASF) under one
+#  or more contributor license agreements.  See the NOTICE file
+#  distributed with this work for additional information
+#  regarding copyright ownership.  The ASF licenses this file
+#  to you under the Apache License, Version 2.0 (the
+#  "License"); you may not use this file except in compliance
+#  with the License.  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+import socket
+
+Test.Summary = '''
+Test the byte ranges of sparse objects: cached, filled from the origin server and refused when the origin server is down
+'''
+
+Test.SkipUnless(
+    Condition.PluginExists('cachekey.so'),
+    Condition.PluginExists('xdebug.so'),
+)
+Test.ContinueOnFail = False
+
+chunk_size = 4096
+# one letter per chunk
+body = ''.join(c * chunk_size for c in 'abcd')
+
+server = Test.MakeOriginServer("server", lookup_key="{%Range}{PATH}")
+
+
+def add_range(first, last):
+    request_header = {"headers":
+                      "GET /sparse HTTP/1.1\r\n" +
+                      "Host: www.example.com\r\n" +
+                      "Range: bytes={}-{}\r\n".format(first, last) +
+                      "\r\n",
+                      "timestamp": "1469733493.993",
+                      "body": "",
+                      }
+    response_header = {"headers":
+                       "HTTP/1.1 206 Partial Content\r\n" +
+                       "Connection: close\r\n" +
+                       'ETag: "sparse"\r\n' +
+                       "Cache-Control: max-age=300\r\n" +
+                       "Content-Range: bytes {}-{}/{}\r\n".format(first, last, len(body)) +
+                       "\r\n",
+                       "timestamp": "1469733493.993",
+                       "body": body[first:last + 1],
+                       }
+    server.addResponse("sessionlog.json", request_header, response_header)
+
+
+add_range(0, 2 * chunk_size - 1)
+add_range(2 * chunk_size, 3 * chunk_size - 1)
+
+# a port without a listener, for an origin server which is down
+sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+sock.bind(('127.0.0.1', 0))
+down_port = sock.getsockname()[1]
+sock.close()
+
+ts = Test.MakeATSProcess("ts")
+ts.Disk.plugin_config.AddLine('xdebug.so')
+ts.Disk.records_config.update({
+    'proxy.config.diags.debug.enabled': 1,
+    'proxy.config.diags.debug.tags': 'http_trans|http_range',
+    'proxy.config.http.cache.http': 1,
+    'proxy.config.http.wait_for_cache': 1,
+    'proxy.config.cache.sparse.chunk_size': chunk_size,
+    'proxy.config.http.connect_attempts_max_retries': 0,
+    'proxy.config.http.connect_attempts_rr_retries': 0,
+    'proxy.config.http.connect_attempts_timeout': 2,
+})
+# both origin servers share the cache key of the object
+ts.Disk.remap_config.AddLines([
+    'map http://up.example.com/ http://127.0.0.1:{}/ @plugin=cachekey.so @pparam=--static-prefix=sparse'.format(
+        server.Variables.Port),
+    'map http://down.example.com/ http://127.0.0.1:{}/ @plugin=cachekey.so @pparam=--static-prefix=sparse'.format(down_port),
+])
+
+
+def add_request(host, first, last, status, cached):
+    tr = Test.AddTestRun()
+    tr.Processes.Default.Command = (
+        'curl -s -D - --http1.1 -H "Host: {}.example.com" -H "Range: bytes={}-{}" -H "x-debug: x-cache"'
+        ' http://127.0.0.1:{}/sparse'.format(host, first, last, ts.Variables.port))
+    tr.Processes.Default.ReturnCode = 0
+    tr.Processes.Default.Streams.stdout = Testers.ContainsExpression(
+        "HTTP/1.1 {}".format(status), "the response status is {}".format(status))
+    if status == 206:
+        tr.Processes.Default.Streams.stdout += Testers.ContainsExpression(
+            "Content-Range: bytes {}-{}/{}".format(first, last, len(body)), "the response holds the range")
+        tr.Processes.Default.Streams.stdout += Testers.ContainsExpression(
+            "\r\n\r\n{}$".format(body[first:last + 1]), "the body is the range of the object")
+    if cached:
+        tr.Processes.Default.Streams.stdout += Testers.ContainsExpression("x-cache: hit-fresh", "the range is served from cache")
+    else:
+        tr.Processes.Default.Streams.stdout += Testers.ExcludesExpression("x-cache: hit-fresh", "the range is not in cache")
+    tr.StillRunningAfter = ts
+    tr.StillRunningAfter = server
+    return tr
+
+
+# range miss, the two first chunks are stored
+tr = add_request('up', 0, 2 * chunk_size - 1, 206, False)
+tr.Processes.Default.StartBefore(server)
+tr.Processes.Default.StartBefore(Test.Processes.ts, ready=When.PortOpen(ts.Variables.port))
+
+# a range inside the stored chunks is a hit
+add_request('up', chunk_size, 2 * chunk_size - 1, 206, True)
+
+# a range outside of them is filled from the origin server, then it is a hit too
+add_request('up', 2 * chunk_size, 3 * chunk_size - 1, 206, False)
+add_request('up', 2 * chunk_size, 3 * chunk_size - 1, 206, True)
+
+# with the origin server down, the stored chunks are still served
+add_request('down', 0, chunk_size - 1, 206, True)
+
+# but the missing ones are not served from the object which does not hold them
+add_request('down', 3 * chunk_size, 4 * chunk_size - 1, 502, False)